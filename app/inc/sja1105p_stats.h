@@ -0,0 +1,62 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2018 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file sja1105p_stats.h
+*
+* \author NXP Semiconductors
+*
+* \date 2018-01-15
+*
+* \brief Port counters collected in the background
+*
+*****************************************************************************/
+#ifndef _SJA1105P_STATS_H__
+#define _SJA1105P_STATS_H__
+
+#include <linux/types.h>
+
+#include "NXP_SJA1105P_diagnostics.h"
+
+/* unidirectional 32-bit counters, indexed by SJA1105P_etherStat32_t */
+#define SJA1105P_STATS_N_COUNTERS (SJA1105P_e_etherStat32_N_UNTAGGED_DROP + 1)
+/* 32-bit counters kept per direction (frame size histogram, multicast, broadcast),
+ * indexed by SJA1105P_etherStat32_t - SJA1105P_STATS_N_COUNTERS
+ */
+#define SJA1105P_STATS_N_DIR_COUNTERS (SJA1105P_N_ETHER_STAT32 - SJA1105P_STATS_N_COUNTERS)
+
+/* snapshot of the counters of a port, the 32-bit counters are extended to 64 bits */
+struct sja1105p_port_stats {
+	u64 tx_bytes;
+	u64 tx_packets;
+	u64 rx_bytes;
+	u64 rx_packets;
+	u64 counter[SJA1105P_STATS_N_COUNTERS];
+	u64 rx_counter[SJA1105P_STATS_N_DIR_COUNTERS];
+	u64 tx_counter[SJA1105P_STATS_N_DIR_COUNTERS];
+	SJA1105P_macLevelErrors_t mac_errors;          /* do not wrap */
+	u8 q_occupancy[SJA1105P_N_EGRESS_QUEUES];      /* at the time of the read */
+	u8 q_occupancy_high_watt[SJA1105P_N_EGRESS_QUEUES];
+};
+
+void sja1105p_stats_start(void);
+void sja1105p_stats_stop(void);
+int sja1105p_stats_get(int port, struct sja1105p_port_stats *stats);
+
+#endif /* _SJA1105P_STATS_H__ */
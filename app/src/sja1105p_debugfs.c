@@ -31,13 +31,16 @@
 #include <linux/spi/spi.h>
 #include <linux/debugfs.h>
 #include <linux/uaccess.h>
+#include <linux/math64.h>
 
 #include "sja1105p_spi_linux.h"
 #include "sja1105p_cfg_file.h"
 #include "sja1105p_general_status.h"
 #include "sja1105p_debugfs.h"
+#include "sja1105p_stats.h"
 #include "NXP_SJA1105P_switchCore.h"
 #include "NXP_SJA1105P_diagnostics.h"
+#include "NXP_SJA1105P_spi.h"
 
 #define BUFSIZE 20
 
@@ -151,11 +154,11 @@ static int sja1105p_ethernet_mac_level_show(struct seq_file *s, void *data)
 {
 	struct sja1105p_context_data *ctx_data = s->private;
 	struct spi_device *spi = ctx_data->spi_dev;
-	SJA1105P_macLevelErrors_t p_macLevelErrors;
+	struct sja1105p_port_stats stats;
 	int err, port;
 
 	for (port=0; port<SJA1105P_N_LOGICAL_PORTS; port++) {
-		err = SJA1105P_getMacErrors(&p_macLevelErrors, port);
+		err = sja1105p_stats_get(port, &stats);
 		if (err) {
 			dev_err(&spi->dev, "Error: Could not get ethernet mac level status for logical port %d (err=%d)\n", port, err);
 			return err;
@@ -163,10 +166,10 @@ static int sja1105p_ethernet_mac_level_show(struct seq_file *s, void *data)
 
 		seq_printf(s, "\nEthernet MAC-level status logical port %d\n", port);
 
-		seq_printf(s, "nRunt      = %u\n", p_macLevelErrors.nRunt);
-		seq_printf(s, "nSoferr    = %u\n", p_macLevelErrors.nSoferr);
-		seq_printf(s, "nAlignerr  = %u\n", p_macLevelErrors.nAlignerr);
-		seq_printf(s, "nMiierr    = %u\n", p_macLevelErrors.nMiierr);
+		seq_printf(s, "nRunt      = %u\n", stats.mac_errors.nRunt);
+		seq_printf(s, "nSoferr    = %u\n", stats.mac_errors.nSoferr);
+		seq_printf(s, "nAlignerr  = %u\n", stats.mac_errors.nAlignerr);
+		seq_printf(s, "nMiierr    = %u\n", stats.mac_errors.nMiierr);
 	}
 
 	return 0;
@@ -176,53 +179,11 @@ static int sja1105p_ethernet_high_level_show(struct seq_file *s, void *data)
 {
 	struct sja1105p_context_data *ctx_data = s->private;
 	struct spi_device *spi = ctx_data->spi_dev;
-	uint64_t tx_bytes, tx_packets, rx_bytes, rx_packets;
-	uint32_t rx_crc_errors, rx_length_errors, polerr, vlanerr, n664err;
-	uint32_t not_reach, egr_disabled, part_drop, qfull;
+	struct sja1105p_port_stats stats;
 	int err, port;
 
-
-
 	for (port=0; port<SJA1105P_N_LOGICAL_PORTS; port++) {
-		err = SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_OCTETS,
-							&tx_bytes, port,
-							SJA1105P_e_etherStatDirection_EGRESS);
-		err += SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_PKTS,
-							&tx_packets, port,
-							SJA1105P_e_etherStatDirection_EGRESS);
-		err += SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_OCTETS,
-							&rx_bytes, port,
-							SJA1105P_e_etherStatDirection_INGRESS);
-		err += SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_PKTS,
-							&rx_packets, port,
-							SJA1105P_e_etherStatDirection_INGRESS);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_CRCERR,
-							&rx_crc_errors, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_SIZEERR,
-							&rx_length_errors, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_NOT_REACH,
-							&not_reach, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_EGR_DISABLED,
-							&egr_disabled, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_PART_DROP,
-							&part_drop, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_QFULL,
-							&qfull, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_POLERR,
-							&polerr, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_VLANERR,
-							&vlanerr, port,
-							SJA1105P_e_etherStatDirection_BOTH);
-		err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_N664ERR,
-							&n664err, port,
-							SJA1105P_e_etherStatDirection_BOTH);
+		err = sja1105p_stats_get(port, &stats);
 		if (err) {
 			dev_err(&spi->dev, "Error: Could not get ethernet high level status for logical port %d (err=%d)\n", port, err);
 			return err;
@@ -230,20 +191,20 @@ static int sja1105p_ethernet_high_level_show(struct seq_file *s, void *data)
 
 		seq_printf(s, "\nEthernet High-level status logical port %d\n", port);
 
-		seq_printf(s, "tx_bytes         = %llu\n", tx_bytes);
-		seq_printf(s, "tx_packets       = %llu\n", tx_packets);
-		seq_printf(s, "rx_bytes         = %llu\n", rx_bytes);
-		seq_printf(s, "rx_packets       = %llu\n", rx_packets);
-
-		seq_printf(s, "rx_crc_errors    = %u\n", rx_crc_errors);
-		seq_printf(s, "rx_length_errors = %u\n", rx_length_errors);
-		seq_printf(s, "polerr           = %u\n", polerr);
-		seq_printf(s, "vlanerr          = %u\n", vlanerr);
-		seq_printf(s, "n664err          = %u\n", n664err);
-		seq_printf(s, "not_reach        = %u\n", not_reach);
-		seq_printf(s, "egr_disabled     = %u\n", egr_disabled);
-		seq_printf(s, "part_drop        = %u\n", part_drop);
-		seq_printf(s, "qfull            = %u\n", qfull);
+		seq_printf(s, "tx_bytes         = %llu\n", stats.tx_bytes);
+		seq_printf(s, "tx_packets       = %llu\n", stats.tx_packets);
+		seq_printf(s, "rx_bytes         = %llu\n", stats.rx_bytes);
+		seq_printf(s, "rx_packets       = %llu\n", stats.rx_packets);
+
+		seq_printf(s, "rx_crc_errors    = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_CRCERR]);
+		seq_printf(s, "rx_length_errors = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_SIZEERR]);
+		seq_printf(s, "polerr           = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_POLERR]);
+		seq_printf(s, "vlanerr          = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_VLANERR]);
+		seq_printf(s, "n664err          = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_N664ERR]);
+		seq_printf(s, "not_reach        = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_NOT_REACH]);
+		seq_printf(s, "egr_disabled     = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_EGR_DISABLED]);
+		seq_printf(s, "part_drop        = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_PART_DROP]);
+		seq_printf(s, "qfull            = %llu\n", stats.counter[SJA1105P_e_etherStat32_N_QFULL]);
 	}
 
 	return 0;
@@ -280,6 +241,8 @@ static ssize_t sja1105p_register_rw_write(struct file* file, const char __user*
 	case 'w':
 		/* write to register */
 		ret = sja1105p_cfg_block_write(spi, reg_addr, (u32*)&reg_content, 1);
+		/* raw access bypasses the HAL register shadow */
+		SJA1105P_invalidateRegisterCache(ctx_data->device_select);
 		if (!ret)
 			dev_alert(&spi->dev, "Wrote %08lx to register %lx\n", reg_content, reg_addr);
 		else
@@ -297,6 +260,90 @@ error:
 	return size;
 }
 
+static int sja1105p_spi_statistics_show(struct seq_file *s, void *data)
+{
+	struct sja1105p_context_data *ctx_data = s->private;
+	int device_select = ctx_data->device_select;
+
+	seq_printf(s, "\nSPI transfer statistics of switch %d (write to this file to reset)\n", device_select);
+	sja1105p_spi_stats_show(s, device_select);
+
+	return 0;
+}
+
+static ssize_t sja1105p_spi_statistics_write(struct file* file, const char __user* user_buf, size_t size, loff_t* pos)
+{
+	struct sja1105p_context_data *ctx_data = file->f_inode->i_private;
+
+	sja1105p_spi_stats_reset(ctx_data->device_select);
+
+	return size;
+}
+
+static const char * const sja1105p_reconfiguration_names[SJA1105P_N_RECONFIGURATIONS] = {
+	"l2_address_lookup",
+	"l2_forwarding",
+	"vlan_lookup",
+	"credit_based_shaping",
+	"retagging",
+	"general_parameters",
+	"mac_cfg",
+	"l2_lookup_parameters",
+	"avb_parameters",
+};
+
+static int sja1105p_reconfiguration_stats_show(struct seq_file *s, void *data)
+{
+	struct sja1105p_context_data *ctx_data = s->private;
+	int device_select = ctx_data->device_select;
+	SJA1105P_reconfigurationStats_t stats;
+	int i;
+
+	seq_printf(s, "\nCompletion of dynamic reconfiguration commands of switch %d (write to this file to reset)\n", device_select);
+	seq_printf(s, "%-22s %10s %8s %8s %10s %10s %12s %12s\n",
+		"table", "commands", "timeouts", "errors", "avg polls", "max polls", "avg [ns]", "max [ns]");
+	for (i = 0; i < SJA1105P_N_RECONFIGURATIONS; i++) {
+		if (SJA1105P_getReconfigurationStats(i, &stats, device_select) || !stats.nCommands)
+			continue;
+		seq_printf(s, "%-22s %10u %8u %8u %10llu %10u %12llu %12llu\n",
+			sja1105p_reconfiguration_names[i], stats.nCommands, stats.nTimeouts, stats.nErrors,
+			div_u64(stats.totalPolls, stats.nCommands), stats.maxPolls,
+			div_u64(stats.totalLatencyNs, stats.nCommands), stats.maxLatencyNs);
+	}
+
+	return 0;
+}
+
+static ssize_t sja1105p_reconfiguration_stats_write(struct file* file, const char __user* user_buf, size_t size, loff_t* pos)
+{
+	struct sja1105p_context_data *ctx_data = file->f_inode->i_private;
+
+	SJA1105P_resetReconfigurationStats(ctx_data->device_select);
+
+	return size;
+}
+
+static int sja1105p_spi_calibration_show(struct seq_file *s, void *data)
+{
+	struct sja1105p_context_data *ctx_data = s->private;
+	struct sja1105p_spi_calib_step *step;
+	int i;
+
+	seq_printf(s, "\nSPI clock of switch %d: %u Hz\n", ctx_data->device_select, ctx_data->spi_hz);
+	if (!ctx_data->nb_spi_calib_steps) {
+		seq_printf(s, "Calibration did not run\n");
+		return 0;
+	}
+
+	seq_printf(s, "%10s %8s %8s\n", "rate [Hz]", "words", "errors");
+	for (i = 0; i < ctx_data->nb_spi_calib_steps; i++) {
+		step = &ctx_data->spi_calib[i];
+		seq_printf(s, "%10u %8u %8u\n", step->hz, step->nb_words, step->nb_errors);
+	}
+
+	return 0;
+}
+
 static int sja1105p_register_rw_show(struct seq_file *s, void *data)
 {
 	seq_printf(s, "Read a register: write \"r:REG_ADDR\" to this file, where REG_ADDR is hexadecimal\n");
@@ -331,6 +378,21 @@ static int sja1105p_ethernet_high_level_open(struct inode *inode, struct file *f
 	return single_open(file, sja1105p_ethernet_high_level_show, inode->i_private);
 }
 
+static int sja1105p_spi_statistics_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sja1105p_spi_statistics_show, inode->i_private);
+}
+
+static int sja1105p_spi_calibration_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sja1105p_spi_calibration_show, inode->i_private);
+}
+
+static int sja1105p_reconfiguration_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sja1105p_reconfiguration_stats_show, inode->i_private);
+}
+
 static int sja1105p_register_rw_open(struct inode *inode, struct file *file)
 {
 	return single_open(file, sja1105p_register_rw_show, inode->i_private);
@@ -371,6 +433,29 @@ static const struct file_operations sja1105p_ethernet_high_level_fops = {
 	.llseek		= seq_lseek,
 };
 
+static const struct file_operations sja1105p_spi_stats_fops = {
+	.open		= sja1105p_spi_statistics_open,
+	.release	= single_release,
+	.read		= seq_read,
+	.write		= sja1105p_spi_statistics_write,
+	.llseek		= seq_lseek,
+};
+
+static const struct file_operations sja1105p_spi_calibration_fops = {
+	.open		= sja1105p_spi_calibration_open,
+	.release	= single_release,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+};
+
+static const struct file_operations sja1105p_reconfiguration_stats_fops = {
+	.open		= sja1105p_reconfiguration_stats_open,
+	.release	= single_release,
+	.read		= seq_read,
+	.write		= sja1105p_reconfiguration_stats_write,
+	.llseek		= seq_lseek,
+};
+
 static const struct file_operations sja1105p_register_rw = {
 	.open		= sja1105p_register_rw_open,
 	.release	= single_release,
@@ -400,6 +485,9 @@ void sja1105p_debugfs_init(struct sja1105p_context_data *ctx_data)
 	debugfs_create_file("configuration", S_IRUSR, general_dentry, ctx_data, &sja1105p_general_configuration_fops);
 	debugfs_create_file("registers", S_IRUSR, general_dentry, ctx_data, &sja1105p_general_registers_fops);
 	debugfs_create_file("register_rw", S_IRUSR, general_dentry, ctx_data, &sja1105p_register_rw);
+	debugfs_create_file("spi_stats", S_IRUSR | S_IWUSR, general_dentry, ctx_data, &sja1105p_spi_stats_fops);
+	debugfs_create_file("spi_calibration", S_IRUSR, general_dentry, ctx_data, &sja1105p_spi_calibration_fops);
+	debugfs_create_file("reconfiguration_stats", S_IRUSR | S_IWUSR, general_dentry, ctx_data, &sja1105p_reconfiguration_stats_fops);
 
 	ethernet_dentry = debugfs_create_dir("ethernet", sja_dentry[device_select]);
 	if (!ethernet_dentry)
@@ -36,6 +36,7 @@
 #include "NXP_SJA1105P_ptp.h"
 #include "NXP_SJA1105P_diagnostics.h"
 #include "NXP_SJA1105P_addressResolutionTable.h"
+#include "NXP_SJA1105P_arlCompaction.h"
 #include "NXP_SJA1105P_vlan.h"
 #include "NXP_SJA1105P_spi.h"
 
@@ -73,14 +74,39 @@ EXPORT_SYMBOL(SJA1105P_setPhyPropagationDelay);
 
 EXPORT_SYMBOL(SJA1105P_get32bitEtherStatCounter);
 EXPORT_SYMBOL(SJA1105P_get64bitEtherStatCounter);
+EXPORT_SYMBOL(SJA1105P_getPortCounters);
 
 EXPORT_SYMBOL(SJA1105P_removeArlTableEntryByAddress);
 EXPORT_SYMBOL(SJA1105P_readArlTableEntryByAddress);
 EXPORT_SYMBOL(SJA1105P_readArlTableEntryByIndex);
 EXPORT_SYMBOL(SJA1105P_addArlTableEntry);
+EXPORT_SYMBOL(SJA1105P_updateArlTableEntryPorts);
+EXPORT_SYMBOL(SJA1105P_synchArlOccupancy);
+EXPORT_SYMBOL(SJA1105P_synchArlVlanSwitches);
+EXPORT_SYMBOL(SJA1105P_verifyArlTableEntry);
+EXPORT_SYMBOL(SJA1105P_beginArlBatch);
+EXPORT_SYMBOL(SJA1105P_addArlBatchEntry);
+EXPORT_SYMBOL(SJA1105P_removeArlBatchEntry);
+EXPORT_SYMBOL(SJA1105P_commitArlBatch);
+EXPORT_SYMBOL(SJA1105P_abortArlBatch);
+EXPORT_SYMBOL(SJA1105P_snapshotArlTable);
+EXPORT_SYMBOL(SJA1105P_getArlTableGeneration);
+EXPORT_SYMBOL(SJA1105P_readLearnedArlTableEntries);
+EXPORT_SYMBOL(SJA1105P_compactArlTable);
+EXPORT_SYMBOL(SJA1105P_removeCompactedArlAddress);
+EXPORT_SYMBOL(SJA1105P_findCompactedArlEntry);
+EXPORT_SYMBOL(SJA1105P_getArlCompactionStats);
 
 EXPORT_SYMBOL(SJA1105P_readVlanConfig);
 EXPORT_SYMBOL(SJA1105P_writeVlanConfig);
+EXPORT_SYMBOL(SJA1105P_setVlanPort);
+EXPORT_SYMBOL(SJA1105P_setVlanPortRange);
+EXPORT_SYMBOL(SJA1105P_flushVlanConfig);
+EXPORT_SYMBOL(SJA1105P_getVlanSwitches);
+EXPORT_SYMBOL(SJA1105P_resetVlanShadow);
+EXPORT_SYMBOL(SJA1105P_setPvid);
+EXPORT_SYMBOL(SJA1105P_getPvid);
+EXPORT_SYMBOL(SJA1105P_resetPvid);
 
 EXPORT_SYMBOL(SJA1105P_getPhysicalPort);
 
@@ -0,0 +1,224 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2018 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file  sja1105p_stats.c
+*
+* \author NXP Semiconductors
+*
+* \date 2018-01-15
+*
+* \brief Reads the port counters of each switch at a fixed interval
+*
+* Readers (ndo_get_stats64, debugfs) get the last snapshot without SPI
+* access, they may run in atomic context. The 32-bit counters of the
+* switches wrap after a few hours at line rate, they are extended to
+* 64 bits by accumulating the difference between two reads.
+*
+*****************************************************************************/
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/seqlock.h>
+#include <linux/string.h>
+#include <linux/workqueue.h>
+
+#include "sja1105p_stats.h"
+#include "NXP_SJA1105P_config.h"
+
+#define STATS_MIN_INTERVAL_MS 100
+
+extern int verbosity;
+extern int stats_interval_ms;
+
+/* 32-bit counter values as read from the switch */
+struct sja1105p_stats_raw {
+	u32 counter[SJA1105P_STATS_N_COUNTERS];
+	u32 rx_counter[SJA1105P_STATS_N_DIR_COUNTERS];
+	u32 tx_counter[SJA1105P_STATS_N_DIR_COUNTERS];
+};
+
+/* state of a logical port, written by the collector of its switch only */
+struct sja1105p_stats_port {
+	struct sja1105p_port_stats snapshot;           /* protected by the seqlock of the switch */
+	bool valid;                                    /* protected by the seqlock of the switch */
+	struct sja1105p_stats_raw raw;                 /* counter values of the last read */
+	int switch_id;
+};
+
+struct sja1105p_stats_switch {
+	struct delayed_work work;
+	seqlock_t lock;
+	int switch_id;
+};
+
+static struct sja1105p_stats_port stats_port[SJA1105P_N_LOGICAL_PORTS];
+static struct sja1105p_stats_switch stats_switch[SJA1105P_N_SWITCHES];
+static unsigned long stats_interval;               /* jiffies */
+static bool stats_running;
+
+/* Read all counters of a port, the 32-bit counters are returned unextended */
+static int sja1105p_stats_read(int port, struct sja1105p_port_stats *stats,
+			       struct sja1105p_stats_raw *raw)
+{
+	const int in = SJA1105P_e_etherStatDirection_INGRESS;
+	const int eg = SJA1105P_e_etherStatDirection_EGRESS;
+	SJA1105P_portCounters_t counters;
+	int i;
+
+	/* all counter blocks of the port within one SPI batch */
+	if (SJA1105P_getPortCounters(&counters, port))
+		return -EIO;
+
+	stats->tx_bytes = counters.etherStat64[SJA1105P_e_etherStat64_N_OCTETS][eg];
+	stats->tx_packets = counters.etherStat64[SJA1105P_e_etherStat64_N_PKTS][eg];
+	stats->rx_bytes = counters.etherStat64[SJA1105P_e_etherStat64_N_OCTETS][in];
+	stats->rx_packets = counters.etherStat64[SJA1105P_e_etherStat64_N_PKTS][in];
+
+	/* unidirectional, the other direction is 0 */
+	for (i = 0; i < SJA1105P_STATS_N_COUNTERS; i++)
+		raw->counter[i] = counters.etherStat32[i][in] + counters.etherStat32[i][eg];
+
+	for (i = 0; i < SJA1105P_STATS_N_DIR_COUNTERS; i++) {
+		raw->rx_counter[i] = counters.etherStat32[SJA1105P_STATS_N_COUNTERS + i][in];
+		raw->tx_counter[i] = counters.etherStat32[SJA1105P_STATS_N_COUNTERS + i][eg];
+	}
+
+	stats->mac_errors = counters.macLevelErrors;
+	memcpy(stats->q_occupancy, counters.qOccupancy, sizeof(stats->q_occupancy));
+	memcpy(stats->q_occupancy_high_watt, counters.qOccupancyHighWatt,
+	       sizeof(stats->q_occupancy_high_watt));
+
+	return 0;
+}
+
+/* Extend a 32-bit counter by the difference to its last value */
+static u64 sja1105p_stats_extend(bool valid, u64 last, u32 raw, u32 last_raw)
+{
+	return valid ? last + (u32)(raw - last_raw) : raw;
+}
+
+static void sja1105p_stats_work(struct work_struct *work)
+{
+	struct sja1105p_stats_switch *sw = container_of(to_delayed_work(work),
+						       struct sja1105p_stats_switch,
+						       work);
+	struct sja1105p_stats_port *sp;
+	struct sja1105p_port_stats stats;
+	struct sja1105p_stats_raw raw;
+	int port, i;
+
+	for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++) {
+		sp = &stats_port[port];
+		if (sp->switch_id != sw->switch_id)
+			continue;
+
+		/* SPI access outside of the seqlock, readers only wait for the copy */
+		if (sja1105p_stats_read(port, &stats, &raw)) {
+			if (verbosity > 0)
+				pr_err("sja1105p: could not read the counters of port %d\n", port);
+			continue;
+		}
+
+		write_seqlock(&sw->lock);
+		for (i = 0; i < SJA1105P_STATS_N_COUNTERS; i++)
+			stats.counter[i] = sja1105p_stats_extend(sp->valid, sp->snapshot.counter[i],
+								 raw.counter[i], sp->raw.counter[i]);
+		for (i = 0; i < SJA1105P_STATS_N_DIR_COUNTERS; i++) {
+			stats.rx_counter[i] = sja1105p_stats_extend(sp->valid, sp->snapshot.rx_counter[i],
+								    raw.rx_counter[i], sp->raw.rx_counter[i]);
+			stats.tx_counter[i] = sja1105p_stats_extend(sp->valid, sp->snapshot.tx_counter[i],
+								    raw.tx_counter[i], sp->raw.tx_counter[i]);
+		}
+		sp->snapshot = stats;
+		sp->valid = true;
+		write_sequnlock(&sw->lock);
+
+		sp->raw = raw;
+	}
+
+	schedule_delayed_work(&sw->work, stats_interval);
+}
+
+/* Start one collector per switch, the port mapping must be final */
+void sja1105p_stats_start(void)
+{
+	SJA1105P_port_t physical_port;
+	int port, switch_id;
+
+	if (stats_running)
+		return;
+
+	stats_interval = msecs_to_jiffies(max(stats_interval_ms, STATS_MIN_INTERVAL_MS));
+
+	for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++) {
+		stats_port[port].valid = false;
+		if (SJA1105P_getPhysicalPort(port, &physical_port))
+			stats_port[port].switch_id = -1;
+		else
+			stats_port[port].switch_id = physical_port.switchId;
+	}
+
+	for (switch_id = 0; switch_id < SJA1105P_N_SWITCHES; switch_id++) {
+		stats_switch[switch_id].switch_id = switch_id;
+		seqlock_init(&stats_switch[switch_id].lock);
+		INIT_DELAYED_WORK(&stats_switch[switch_id].work, sja1105p_stats_work);
+		schedule_delayed_work(&stats_switch[switch_id].work, 0);
+	}
+
+	stats_running = true;
+}
+
+/* Stop the collectors before the SPI access to the switches goes away */
+void sja1105p_stats_stop(void)
+{
+	int switch_id;
+
+	if (!stats_running)
+		return;
+
+	for (switch_id = 0; switch_id < SJA1105P_N_SWITCHES; switch_id++)
+		cancel_delayed_work_sync(&stats_switch[switch_id].work);
+
+	stats_running = false;
+}
+
+/* Copy the last snapshot of a port, -EAGAIN until the port was read once */
+int sja1105p_stats_get(int port, struct sja1105p_port_stats *stats)
+{
+	struct sja1105p_stats_port *sp;
+	struct sja1105p_stats_switch *sw;
+	unsigned int seq;
+	bool valid;
+
+	if (port < 0 || port >= SJA1105P_N_LOGICAL_PORTS || !stats_running)
+		return -EINVAL;
+
+	sp = &stats_port[port];
+	if (sp->switch_id < 0)
+		return -EINVAL;
+	sw = &stats_switch[sp->switch_id];
+
+	do {
+		seq = read_seqbegin(&sw->lock);
+		valid = sp->valid;
+		*stats = sp->snapshot;
+	} while (read_seqretry(&sw->lock, seq));
+
+	return valid ? 0 : -EAGAIN;
+}
@@ -41,6 +41,12 @@
 
 #include "typedefs.h"
 
+/******************************************************************************
+* DEFINES
+*****************************************************************************/
+
+#define SJA1105P_N_ARL_ENTRIES 1024U  /**< Number of entries of the address resolution table */
+
 /******************************************************************************
 * TYPE DEFINITIONS
 *****************************************************************************/
@@ -66,11 +72,21 @@ typedef struct
     SJA1105P_extendedAddressResolutionTableEntry_t *p_extension;  /**< Pointer to extension of the entry. If pointer towards NULL, default values are used */
 } SJA1105P_addressResolutionTableEntry_t;
 
+typedef struct
+{
+    uint32_t generation;  /**< Value of ::SJA1105P_getArlTableGeneration at the time the snapshot was taken */
+    uint16_t nEntries;    /**< Number of entries stored in the snapshot */
+    SJA1105P_addressResolutionTableEntry_t entries[SJA1105P_N_ARL_ENTRIES];  /**< Valid entries in ascending order of their index. The extension pointers are NULL. */
+} SJA1105P_arlTableSnapshot_t;
+
 /******************************************************************************
 * EXPORTED FUNCTIONS
 *****************************************************************************/
 
 extern uint8_t SJA1105P_addArlTableEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
+extern uint8_t SJA1105P_updateArlTableEntryPorts(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry, uint16_t previousPorts);
+extern uint8_t SJA1105P_synchArlOccupancy(void);
+extern uint8_t SJA1105P_synchArlVlanSwitches(uint16_t vlanId);
 
 extern uint8_t SJA1105P_readArlTableEntryByAddress(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
 extern uint8_t SJA1105P_readArlTableEntryByIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
@@ -78,6 +94,19 @@ extern uint8_t SJA1105P_readArlTableEntryByIndex(SJA1105P_addressResolutionTable
 extern uint8_t SJA1105P_removeArlTableEntryByAddress(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
 extern uint8_t SJA1105P_removeArlTableEntryByIndex(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry);
 
+extern uint8_t SJA1105P_verifyArlTableEntry(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry);
+
+extern uint8_t SJA1105P_beginArlBatch(void);
+extern uint8_t SJA1105P_addArlBatchEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
+extern uint8_t SJA1105P_removeArlBatchEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
+extern uint8_t SJA1105P_commitArlBatch(void);
+extern void SJA1105P_abortArlBatch(void);
+
+extern uint8_t SJA1105P_snapshotArlTable(SJA1105P_arlTableSnapshot_t *p_snapshot);
+extern uint32_t SJA1105P_getArlTableGeneration(void);
+
+extern uint8_t SJA1105P_readLearnedArlTableEntries(uint16_t firstIndex, uint16_t nIndices, SJA1105P_addressResolutionTableEntry_t *p_entries, uint8_t switchId);
+
 extern uint8_t SJA1105P_enableArlMirroring(uint16_t arlEntryIndex, uint8_t enable);
 extern uint8_t SJA1105P_enableArlRetagging(uint16_t arlEntryIndex, uint16_t retaggingVlanId, uint8_t enable);
 
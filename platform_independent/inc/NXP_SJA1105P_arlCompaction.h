@@ -0,0 +1,87 @@
+/******************************************************************************
+* Copyright (c) NXP B.V. 2016 - 2017. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*****************************************************************************/
+
+/**
+*
+* \file NXP_SJA1105P_arlCompaction.h
+*
+* \author NXP Semiconductors
+*
+* \date 2017-07-04
+*
+* \brief Compaction of static address resolution entries into masked entries
+*
+*****************************************************************************/
+
+#ifndef NXP_SJA1105P_ARLCOMPACTION_H
+#define NXP_SJA1105P_ARLCOMPACTION_H
+
+/******************************************************************************
+* INCLUDES
+*****************************************************************************/
+
+#include "typedefs.h"
+#include "NXP_SJA1105P_addressResolutionTable.h"
+
+/******************************************************************************
+* DEFINES
+*****************************************************************************/
+
+#define SJA1105P_MAC_ADDRESS_BITS 48U  /**< Prefix length of an entry matching a single MAC address */
+
+/******************************************************************************
+* TYPE DEFINITIONS
+*****************************************************************************/
+
+typedef struct
+{
+    uint64_t dstMacAddress;  /**< Destination MAC address, most significant octet first (first octet on the wire in bits 47..40) */
+    uint16_t vlanId;         /**< VLAN ID */
+    uint16_t ports;          /**< Logical ports to which frames carrying the address are forwarded */
+} SJA1105P_arlCompactionEntry_t;
+
+typedef struct
+{
+    uint64_t dstMacAddress;  /**< First MAC address of the block, most significant octet first */
+    uint16_t vlanId;         /**< VLAN ID */
+    uint16_t ports;          /**< Logical ports to which frames carrying an address of the block are forwarded */
+    uint16_t index;          /**< Index of the entry within the address resolution table */
+    uint8_t  prefixLength;   /**< Number of leading MAC address bits matched, ::SJA1105P_MAC_ADDRESS_BITS for a single address */
+} SJA1105P_arlCompactedEntry_t;
+
+typedef struct
+{
+    uint32_t nAddresses;   /**< Number of (MAC, VLAN) pairs covered by the compacted entries */
+    uint16_t nEntries;     /**< Number of address resolution table entries used */
+    uint32_t nSlotsSaved;  /**< Entries saved compared to one exact entry per address */
+} SJA1105P_arlCompactionStats_t;
+
+/******************************************************************************
+* EXPORTED FUNCTIONS
+*****************************************************************************/
+
+extern uint8_t SJA1105P_compactArlTable(SJA1105P_arlCompactionEntry_t *p_entries, uint32_t nEntries);
+extern uint8_t SJA1105P_removeCompactedArlAddress(uint64_t dstMacAddress, uint16_t vlanId);
+extern uint8_t SJA1105P_findCompactedArlEntry(uint64_t dstMacAddress, uint16_t vlanId, SJA1105P_arlCompactedEntry_t *p_compactedEntry);
+extern void SJA1105P_getArlCompactionStats(SJA1105P_arlCompactionStats_t *p_stats);
+
+#endif /* NXP_SJA1105P_ARLCOMPACTION_H */
@@ -44,6 +44,15 @@
 #include "NXP_SJA1105P_config.h"
 #include "NXP_SJA1105P_auxiliaryConfigurationUnit.h"
 
+/******************************************************************************
+* DEFINES
+*****************************************************************************/
+
+#define SJA1105P_N_ETHER_STAT_DIRECTIONS (2U)  /**< Ingress and egress, the directions of a counter in ::SJA1105P_portCounters_t */
+#define SJA1105P_N_ETHER_STAT32 ((uint8_t) SJA1105P_e_etherStat32_N_BROADCAST_PKTS + 1U)  /**< Number of ::SJA1105P_etherStat32_t counters */
+#define SJA1105P_N_ETHER_STAT64 ((uint8_t) SJA1105P_e_etherStat64_N_PKTS + 1U)            /**< Number of ::SJA1105P_etherStat64_t counters */
+#define SJA1105P_N_EGRESS_QUEUES (8U)  /**< Number of priority queues of a port */
+
 /******************************************************************************
 * TYPE DEFINITIONS
 *****************************************************************************/
@@ -101,6 +110,15 @@ typedef struct
 	uint32_t nMiierr;    /**< This field counts the number of frames that started with a valid start sequence (preamble plus SOF delimiter byte) but terminated with the MII error input being asserted. The field will not wrap. */
 } SJA1105P_macLevelErrors_t;
 
+typedef struct
+{
+	uint64_t etherStat64[SJA1105P_N_ETHER_STAT64][SJA1105P_N_ETHER_STAT_DIRECTIONS];  /**< 64-bit counters, indexed by ::SJA1105P_etherStat64_t and by the ingress or egress ::SJA1105P_etherStatDirection_t */
+	uint32_t etherStat32[SJA1105P_N_ETHER_STAT32][SJA1105P_N_ETHER_STAT_DIRECTIONS];  /**< 32-bit counters, indexed by ::SJA1105P_etherStat32_t and by the ingress or egress ::SJA1105P_etherStatDirection_t. A unidirectional counter is found at the direction it counts (N_NOT_REACH, N_EGR_DISABLED and N_QFULL at egress, the others at ingress), the other direction is 0 */
+	SJA1105P_macLevelErrors_t macLevelErrors;               /**< MAC level errors, accumulated together with ::SJA1105P_getMacErrors */
+	uint8_t qOccupancy[SJA1105P_N_EGRESS_QUEUES];          /**< Number of frames stored in each priority queue of the port */
+	uint8_t qOccupancyHighWatt[SJA1105P_N_EGRESS_QUEUES];  /**< Highest watermark of the occupancy of each priority queue of the port */
+} SJA1105P_portCounters_t;  /**< All counters of a port, see ::SJA1105P_getPortCounters */
+
 /******************************************************************************
 * EXPORTED FUNCTIONS
 *****************************************************************************/
@@ -109,6 +127,7 @@ extern uint8_t SJA1105P_get64bitEtherStatCounter(SJA1105P_etherStat64_t counterN
 extern uint8_t SJA1105P_get32bitEtherStatCounter(SJA1105P_etherStat32_t counterName, uint32_t *p_counterValue, uint8_t port, SJA1105P_etherStatDirection_t direction);
 
 extern uint8_t SJA1105P_getMacErrors(SJA1105P_macLevelErrors_t *p_macLevelErrors, uint8_t port);
+extern uint8_t SJA1105P_getPortCounters(SJA1105P_portCounters_t *p_portCounters, uint8_t port);
 
 extern uint8_t SJA1105P_getTemperature(SJA1105P_tempThreshold_t a_temperature[SJA1105P_N_SWITCHES]);
 
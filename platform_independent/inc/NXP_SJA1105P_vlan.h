@@ -59,14 +59,25 @@ typedef enum
 extern uint8_t SJA1105P_writeVlanConfig(uint16_t vlanId, const SJA1105P_vlanForwarding_t *pk_vlanForwarding, uint16_t enable);
 extern uint8_t SJA1105P_readVlanConfig(uint16_t vlanId, SJA1105P_vlanForwarding_t *p_vlanForwarding, uint16_t *p_enable);
 extern uint8_t SJA1105P_enableVlan(uint16_t vlanId, uint8_t ingressPort, uint8_t enable);
+extern uint8_t SJA1105P_setVlanPort(uint16_t vlanId, uint8_t port, SJA1105P_vlanForwarding_t forwarding, uint8_t enable);
+extern uint8_t SJA1105P_setVlanPortRange(uint16_t firstVlanId, uint16_t lastVlanId, uint8_t port, SJA1105P_vlanForwarding_t forwarding, uint8_t enable);
+extern uint8_t SJA1105P_flushVlanConfig(void);
+
+extern uint8_t SJA1105P_getVlanSwitches(uint16_t vlanId);
+extern void SJA1105P_resetVlanShadow(void);
+
+extern uint8_t SJA1105P_setPvid(uint8_t port, uint16_t vlanId);
+extern uint8_t SJA1105P_getPvid(uint8_t port, uint16_t *p_vlanId);
+extern uint8_t SJA1105P_resetPvid(uint8_t port);
 
 extern uint8_t SJA1105P_enableVlanIngressMirroring(uint16_t vlanId, uint8_t ingressPort, uint8_t enable);
 extern uint8_t SJA1105P_enableVlanEgressMirroring(uint16_t vlanId, uint8_t egressPort, uint8_t enable);
 
 extern uint8_t SJA1105P_startRetagging(uint16_t ingressPorts, uint16_t egressPorts, uint16_t ingressVlanId, uint16_t egressVlanId);
-extern uint8_t SJA1105P_stopRetagging(uint16_t egressVlanId);
+extern uint8_t SJA1105P_stopRetagging(uint16_t ingressPorts, uint16_t egressPorts, uint16_t ingressVlanId, uint16_t egressVlanId);
 
 extern uint8_t SJA1105P_enableBypassing(uint16_t vlanId, uint16_t destPorts, uint8_t learningDisabled);
 extern uint8_t SJA1105P_disableBypassing(uint16_t vlanId);
+extern void SJA1105P_resetRetagging(void);
 
 #endif /* NXP_SJA1105P_VLAN_H */
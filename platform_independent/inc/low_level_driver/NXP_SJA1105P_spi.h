@@ -43,6 +43,15 @@
 
 #include "typedefs.h"
 
+/******************************************************************************
+* DEFINES
+*****************************************************************************/
+
+#ifndef SJA1105P_REGISTER_CACHE
+	/* default assumption: static configuration registers are shadowed */
+	#define SJA1105P_REGISTER_CACHE 1U  /**< Keep a write-through shadow of registers that are only modified by the driver (CGU, ACU pad configuration) */
+#endif
+
 /******************************************************************************
 * TYPE DEFINITIONS
 *****************************************************************************/
@@ -50,6 +59,17 @@
 typedef uint8_t (*SJA1105P_spiRead32_cb_t)(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);  /**< Type of the function used to perform read operations via SPI */
 typedef uint8_t (*SJA1105P_spiWrite32_cb_t)(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);  /**< Type of the function used to perform write operations via SPI */
 
+typedef void (*SJA1105P_spiComplete_cb_t)(uint8_t deviceSelect, uint8_t status, void *p_context);  /**< Type of the function notified when a queued SPI batch was transferred (status 0: success, else failed) */
+typedef uint8_t (*SJA1105P_spiQueueStart_cb_t)(uint8_t deviceSelect);  /**< Type of the function used to open a batch of queued SPI operations */
+typedef uint8_t (*SJA1105P_spiQueueRead32_cb_t)(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);  /**< Type of the function used to queue a read operation, the result is valid after commit */
+typedef uint8_t (*SJA1105P_spiQueueCommit_cb_t)(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context);  /**< Type of the function used to transfer and close a batch of queued SPI operations */
+
+typedef uint8_t (*SJA1105P_switchJob_cb_t)(uint8_t switchId, void *p_context);  /**< Type of a job executed once for each switch (return 0: success, else failed) */
+typedef uint8_t (*SJA1105P_forEachSwitch_cb_t)(SJA1105P_switchJob_cb_t pf_job, void *p_context);  /**< Type of the function used to execute a job for all switches, returns the sum of the job results */
+
+typedef void (*SJA1105P_waitUs_cb_t)(uint32_t waitUs);  /**< Type of the function used to suspend the caller for at least waitUs microseconds, it may sleep */
+typedef uint64_t (*SJA1105P_getTimeNs_cb_t)(void);  /**< Type of the function used to read a monotonic time in nanoseconds */
+
 /******************************************************************************
 * EXPORTED VARIABLES
 *****************************************************************************/
@@ -64,4 +84,24 @@ extern SJA1105P_spiWrite32_cb_t SJA1105P_gpf_spiWrite32;  /**< Callback function
 extern void SJA1105P_registerSpiRead32CB(SJA1105P_spiRead32_cb_t pf_spiRead32);  /**< Function used to register the callback function to perform read operations via SPI */
 extern void SJA1105P_registerSpiWrite32CB(SJA1105P_spiWrite32_cb_t pf_spiWrite32);  /**< Function used to register the callback function to perform write operations via SPI */
 
+extern void SJA1105P_registerSpiQueueStartCB(SJA1105P_spiQueueStart_cb_t pf_spiQueueStart);  /**< Function used to register the callback function to open a batch of queued SPI operations */
+extern void SJA1105P_registerSpiQueueRead32CB(SJA1105P_spiQueueRead32_cb_t pf_spiQueueRead32);  /**< Function used to register the callback function to queue read operations */
+extern void SJA1105P_registerSpiQueueCommitCB(SJA1105P_spiQueueCommit_cb_t pf_spiQueueCommit);  /**< Function used to register the callback function to transfer a batch of queued SPI operations */
+
+extern void SJA1105P_registerForEachSwitchCB(SJA1105P_forEachSwitch_cb_t pf_forEachSwitch);  /**< Function used to register the callback function to execute a job for all switches, e.g. concurrently */
+
+extern void SJA1105P_registerWaitUsCB(SJA1105P_waitUs_cb_t pf_waitUs);  /**< Function used to register the callback function to wait for a completion without spinning */
+extern void SJA1105P_registerGetTimeNsCB(SJA1105P_getTimeNs_cb_t pf_getTimeNs);  /**< Function used to register the callback function to measure durations */
+
+extern void SJA1105P_invalidateRegisterCache(uint8_t deviceSelect);
+
+extern uint8_t SJA1105P_spiQueueStart(uint8_t deviceSelect);
+extern uint8_t SJA1105P_spiQueueRead32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+extern uint8_t SJA1105P_spiQueueCommit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context);
+
+extern uint8_t SJA1105P_forEachSwitch(SJA1105P_switchJob_cb_t pf_job, void *p_context);
+
+extern void SJA1105P_waitUs(uint32_t waitUs);
+extern uint64_t SJA1105P_getTimeNs(void);
+
 #endif  /* NXP_SJA1105P_SPI_H */
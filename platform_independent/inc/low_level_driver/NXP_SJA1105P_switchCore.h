@@ -43,6 +43,26 @@
 
 #include "typedefs.h"
 
+/******************************************************************************
+* DEFINES
+*****************************************************************************/
+
+#define SJA1105P_L2_ART_LOCKED_ENTRY_WORDS (5U)  /**< Number of raw words of the l2_art_locked_entry register */
+#define SJA1105P_VLAN_LOOKUP_TABLE_ENTRY_WORDS (2U)  /**< Number of raw words of the vlan_lookup_table_entry register */
+#define SJA1105P_HL_DIAGN_COUNTERS_1_WORDS (16U)  /**< Number of raw words of the hl_diagn_counters_1 block of a port */
+#define SJA1105P_HL_DC_1_0_N_TXBYTE_SHIFT_OVLP (32U)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_TXBYTE field */
+#define SJA1105P_HL_DC_1_1_N_TXFRM_SHIFT_OVLP  (32U)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_TXFRM field */
+#define SJA1105P_HL_DC_1_2_N_RXBYTE_SHIFT_OVLP (32U)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_RXBYTE field */
+#define SJA1105P_HL_DC_1_3_N_RXFRM_SHIFT_OVLP  (32U)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_RXFRM field */
+#define SJA1105P_HL_DIAGN_COUNTERS_2_WORDS (12U)  /**< Number of raw words of the hl_diagn_counters_2 block of a port, including the occupancy of the queues */
+#define SJA1105P_ETH_STAT_COUNTERS_WORDS   (23U)  /**< Number of raw words of the eth_stat_counters block of a port */
+
+#define SJA1105P_N_RECONFIGURATIONS (9U)  /**< Number of dynamic reconfiguration control registers, see ::SJA1105P_reconfiguration_t */
+
+#ifndef SJA1105P_RECONFIGURATION_TIMEOUT_US
+	#define SJA1105P_RECONFIGURATION_TIMEOUT_US (10000U)  /**< Time after which a dynamic reconfiguration command that is still pending is reported as failed */
+#endif
+
 /******************************************************************************
 * TYPE DEFINITIONS
 *****************************************************************************/
@@ -55,6 +75,19 @@ typedef enum
 	SJA1105P_e_switchSpeed_DISABLED = 0   /**< Port disabled */
 } SJA1105P_switchSpeed_t;
 
+typedef enum 
+{
+	SJA1105P_e_reconfiguration_L2_ADDRESS_LOOKUP     = 0,  /**< l2_address_lookup_table_control */
+	SJA1105P_e_reconfiguration_L2_FORWARDING         = 1,  /**< l2_forwarding_table_control */
+	SJA1105P_e_reconfiguration_VLAN_LOOKUP           = 2,  /**< vlan_lookup_table_control */
+	SJA1105P_e_reconfiguration_CREDIT_BASED_SHAPING  = 3,  /**< credit_based_shaping_control */
+	SJA1105P_e_reconfiguration_RETAGGING             = 4,  /**< retagging_table_control */
+	SJA1105P_e_reconfiguration_GENERAL_PARAMETERS    = 5,  /**< general_parameters_control */
+	SJA1105P_e_reconfiguration_MAC_CFG               = 6,  /**< mac_cfg_table_control */
+	SJA1105P_e_reconfiguration_L2_LOOKUP_PARAMETERS  = 7,  /**< l2_lookup_parameters_control */
+	SJA1105P_e_reconfiguration_AVB_PARAMETERS        = 8   /**< avb_parameters_control */
+} SJA1105P_reconfiguration_t;
+
 typedef enum 
 {
 	SJA1105P_e_hostCmd_WRITE      = 3,  /**< Host write */
@@ -430,6 +463,17 @@ typedef struct
 	uint8_t rdwrset;  /**< The host sets this flag to trigger a dynamic change in the entry indicated by INDEX */
 } SJA1105P_avbParametersControlArgument_t;
 
+typedef struct
+{
+	uint32_t nCommands;       /**< Number of commands waited for */
+	uint32_t nTimeouts;       /**< Number of commands still pending after ::SJA1105P_RECONFIGURATION_TIMEOUT_US */
+	uint32_t nErrors;         /**< Number of commands completed with the ERRORS flag set */
+	uint32_t maxPolls;        /**< Highest number of control register reads needed by a command */
+	uint64_t totalPolls;      /**< Sum of the control register reads of all commands */
+	uint64_t totalLatencyNs;  /**< Sum of the completion latencies of all commands in ns, 0 if the platform provides no time */
+	uint64_t maxLatencyNs;    /**< Highest completion latency of a command in ns */
+} SJA1105P_reconfigurationStats_t;
+
 /******************************************************************************
 * EXPORTED FUNCTIONS
 *****************************************************************************/
@@ -487,10 +531,14 @@ extern uint8_t SJA1105P_getL2ArtEntry(SJA1105P_l2ArtEntryArgument_t *p_l2ArtEntr
 /* register category l2_art_locked_entry */
 extern uint8_t SJA1105P_setL2ArtLockedEntry(const SJA1105P_l2ArtLockedEntryArgument_t *pk_l2ArtLockedEntry, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getL2ArtLockedEntry(SJA1105P_l2ArtLockedEntryArgument_t *p_l2ArtLockedEntry, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetL2ArtLockedEntry(uint32_t *p_registerValue, uint8_t deviceSelect);
+extern void SJA1105P_decodeL2ArtLockedEntry(const uint32_t *kp_registerValue, SJA1105P_l2ArtLockedEntryArgument_t *p_l2ArtLockedEntry);
 
 /* register category l2_address_lookup_table_control */
 extern uint8_t SJA1105P_setL2AddressLookupTableControl(const SJA1105P_l2AddressLookupTableControlSetArgument_t *pk_l2AddressLookupTableControl, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getL2AddressLookupTableControl(SJA1105P_l2AddressLookupTableControlGetArgument_t *p_l2AddressLookupTableControl, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetL2AddressLookupTableControl(uint32_t *p_registerValue, uint8_t deviceSelect);
+extern void SJA1105P_decodeL2AddressLookupTableControl(uint32_t registerValue, SJA1105P_l2AddressLookupTableControlGetArgument_t *p_l2AddressLookupTableControl);
 
 /* register category l2_forwarding_table_entry */
 extern uint8_t SJA1105P_setL2ForwardingTableEntry(const SJA1105P_l2ForwardingTableEntryArgument_t *pk_l2ForwardingTableEntry, uint8_t deviceSelect);
@@ -503,10 +551,14 @@ extern uint8_t SJA1105P_getL2ForwardingTableControl(uint8_t *p_errors, uint8_t d
 /* register category vlan_lookup_table_entry */
 extern uint8_t SJA1105P_setVlanLookupTableEntry(const SJA1105P_vlanLookupTableEntryArgument_t *pk_vlanLookupTableEntry, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getVlanLookupTableEntry(SJA1105P_vlanLookupTableEntryArgument_t *p_vlanLookupTableEntry, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetVlanLookupTableEntry(uint32_t *p_registerValue, uint8_t deviceSelect);
+extern void SJA1105P_decodeVlanLookupTableEntry(const uint32_t *kp_registerValue, SJA1105P_vlanLookupTableEntryArgument_t *p_vlanLookupTableEntry);
 
 /* register category vlan_lookup_table_control */
 extern uint8_t SJA1105P_setVlanLookupTableControl(const SJA1105P_vlanLookupTableControlArgument_t *pk_vlanLookupTableControl, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getVlanLookupTableControl(uint8_t *p_valident, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetVlanLookupTableControl(uint32_t *p_registerValue, uint8_t deviceSelect);
+extern void SJA1105P_decodeVlanLookupTableControl(uint32_t registerValue, SJA1105P_vlanLookupTableControlArgument_t *p_vlanLookupTableControl);
 
 /* register category credit_based_shaping_entry */
 extern uint8_t SJA1105P_setCreditBasedShapingEntry(const SJA1105P_creditBasedShapingEntryArgument_t *pk_creditBasedShapingEntry, uint8_t deviceSelect);
@@ -557,6 +609,8 @@ extern uint8_t SJA1105P_getL2MemoryPartitionStatus(SJA1105P_l2MemoryPartitionSta
 
 /* register category mac_level_diagn_counters */
 extern uint8_t SJA1105P_getMacLevelDiagnCounters(SJA1105P_macLevelDiagnCountersArgument_t *p_macLevelDiagnCounters, uint8_t port, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetMacLevelDiagnCounters(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect);
+extern void SJA1105P_decodeMacLevelDiagnCounters(uint32_t registerValue, SJA1105P_macLevelDiagnCountersArgument_t *p_macLevelDiagnCounters);
 
 /* register category mac_level_diagn_flags */
 extern uint8_t SJA1105P_getMacLevelDiagnFlags(SJA1105P_macLevelDiagnFlagsArgument_t *p_macLevelDiagnFlags, uint8_t port, uint8_t deviceSelect);
@@ -571,6 +625,7 @@ extern uint8_t SJA1105P_getHlDiagnCounters15(uint32_t *p_nCrcerr, uint8_t port,
 extern uint8_t SJA1105P_getHlDiagnCounters16(uint32_t *p_nSizeerr, uint8_t port, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getHlDiagnCounters17(uint32_t *p_nVlanerr, uint8_t port, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getHlDiagnCounters18(uint32_t *p_nN664err, uint8_t port, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetHlDiagnCounters1(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect);
 
 /* register category hl_diagn_counters_2 */
 extern uint8_t SJA1105P_getHlDiagnCounters20(uint32_t *p_notReach, uint8_t port, uint8_t deviceSelect);
@@ -580,6 +635,8 @@ extern uint8_t SJA1105P_getHlDiagnCounters23(uint32_t *p_qfull, uint8_t port, ui
 
 /* register category hl_diagn_counters_occupancy */
 extern uint8_t SJA1105P_getHlDiagnCountersOccupancy(SJA1105P_hlDiagnCountersOccupancyArgument_t *p_hlDiagnCountersOccupancy, uint8_t port, uint8_t queue, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetHlDiagnCounters2(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect);
+extern void SJA1105P_decodeHlDiagnCountersOccupancy(uint32_t registerValue, SJA1105P_hlDiagnCountersOccupancyArgument_t *p_hlDiagnCountersOccupancy);
 
 /* register category l2_memory_partition_error_counters */
 extern uint8_t SJA1105P_getL2MemoryPartitionErrorCounters(uint32_t *p_nL2pspcdrn, uint8_t partition, uint8_t deviceSelect);
@@ -608,6 +665,7 @@ extern uint8_t SJA1105P_getEthStatCounters19(uint32_t *p_ingDoubleTaggedDrop, ui
 extern uint8_t SJA1105P_getEthStatCounters20(uint32_t *p_ingIllegalDoubleTaggedDrop, uint8_t port, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getEthStatCounters21(uint32_t *p_ingEmptyRouteDrop, uint8_t port, uint8_t deviceSelect);
 extern uint8_t SJA1105P_getEthStatCounters22(uint32_t *p_ingAddrNotLearnedDrop, uint8_t port, uint8_t deviceSelect);
+extern uint8_t SJA1105P_queueGetEthStatCounters(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect);
 
 /* register category l2_forwarding_parameters */
 extern uint8_t SJA1105P_getL2ForwardingParameters(SJA1105P_l2ForwardingParametersArgument_t *p_l2ForwardingParameters, uint8_t deviceSelect);
@@ -622,4 +680,9 @@ extern uint8_t SJA1105P_getAvbParametersControl(uint8_t *p_errors, uint8_t devic
 
 extern SJA1105P_hostCmd_t SJA1105P_convertToHostCmd(uint32_t stdintValue);
 
+/* completion of dynamic reconfiguration commands */
+extern uint8_t SJA1105P_waitReconfiguration(SJA1105P_reconfiguration_t reconfiguration, uint32_t *p_registerValue, uint8_t deviceSelect);
+extern uint8_t SJA1105P_getReconfigurationStats(SJA1105P_reconfiguration_t reconfiguration, SJA1105P_reconfigurationStats_t *p_stats, uint8_t deviceSelect);
+extern void SJA1105P_resetReconfigurationStats(uint8_t deviceSelect);
+
 #endif  /* NXP_SJA1105P_SWITCHCORE_H */
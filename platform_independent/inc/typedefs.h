@@ -45,6 +45,7 @@
 	#include <linux/types.h>
 #else
     #include <stdint.h>
+    #include <stdbool.h>
 #endif
 
 /******************************************************************************
@@ -38,316 +38,1752 @@
 
 #include "NXP_SJA1105P_config.h"
 #include "NXP_SJA1105P_switchCore.h"
+#include "NXP_SJA1105P_spi.h"
 #include "NXP_SJA1105P_addressResolutionTable.h"
+#include "NXP_SJA1105P_vlan.h"
 
 /******************************************************************************
 * Defines
 *****************************************************************************/
 
-#define N_ARL_ENTRIES 1024U
+#define N_ARL_ENTRIES SJA1105P_N_ARL_ENTRIES
+
+#define OCCUPANCY_WORD_BITS 32U
+#define N_OCCUPANCY_WORDS   (N_ARL_ENTRIES / OCCUPANCY_WORD_BITS)  /* must not exceed OCCUPANCY_WORD_BITS, see g_arlFullWords */
+#define FULL_WORD           (0xFFFFFFFFUL)
+#define DEBRUIJN_32         (0x077CB531UL)
+
+#define N_KEY_BUCKETS   256U           /* power of two */
+#define KEY_BUCKET_BITS 8U
+#define GOLDEN_RATIO_32 (0x9E3779B1UL)
+
+#define N_PIPELINED_READS  16U  /* TCAM reads transferred within one SPI batch */
+#define N_PIPELINED_WRITES 16U  /* TCAM writes transferred within one SPI batch */
+
+#define NO_BATCH_OP N_ARL_ENTRIES
 
 #define MAC_ADDRESS_BYTES 6U
-#define MAC_ADDRESS_MASK  (0xFFFFFFFFFFUL)
+#define MAC_ADDRESS_MASK  (0xFFFFFFFFFFFFULL)
+#define EXACT_MATCH_MASK  (0x1FFFFFFFFFFFFFFFULL)  /* INNER_OUTER_VLAN, VLANID and MACADDR are compared */
+#define VLAN_ID_MASK      (0x0FFFU)
 
 #define BYTE 8U
 
+#define ALL_SWITCHES      ((uint8_t) ((1U << SJA1105P_N_SWITCHES) - 1U))
+#define MASTER_SWITCH_BIT ((uint8_t) (((uint8_t) 1) << SJA1105P_MASTER_SWITCH))
+
+/******************************************************************************
+* TYPE DEFINITIONS
+*****************************************************************************/
+
+/* arguments of the per switch jobs, see SJA1105P_forEachSwitch */
+typedef struct
+{
+	const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry;
+	uint16_t index;
+	uint8_t  firstDestSwitchId;
+	uint8_t  lastDestSwitchId;
+	uint8_t  switches;             /* one bit per switch to be written */
+	uint8_t  invalidatedSwitches;  /* one bit per switch of which the copy is removed */
+} arlWriteJob_t;
+
+typedef struct
+{
+	uint16_t index;
+	uint8_t  switches;  /* one bit per switch to be read, the entries of the other switches are empty */
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry[SJA1105P_N_SWITCHES];
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus[SJA1105P_N_SWITCHES];
+} arlReadJob_t;
+
+typedef struct
+{
+	uint16_t index;
+	uint16_t retaggingVlanId;
+	uint8_t  enable;
+	uint8_t  switches;  /* one bit per switch to be modified */
+} arlModifyJob_t;
+
+typedef struct
+{
+	const SJA1105P_arlTableSnapshot_t *kp_snapshot;
+} arlSnapshotJob_t;
+
+typedef struct
+{
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;  /* entry in the master switch, the destination ports are derived from ports */
+	uint16_t ports;  /* logical destination ports */
+	uint8_t  valid;  /* 0 if the index is invalidated */
+} arlBatchContent_t;
+
+typedef struct
+{
+	arlBatchContent_t next;  /* content written by the commit */
+	arlBatchContent_t prev;  /* content before the batch, restored by a rollback */
+} arlBatchOp_t;
+
+typedef struct
+{
+	uint8_t rollback;  /* 0: write the next content, 1: write the previous content */
+} arlBatchJob_t;
+
 /******************************************************************************
 * INTERNAL VARIABLES
 *****************************************************************************/
 
+/* Occupancy of the static entries in the master switch. An index is occupied
+ * if it holds a valid, locked entry. Learned entries may be overwritten. */
+static uint32_t g_arlOccupancy[N_OCCUPANCY_WORDS];  /**< one bit per index, set if occupied */
+static uint32_t g_arlFullWords = 0;                 /**< one bit per word of g_arlOccupancy, set if all its indices are occupied */
+static uint8_t  g_arlOccupancyValid = 0;            /**< the bitmap and the key index reflect the hardware */
+
+/* Index of the occupied entries by (MAC, VLAN), chained per bucket */
+static uint16_t g_arlKeyBucket[N_KEY_BUCKETS];  /**< first index of the chain, N_ARL_ENTRIES if empty */
+static uint16_t g_arlKeyNext[N_ARL_ENTRIES];    /**< next index in the same chain, N_ARL_ENTRIES at the end */
+static uint64_t g_arlKeyMac[N_ARL_ENTRIES];     /**< MAC address of the entry at this index */
+static uint16_t g_arlKeyVlan[N_ARL_ENTRIES];    /**< VLAN ID of the entry at this index */
+
+/* Switches holding a copy of the static entry at an index. Frames of a VLAN are only
+ * forwarded by the switches in which the VLAN is configured, an entry matching one VLAN
+ * is only needed there. The master switch holds all entries. */
+static uint8_t g_arlSwitches[N_ARL_ENTRIES];  /**< one bit per switch, cleared if the switch is known to hold no static entry at this index */
+static uint8_t g_arlVlanPruning = 0;          /**< 1 if the VLAN ID is part of the lookup key, see SHARED_LEARN */
+
+/* Incremented whenever the driver modifies the table */
+static uint32_t g_arlGeneration = 0;
+
+/* Physical ports found in the cascaded switches, by position within the snapshot */
+static uint8_t g_arlSnapshotPorts[SJA1105P_N_SWITCHES][N_ARL_ENTRIES];
+
+/* Logical ports found in the cascaded switches, by operation of the batch */
+static uint16_t g_arlBatchBackupPorts[SJA1105P_N_SWITCHES][N_ARL_ENTRIES];
+
+/* Batch of modifications, at most one operation per index */
+static arlBatchOp_t g_arlBatchOps[N_ARL_ENTRIES];
+static uint16_t g_arlBatchOpOfIndex[N_ARL_ENTRIES];  /**< position within g_arlBatchOps, NO_BATCH_OP if the index is not modified */
+static uint16_t g_arlBatchNOps = 0;
+static uint8_t  g_arlBatchOpen = 0;
+
+/* bit position of a power of two, indexed by ((value * DEBRUIJN_32) >> 27) */
+static const uint8_t gk_debruijnBitPosition[OCCUPANCY_WORD_BITS] = {
+	0U,  1U,  28U, 2U,  29U, 14U, 24U, 3U,  30U, 22U, 20U, 15U, 25U, 17U, 4U,  8U,
+	31U, 27U, 13U, 23U, 21U, 19U, 16U, 7U,  26U, 12U, 18U, 6U,  11U, 5U,  10U, 9U
+};
+
 /******************************************************************************
 * INTERNAL FUNCTION DECLARATIONS
 *****************************************************************************/
 
 static uint8_t findEntryIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
+static uint8_t searchEntryIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry);
 static uint8_t findFreeEntry(uint16_t *p_freeEntryIndex, uint8_t switchId);
+static void setEntryOccupancy(uint16_t index, uint8_t occupied);
+static uint8_t isEntryOccupied(uint16_t index);
+static uint8_t getEntrySwitches(uint16_t index);
+static uint8_t getIndexSwitches(uint16_t index);
+static uint8_t getRequiredSwitches(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry);
+static void setEntrySwitches(uint16_t index, uint8_t switches, uint8_t written);
+static uint16_t getKeyBucket(uint64_t macAddress, uint16_t vlanId);
+static void linkEntryKey(uint16_t index, uint64_t macAddress, uint16_t vlanId);
+static void unlinkEntryKey(uint16_t index);
+static uint8_t findFirstZeroBit(uint32_t value);
+static arlBatchOp_t *getBatchOp(uint16_t index);
+static void rollbackBatchOccupancy(void);
 static uint8_t executeTcamCommand(SJA1105P_hostCmd_t hostCmd, SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, SJA1105P_l2AddressLookupTableControlGetArgument_t *p_physicalArlTableStatus, uint8_t switchId);
 
+static uint8_t readEntryBatch(const uint16_t *kp_index, uint8_t nEntries, SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, SJA1105P_l2AddressLookupTableControlGetArgument_t *p_physicalArlTableStatus, uint8_t switchId);
+static uint8_t writeEntryBatch(const SJA1105P_l2ArtLockedEntryArgument_t *kp_physicalArlTableEntry, const SJA1105P_hostCmd_t *kp_hostCmd, uint8_t nEntries, uint8_t switchId);
+
+static uint8_t writeEntryJob(uint8_t switchId, void *p_context);
+static uint8_t snapshotPortsJob(uint8_t switchId, void *p_context);
+static uint8_t readBatchBackup(uint8_t switchId);
+static uint8_t readEntryJob(uint8_t switchId, void *p_context);
+static uint8_t invalidateEntryJob(uint8_t switchId, void *p_context);
+static uint8_t enableMirroringJob(uint8_t switchId, void *p_context);
+static uint8_t enableRetaggingJob(uint8_t switchId, void *p_context);
+static uint8_t backupBatchJob(uint8_t switchId, void *p_context);
+static uint8_t writeBatchJob(uint8_t switchId, void *p_context);
+
 static void convertToPhysicalEntry(const SJA1105P_addressResolutionTableEntry_t *kp_arlTableEntry, SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, uint8_t switchId);
 static void convertFromPhysicalEntry(SJA1105P_addressResolutionTableEntry_t *p_arlTableEntry, const SJA1105P_l2ArtLockedEntryArgument_t *kp_physicalArlTableEntry, uint8_t switchId);
+static void getDestSwitchRange(uint16_t ports, uint8_t *p_firstDestSwitchId, uint8_t *p_lastDestSwitchId);
+static void addInterSwitchForwarding(SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, uint8_t firstDestSwitchId, uint8_t lastDestSwitchId, uint8_t switchId);
+
+/******************************************************************************
+* FUNCTIONS
+*****************************************************************************/
+
+/**
+* \brief Insert an entry into the Address Resolution Table.
+*
+* If an entry with the same MAC address and VLAN ID exists already, it is overwritten in place.
+* An entry matching a single VLAN is only written to the master switch and to the switches in which
+* the VLAN is configured, see ::SJA1105P_getVlanSwitches. Copies held by other switches are removed.
+*
+* \param[in,out] p_addressResolutionTableEntry Memory location where the ARL entry data is stored. After success, the index field is updated.
+*
+* \return uint8_t: {0: config successful, else: failed}
+*/
+extern uint8_t SJA1105P_addArlTableEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t ret;
+	arlWriteJob_t writeJob;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
+
+	/* reuse the entry of the same address or find a free entry in the first switch and add entry there */
+	convertToPhysicalEntry(p_addressResolutionTableEntry, &physicalArlTableEntry, SJA1105P_MASTER_SWITCH);
+	ret = findEntryIndex(p_addressResolutionTableEntry);
+	physicalArlTableEntry.index = p_addressResolutionTableEntry->index;
+	if ((ret == 0U) && (physicalArlTableEntry.index == N_ARL_ENTRIES))
+	{
+		ret = findFreeEntry(&(physicalArlTableEntry.index), SJA1105P_MASTER_SWITCH);
+	}
+	if ((ret == 0U) && (physicalArlTableEntry.index != N_ARL_ENTRIES))
+	{
+		p_addressResolutionTableEntry->index = physicalArlTableEntry.index;
+
+		writeJob.kp_addressResolutionTableEntry = p_addressResolutionTableEntry;
+		writeJob.index = physicalArlTableEntry.index;
+		writeJob.switches = getRequiredSwitches(p_addressResolutionTableEntry);
+		writeJob.invalidatedSwitches = getEntrySwitches(physicalArlTableEntry.index) & (uint8_t) ~writeJob.switches;
+
+		/* Determine physical switch setup */
+		getDestSwitchRange(p_addressResolutionTableEntry->ports, &(writeJob.firstDestSwitchId), &(writeJob.lastDestSwitchId));
+
+		/* add entries to the switch instances */
+		g_arlGeneration++;
+		ret += SJA1105P_forEachSwitch(writeEntryJob, &writeJob);
+		setEntrySwitches(physicalArlTableEntry.index, writeJob.switches, (ret == 0U) ? 1U : 0U);
+		if ((ret == 0U) && (isEntryOccupied(physicalArlTableEntry.index) == 0U))
+		{  /* new entry */
+			setEntryOccupancy(physicalArlTableEntry.index, 1U);
+			linkEntryKey(physicalArlTableEntry.index, p_addressResolutionTableEntry->dstMacAddress, p_addressResolutionTableEntry->vlanId);
+		}
+	}
+	else
+	{  /* no free static entry left */
+		ret = 1;
+	}
+	return ret;
+}
+
+/**
+* \brief Change the destination ports of an entry of the Address Resolution Table.
+*
+* Only the switches in which the physical destination ports differ, including the
+* forwarding between the cascaded switches, are written, as well as switches missing a copy
+* like in SJA1105P_addArlTableEntry(). All other fields of the entry must be unchanged. If no entry with the same MAC address and VLAN ID exists, the
+* entry is added to all switches like by SJA1105P_addArlTableEntry().
+*
+* \param[in,out] p_addressResolutionTableEntry Entry holding the new destination ports. After success, the index field is updated.
+* \param[in]     previousPorts Destination ports currently configured for the entry
+*
+* \return uint8_t: {0: config successful, else: failed}
+*/
+extern uint8_t SJA1105P_updateArlTableEntryPorts(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry, uint16_t previousPorts)
+{
+	uint8_t ret;
+	uint8_t switchId;
+	uint8_t holderSwitches;
+	uint8_t previousFirstDestSwitchId;
+	uint8_t previousLastDestSwitchId;
+	arlWriteJob_t writeJob;
+	SJA1105P_addressResolutionTableEntry_t previousEntry;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
+	SJA1105P_l2ArtLockedEntryArgument_t previousPhysicalArlTableEntry;
+
+	ret = findEntryIndex(p_addressResolutionTableEntry);
+	if ((ret == 0U) && (p_addressResolutionTableEntry->index < N_ARL_ENTRIES))
+	{  /* the entry exists, compare the port vectors per switch */
+		previousEntry = *p_addressResolutionTableEntry;
+		previousEntry.ports = previousPorts;
+
+		writeJob.kp_addressResolutionTableEntry = p_addressResolutionTableEntry;
+		writeJob.index = p_addressResolutionTableEntry->index;
+		holderSwitches = getEntrySwitches(writeJob.index);
+		writeJob.switches = getRequiredSwitches(p_addressResolutionTableEntry);
+		writeJob.invalidatedSwitches = holderSwitches & (uint8_t) ~writeJob.switches;
+		holderSwitches &= writeJob.switches;             /* copies to be kept */
+		writeJob.switches &= (uint8_t) ~holderSwitches;  /* copies to be added */
+		getDestSwitchRange(p_addressResolutionTableEntry->ports, &(writeJob.firstDestSwitchId), &(writeJob.lastDestSwitchId));
+		getDestSwitchRange(previousPorts, &previousFirstDestSwitchId, &previousLastDestSwitchId);
+
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			convertToPhysicalEntry(p_addressResolutionTableEntry, &physicalArlTableEntry, switchId);
+			addInterSwitchForwarding(&physicalArlTableEntry, writeJob.firstDestSwitchId, writeJob.lastDestSwitchId, switchId);
+			convertToPhysicalEntry(&previousEntry, &previousPhysicalArlTableEntry, switchId);
+			addInterSwitchForwarding(&previousPhysicalArlTableEntry, previousFirstDestSwitchId, previousLastDestSwitchId, switchId);
+			if ((((holderSwitches >> switchId) & 1U) == 1U) && (physicalArlTableEntry.destports != previousPhysicalArlTableEntry.destports))
+			{  /* copy to be kept but changed */
+				writeJob.switches |= (uint8_t) (((uint8_t) 1) << switchId);
+			}
+		}
+
+		if ((writeJob.switches | writeJob.invalidatedSwitches) != 0U)
+		{
+			g_arlGeneration++;
+			ret = SJA1105P_forEachSwitch(writeEntryJob, &writeJob);
+			setEntrySwitches(writeJob.index, holderSwitches | writeJob.switches, (ret == 0U) ? 1U : 0U);
+		}
+	}
+	else
+	{  /* new entry */
+		ret = SJA1105P_addArlTableEntry(p_addressResolutionTableEntry);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read the entry from the Address Resolution table base on VLAN and MAC address information.
+*
+* A partial entry can be provided to this function containing only VLAN and MAC information.
+* The function will return the complete entry containing the full configuration of the entry.
+* The index is resolved on the host, an exact match of MAC address and VLAN ID is required.
+*
+* \param[inout] p_addressResolutionTableEntry ARL entry that should be read (in: VLAN/MAC information. Out: complete entry)
+*
+* \return uint8_t: Returns 0 when successful, else failed or entry didn't exist
+*/
+extern uint8_t SJA1105P_readArlTableEntryByAddress(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t ret ;
+
+	ret = findEntryIndex(p_addressResolutionTableEntry);
+	if ((ret == 0U) && (p_addressResolutionTableEntry->index < N_ARL_ENTRIES))
+	{  /* an entry was found */
+		ret = SJA1105P_readArlTableEntryByIndex(p_addressResolutionTableEntry);
+	}
+	else
+	{
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read the entry from the Address Resolution table base on the index.
+*
+* A partial entry can be provided to this function containing only VLAN and MAC information.
+* The function will return the complete entry containing the full configuration of the entry.
+*
+* \param[inout] p_addressResolutionTableEntry ARL entry that should be read (in: index. Out: complete entry)
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+extern uint8_t SJA1105P_readArlTableEntryByIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t  ret;
+	uint8_t  switchId;
+	uint16_t logicalDestPorts;
+	arlReadJob_t readJob = {0};
+
+	readJob.index    = p_addressResolutionTableEntry->index;
+	readJob.switches = getIndexSwitches(readJob.index);
+	ret = SJA1105P_forEachSwitch(readEntryJob, &readJob);
+
+	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	{
+		if (switchId == 0U)
+		{
+			p_addressResolutionTableEntry->enabled = readJob.physicalArlTableControlStatus[switchId].valident;
+			convertFromPhysicalEntry(p_addressResolutionTableEntry, &(readJob.physicalArlTableEntry[switchId]), switchId);
+		}
+		else
+		{  /* for incremental switches, only update the port vector */
+			SJA1105P_getPortVectorFromPhysicalPortVector(readJob.physicalArlTableEntry[switchId].destports, switchId, &logicalDestPorts);
+			p_addressResolutionTableEntry->ports |= logicalDestPorts;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Remove the entry from the Address Resolution table base on VLAN and MAC address information.
+*
+* The index is resolved on the host first. Entries unknown to the host (e.g. learned entries)
+* are located with a hardware search.
+*
+* \param[in] p_addressResolutionTableEntry ARL entry that should be removed
+*
+* \return uint8_t: Returns 0 when successful, else failed or entry didn't exist
+*/
+extern uint8_t SJA1105P_removeArlTableEntryByAddress(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t ret;
+
+	ret = findEntryIndex(p_addressResolutionTableEntry);
+	if ((ret == 0U) && (p_addressResolutionTableEntry->index == N_ARL_ENTRIES))
+	{  /* not a host managed entry */
+		ret = searchEntryIndex(p_addressResolutionTableEntry);
+	}
+	if ((ret == 0U) && (p_addressResolutionTableEntry->index < N_ARL_ENTRIES))
+	{  /* an entry was found */
+		ret = SJA1105P_removeArlTableEntryByIndex(p_addressResolutionTableEntry);
+	}
+	else
+	{
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Remove the entry from the Address Resolution table base at a specific index
+*
+* \param[in] p_addressResolutionTableEntry ARL entry that should be removed
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+extern uint8_t SJA1105P_removeArlTableEntryByIndex(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry)
+{
+	uint8_t ret;
+	arlModifyJob_t modifyJob = {0};
+
+	modifyJob.index    = kp_addressResolutionTableEntry->index;
+	modifyJob.switches = getIndexSwitches(modifyJob.index);
+
+	g_arlGeneration++;
+	ret = SJA1105P_forEachSwitch(invalidateEntryJob, &modifyJob);
+	if (ret == 0U)
+	{
+		setEntrySwitches(modifyJob.index, 0U, 1U);
+	}
+	if ((ret == 0U) && (modifyJob.index < N_ARL_ENTRIES) && (isEntryOccupied(modifyJob.index) == 1U))
+	{
+		unlinkEntryKey(modifyJob.index);
+		setEntryOccupancy(modifyJob.index, 0U);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Rebuild the host side occupancy and key index of the static entries from the hardware
+*
+* Reads every index of the master switch once. Called by SJA1105P_synchSwitchConfiguration(),
+* afterwards SJA1105P_addArlTableEntry() allocates indices and the address based functions
+* resolve indices without accessing the TCAM. All switches are assumed to hold a copy of
+* every index until it is written again.
+* Must be called again if the table was modified without using this module.
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+extern uint8_t SJA1105P_synchArlOccupancy(void)
+{
+	uint8_t ret = 0;
+	uint16_t entryIndex;
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	SJA1105P_l2LookupParametersEntryArgument_t l2LookupParametersEntry;
+	SJA1105P_l2LookupParametersControlArgument_t l2LookupParametersControl = {1, 0};  /* read access */
+
+	g_arlOccupancyValid = 0;
+	g_arlGeneration++;
+	for (entryIndex = 0; entryIndex < N_KEY_BUCKETS; entryIndex++)
+	{
+		g_arlKeyBucket[entryIndex] = N_ARL_ENTRIES;
+	}
+	for (entryIndex = 0; entryIndex < N_ARL_ENTRIES; entryIndex++)
+	{
+		g_arlSwitches[entryIndex] = ALL_SWITCHES;
+		physicalArlTableEntry.index = entryIndex;
+		ret = executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, SJA1105P_MASTER_SWITCH);
+		if (ret != 0U)
+		{
+			break;
+		}
+		if ((physicalArlTableControlStatus.valident == 1U) && (physicalArlTableControlStatus.lockeds == 1U))
+		{
+			setEntryOccupancy(entryIndex, 1U);
+			linkEntryKey(entryIndex, physicalArlTableEntry.macaddr, physicalArlTableEntry.vlanid);
+		}
+		else
+		{
+			setEntryOccupancy(entryIndex, 0U);
+		}
+	}
+	if (ret == 0U)
+	{  /* with shared learning, entries match the frames of all VLANs */
+		ret  = SJA1105P_setL2LookupParametersControl(&l2LookupParametersControl, SJA1105P_MASTER_SWITCH);
+		ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_L2_LOOKUP_PARAMETERS, NULL, SJA1105P_MASTER_SWITCH);
+		ret += SJA1105P_getL2LookupParametersEntry(&l2LookupParametersEntry, SJA1105P_MASTER_SWITCH);
+		g_arlVlanPruning = (l2LookupParametersEntry.sharedLearning == 0U) ? 1U : 0U;
+	}
+	if (ret == 0U)
+	{
+		g_arlOccupancyValid = 1;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Copy the static entries of a VLAN to the switches in which the VLAN was configured since they were written
+*
+* Called by the VLAN functions whenever ::SJA1105P_getVlanSwitches returns additional switches.
+* The entries are read from the switches holding a copy and written again.
+*
+* \param[in] vlanId VLAN ID of the entries
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+extern uint8_t SJA1105P_synchArlVlanSwitches(uint16_t vlanId)
+{
+	uint8_t  ret = 0;
+	uint16_t entryIndex;
+	SJA1105P_addressResolutionTableEntry_t entry;
+	SJA1105P_extendedAddressResolutionTableEntry_t extension;
+
+	for (entryIndex = 0; (entryIndex < N_ARL_ENTRIES) && (ret == 0U); entryIndex++)
+	{
+		if ((isEntryOccupied(entryIndex) == 1U) && (g_arlKeyVlan[entryIndex] == vlanId) &&
+		    (((MASTER_SWITCH_BIT | SJA1105P_getVlanSwitches(vlanId)) & (uint8_t) ~getEntrySwitches(entryIndex)) != 0U))
+		{  /* copies are missing, entries matching several VLANs are held by all switches */
+			entry.index       = entryIndex;
+			entry.p_extension = &extension;
+			ret = SJA1105P_readArlTableEntryByIndex(&entry);
+			if (ret == 0U)
+			{
+				ret = SJA1105P_addArlTableEntry(&entry);
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read all valid entries of the Address Resolution table at once
+*
+* The master switch is read completely, the cascaded switches only at the indices found valid in
+* the master switch. TCAM reads are pipelined within SPI batches. The ports of an entry are
+* combined from all switches storing the same address at the same index.
+* A snapshot can be reused as long as ::SJA1105P_getArlTableGeneration returns the generation
+* stored within. Entries learned or aged by the switch do not change the generation.
+*
+* \param[out] p_snapshot Memory location where the snapshot is stored
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+extern uint8_t SJA1105P_snapshotArlTable(SJA1105P_arlTableSnapshot_t *p_snapshot)
+{
+	uint8_t  ret = 0;
+	uint8_t  i;
+	uint8_t  switchId;
+	uint16_t firstIndex;
+	uint16_t entryIndex;
+	uint16_t logicalDestPorts;
+	uint16_t index[N_PIPELINED_READS];
+	arlSnapshotJob_t snapshotJob;
+	SJA1105P_addressResolutionTableEntry_t *p_entry;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry[N_PIPELINED_READS];
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus[N_PIPELINED_READS];
+
+	p_snapshot->generation = g_arlGeneration;
+	p_snapshot->nEntries   = 0;
+
+	/* master switch */
+	for (firstIndex = 0; (firstIndex < N_ARL_ENTRIES) && (ret == 0U); firstIndex += N_PIPELINED_READS)
+	{
+		for (i = 0; i < N_PIPELINED_READS; i++)
+		{
+			index[i] = firstIndex + i;
+		}
+		ret = readEntryBatch(index, N_PIPELINED_READS, physicalArlTableEntry, physicalArlTableControlStatus, SJA1105P_MASTER_SWITCH);
+		for (i = 0; (i < N_PIPELINED_READS) && (ret == 0U); i++)
+		{
+			if (physicalArlTableControlStatus[i].valident == 1U)
+			{
+				p_entry = &(p_snapshot->entries[p_snapshot->nEntries]);
+				p_entry->p_extension = NULL;
+				p_entry->enabled     = 1;
+				convertFromPhysicalEntry(p_entry, &(physicalArlTableEntry[i]), SJA1105P_MASTER_SWITCH);
+				p_snapshot->nEntries++;
+			}
+		}
+	}
+
+	/* cascaded switches */
+	if (ret == 0U)
+	{
+		snapshotJob.kp_snapshot = p_snapshot;
+		ret = SJA1105P_forEachSwitch(snapshotPortsJob, &snapshotJob);
+	}
+	for (switchId = 0; (switchId < SJA1105P_N_SWITCHES) && (ret == 0U); switchId++)
+	{
+		if (switchId != SJA1105P_MASTER_SWITCH)
+		{
+			for (entryIndex = 0; entryIndex < p_snapshot->nEntries; entryIndex++)
+			{
+				SJA1105P_getPortVectorFromPhysicalPortVector(g_arlSnapshotPorts[switchId][entryIndex], switchId, &logicalDestPorts);
+				p_snapshot->entries[entryIndex].ports |= logicalDestPorts;
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Get the generation of the Address Resolution table
+*
+* \return uint32_t: Value incremented with every modification of the table by the driver
+*/
+extern uint32_t SJA1105P_getArlTableGeneration(void)
+{
+	return g_arlGeneration;
+}
+
+/**
+* \brief Read a range of indices of one switch for entries learned by the switch
+*
+* Learned entries are not locked and only exist in the switch which received
+* the frame, at an index chosen by the hash of the switch. Entries learned on a
+* cascaded port are ignored, the address is learned on an external port of another
+* switch as well. TCAM reads are pipelined within SPI batches.
+*
+* \param[in]  firstIndex First index to be read
+* \param[in]  nIndices Number of consecutive indices to be read
+* \param[out] p_entries One entry per index. The enabled field is 1 if a learned entry is stored at the index, else 0. The extension pointers are NULL.
+* \param[in]  switchId Switch to be read
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+extern uint8_t SJA1105P_readLearnedArlTableEntries(uint16_t firstIndex, uint16_t nIndices, SJA1105P_addressResolutionTableEntry_t *p_entries, uint8_t switchId)
+{
+	uint8_t  ret = 0;
+	uint8_t  i;
+	uint8_t  nEntries;
+	uint16_t offset;
+	uint16_t nRemaining;
+	uint16_t index[N_PIPELINED_READS];
+	SJA1105P_addressResolutionTableEntry_t *p_entry;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry[N_PIPELINED_READS];
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus[N_PIPELINED_READS];
+
+	if ((switchId >= SJA1105P_N_SWITCHES) || (firstIndex >= N_ARL_ENTRIES) || (nIndices > (N_ARL_ENTRIES - firstIndex)))
+	{
+		ret = 1;
+	}
+
+	for (offset = 0; (offset < nIndices) && (ret == 0U); offset += nEntries)
+	{
+		nRemaining = nIndices - offset;
+		nEntries   = (uint8_t) ((nRemaining < N_PIPELINED_READS) ? nRemaining : N_PIPELINED_READS);
+		for (i = 0; i < nEntries; i++)
+		{
+			index[i] = firstIndex + offset + i;
+		}
+		ret = readEntryBatch(index, nEntries, physicalArlTableEntry, physicalArlTableControlStatus, switchId);
+		for (i = 0; (i < nEntries) && (ret == 0U); i++)
+		{
+			p_entry = &(p_entries[offset + i]);
+			p_entry->p_extension = NULL;
+			convertFromPhysicalEntry(p_entry, &(physicalArlTableEntry[i]), switchId);
+			p_entry->index = index[i];
+			if ((physicalArlTableControlStatus[i].valident == 1U) && (physicalArlTableControlStatus[i].lockeds == 0U) && (p_entry->ports != 0U))
+			{
+				p_entry->enabled = 1;
+			}
+			else
+			{  /* empty, static or learned on a cascaded port */
+				p_entry->enabled = 0;
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Check the host side index of an entry against a hardware search
+*
+* \param[in] kp_addressResolutionTableEntry ARL entry identified by VLAN/MAC information
+*
+* \return uint8_t: Returns 0 when the TCAM resolves the address to the same index as the host, else failed or inconsistent
+*/
+extern uint8_t SJA1105P_verifyArlTableEntry(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry)
+{
+	uint8_t ret;
+	SJA1105P_addressResolutionTableEntry_t hostEntry     = *kp_addressResolutionTableEntry;
+	SJA1105P_addressResolutionTableEntry_t hardwareEntry = *kp_addressResolutionTableEntry;
+
+	ret  = findEntryIndex(&hostEntry);
+	ret += searchEntryIndex(&hardwareEntry);
+	if ((ret == 0U) && (hostEntry.index != hardwareEntry.index))
+	{
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Open a batch of modifications of the Address Resolution table
+*
+* Entries added or removed with ::SJA1105P_addArlBatchEntry and ::SJA1105P_removeArlBatchEntry
+* are placed on the host only. ::SJA1105P_commitArlBatch writes them to all switches at once,
+* ::SJA1105P_abortArlBatch discards them. While a batch is open, the table must not be modified
+* by other functions of this module.
+*
+* \return uint8_t: Returns 0 when successful, else failed or a batch is open already
+*/
+extern uint8_t SJA1105P_beginArlBatch(void)
+{
+	uint8_t  ret = 0;
+	uint16_t entryIndex;
+
+	if (g_arlBatchOpen == 1U)
+	{  /* batches cannot be nested */
+		ret = 1;
+	}
+	else
+	{
+		if (g_arlOccupancyValid == 0U)
+		{
+			ret = SJA1105P_synchArlOccupancy();
+		}
+	}
+
+	if (ret == 0U)
+	{
+		for (entryIndex = 0; entryIndex < N_ARL_ENTRIES; entryIndex++)
+		{
+			g_arlBatchOpOfIndex[entryIndex] = NO_BATCH_OP;
+		}
+		g_arlBatchNOps = 0;
+		g_arlBatchOpen = 1;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Add an entry to the open batch
+*
+* The index is assigned immediately, as ::SJA1105P_addArlTableEntry would do. An entry with the same
+* MAC address and VLAN ID, in the table or earlier in the batch, is overwritten in place.
+* A failed call leaves the batch unchanged.
+*
+* \param[in,out] p_addressResolutionTableEntry Memory location where the ARL entry data is stored. After success, the index field is updated.
+*
+* \return uint8_t: Returns 0 when successful, else failed, table full or no batch open
+*/
+extern uint8_t SJA1105P_addArlBatchEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t  ret = 1;
+	uint16_t entryIndex;
+	arlBatchContent_t *p_content;
+
+	if (g_arlBatchOpen == 1U)
+	{
+		ret = findEntryIndex(p_addressResolutionTableEntry);
+		entryIndex = p_addressResolutionTableEntry->index;
+		if ((ret == 0U) && (entryIndex == N_ARL_ENTRIES))
+		{
+			ret = findFreeEntry(&entryIndex, SJA1105P_MASTER_SWITCH);
+		}
+		if ((ret == 0U) && (entryIndex != N_ARL_ENTRIES))
+		{
+			p_addressResolutionTableEntry->index = entryIndex;
+
+			p_content = &(getBatchOp(entryIndex)->next);
+			convertToPhysicalEntry(p_addressResolutionTableEntry, &(p_content->physicalArlTableEntry), SJA1105P_MASTER_SWITCH);
+			p_content->ports = p_addressResolutionTableEntry->ports;
+			p_content->valid = 1;
+
+			if (isEntryOccupied(entryIndex) == 0U)
+			{  /* new entry */
+				setEntryOccupancy(entryIndex, 1U);
+				linkEntryKey(entryIndex, p_addressResolutionTableEntry->dstMacAddress, p_addressResolutionTableEntry->vlanId);
+			}
+		}
+		else
+		{  /* no free static entry left */
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Remove an entry identified by VLAN and MAC address information within the open batch
+*
+* \param[in,out] p_addressResolutionTableEntry ARL entry that should be removed. After success, the index field is updated.
+*
+* \return uint8_t: Returns 0 when successful, else failed, entry didn't exist or no batch open
+*/
+extern uint8_t SJA1105P_removeArlBatchEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t  ret = 1;
+	uint16_t entryIndex;
+	arlBatchContent_t *p_content;
+
+	if (g_arlBatchOpen == 1U)
+	{
+		ret = findEntryIndex(p_addressResolutionTableEntry);
+		entryIndex = p_addressResolutionTableEntry->index;
+		if ((ret == 0U) && (entryIndex < N_ARL_ENTRIES))
+		{  /* an entry was found */
+			p_content = &(getBatchOp(entryIndex)->next);
+			p_content->physicalArlTableEntry.index = entryIndex;
+			p_content->valid = 0;
+
+			unlinkEntryKey(entryIndex);
+			setEntryOccupancy(entryIndex, 0U);
+		}
+		else
+		{
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Write the open batch to all switches and close it
+*
+* The previous content of the modified static entries is read first. Then the final content of each
+* modified index is written, with the TCAM commands pipelined within SPI batches. If a switch fails,
+* the previous content is written back to all switches and the batch has no effect.
+*
+* \return uint8_t: Returns 0 when successful, else failed or no batch open
+*/
+extern uint8_t SJA1105P_commitArlBatch(void)
+{
+	uint8_t  ret = 1;
+	uint8_t  switchId;
+	uint16_t op;
+	arlBatchJob_t batchJob;
+	const arlBatchContent_t *kp_content;
+
+	if (g_arlBatchOpen == 1U)
+	{
+		g_arlGeneration++;
+
+		/* the cascaded switches are compared to the content of the master switch */
+		ret = readBatchBackup(SJA1105P_MASTER_SWITCH);
+		if (ret == 0U)
+		{
+			ret = SJA1105P_forEachSwitch(backupBatchJob, NULL);
+		}
+		for (op = 0; (op < g_arlBatchNOps) && (ret == 0U); op++)
+		{
+			for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+			{
+				if ((switchId != SJA1105P_MASTER_SWITCH) && (g_arlBatchOps[op].prev.valid == 1U))
+				{
+					g_arlBatchOps[op].prev.ports |= g_arlBatchBackupPorts[switchId][op];
+				}
+			}
+		}
+
+		if (ret == 0U)
+		{
+			batchJob.rollback = 0;
+			ret = SJA1105P_forEachSwitch(writeBatchJob, &batchJob);
+			if (ret != 0U)
+			{
+				batchJob.rollback = 1;
+				if (SJA1105P_forEachSwitch(writeBatchJob, &batchJob) != 0U)
+				{  /* content of the switches unknown, read it again on next use */
+					g_arlOccupancyValid = 0;
+				}
+			}
+		}
+
+		/* the batch is written to all switches */
+		for (op = 0; op < g_arlBatchNOps; op++)
+		{
+			kp_content = (ret == 0U) ? &(g_arlBatchOps[op].next) : &(g_arlBatchOps[op].prev);
+			setEntrySwitches(kp_content->physicalArlTableEntry.index, (kp_content->valid == 1U) ? ALL_SWITCHES : 0U, 1U);
+		}
+
+		if (ret != 0U)
+		{
+			rollbackBatchOccupancy();
+		}
+		g_arlBatchOpen = 0;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Discard the open batch without accessing the switches
+*/
+extern void SJA1105P_abortArlBatch(void)
+{
+	if (g_arlBatchOpen == 1U)
+	{
+		rollbackBatchOccupancy();
+		g_arlBatchOpen = 0;
+	}
+}
+
+/**
+* \brief Start/Stop mirroring based on an entry in the ARL table
+*
+* \param[in]  arlEntryIndex Index of the entry to be used for mirroring
+* \param[in]  enable 0 to turn mirroring off, 1 to start mirroring
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+extern uint8_t SJA1105P_enableArlMirroring(uint16_t arlEntryIndex, uint8_t enable)
+{
+	arlModifyJob_t modifyJob = {0};
+
+	modifyJob.index    = arlEntryIndex;
+	modifyJob.enable   = enable;
+	modifyJob.switches = getIndexSwitches(arlEntryIndex);
+
+	g_arlGeneration++;
+	return SJA1105P_forEachSwitch(enableMirroringJob, &modifyJob);
+}
+
+/**
+* \brief Start/Stop retagging based on an entry in the ARL table
+*
+* \param[in]  arlEntryIndex Index of the entry to be used for retagging
+* \param[in]  retaggingVlanId VLAN ID used in the retagging process
+* \param[in]  enable 0 to turn retagging off, 1 to start retagging
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+extern uint8_t SJA1105P_enableArlRetagging(uint16_t arlEntryIndex, uint16_t retaggingVlanId, uint8_t enable)
+{
+	arlModifyJob_t modifyJob;
+
+	modifyJob.index           = arlEntryIndex;
+	modifyJob.retaggingVlanId = retaggingVlanId;
+	modifyJob.enable          = enable;
+	modifyJob.switches        = getIndexSwitches(arlEntryIndex);
+
+	g_arlGeneration++;
+	return SJA1105P_forEachSwitch(enableRetaggingJob, &modifyJob);
+}
+
+
+/**
+* \brief Write an entry to one switch, including the inter switch forwarding
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context ::arlWriteJob_t describing the entry
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t writeEntryJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret = 0;
+	const arlWriteJob_t *kp_writeJob = (const arlWriteJob_t *) p_context;
+
+	const SJA1105P_l2ArtLockedEntryArgument_t k_invalidEntry = {0};
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+
+	if (((kp_writeJob->switches >> switchId) & 1U) == 1U)
+	{  /* otherwise, the entry of this switch is unchanged */
+		/* configure external ports */
+		convertToPhysicalEntry(kp_writeJob->kp_addressResolutionTableEntry, &physicalArlTableEntry, switchId);
+		physicalArlTableEntry.index = kp_writeJob->index;
+
+		/* configure inter switch forwarding */
+		addInterSwitchForwarding(&physicalArlTableEntry, kp_writeJob->firstDestSwitchId, kp_writeJob->lastDestSwitchId, switchId);
+
+		ret = executeTcamCommand(SJA1105P_e_hostCmd_WRITE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+	}
+	else
+	{
+		if (((kp_writeJob->invalidatedSwitches >> switchId) & 1U) == 1U)
+		{  /* the switch does not forward frames matching the entry */
+			physicalArlTableEntry = k_invalidEntry;
+			physicalArlTableEntry.index = kp_writeJob->index;
+			ret = executeTcamCommand(SJA1105P_e_hostCmd_INVALIDATE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read an entry from one switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in,out] p_context ::arlReadJob_t, the result is stored at the position of the switch
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t readEntryJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret = 0;
+	arlReadJob_t *p_readJob = (arlReadJob_t *) p_context;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
+
+	if (((p_readJob->switches >> switchId) & 1U) == 1U)
+	{  /* otherwise, the switch holds no copy */
+		physicalArlTableEntry.index = p_readJob->index;
+
+		ret = executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &(p_readJob->physicalArlTableControlStatus[switchId]), switchId);
+		p_readJob->physicalArlTableEntry[switchId] = physicalArlTableEntry;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read the physical ports of the snapshot entries in one cascaded switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context ::arlSnapshotJob_t, the result is stored in g_arlSnapshotPorts
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t snapshotPortsJob(uint8_t switchId, void *p_context)
+{
+	uint8_t  ret = 0;
+	uint8_t  i;
+	uint8_t  nEntries;
+	uint16_t firstEntry;
+	uint16_t nRemaining;
+	uint16_t index[N_PIPELINED_READS];
+	const arlSnapshotJob_t *kp_snapshotJob = (const arlSnapshotJob_t *) p_context;
+	const SJA1105P_addressResolutionTableEntry_t *kp_entry;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry[N_PIPELINED_READS];
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus[N_PIPELINED_READS];
+
+	if (switchId != SJA1105P_MASTER_SWITCH)
+	{
+		for (firstEntry = 0; (firstEntry < kp_snapshotJob->kp_snapshot->nEntries) && (ret == 0U); firstEntry += nEntries)
+		{
+			nRemaining = kp_snapshotJob->kp_snapshot->nEntries - firstEntry;
+			nEntries   = (uint8_t) ((nRemaining < N_PIPELINED_READS) ? nRemaining : N_PIPELINED_READS);
+			for (i = 0; i < nEntries; i++)
+			{
+				index[i] = kp_snapshotJob->kp_snapshot->entries[firstEntry + i].index;
+			}
+			ret = readEntryBatch(index, nEntries, physicalArlTableEntry, physicalArlTableControlStatus, switchId);
+			for (i = 0; i < nEntries; i++)
+			{
+				kp_entry = &(kp_snapshotJob->kp_snapshot->entries[firstEntry + i]);
+				g_arlSnapshotPorts[switchId][firstEntry + i] = 0;
+				if ((ret == 0U) && (physicalArlTableControlStatus[i].valident == 1U) &&
+				    (physicalArlTableEntry[i].macaddr == kp_entry->dstMacAddress) && (physicalArlTableEntry[i].vlanid == kp_entry->vlanId))
+				{  /* same address stored at this index */
+					g_arlSnapshotPorts[switchId][firstEntry + i] = physicalArlTableEntry[i].destports;
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read the previous content of the static entries modified by the batch in one switch
+*
+* The master switch provides the complete entries and must be read first. The cascaded switches
+* only provide the ports of the same addresses, stored in g_arlBatchBackupPorts.
+*
+* \param[in]  switchId Reference to the physical switch
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t readBatchBackup(uint8_t switchId)
+{
+	uint8_t  ret = 0;
+	uint8_t  i;
+	uint8_t  nEntries;
+	uint16_t op;
+	uint16_t nextOp = 0;
+	uint16_t logicalDestPorts;
+	uint16_t index[N_PIPELINED_READS];
+	uint16_t opOfEntry[N_PIPELINED_READS];
+	arlBatchContent_t *p_prev;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry[N_PIPELINED_READS];
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus[N_PIPELINED_READS];
+
+	while ((nextOp < g_arlBatchNOps) && (ret == 0U))
+	{
+		/* collect the next indices which held a static entry */
+		nEntries = 0;
+		for (op = nextOp; (op < g_arlBatchNOps) && (nEntries < N_PIPELINED_READS); op++)
+		{
+			g_arlBatchBackupPorts[switchId][op] = 0;
+			if (g_arlBatchOps[op].prev.valid == 1U)
+			{
+				index[nEntries]     = g_arlBatchOps[op].prev.physicalArlTableEntry.index;
+				opOfEntry[nEntries] = op;
+				nEntries++;
+			}
+		}
+		nextOp = op;
+
+		if (nEntries > 0U)
+		{
+			ret = readEntryBatch(index, nEntries, physicalArlTableEntry, physicalArlTableControlStatus, switchId);
+		}
+		for (i = 0; (i < nEntries) && (ret == 0U); i++)
+		{
+			p_prev = &(g_arlBatchOps[opOfEntry[i]].prev);
+			if (switchId == SJA1105P_MASTER_SWITCH)
+			{
+				p_prev->valid = physicalArlTableControlStatus[i].valident;
+				p_prev->physicalArlTableEntry = physicalArlTableEntry[i];
+				SJA1105P_getPortVectorFromPhysicalPortVector(physicalArlTableEntry[i].destports, switchId, &(p_prev->ports));
+			}
+			else
+			{
+				if ((physicalArlTableControlStatus[i].valident == 1U) &&
+				    (physicalArlTableEntry[i].macaddr == p_prev->physicalArlTableEntry.macaddr) && (physicalArlTableEntry[i].vlanid == p_prev->physicalArlTableEntry.vlanid))
+				{  /* same address stored at this index */
+					SJA1105P_getPortVectorFromPhysicalPortVector(physicalArlTableEntry[i].destports, switchId, &logicalDestPorts);
+					g_arlBatchBackupPorts[switchId][opOfEntry[i]] = logicalDestPorts;
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Read the ports of the static entries modified by the batch in one cascaded switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context not used
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t backupBatchJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret = 0;
+
+	(void) p_context;
+
+	if (switchId != SJA1105P_MASTER_SWITCH)
+	{
+		ret = readBatchBackup(switchId);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Write the content of all indices modified by the batch to one switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context ::arlBatchJob_t selecting the next or the previous content
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t writeBatchJob(uint8_t switchId, void *p_context)
+{
+	uint8_t  ret = 0;
+	uint8_t  i;
+	uint8_t  nEntries;
+	uint8_t  firstDestSwitchId;
+	uint8_t  lastDestSwitchId;
+	uint16_t firstOp;
+	uint16_t nRemaining;
+	const arlBatchJob_t *kp_batchJob = (const arlBatchJob_t *) p_context;
+	const arlBatchContent_t *kp_content;
+
+	const SJA1105P_l2ArtLockedEntryArgument_t k_invalidEntry = {0};
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry[N_PIPELINED_WRITES];
+	SJA1105P_hostCmd_t hostCmd[N_PIPELINED_WRITES];
+
+	for (firstOp = 0; (firstOp < g_arlBatchNOps) && (ret == 0U); firstOp += nEntries)
+	{
+		nRemaining = g_arlBatchNOps - firstOp;
+		nEntries   = (uint8_t) ((nRemaining < N_PIPELINED_WRITES) ? nRemaining : N_PIPELINED_WRITES);
+		for (i = 0; i < nEntries; i++)
+		{
+			kp_content = (kp_batchJob->rollback == 1U) ? &(g_arlBatchOps[firstOp + i].prev) : &(g_arlBatchOps[firstOp + i].next);
+			if (kp_content->valid == 1U)
+			{
+				physicalArlTableEntry[i] = kp_content->physicalArlTableEntry;
+				SJA1105P_getPhysicalPortVector(kp_content->ports, switchId, &(physicalArlTableEntry[i].destports));
+				getDestSwitchRange(kp_content->ports, &firstDestSwitchId, &lastDestSwitchId);
+				addInterSwitchForwarding(&(physicalArlTableEntry[i]), firstDestSwitchId, lastDestSwitchId, switchId);
+				hostCmd[i] = SJA1105P_e_hostCmd_WRITE;
+			}
+			else
+			{
+				physicalArlTableEntry[i] = k_invalidEntry;
+				physicalArlTableEntry[i].index = kp_content->physicalArlTableEntry.index;
+				hostCmd[i] = SJA1105P_e_hostCmd_INVALIDATE;
+			}
+		}
+		ret = writeEntryBatch(physicalArlTableEntry, hostCmd, nEntries, switchId);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Invalidate an entry in one switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context ::arlModifyJob_t containing the index
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t invalidateEntryJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret = 0;
+	const arlModifyJob_t *kp_modifyJob = (const arlModifyJob_t *) p_context;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+
+	if (((kp_modifyJob->switches >> switchId) & 1U) == 1U)
+	{  /* otherwise, the switch holds no copy */
+		physicalArlTableEntry.index = kp_modifyJob->index;
+
+		ret = executeTcamCommand(SJA1105P_e_hostCmd_INVALIDATE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Update the mirroring flag of an entry in one switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context ::arlModifyJob_t containing index and flag
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t enableMirroringJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret = 0;
+	const arlModifyJob_t *kp_modifyJob = (const arlModifyJob_t *) p_context;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+
+	if (((kp_modifyJob->switches >> switchId) & 1U) == 1U)
+	{  /* otherwise, the switch holds no copy to be modified */
+		physicalArlTableEntry.index = kp_modifyJob->index;
+
+		ret  = executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+		physicalArlTableEntry.mirror = kp_modifyJob->enable;
+		ret += executeTcamCommand(SJA1105P_e_hostCmd_WRITE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Update the retagging configuration of an entry in one switch
+*
+* \param[in]  switchId Reference to the physical switch
+* \param[in]  p_context ::arlModifyJob_t containing index, flag and VLAN
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t enableRetaggingJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret = 0;
+	const arlModifyJob_t *kp_modifyJob = (const arlModifyJob_t *) p_context;
+
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+
+	if (((kp_modifyJob->switches >> switchId) & 1U) == 1U)
+	{  /* otherwise, the switch holds no copy to be modified */
+		physicalArlTableEntry.index = kp_modifyJob->index;
+
+		ret  = executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+		physicalArlTableEntry.retag        = kp_modifyJob->enable;
+		physicalArlTableEntry.mirroredVlan = kp_modifyJob->retaggingVlanId;
+		ret += executeTcamCommand(SJA1105P_e_hostCmd_WRITE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Find the index of a static entry in the host side key index
+*
+* The key index is read from the hardware on first use if SJA1105P_synchArlOccupancy() was not called.
+*
+* \param[inout] p_addressResolutionTableEntry ARL entry (in: VLAN/MAC information. Out: index, N_ARL_ENTRIES if the entry is not found)
+*
+* \return uint8_t: Returns 0 on success, else failed.
+*/
+static uint8_t findEntryIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+{
+	uint8_t  ret = 0;
+	uint16_t entryIndex;
+
+	p_addressResolutionTableEntry->index = N_ARL_ENTRIES;  /* init with invalid index */
+	if (g_arlOccupancyValid == 0U)
+	{
+		ret = SJA1105P_synchArlOccupancy();
+	}
+
+	if (ret == 0U)
+	{
+		entryIndex = g_arlKeyBucket[getKeyBucket(p_addressResolutionTableEntry->dstMacAddress, p_addressResolutionTableEntry->vlanId)];
+		while (entryIndex != N_ARL_ENTRIES)
+		{
+			if ((g_arlKeyMac[entryIndex] == p_addressResolutionTableEntry->dstMacAddress) && (g_arlKeyVlan[entryIndex] == p_addressResolutionTableEntry->vlanId))
+			{
+				p_addressResolutionTableEntry->index = entryIndex;
+				break;
+			}
+			entryIndex = g_arlKeyNext[entryIndex];
+		}
+	}
 
-/******************************************************************************
-* FUNCTIONS
-*****************************************************************************/
+	return ret;
+}
 
 /**
-* \brief Insert an entry into the Address Resolution Table.
+* \brief Find the index corresponding to a TCAM entry using a hardware search
 *
-* \param[in,out] p_addressResolutionTableEntry Memory location where the ARL entry data is stored. After success, the index field is updated.
+* \param[inout] p_addressResolutionTableEntry ARL entry (in: VLAN/MAC information. Out: index, N_ARL_ENTRIES if the entry is not found)
 *
-* \return uint8_t: {0: config successful, else: failed}
+* \return uint8_t: Returns 0 on success, else failed.
 */
-extern uint8_t SJA1105P_addArlTableEntry(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+static uint8_t searchEntryIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
 {
 	uint8_t ret;
-	uint8_t switchId;
-	uint8_t destSwitches;
-	uint8_t firstDestSwitchId = SJA1105P_N_SWITCHES;
-	uint8_t lastDestSwitchId = 0;
 
 	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
 	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
 
-	/* find free entry in the first switch and add entry there */
 	convertToPhysicalEntry(p_addressResolutionTableEntry, &physicalArlTableEntry, SJA1105P_MASTER_SWITCH);
-	ret = findFreeEntry(&(physicalArlTableEntry.index), SJA1105P_MASTER_SWITCH);
-	if ((ret == 0U) && (physicalArlTableEntry.index != N_ARL_ENTRIES))
+	ret = executeTcamCommand(SJA1105P_e_hostCmd_SEARCH, &physicalArlTableEntry, &physicalArlTableControlStatus, SJA1105P_MASTER_SWITCH);
+
+	p_addressResolutionTableEntry->index = N_ARL_ENTRIES;  /* init with invalid index */
+	if ((ret == 0U) && (physicalArlTableControlStatus.valident == 1U) && (physicalArlTableControlStatus.errors == 0U))
 	{
 		p_addressResolutionTableEntry->index = physicalArlTableEntry.index;
-
-		/* Determine physical switch setup */
-		SJA1105P_getSwitchesFromPorts(p_addressResolutionTableEntry->ports, &destSwitches);
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-		{
-			if (((destSwitches >> switchId) & 1U) == 1U)
-			{  /* switchId is a destination of this MAC-VLAN combination */
-				firstDestSwitchId = (firstDestSwitchId == SJA1105P_N_SWITCHES) ? switchId : firstDestSwitchId;
-				lastDestSwitchId = (switchId > lastDestSwitchId) ? switchId : lastDestSwitchId;
-			}
-		}
-
-		/* add entries to the switch instances */
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-		{
-			/* configure external ports */
-			SJA1105P_getPhysicalPortVector(p_addressResolutionTableEntry->ports, switchId, &(physicalArlTableEntry.destports)); 
-
-			/* configure inter switch forwarding */
-			if (switchId < lastDestSwitchId)
-			{  /* forward to next switch */
-				physicalArlTableEntry.destports |= (uint8_t) (((uint8_t) 1) << SJA1105P_g_generalParameters.cascPort[switchId]);
-			}
-			if (switchId > firstDestSwitchId)
-			{  /* forward to previous switch */
-				physicalArlTableEntry.destports |= (uint8_t) (((uint8_t) 1) << SJA1105P_g_generalParameters.hostPort[switchId]);
-			}
-
-			ret += executeTcamCommand(SJA1105P_e_hostCmd_WRITE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
-		}
 	}
+
 	return ret;
 }
 
 /**
-* \brief Read the entry from the Address Resolution table base on VLAN and MAC address information.
+* \brief Find the first free entry using the host side occupancy
 *
-* A partial entry can be provided to this function containing only VLAN and MAC information.
-* The function will return the complete entry containing the full configuration of the entry.
+* The occupancy is read from the hardware on first use if SJA1105P_synchArlOccupancy() was not called.
 *
-* \param[inout] p_addressResolutionTableEntry ARL entry that should be read (in: VLAN/MAC information. Out: complete entry)
+* \param[out]   p_freeEntryIndex Index of the free index. Invalid index if TCAM is full
+* \param[in]    switchId Reference to the physical switch on which the entries are allocated
 *
-* \return uint8_t: Returns 0 when successful, else failed or entry didn't exist
+* \return uint8_t: Returns 0 on success, else failed.
 */
-extern uint8_t SJA1105P_readArlTableEntryByAddress(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+static uint8_t findFreeEntry(uint16_t *p_freeEntryIndex, uint8_t switchId)
 {
-	uint8_t ret ;
+	uint8_t ret = 0;
+	uint8_t word;
 
-	ret = findEntryIndex(p_addressResolutionTableEntry);
-	if ((ret == 0U) && (p_addressResolutionTableEntry->index <= N_ARL_ENTRIES))
-	{  /* an entry was found */
-		ret = SJA1105P_readArlTableEntryByIndex(p_addressResolutionTableEntry);
+	*p_freeEntryIndex = N_ARL_ENTRIES;
+	if ((g_arlOccupancyValid == 0U) && (switchId == SJA1105P_MASTER_SWITCH))
+	{
+		ret = SJA1105P_synchArlOccupancy();
+	}
+
+	if ((ret == 0U) && (g_arlFullWords != FULL_WORD))
+	{
+		word = findFirstZeroBit(g_arlFullWords);
+		*p_freeEntryIndex = (uint16_t) (((uint16_t) word * OCCUPANCY_WORD_BITS) + findFirstZeroBit(g_arlOccupancy[word]));
 	}
 
 	return ret;
 }
 
 /**
-* \brief Read the entry from the Address Resolution table base on the index.
+* \brief Update the host side occupancy of an index
 *
-* A partial entry can be provided to this function containing only VLAN and MAC information.
-* The function will return the complete entry containing the full configuration of the entry.
+* \param[in]  index Index within the address resolution table
+* \param[in]  occupied 1 if a static entry was written, 0 if it was invalidated
+*/
+static void setEntryOccupancy(uint16_t index, uint8_t occupied)
+{
+	uint8_t  word = (uint8_t) (index / OCCUPANCY_WORD_BITS);
+	uint32_t bit  = ((uint32_t) 1) << (index % OCCUPANCY_WORD_BITS);
+
+	if (occupied == 1U)
+	{
+		g_arlOccupancy[word] |= bit;
+		if (g_arlOccupancy[word] == FULL_WORD)
+		{
+			g_arlFullWords |= ((uint32_t) 1) << word;
+		}
+	}
+	else
+	{
+		g_arlOccupancy[word] &= ~bit;
+		g_arlFullWords &= ~(((uint32_t) 1) << word);
+	}
+}
+
+/**
+* \brief Host side occupancy of an index
 *
-* \param[inout] p_addressResolutionTableEntry ARL entry that should be read (in: index. Out: complete entry)
+* \param[in]  index Index within the address resolution table
 *
-* \return uint8_t: Returns 0 when successful, else failed
+* \return uint8_t: 1 if a static entry is stored at the index, else 0
 */
-extern uint8_t SJA1105P_readArlTableEntryByIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+static uint8_t isEntryOccupied(uint16_t index)
 {
-	uint8_t  ret = 0;
-	uint8_t  switchId;
-	uint16_t logicalDestPorts;
-
-	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
-	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	return (uint8_t) ((g_arlOccupancy[index / OCCUPANCY_WORD_BITS] >> (index % OCCUPANCY_WORD_BITS)) & 1U);
+}
 
-	physicalArlTableEntry.index = p_addressResolutionTableEntry->index;
+/**
+* \brief Get the switches which may hold a static entry at an index
+*
+* \param[in]  index Index within the table
+*
+* \return uint8_t: One bit per switch, all switches if the content of the index is not known
+*/
+static uint8_t getEntrySwitches(uint16_t index)
+{
+	uint8_t switches = ALL_SWITCHES;
 
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	if ((g_arlOccupancyValid == 1U) && (index < N_ARL_ENTRIES))
 	{
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
-		if (switchId == 0U)
-		{
-			p_addressResolutionTableEntry->enabled = physicalArlTableControlStatus.valident;
-			convertFromPhysicalEntry(p_addressResolutionTableEntry, &physicalArlTableEntry, switchId);
-		}
-		else
-		{  /* for incremental switches, only update the port vector */
-			SJA1105P_getPortVectorFromPhysicalPortVector(physicalArlTableEntry.destports, switchId, &logicalDestPorts);
-			p_addressResolutionTableEntry->ports |= logicalDestPorts;
-		}
+		switches = g_arlSwitches[index];
 	}
 
-	return ret;
+	return switches;
 }
 
 /**
-* \brief Remove the entry from the Address Resolution table base on VLAN and MAC address information.
+* \brief Get the switches accessed by the index based functions
 *
-* \param[in] p_addressResolutionTableEntry ARL entry that should be removed
+* Indices not occupied by a static entry of the driver are accessed in all switches,
+* they may hold entries learned by the switches.
 *
-* \return uint8_t: Returns 0 when successful, else failed or entry didn't exist
+* \param[in]  index Index within the table
+*
+* \return uint8_t: One bit per switch
 */
-extern uint8_t SJA1105P_removeArlTableEntryByAddress(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+static uint8_t getIndexSwitches(uint16_t index)
 {
-	uint8_t ret;
+	uint8_t switches = ALL_SWITCHES;
 
-	ret = findEntryIndex(p_addressResolutionTableEntry);
-	if ((ret == 0U) && (p_addressResolutionTableEntry->index <= N_ARL_ENTRIES))
-	{  /* an entry was found */
-		ret = SJA1105P_removeArlTableEntryByIndex(p_addressResolutionTableEntry);
+	if ((index < N_ARL_ENTRIES) && (isEntryOccupied(index) == 1U))
+	{
+		switches = getEntrySwitches(index);
 	}
 
-	return ret;
+	return switches;
 }
 
 /**
-* \brief Remove the entry from the Address Resolution table base at a specific index
+* \brief Get the switches which need a copy of an entry
 *
-* \param[in] p_addressResolutionTableEntry ARL entry that should be removed
+* An entry matching a single VLAN is needed by the master switch, which holds all entries, and by
+* the switches in which the VLAN is configured. Frames of the VLAN are not forwarded by the others.
 *
-* \return uint8_t: Returns 0 when successful, else failed
+* \param[in]  kp_addressResolutionTableEntry Entry to be written
+*
+* \return uint8_t: One bit per switch
 */
-extern uint8_t SJA1105P_removeArlTableEntryByIndex(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry)
+static uint8_t getRequiredSwitches(const SJA1105P_addressResolutionTableEntry_t *kp_addressResolutionTableEntry)
 {
-	uint8_t ret = 0;
-	uint8_t switchId;
+	uint8_t switches = ALL_SWITCHES;
 
-	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
-	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	if ((g_arlVlanPruning == 1U) &&
+	    ((kp_addressResolutionTableEntry->p_extension == NULL) || ((kp_addressResolutionTableEntry->p_extension->vlanIdMask & VLAN_ID_MASK) == VLAN_ID_MASK)))
+	{
+		switches = MASTER_SWITCH_BIT | SJA1105P_getVlanSwitches(kp_addressResolutionTableEntry->vlanId);
+	}
 
-	physicalArlTableEntry.index = kp_addressResolutionTableEntry->index;
+	return switches;
+}
 
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+/**
+* \brief Record the switches holding a static entry at an index after it was written
+*
+* \param[in]  index Index within the table
+* \param[in]  switches Switches holding a copy if the write succeeded
+* \param[in]  written 1 if the write succeeded, 0 if the switches may hold their previous copies as well
+*/
+static void setEntrySwitches(uint16_t index, uint8_t switches, uint8_t written)
+{
+	if (index < N_ARL_ENTRIES)
 	{
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_INVALIDATE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+		if (written == 1U)
+		{
+			g_arlSwitches[index] = switches;
+		}
+		else
+		{
+			g_arlSwitches[index] |= switches;
+		}
 	}
-	return ret;
 }
 
 /**
-* \brief Start/Stop mirroring based on an entry in the ARL table
+* \brief Bucket of the key index for an address
 *
-* \param[in]  arlEntryIndex Index of the entry to be used for mirroring
-* \param[in]  enable 0 to turn mirroring off, 1 to start mirroring
+* \param[in]  macAddress MAC address of the entry
+* \param[in]  vlanId VLAN ID of the entry
 *
-* \return uint8_t: Returns 0 on success, else failed.
+* \return uint16_t: bucket
 */
-extern uint8_t SJA1105P_enableArlMirroring(uint16_t arlEntryIndex, uint8_t enable)
+static uint16_t getKeyBucket(uint64_t macAddress, uint16_t vlanId)
 {
-	uint8_t ret = 0;
-	uint8_t switchId;
+	uint32_t key = (uint32_t) (macAddress ^ (macAddress >> 24U)) ^ ((uint32_t) vlanId << 20U);
 
-	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
-	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	return (uint16_t) ((uint32_t) (key * GOLDEN_RATIO_32) >> (32U - KEY_BUCKET_BITS));
+}
+
+/**
+* \brief Add an occupied index to the key index
+*
+* \param[in]  index Index within the address resolution table
+* \param[in]  macAddress MAC address of the entry
+* \param[in]  vlanId VLAN ID of the entry
+*/
+static void linkEntryKey(uint16_t index, uint64_t macAddress, uint16_t vlanId)
+{
+	uint16_t bucket = getKeyBucket(macAddress, vlanId);
 
-	physicalArlTableEntry.index = arlEntryIndex;
+	g_arlKeyMac[index]     = macAddress;
+	g_arlKeyVlan[index]    = vlanId;
+	g_arlKeyNext[index]    = g_arlKeyBucket[bucket];
+	g_arlKeyBucket[bucket] = index;
+}
 
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+/**
+* \brief Remove an occupied index from the key index
+*
+* \param[in]  index Index within the address resolution table
+*/
+static void unlinkEntryKey(uint16_t index)
+{
+	uint16_t *p_link = &(g_arlKeyBucket[getKeyBucket(g_arlKeyMac[index], g_arlKeyVlan[index])]);
+
+	while (*p_link != N_ARL_ENTRIES)
 	{
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
-		physicalArlTableEntry.mirror = enable;
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_WRITE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+		if (*p_link == index)
+		{
+			*p_link = g_arlKeyNext[index];
+			break;
+		}
+		p_link = &(g_arlKeyNext[*p_link]);
 	}
+}
 
-	return ret;
+/**
+* \brief Position of the least significant zero bit in constant time
+*
+* \param[in]  value Word with at least one zero bit
+*
+* \return uint8_t: bit position
+*/
+static uint8_t findFirstZeroBit(uint32_t value)
+{
+	uint32_t lowestZero = (~value) & (value + 1U);  /* isolate the least significant zero as a single set bit */
+
+	return gk_debruijnBitPosition[(uint32_t) (lowestZero * DEBRUIJN_32) >> 27U];
 }
 
 /**
-* \brief Start/Stop retagging based on an entry in the ARL table
+* \brief Operation of the open batch on an index, created on first use
 *
-* \param[in]  arlEntryIndex Index of the entry to be used for retagging
-* \param[in]  retaggingVlanId VLAN ID used in the retagging process
-* \param[in]  enable 0 to turn retagging off, 1 to start retagging
+* A new operation records the host side state of the index before the batch.
 *
-* \return uint8_t: Returns 0 on success, else failed.
+* \param[in]  index Index within the address resolution table
+*
+* \return arlBatchOp_t*: operation of the index
 */
-extern uint8_t SJA1105P_enableArlRetagging(uint16_t arlEntryIndex, uint16_t retaggingVlanId, uint8_t enable)
+static arlBatchOp_t *getBatchOp(uint16_t index)
 {
-	uint8_t ret = 0;
-	uint8_t switchId;
+	arlBatchOp_t *p_op;
+
+	if (g_arlBatchOpOfIndex[index] == NO_BATCH_OP)
+	{  /* first modification of this index within the batch */
+		g_arlBatchOpOfIndex[index] = g_arlBatchNOps;
+		p_op = &(g_arlBatchOps[g_arlBatchNOps]);
+		g_arlBatchNOps++;
+
+		p_op->prev.physicalArlTableEntry.index   = index;
+		p_op->prev.physicalArlTableEntry.macaddr = g_arlKeyMac[index];
+		p_op->prev.physicalArlTableEntry.vlanid  = g_arlKeyVlan[index];
+		p_op->prev.ports = 0;
+		p_op->prev.valid = isEntryOccupied(index);
+	}
+	else
+	{
+		p_op = &(g_arlBatchOps[g_arlBatchOpOfIndex[index]]);
+	}
 
-	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
-	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	return p_op;
+}
 
-	physicalArlTableEntry.index = arlEntryIndex;
+/**
+* \brief Restore the host side occupancy and key index of all indices modified by the batch
+*/
+static void rollbackBatchOccupancy(void)
+{
+	uint16_t op;
+	uint16_t entryIndex;
+	const arlBatchContent_t *kp_prev;
 
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	for (op = 0; op < g_arlBatchNOps; op++)
 	{
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
-		physicalArlTableEntry.retag = enable;
-		physicalArlTableEntry.mirroredVlan = retaggingVlanId;
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_WRITE, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
+		kp_prev = &(g_arlBatchOps[op].prev);
+		entryIndex = kp_prev->physicalArlTableEntry.index;
+		if (isEntryOccupied(entryIndex) == 1U)
+		{
+			unlinkEntryKey(entryIndex);
+			setEntryOccupancy(entryIndex, 0U);
+		}
+		if (kp_prev->valid == 1U)
+		{
+			setEntryOccupancy(entryIndex, 1U);
+			linkEntryKey(entryIndex, kp_prev->physicalArlTableEntry.macaddr, kp_prev->physicalArlTableEntry.vlanid);
+		}
 	}
-	
-	return ret;
 }
 
-
 /**
-* \brief Find the index corresponding to a TCAM entry.
+* \brief Reads several entries of the TCAM within one SPI batch
+*
+* For each entry, the index and the READ command are written, followed by a read of the control
+* register and of the entry. If the control register shows that a command did not complete in
+* time, this entry is read again with ::executeTcamCommand.
 *
-* \param[inout] p_freeEntryIndex Index of the free index. Invalid index if entry is not found
-* \param[in]    switchId Reference to the physical switch on which the entry will be searched for
+* \param[in]    kp_index Indices of the entries to be read
+* \param[in]    nEntries Number of entries to be read, at most N_PIPELINED_READS
+* \param[out]   p_physicalArlTableEntry The entries read
+* \param[out]   p_physicalArlTableStatus The status of the control register after each read
+* \param[in]    switchId Reference to the physical switch on which the command will be executed
 *
 * \return uint8_t: Returns 0 on success, else failed.
 */
-static uint8_t findEntryIndex(SJA1105P_addressResolutionTableEntry_t *p_addressResolutionTableEntry)
+static uint8_t readEntryBatch(const uint16_t *kp_index, uint8_t nEntries, SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, SJA1105P_l2AddressLookupTableControlGetArgument_t *p_physicalArlTableStatus, uint8_t switchId)
 {
-	uint8_t ret;
+	uint8_t  ret;
+	uint8_t  i;
+	uint32_t statusRegister[N_PIPELINED_READS];
+	uint32_t entryRegister[N_PIPELINED_READS][SJA1105P_L2_ART_LOCKED_ENTRY_WORDS];
 
-	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
-	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry = {0};
+	SJA1105P_l2AddressLookupTableControlSetArgument_t controlSetArg;
 
-	convertToPhysicalEntry(p_addressResolutionTableEntry, &physicalArlTableEntry, SJA1105P_MASTER_SWITCH);
-	ret = executeTcamCommand(SJA1105P_e_hostCmd_SEARCH, &physicalArlTableEntry, &physicalArlTableControlStatus, SJA1105P_MASTER_SWITCH);
+	controlSetArg.valid     = 1;
+	controlSetArg.rdwrset   = 0;  /* read access */
+	controlSetArg.lockeds   = 1;
+	controlSetArg.valident  = 1;
+	controlSetArg.mgmtroute = 0;
+	controlSetArg.hostCmd   = SJA1105P_e_hostCmd_READ;
 
-	p_addressResolutionTableEntry->index = N_ARL_ENTRIES;  /* init with invalid index */
-	if (physicalArlTableControlStatus.valident == 1U)
+	ret = SJA1105P_spiQueueStart(switchId);
+	for (i = 0; i < nEntries; i++)
 	{
-		p_addressResolutionTableEntry->index = physicalArlTableEntry.index;
+		physicalArlTableEntry.index = kp_index[i];
+		ret += SJA1105P_setL2ArtLockedEntry(&physicalArlTableEntry, switchId);
+		ret += SJA1105P_setL2AddressLookupTableControl(&controlSetArg, switchId);
+		ret += SJA1105P_queueGetL2AddressLookupTableControl(&(statusRegister[i]), switchId);
+		ret += SJA1105P_queueGetL2ArtLockedEntry(entryRegister[i], switchId);
+	}
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
+	for (i = 0; (i < nEntries) && (ret == 0U); i++)
+	{
+		SJA1105P_decodeL2AddressLookupTableControl(statusRegister[i], &(p_physicalArlTableStatus[i]));
+		if ((p_physicalArlTableStatus[i].valid == 1U) || (p_physicalArlTableStatus[i].errors == 1U))
+		{  /* not complete when the entry was read */
+			p_physicalArlTableEntry[i] = physicalArlTableEntry;
+			p_physicalArlTableEntry[i].index = kp_index[i];
+			ret = executeTcamCommand(SJA1105P_e_hostCmd_READ, &(p_physicalArlTableEntry[i]), &(p_physicalArlTableStatus[i]), switchId);
+		}
+		else
+		{
+			SJA1105P_decodeL2ArtLockedEntry(entryRegister[i], &(p_physicalArlTableEntry[i]));
+		}
 	}
 
 	return ret;
 }
 
 /**
-* \brief Iterate through TCAM to find the first free entry
+* \brief Writes or invalidates several entries of the TCAM within one SPI batch
 *
-* \param[out]   p_freeEntryIndex Index of the free index. Invalid index if TCAM is full
-* \param[in]    switchId Reference to the physical switch on which the command will be executed
+* For each entry, the entry and the command are written, followed by a read of the control register.
+* If the control register shows that a command did not complete in time, the following commands
+* may have been ignored and are executed again with ::executeTcamCommand.
+*
+* \param[in]    kp_physicalArlTableEntry The entries to be written
+* \param[in]    kp_hostCmd Command per entry, SJA1105P_e_hostCmd_WRITE or SJA1105P_e_hostCmd_INVALIDATE
+* \param[in]    nEntries Number of entries to be written, at most N_PIPELINED_WRITES
+* \param[in]    switchId Reference to the physical switch on which the commands will be executed
 *
 * \return uint8_t: Returns 0 on success, else failed.
 */
-static uint8_t findFreeEntry(uint16_t *p_freeEntryIndex, uint8_t switchId)
+static uint8_t writeEntryBatch(const SJA1105P_l2ArtLockedEntryArgument_t *kp_physicalArlTableEntry, const SJA1105P_hostCmd_t *kp_hostCmd, uint8_t nEntries, uint8_t switchId)
 {
-	uint8_t ret = 0;
-	uint16_t entryIndex;
+	uint8_t  ret;
+	uint8_t  i;
+	uint8_t  inTime = 1;
+	uint32_t statusRegister[N_PIPELINED_WRITES];
+
 	SJA1105P_l2ArtLockedEntryArgument_t physicalArlTableEntry;
-	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableControlStatus;
+	SJA1105P_l2AddressLookupTableControlGetArgument_t physicalArlTableStatus;
+	SJA1105P_l2AddressLookupTableControlSetArgument_t controlSetArg;
 
-	*p_freeEntryIndex = N_ARL_ENTRIES;
-	for (entryIndex = 0; entryIndex < N_ARL_ENTRIES; entryIndex++)
+	controlSetArg.valid     = 1;
+	controlSetArg.rdwrset   = 1;  /* write access */
+	controlSetArg.lockeds   = 1;
+	controlSetArg.valident  = 1;
+	controlSetArg.mgmtroute = 0;
+
+	ret = SJA1105P_spiQueueStart(switchId);
+	for (i = 0; i < nEntries; i++)
 	{
-		physicalArlTableEntry.index = entryIndex;
-		ret += executeTcamCommand(SJA1105P_e_hostCmd_READ, &physicalArlTableEntry, &physicalArlTableControlStatus, switchId);
-		if ((ret != 0U) || (*p_freeEntryIndex != N_ARL_ENTRIES))
-		{  /* either on failure or success, break the loop */
-			break;
+		controlSetArg.hostCmd = kp_hostCmd[i];
+		ret += SJA1105P_setL2ArtLockedEntry(&(kp_physicalArlTableEntry[i]), switchId);
+		ret += SJA1105P_setL2AddressLookupTableControl(&controlSetArg, switchId);
+		ret += SJA1105P_queueGetL2AddressLookupTableControl(&(statusRegister[i]), switchId);
+	}
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
+	for (i = 0; (i < nEntries) && (ret == 0U); i++)
+	{
+		if (inTime == 1U)
+		{
+			SJA1105P_decodeL2AddressLookupTableControl(statusRegister[i], &physicalArlTableStatus);
+			if (physicalArlTableStatus.valid == 1U)
+			{  /* still busy when the next command was issued */
+				inTime = 0;
+			}
+			else if (physicalArlTableStatus.errors == 1U)
+			{
+				ret = 1;
+			}
+			else
+			{
+				/* command complete */
+			}
 		}
-		if ((physicalArlTableControlStatus.valident == 0U) ||
-		    (physicalArlTableControlStatus.lockeds == 0U))
-		{  /* There is no valid, static entry at this index */
-			*p_freeEntryIndex = entryIndex; /* use this index */
+		else
+		{
+			physicalArlTableEntry = kp_physicalArlTableEntry[i];
+			ret = executeTcamCommand(kp_hostCmd[i], &physicalArlTableEntry, &physicalArlTableStatus, switchId);
 		}
 	}
 
@@ -367,6 +1803,7 @@ static uint8_t findFreeEntry(uint16_t *p_freeEntryIndex, uint8_t switchId)
 static uint8_t executeTcamCommand(SJA1105P_hostCmd_t hostCmd, SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, SJA1105P_l2AddressLookupTableControlGetArgument_t *p_physicalArlTableStatus, uint8_t switchId)
 {
 	uint8_t ret;
+	uint32_t registerValue = 0;
 
 	SJA1105P_l2AddressLookupTableControlSetArgument_t controlSetArg;
 
@@ -389,19 +1826,19 @@ static uint8_t executeTcamCommand(SJA1105P_hostCmd_t hostCmd, SJA1105P_l2ArtLock
 			break;
 	}
 
-	ret  = SJA1105P_setL2ArtLockedEntry(p_physicalArlTableEntry, switchId);
+	/* entry and control are queued and transferred together with the first status poll */
+	ret  = SJA1105P_spiQueueStart(switchId);
+	ret += SJA1105P_setL2ArtLockedEntry(p_physicalArlTableEntry, switchId);
 	ret += SJA1105P_setL2AddressLookupTableControl(&controlSetArg, switchId);
 
-	do
-	{  /* check status until operation is complete or failed */
-		ret += SJA1105P_getL2AddressLookupTableControl(p_physicalArlTableStatus, switchId);
-	}
-	while ((p_physicalArlTableStatus->valid == 1U) && (ret == 0U));  /* Operation not yet complete, but no error */
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_L2_ADDRESS_LOOKUP, &registerValue, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+	SJA1105P_decodeL2AddressLookupTableControl(registerValue, p_physicalArlTableStatus);
 
-	/* complete read operations */
-	if ((ret == 0U) && (p_physicalArlTableStatus->errors == 0U))
+	/* complete read operations, a SEARCH miss is reported by the status and is not a failure */
+	if ((ret == 0U) && ((p_physicalArlTableStatus->errors == 0U) || (hostCmd == SJA1105P_e_hostCmd_SEARCH)))
 	{  /* operation complete and went fine */
-		if (controlSetArg.rdwrset == 0U)
+		if ((controlSetArg.rdwrset == 0U) && (p_physicalArlTableStatus->errors == 0U))
 		{
 			ret = SJA1105P_getL2ArtLockedEntry(p_physicalArlTableEntry, switchId);
 		}
@@ -435,7 +1872,7 @@ static void convertToPhysicalEntry(const SJA1105P_addressResolutionTableEntry_t
 	if (kp_arlTableEntry->p_extension == NULL)
 	{  /* No extended configuration, use default values */
 		p_physicalArlTableEntry->innerOuterVlan = 1;  /* outer VLAN */
-		p_physicalArlTableEntry->mask           = 1;  /* exact match */
+		p_physicalArlTableEntry->mask           = EXACT_MATCH_MASK;  /* exact match */
 		p_physicalArlTableEntry->retag          = 0;  /* no retagging */
 		p_physicalArlTableEntry->mirror         = 0;  /* no mirroring */
 		p_physicalArlTableEntry->mirroredVlan   = 0;  /* not applicable */
@@ -477,8 +1914,56 @@ static void convertFromPhysicalEntry(SJA1105P_addressResolutionTableEntry_t *p_a
 		p_arlTableEntry->p_extension->retaggingVlanId = kp_physicalArlTableEntry->mirroredVlan;
 
 		p_arlTableEntry->p_extension->vlanIdMask        = (uint16_t) (kp_physicalArlTableEntry->mask >> (MAC_ADDRESS_BYTES * BYTE));
-		p_arlTableEntry->p_extension->dstMacAddressMask = (uint16_t) (kp_physicalArlTableEntry->mask & MAC_ADDRESS_MASK);
+		p_arlTableEntry->p_extension->dstMacAddressMask = kp_physicalArlTableEntry->mask & MAC_ADDRESS_MASK;
 	}
 
 	SJA1105P_getPortVectorFromPhysicalPortVector(kp_physicalArlTableEntry->destports, switchId, &(p_arlTableEntry->ports));
 }
+
+/**
+* \brief Determine the first and the last switch holding one of the ports
+*
+* \param[in]  ports Logical destination ports of an entry
+* \param[out] p_firstDestSwitchId First switch, SJA1105P_N_SWITCHES if no port is set
+* \param[out] p_lastDestSwitchId Last switch, 0 if no port is set
+*
+*/
+static void getDestSwitchRange(uint16_t ports, uint8_t *p_firstDestSwitchId, uint8_t *p_lastDestSwitchId)
+{
+	uint8_t switchId;
+	uint8_t destSwitches;
+
+	*p_firstDestSwitchId = SJA1105P_N_SWITCHES;
+	*p_lastDestSwitchId  = 0;
+
+	SJA1105P_getSwitchesFromPorts(ports, &destSwitches);
+	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	{
+		if (((destSwitches >> switchId) & 1U) == 1U)
+		{  /* switchId is a destination of this MAC-VLAN combination */
+			*p_firstDestSwitchId = (*p_firstDestSwitchId == SJA1105P_N_SWITCHES) ? switchId : *p_firstDestSwitchId;
+			*p_lastDestSwitchId  = (switchId > *p_lastDestSwitchId) ? switchId : *p_lastDestSwitchId;
+		}
+	}
+}
+
+/**
+* \brief Add the cascade ports towards the destination switches of an entry
+*
+* \param[inout] p_physicalArlTableEntry Entry within the switch
+* \param[in]    firstDestSwitchId First switch holding a destination port
+* \param[in]    lastDestSwitchId Last switch holding a destination port
+* \param[in]    switchId Reference to the physical switch
+*
+*/
+static void addInterSwitchForwarding(SJA1105P_l2ArtLockedEntryArgument_t *p_physicalArlTableEntry, uint8_t firstDestSwitchId, uint8_t lastDestSwitchId, uint8_t switchId)
+{
+	if (switchId < lastDestSwitchId)
+	{  /* forward to next switch */
+		p_physicalArlTableEntry->destports |= (uint8_t) (((uint8_t) 1) << SJA1105P_g_generalParameters.cascPort[switchId]);
+	}
+	if (switchId > firstDestSwitchId)
+	{  /* forward to previous switch */
+		p_physicalArlTableEntry->destports |= (uint8_t) (((uint8_t) 1) << SJA1105P_g_generalParameters.hostPort[switchId]);
+	}
+}
@@ -0,0 +1,648 @@
+/******************************************************************************
+* Copyright (c) NXP B.V. 2016 - 2017. All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*****************************************************************************/
+
+/**
+*
+* \file NXP_SJA1105P_arlCompaction.c
+*
+* \author NXP Semiconductors
+*
+* \date 2017-07-04
+*
+* \brief Compaction of static address resolution entries into masked entries
+*
+* A set of static (MAC, VLAN, ports) entries is stored using masked entries of the
+* address resolution table. Consecutive addresses of the same VLAN forwarded to the
+* same ports are merged into aligned blocks, each matched by one entry on a prefix of
+* the 48 bit MAC address value. The blocks cover exactly the addresses of the set and
+* do not overlap, so forwarding is the same as with one exact entry per address.
+*
+* MAC addresses are given most significant octet first: the first octet of the
+* address on the wire is held in bits 47..40, as in the frames parsed by the
+* Ethernet interface. A prefix thus covers the leading octets of the address.
+* Callers holding the address as an octet array convert it accordingly, e.g. with
+* ether_addr_to_u64() in the Linux kernel, not by copying the array into the value.
+*
+*****************************************************************************/
+
+/******************************************************************************
+* INCLUDES
+*****************************************************************************/
+
+#include "NXP_SJA1105P_config.h"
+#include "NXP_SJA1105P_addressResolutionTable.h"
+#include "NXP_SJA1105P_arlCompaction.h"
+
+/******************************************************************************
+* Defines
+*****************************************************************************/
+
+#define N_ARL_ENTRIES SJA1105P_N_ARL_ENTRIES
+
+#define MAC_ADDRESS_BITS SJA1105P_MAC_ADDRESS_BITS
+#define MAC_ADDRESS_MASK (0xFFFFFFFFFFFFULL)
+#define VLAN_ID_MASK     (0x1FFFU)  /* VLAN ID and inner/outer VLAN flag are compared, as for exact entries */
+
+/******************************************************************************
+* INTERNAL VARIABLES
+*****************************************************************************/
+
+/* Entries programmed by this module in ascending order of (VLAN ID, MAC address).
+ * The blocks do not overlap, the entry covering an address is found by a binary search. */
+static SJA1105P_arlCompactedEntry_t g_compactedEntries[N_ARL_ENTRIES];
+static uint16_t g_nCompactedEntries   = 0;
+static uint32_t g_nCompactedAddresses = 0;
+
+/* Entries computed by a compaction or a split, taken over after success */
+static SJA1105P_arlCompactedEntry_t g_compactionResult[N_ARL_ENTRIES];
+
+/******************************************************************************
+* INTERNAL FUNCTION DECLARATIONS
+*****************************************************************************/
+
+static int8_t compareKeys(uint16_t vlanIdA, uint64_t dstMacAddressA, uint16_t vlanIdB, uint64_t dstMacAddressB);
+static void sortEntries(SJA1105P_arlCompactionEntry_t *p_entries, uint32_t nEntries);
+static void siftDown(SJA1105P_arlCompactionEntry_t *p_entries, uint32_t root, uint32_t nEntries);
+static uint8_t buildBlocks(const SJA1105P_arlCompactionEntry_t *kp_entries, uint32_t nEntries, uint16_t *p_nBlocks, uint32_t *p_nAddresses);
+static uint8_t addRunBlocks(uint64_t firstAddress, uint64_t lastAddress, uint16_t vlanId, uint16_t ports, uint16_t *p_nBlocks);
+static uint16_t searchEntry(uint64_t dstMacAddress, uint16_t vlanId);
+static uint8_t addBatchBlock(SJA1105P_arlCompactedEntry_t *p_compactedEntry);
+static uint8_t removeBatchBlock(const SJA1105P_arlCompactedEntry_t *kp_compactedEntry);
+static uint64_t getBlockSize(uint8_t prefixLength);
+static uint64_t getPrefixMask(uint8_t prefixLength);
+
+/******************************************************************************
+* FUNCTIONS
+*****************************************************************************/
+
+/**
+* \brief Program a set of static entries using as few table entries as possible
+*
+* The set replaces the set of the previous call. Only entries which differ from the
+* previous result are written, removed entries are invalidated first. All modifications
+* are written within one batch of the address resolution table, on failure the previous
+* result remains in place. The addresses of the set must not be configured by other
+* functions of the address resolution table.
+*
+* \param[in,out] p_entries Desired entries, sorted in place by VLAN ID and MAC address. An address may be given more than once with the same ports.
+* \param[in]     nEntries Number of desired entries
+*
+* \return uint8_t: Returns 0 when successful, else failed, conflicting ports for an address or the result does not fit into the table
+*/
+extern uint8_t SJA1105P_compactArlTable(SJA1105P_arlCompactionEntry_t *p_entries, uint32_t nEntries)
+{
+	uint8_t  ret;
+	int8_t   order;
+	uint16_t oldPos;
+	uint16_t newPos;
+	uint16_t nBlocks;
+	uint32_t nAddresses;
+	SJA1105P_arlCompactedEntry_t *p_oldEntry;
+	SJA1105P_arlCompactedEntry_t *p_newEntry;
+
+	sortEntries(p_entries, nEntries);
+	ret = buildBlocks(p_entries, nEntries, &nBlocks, &nAddresses);
+	if (ret == 0U)
+	{
+		ret = SJA1105P_beginArlBatch();
+	}
+
+	if (ret == 0U)
+	{
+		/* remove the entries which are not replaced in place first, the new entries may reuse their indices */
+		oldPos = 0;
+		newPos = 0;
+		while ((oldPos < g_nCompactedEntries) && (ret == 0U))
+		{
+			p_oldEntry = &(g_compactedEntries[oldPos]);
+			p_newEntry = &(g_compactionResult[newPos]);
+			order = (newPos < nBlocks) ? compareKeys(p_oldEntry->vlanId, p_oldEntry->dstMacAddress, p_newEntry->vlanId, p_newEntry->dstMacAddress) : -1;
+			if (order < 0)
+			{
+				ret = removeBatchBlock(p_oldEntry);
+				oldPos++;
+			}
+			else if (order > 0)
+			{
+				newPos++;
+			}
+			else
+			{
+				oldPos++;
+				newPos++;
+			}
+		}
+
+		/* add the new entries, an entry with the key of a previous one is overwritten in place */
+		oldPos = 0;
+		newPos = 0;
+		while ((newPos < nBlocks) && (ret == 0U))
+		{
+			p_oldEntry = &(g_compactedEntries[oldPos]);
+			p_newEntry = &(g_compactionResult[newPos]);
+			order = (oldPos < g_nCompactedEntries) ? compareKeys(p_oldEntry->vlanId, p_oldEntry->dstMacAddress, p_newEntry->vlanId, p_newEntry->dstMacAddress) : 1;
+			if (order < 0)
+			{
+				oldPos++;
+			}
+			else if (order > 0)
+			{
+				ret = addBatchBlock(p_newEntry);
+				newPos++;
+			}
+			else
+			{
+				if ((p_oldEntry->prefixLength == p_newEntry->prefixLength) && (p_oldEntry->ports == p_newEntry->ports))
+				{  /* unchanged */
+					p_newEntry->index = p_oldEntry->index;
+				}
+				else
+				{
+					ret = addBatchBlock(p_newEntry);
+				}
+				oldPos++;
+				newPos++;
+			}
+		}
+
+		if (ret == 0U)
+		{
+			ret = SJA1105P_commitArlBatch();
+		}
+		else
+		{
+			SJA1105P_abortArlBatch();
+		}
+	}
+
+	if (ret == 0U)
+	{
+		for (newPos = 0; newPos < nBlocks; newPos++)
+		{
+			g_compactedEntries[newPos] = g_compactionResult[newPos];
+		}
+		g_nCompactedEntries   = nBlocks;
+		g_nCompactedAddresses = nAddresses;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Remove a single address of the compacted set
+*
+* If the address is part of a larger block, the entry of the block is replaced by
+* one entry per remaining sub-block, all within one batch of the address resolution table.
+*
+* \param[in] dstMacAddress MAC address to be removed, most significant octet first
+* \param[in] vlanId VLAN ID of the address
+*
+* \return uint8_t: Returns 0 when successful, else failed, address not part of the set or the split entries do not fit into the table
+*/
+extern uint8_t SJA1105P_removeCompactedArlAddress(uint64_t dstMacAddress, uint16_t vlanId)
+{
+	uint8_t  ret = 1;
+	uint8_t  prefixLength;
+	uint16_t pos;
+	uint16_t i;
+	uint16_t nBlocks = 0;
+	SJA1105P_arlCompactedEntry_t removedEntry;
+
+	pos = searchEntry(dstMacAddress, vlanId);
+	if (pos < N_ARL_ENTRIES)
+	{
+		removedEntry = g_compactedEntries[pos];
+
+		/* the rest of the block consists of one block per longer prefix, in ascending order:
+		 * the blocks below the address with growing prefix length, then the blocks above with shrinking prefix length */
+		for (prefixLength = (uint8_t) (removedEntry.prefixLength + 1U); prefixLength <= MAC_ADDRESS_BITS; prefixLength++)
+		{
+			if ((dstMacAddress & getBlockSize(prefixLength)) != 0U)
+			{
+				g_compactionResult[nBlocks] = removedEntry;
+				g_compactionResult[nBlocks].dstMacAddress = (dstMacAddress & getPrefixMask(prefixLength)) ^ getBlockSize(prefixLength);
+				g_compactionResult[nBlocks].prefixLength  = prefixLength;
+				nBlocks++;
+			}
+		}
+		for (prefixLength = MAC_ADDRESS_BITS; prefixLength > removedEntry.prefixLength; prefixLength--)
+		{
+			if ((dstMacAddress & getBlockSize(prefixLength)) == 0U)
+			{
+				g_compactionResult[nBlocks] = removedEntry;
+				g_compactionResult[nBlocks].dstMacAddress = (dstMacAddress & getPrefixMask(prefixLength)) ^ getBlockSize(prefixLength);
+				g_compactionResult[nBlocks].prefixLength  = prefixLength;
+				nBlocks++;
+			}
+		}
+
+		ret = (((uint32_t) g_nCompactedEntries - 1U + nBlocks) <= N_ARL_ENTRIES) ? SJA1105P_beginArlBatch() : 1U;
+		if (ret == 0U)
+		{
+			ret = removeBatchBlock(&removedEntry);
+			for (i = 0; (i < nBlocks) && (ret == 0U); i++)
+			{
+				ret = addBatchBlock(&(g_compactionResult[i]));
+			}
+
+			if (ret == 0U)
+			{
+				ret = SJA1105P_commitArlBatch();
+			}
+			else
+			{
+				SJA1105P_abortArlBatch();
+			}
+		}
+
+		if (ret == 0U)
+		{  /* replace the entry by the sub-blocks, the order is kept */
+			if (nBlocks == 0U)
+			{
+				for (i = pos; (i + 1U) < g_nCompactedEntries; i++)
+				{
+					g_compactedEntries[i] = g_compactedEntries[i + 1U];
+				}
+			}
+			else
+			{
+				for (i = g_nCompactedEntries - 1U; i > pos; i--)
+				{
+					g_compactedEntries[i + nBlocks - 1U] = g_compactedEntries[i];
+				}
+				for (i = 0; i < nBlocks; i++)
+				{
+					g_compactedEntries[pos + i] = g_compactionResult[i];
+				}
+			}
+			g_nCompactedEntries = g_nCompactedEntries - 1U + nBlocks;
+			g_nCompactedAddresses--;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Find the compacted entry covering an address
+*
+* \param[in]  dstMacAddress MAC address, most significant octet first
+* \param[in]  vlanId VLAN ID of the address
+* \param[out] p_compactedEntry Entry whose block contains the address
+*
+* \return uint8_t: Returns 0 when successful, else the address is not part of the compacted set
+*/
+extern uint8_t SJA1105P_findCompactedArlEntry(uint64_t dstMacAddress, uint16_t vlanId, SJA1105P_arlCompactedEntry_t *p_compactedEntry)
+{
+	uint8_t  ret = 1;
+	uint16_t pos;
+
+	pos = searchEntry(dstMacAddress, vlanId);
+	if (pos < N_ARL_ENTRIES)
+	{
+		*p_compactedEntry = g_compactedEntries[pos];
+		ret = 0;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Get the size of the compacted set and the number of table entries saved
+*
+* \param[out] p_stats Memory location where the statistics are stored
+*/
+extern void SJA1105P_getArlCompactionStats(SJA1105P_arlCompactionStats_t *p_stats)
+{
+	p_stats->nAddresses  = g_nCompactedAddresses;
+	p_stats->nEntries    = g_nCompactedEntries;
+	p_stats->nSlotsSaved = g_nCompactedAddresses - g_nCompactedEntries;
+}
+
+/******************************************************************************
+* INTERNAL FUNCTIONS
+*****************************************************************************/
+
+/**
+* \brief Compare two keys in the order of the compacted entries
+*
+* \return int8_t: {-1: A before B, 0: equal, 1: A after B}
+*/
+static int8_t compareKeys(uint16_t vlanIdA, uint64_t dstMacAddressA, uint16_t vlanIdB, uint64_t dstMacAddressB)
+{
+	int8_t order = 0;
+
+	if ((vlanIdA < vlanIdB) || ((vlanIdA == vlanIdB) && (dstMacAddressA < dstMacAddressB)))
+	{
+		order = -1;
+	}
+	else if ((vlanIdA != vlanIdB) || (dstMacAddressA != dstMacAddressB))
+	{
+		order = 1;
+	}
+	else
+	{
+		/* equal */
+	}
+
+	return order;
+}
+
+/**
+* \brief Sort the desired entries by VLAN ID and MAC address (heapsort, no additional memory)
+*
+* \param[in,out] p_entries Entries to be sorted
+* \param[in]     nEntries Number of entries
+*/
+static void sortEntries(SJA1105P_arlCompactionEntry_t *p_entries, uint32_t nEntries)
+{
+	uint32_t i;
+	SJA1105P_arlCompactionEntry_t tmp;
+
+	for (i = nEntries / 2U; i > 0U; i--)
+	{
+		siftDown(p_entries, i - 1U, nEntries);
+	}
+	for (i = nEntries; i > 1U; i--)
+	{  /* move the largest entry behind the heap */
+		tmp = p_entries[0];
+		p_entries[0] = p_entries[i - 1U];
+		p_entries[i - 1U] = tmp;
+		siftDown(p_entries, 0, i - 1U);
+	}
+}
+
+/**
+* \brief Restore the heap property below a node
+*
+* \param[in,out] p_entries Heap
+* \param[in]     root Node to be moved down
+* \param[in]     nEntries Number of entries of the heap
+*/
+static void siftDown(SJA1105P_arlCompactionEntry_t *p_entries, uint32_t root, uint32_t nEntries)
+{
+	uint8_t  done = 0;
+	uint32_t parent = root;
+	uint32_t child;
+	SJA1105P_arlCompactionEntry_t tmp;
+
+	while ((((2U * parent) + 1U) < nEntries) && (done == 0U))
+	{
+		child = (2U * parent) + 1U;
+		if (((child + 1U) < nEntries) && (compareKeys(p_entries[child].vlanId, p_entries[child].dstMacAddress, p_entries[child + 1U].vlanId, p_entries[child + 1U].dstMacAddress) < 0))
+		{
+			child++;
+		}
+		if (compareKeys(p_entries[parent].vlanId, p_entries[parent].dstMacAddress, p_entries[child].vlanId, p_entries[child].dstMacAddress) < 0)
+		{
+			tmp = p_entries[parent];
+			p_entries[parent] = p_entries[child];
+			p_entries[child] = tmp;
+			parent = child;
+		}
+		else
+		{
+			done = 1;
+		}
+	}
+}
+
+/**
+* \brief Split the sorted desired entries into runs of consecutive addresses and store their blocks in g_compactionResult
+*
+* \param[in]  kp_entries Desired entries, sorted
+* \param[in]  nEntries Number of desired entries
+* \param[out] p_nBlocks Number of blocks stored
+* \param[out] p_nAddresses Number of distinct addresses
+*
+* \return uint8_t: Returns 0 when successful, else invalid address, conflicting ports for an address or too many blocks
+*/
+static uint8_t buildBlocks(const SJA1105P_arlCompactionEntry_t *kp_entries, uint32_t nEntries, uint16_t *p_nBlocks, uint32_t *p_nAddresses)
+{
+	uint8_t  ret = 0;
+	uint32_t i;
+	uint64_t firstAddress = 0;
+	uint64_t lastAddress = 0;
+	uint16_t vlanId = 0;
+	uint16_t ports = 0;
+	const SJA1105P_arlCompactionEntry_t *kp_entry;
+
+	*p_nBlocks = 0;
+	*p_nAddresses = 0;
+
+	for (i = 0; (i < nEntries) && (ret == 0U); i++)
+	{
+		kp_entry = &(kp_entries[i]);
+		if (kp_entry->dstMacAddress > MAC_ADDRESS_MASK)
+		{
+			ret = 1;
+		}
+		else if ((i > 0U) && (kp_entry->vlanId == vlanId) && (kp_entry->dstMacAddress == lastAddress))
+		{  /* same address again */
+			ret = (kp_entry->ports == ports) ? 0U : 1U;
+		}
+		else
+		{
+			if ((i > 0U) && (kp_entry->vlanId == vlanId) && (kp_entry->ports == ports) && (kp_entry->dstMacAddress == (lastAddress + 1U)))
+			{  /* the run continues */
+				lastAddress = kp_entry->dstMacAddress;
+			}
+			else
+			{
+				if (i > 0U)
+				{
+					ret = addRunBlocks(firstAddress, lastAddress, vlanId, ports, p_nBlocks);
+				}
+				firstAddress = kp_entry->dstMacAddress;
+				lastAddress  = kp_entry->dstMacAddress;
+				vlanId = kp_entry->vlanId;
+				ports  = kp_entry->ports;
+			}
+			(*p_nAddresses)++;
+		}
+	}
+	if ((nEntries > 0U) && (ret == 0U))
+	{
+		ret = addRunBlocks(firstAddress, lastAddress, vlanId, ports, p_nBlocks);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Cover a run of consecutive addresses with the minimal number of aligned blocks
+*
+* \param[in]     firstAddress First address of the run
+* \param[in]     lastAddress Last address of the run
+* \param[in]     vlanId VLAN ID of the run
+* \param[in]     ports Destination ports of the run
+* \param[in,out] p_nBlocks Number of blocks stored in g_compactionResult
+*
+* \return uint8_t: Returns 0 when successful, else the blocks do not fit into the table
+*/
+static uint8_t addRunBlocks(uint64_t firstAddress, uint64_t lastAddress, uint16_t vlanId, uint16_t ports, uint16_t *p_nBlocks)
+{
+	uint8_t  ret = 0;
+	uint8_t  done = 0;
+	uint8_t  prefixLength;
+	uint64_t dstMacAddress = firstAddress;
+	SJA1105P_arlCompactedEntry_t *p_block;
+
+	while ((done == 0U) && (ret == 0U))
+	{
+		/* largest block aligned to the address which does not leave the run */
+		prefixLength = MAC_ADDRESS_BITS;
+		while ((prefixLength > 0U) && ((dstMacAddress & (getBlockSize(prefixLength - 1U) - 1U)) == 0U) && ((lastAddress - dstMacAddress) >= (getBlockSize(prefixLength - 1U) - 1U)))
+		{
+			prefixLength--;
+		}
+
+		if (*p_nBlocks < N_ARL_ENTRIES)
+		{
+			p_block = &(g_compactionResult[*p_nBlocks]);
+			p_block->dstMacAddress = dstMacAddress;
+			p_block->vlanId        = vlanId;
+			p_block->ports         = ports;
+			p_block->index         = N_ARL_ENTRIES;
+			p_block->prefixLength  = prefixLength;
+			(*p_nBlocks)++;
+		}
+		else
+		{
+			ret = 1;
+		}
+
+		if ((lastAddress - dstMacAddress) < getBlockSize(prefixLength))
+		{  /* end of the run reached */
+			done = 1;
+		}
+		else
+		{
+			dstMacAddress += getBlockSize(prefixLength);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Find the compacted entry whose block contains an address
+*
+* \return uint16_t: Position within g_compactedEntries, N_ARL_ENTRIES if the address is not covered
+*/
+static uint16_t searchEntry(uint64_t dstMacAddress, uint16_t vlanId)
+{
+	uint16_t low  = 0;
+	uint16_t high = g_nCompactedEntries;
+	uint16_t middle;
+	uint16_t pos = N_ARL_ENTRIES;
+	const SJA1105P_arlCompactedEntry_t *kp_entry;
+
+	/* first entry starting behind the address */
+	while (low < high)
+	{
+		middle = low + ((high - low) / 2U);
+		if (compareKeys(g_compactedEntries[middle].vlanId, g_compactedEntries[middle].dstMacAddress, vlanId, dstMacAddress) <= 0)
+		{
+			low = middle + 1U;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	/* only the entry before may contain the address */
+	if (low > 0U)
+	{
+		kp_entry = &(g_compactedEntries[low - 1U]);
+		if ((kp_entry->vlanId == vlanId) && ((dstMacAddress & getPrefixMask(kp_entry->prefixLength)) == kp_entry->dstMacAddress))
+		{
+			pos = low - 1U;
+		}
+	}
+
+	return pos;
+}
+
+/**
+* \brief Add the entry of a block to the open batch
+*
+* \param[in,out] p_compactedEntry Block to be added. After success, the index field is updated.
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+static uint8_t addBatchBlock(SJA1105P_arlCompactedEntry_t *p_compactedEntry)
+{
+	uint8_t ret;
+	SJA1105P_addressResolutionTableEntry_t entry = {0};
+	SJA1105P_extendedAddressResolutionTableEntry_t extension = {0};
+
+	entry.dstMacAddress = p_compactedEntry->dstMacAddress;
+	entry.vlanId        = p_compactedEntry->vlanId;
+	entry.ports         = p_compactedEntry->ports;
+	if (p_compactedEntry->prefixLength < MAC_ADDRESS_BITS)
+	{  /* single addresses use the default exact match */
+		extension.dstMacAddressMask = getPrefixMask(p_compactedEntry->prefixLength);
+		extension.vlanIdMask        = VLAN_ID_MASK;
+		extension.innerOuterVlan    = 1;  /* outer VLAN */
+		entry.p_extension = &extension;
+	}
+
+	ret = SJA1105P_addArlBatchEntry(&entry);
+	p_compactedEntry->index = entry.index;
+
+	return ret;
+}
+
+/**
+* \brief Remove the entry of a block within the open batch
+*
+* \param[in] kp_compactedEntry Block to be removed
+*
+* \return uint8_t: Returns 0 when successful, else failed
+*/
+static uint8_t removeBatchBlock(const SJA1105P_arlCompactedEntry_t *kp_compactedEntry)
+{
+	SJA1105P_addressResolutionTableEntry_t entry = {0};
+
+	entry.dstMacAddress = kp_compactedEntry->dstMacAddress;
+	entry.vlanId        = kp_compactedEntry->vlanId;
+
+	return SJA1105P_removeArlBatchEntry(&entry);
+}
+
+/**
+* \brief Number of addresses within a block
+*/
+static uint64_t getBlockSize(uint8_t prefixLength)
+{
+	return ((uint64_t) 1) << (MAC_ADDRESS_BITS - prefixLength);
+}
+
+/**
+* \brief MAC address mask of a block, the bits of the prefix are set
+*/
+static uint64_t getPrefixMask(uint8_t prefixLength)
+{
+	return MAC_ADDRESS_MASK & ~(getBlockSize(prefixLength) - 1U);
+}
@@ -39,6 +39,7 @@
 #include "typedefs.h"
 
 #include "NXP_SJA1105P_switchCore.h"
+#include "NXP_SJA1105P_spi.h"
 #include "NXP_SJA1105P_auxiliaryConfigurationUnit.h"
 #include "NXP_SJA1105P_cbs.h"
 #include "NXP_SJA1105P_config.h"
@@ -178,7 +179,6 @@ extern uint8_t SJA1105P_deregisterStreamFromCbs(uint16_t maxFrameSize, uint16_t
 extern uint8_t SJA1105P_configCbs(const SJA1105P_creditBasedShaperParameters_t *kp_cbsParameters, uint8_t port, uint8_t vlanPrio)
 {
 	uint8_t ret = 0;
-	uint8_t errors;
 	uint8_t logicalShaperId =  SJA1105P_INVALID_SHAPER_ID;
 	SJA1105P_creditBasedShapingControlArgument_t control;
 	SJA1105P_creditBasedShapingEntryArgument_t entry;
@@ -200,10 +200,11 @@ extern uint8_t SJA1105P_configCbs(const SJA1105P_creditBasedShaperParameters_t *
 			entry.sendSlope = kp_cbsParameters->sendSlope;
 			entry.creditHi  = kp_cbsParameters->creditHi;
 			entry.creditLo  = kp_cbsParameters->creditLo;
+			ret += SJA1105P_spiQueueStart(physicalPort.switchId);
 			ret += SJA1105P_setCreditBasedShapingEntry(&entry, physicalPort.switchId);
 			ret += SJA1105P_setCreditBasedShapingControl(&control, physicalPort.switchId);
-			ret += SJA1105P_getCreditBasedShapingControl(&errors, physicalPort.switchId);
-			ret = (errors != 0U) ? (ret + 1U) : (ret);
+			ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_CREDIT_BASED_SHAPING, NULL, physicalPort.switchId);
+			ret += SJA1105P_spiQueueCommit(physicalPort.switchId, NULL, NULL);
 		}
 	}
 	logicalShaperId = (ret == 0U) ? (logicalShaperId) : (SJA1105P_INVALID_SHAPER_ID);
@@ -221,7 +222,6 @@ extern uint8_t SJA1105P_configCbs(const SJA1105P_creditBasedShaperParameters_t *
 extern uint8_t SJA1105P_removeCbs(uint8_t shaperId)
 {
 	uint8_t ret;
-	uint8_t errors;
 	uint8_t physicalShaperId;
 	uint8_t switchId;
 	SJA1105P_creditBasedShapingControlArgument_t control;
@@ -237,10 +237,11 @@ extern uint8_t SJA1105P_removeCbs(uint8_t shaperId)
 	entry.idleSlope = 0;
 	entry.sendSlope = 0;
 
-	ret  = SJA1105P_setCreditBasedShapingEntry(&entry, switchId);
+	ret  = SJA1105P_spiQueueStart(switchId);
+	ret += SJA1105P_setCreditBasedShapingEntry(&entry, switchId);
 	ret += SJA1105P_setCreditBasedShapingControl(&control, switchId);
-	ret += SJA1105P_getCreditBasedShapingControl(&errors, switchId);
-	ret = (errors != 0U) ? (ret + 1U) : (ret);
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_CREDIT_BASED_SHAPING, NULL, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
 
 	return ret;
 }
@@ -357,8 +358,14 @@ static uint8_t getCbsEntry(SJA1105P_creditBasedShapingEntryArgument_t *p_entry,
 	SJA1105P_creditBasedShapingControlArgument_t control = {1, 0, 0};  /* read access */
 
 	control.shaperId = physicalShaperId;
-	ret  = SJA1105P_setCreditBasedShapingControl(&control, switchId);
-	ret += SJA1105P_getCreditBasedShapingEntry(p_entry, switchId);
+	ret  = SJA1105P_spiQueueStart(switchId);
+	ret += SJA1105P_setCreditBasedShapingControl(&control, switchId);
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_CREDIT_BASED_SHAPING, NULL, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+	if (ret == 0U)
+	{  /* the entry is only valid once the read command completed */
+		ret = SJA1105P_getCreditBasedShapingEntry(p_entry, switchId);
+	}
 
 	return ret;
 }
@@ -42,6 +42,8 @@
 #include "NXP_SJA1105P_portConfig.h"
 #include "NXP_SJA1105P_switchCore.h"
 #include "NXP_SJA1105P_auxiliaryConfigurationUnit.h"
+#include "NXP_SJA1105P_addressResolutionTable.h"
+#include "NXP_SJA1105P_vlan.h"
 
 /******************************************************************************
 * DEFINES
@@ -163,6 +165,9 @@ extern uint8_t SJA1105P_initSwitch(void)
 * Settings updated:
 *   - General parameters
 *   - AVB parameters
+*   - Occupancy of the static address resolution table entries
+*   - Shadow of the VLAN lookup table and port based VLANs, loaded again from the switches on demand
+*   - Retagging rules, the static configuration is assumed to hold no retagging entries
 *
 * \return uint8_t: {0: successful, else: failed}
 */
@@ -185,6 +190,7 @@ extern uint8_t SJA1105P_synchSwitchConfiguration(void)
 		/* read */
 		generalParametersControlSet.rdwrset = 0;  /* read access */
 		ret += SJA1105P_setGeneralParametersControl(&generalParametersControlSet, switchId);
+		ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_GENERAL_PARAMETERS, NULL, switchId);
 		ret += SJA1105P_getGeneralParametersEntry(&generalParametersEntry, switchId);
 		/* modify SW configuration */
 		SJA1105P_g_generalParameters.switchId[switchId]   = generalParametersEntry.id;
@@ -213,6 +219,7 @@ extern uint8_t SJA1105P_synchSwitchConfiguration(void)
 	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
 	{
 		ret += SJA1105P_setAvbParametersControl(&avbParametersControl, switchId);
+		ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_AVB_PARAMETERS, NULL, switchId);
 		ret += SJA1105P_getAvbParametersEntry(&avbParametersEntry, switchId);
 		if (switchId == SJA1105P_MASTER_SWITCH)
 		{  /* These settings are required to be equal across the cascaded switches and will only be read once */
@@ -230,6 +237,14 @@ extern uint8_t SJA1105P_synchSwitchConfiguration(void)
 		}
 	}
 
+	/* VLAN lookup, retagging and address resolution table */
+	SJA1105P_resetVlanShadow();
+	SJA1105P_resetRetagging();
+	if (ret == 0U)
+	{
+		ret = SJA1105P_synchArlOccupancy();
+	}
+
 	return ret;
 }
 
@@ -40,6 +40,7 @@
 
 #include "NXP_SJA1105P_diagnostics.h"
 #include "NXP_SJA1105P_switchCore.h"
+#include "NXP_SJA1105P_spi.h"
 #include "NXP_SJA1105P_config.h"
 #include "NXP_SJA1105P_auxiliaryConfigurationUnit.h"
 
@@ -49,6 +50,19 @@
 
 #define N_TRESHOLDS ((uint8_t) SJA1105P_e_tempThreshold_POSITIVE135P5 - (uint8_t) SJA1105P_e_tempThreshold_NOT_VALID)
 
+/* raw words of a port read by SJA1105P_getPortCounters, the register blocks one after the other */
+#define HL_DC_1_OFFSET  (0U)
+#define HL_DC_2_OFFSET  (HL_DC_1_OFFSET + SJA1105P_HL_DIAGN_COUNTERS_1_WORDS)
+#define HL_DCO_OFFSET   (HL_DC_2_OFFSET + 4U)  /* occupancy of queue 0 */
+#define ETH_STAT_OFFSET (HL_DC_2_OFFSET + SJA1105P_HL_DIAGN_COUNTERS_2_WORDS)
+#define MAC_LDC_OFFSET  (ETH_STAT_OFFSET + SJA1105P_ETH_STAT_COUNTERS_WORDS)
+#define N_PORT_COUNTER_WORDS (MAC_LDC_OFFSET + 1U)
+
+#define N_COUNTER_DESCRIPTORS (36U)
+
+#define INGRESS ((uint8_t) SJA1105P_e_etherStatDirection_INGRESS)
+#define EGRESS  ((uint8_t) SJA1105P_e_etherStatDirection_EGRESS)
+
 /******************************************************************************
 * INTERNAL TYPE DEFINITIONS
 *****************************************************************************/
@@ -56,12 +70,76 @@
 typedef uint8_t (*get64bitCounter_cb_t) (uint64_t *p_counterValue, uint8_t port, uint8_t switchId);
 typedef uint8_t (*get32bitCounter_cb_t) (uint32_t *p_counterValue, uint8_t port, uint8_t switchId);
 
+/* location of a counter within the raw words of a port */
+typedef struct
+{
+	uint8_t offset;     /**< Index of the first word of the counter */
+	uint8_t width;      /**< Number of words, 2 for the counters of ::SJA1105P_etherStat64_t, else 1 */
+	uint8_t ovlpShift;  /**< Shift of the second word of a counter overlapping two words */
+	uint8_t counter;    /**< ::SJA1105P_etherStat64_t or ::SJA1105P_etherStat32_t, depending on the width */
+	uint8_t direction;  /**< INGRESS or EGRESS */
+} counterDescriptor_t;
+
+/******************************************************************************
+* INTERNAL VARIABLES
+*****************************************************************************/
+
+static const counterDescriptor_t gk_counterDescriptors[N_COUNTER_DESCRIPTORS] =
+{
+	/* hl_diagn_counters_1 */
+	{HL_DC_1_OFFSET + 0x0U,  2U, SJA1105P_HL_DC_1_0_N_TXBYTE_SHIFT_OVLP, (uint8_t) SJA1105P_e_etherStat64_N_OCTETS, EGRESS},
+	{HL_DC_1_OFFSET + 0x2U,  2U, SJA1105P_HL_DC_1_1_N_TXFRM_SHIFT_OVLP,  (uint8_t) SJA1105P_e_etherStat64_N_PKTS,   EGRESS},
+	{HL_DC_1_OFFSET + 0x4U,  2U, SJA1105P_HL_DC_1_2_N_RXBYTE_SHIFT_OVLP, (uint8_t) SJA1105P_e_etherStat64_N_OCTETS, INGRESS},
+	{HL_DC_1_OFFSET + 0x6U,  2U, SJA1105P_HL_DC_1_3_N_RXFRM_SHIFT_OVLP,  (uint8_t) SJA1105P_e_etherStat64_N_PKTS,   INGRESS},
+	{HL_DC_1_OFFSET + 0x8U,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_POLERR,  INGRESS},
+	{HL_DC_1_OFFSET + 0xbU,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_CRCERR,  INGRESS},
+	{HL_DC_1_OFFSET + 0xcU,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_SIZEERR, INGRESS},
+	{HL_DC_1_OFFSET + 0xeU,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_VLANERR, INGRESS},
+	{HL_DC_1_OFFSET + 0xfU,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_N664ERR, INGRESS},
+
+	/* hl_diagn_counters_2 */
+	{HL_DC_2_OFFSET + 0x0U,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_NOT_REACH,    EGRESS},
+	{HL_DC_2_OFFSET + 0x1U,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_EGR_DISABLED, EGRESS},
+	{HL_DC_2_OFFSET + 0x2U,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_PART_DROP,    INGRESS},
+	{HL_DC_2_OFFSET + 0x3U,  1U, 0U,  (uint8_t) SJA1105P_e_etherStat32_N_QFULL,        EGRESS},
+
+	/* eth_stat_counters */
+	{ETH_STAT_OFFSET + 0x00U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_BROADCAST_PKTS,           INGRESS},
+	{ETH_STAT_OFFSET + 0x01U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_MULTICAST_PKTS,           INGRESS},
+	{ETH_STAT_OFFSET + 0x02U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_64_OCTETS,           INGRESS},
+	{ETH_STAT_OFFSET + 0x03U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_65_TO_127_OCTETS,    INGRESS},
+	{ETH_STAT_OFFSET + 0x04U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_128_TO_255_OCTETS,   INGRESS},
+	{ETH_STAT_OFFSET + 0x05U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_256_TO_511_OCTETS,   INGRESS},
+	{ETH_STAT_OFFSET + 0x06U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_512_TO_1023_OCTETS,  INGRESS},
+	{ETH_STAT_OFFSET + 0x07U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_1024_TO_1518_OCTETS, INGRESS},
+	{ETH_STAT_OFFSET + 0x08U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_BROADCAST_PKTS,           EGRESS},
+	{ETH_STAT_OFFSET + 0x09U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_MULTICAST_PKTS,           EGRESS},
+	{ETH_STAT_OFFSET + 0x0aU, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_64_OCTETS,           EGRESS},
+	{ETH_STAT_OFFSET + 0x0bU, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_65_TO_127_OCTETS,    EGRESS},
+	{ETH_STAT_OFFSET + 0x0cU, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_128_TO_255_OCTETS,   EGRESS},
+	{ETH_STAT_OFFSET + 0x0dU, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_256_TO_511_OCTETS,   EGRESS},
+	{ETH_STAT_OFFSET + 0x0eU, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_512_TO_1023_OCTETS,  EGRESS},
+	{ETH_STAT_OFFSET + 0x0fU, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_PKTS_1024_TO_1518_OCTETS, EGRESS},
+	{ETH_STAT_OFFSET + 0x10U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_UNTAGGED_DROP,            INGRESS},
+	{ETH_STAT_OFFSET + 0x11U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_SINGLE_INNER_DROP,        INGRESS},
+	{ETH_STAT_OFFSET + 0x12U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_SINGLE_OUTER_DROP,        INGRESS},
+	{ETH_STAT_OFFSET + 0x13U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_DOUBLE_TAGGED_DROP,       INGRESS},
+	{ETH_STAT_OFFSET + 0x14U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_ILLEGAL_DOUBLE_DROP,      INGRESS},
+	{ETH_STAT_OFFSET + 0x15U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_EMPTY_ROUTE_DROP,         INGRESS},
+	{ETH_STAT_OFFSET + 0x16U, 1U, 0U, (uint8_t) SJA1105P_e_etherStat32_N_ADDR_NOT_LEARNED_DROP,    INGRESS}
+};
+
+/* MAC level errors per port, the hardware register is cleared on read */
+static SJA1105P_macLevelErrors_t g_macLevelErrors[SJA1105P_N_LOGICAL_PORTS];
+
 /******************************************************************************
 * INTERNAL FUNCTION DECLARATIONS
 *****************************************************************************/
 
 static uint8_t calculate64bitCounter(uint64_t *p_counterValue, get64bitCounter_cb_t pf_getEgressCounter, get64bitCounter_cb_t pf_getIngressCounter, SJA1105P_etherStatDirection_t direction, const SJA1105P_port_t *kp_physicalPort);
 static uint8_t calculate32bitCounter(uint32_t *p_counterValue, get32bitCounter_cb_t pf_getEgressCounter, get32bitCounter_cb_t pf_getIngressCounter, SJA1105P_etherStatDirection_t direction, const SJA1105P_port_t *kp_physicalPort);
+static void accumulateMacErrors(uint8_t port, const SJA1105P_macLevelDiagnCountersArgument_t *kp_macLevelDiagnCounters);
+static void decodePortCounters(const uint32_t *kp_registerValue, SJA1105P_portCounters_t *p_portCounters);
 
 /******************************************************************************
 * FUNCTIONS
@@ -260,22 +338,126 @@ extern uint8_t SJA1105P_getMacErrors(SJA1105P_macLevelErrors_t *p_macLevelErrors
 	uint8_t ret = 1;
 	SJA1105P_macLevelDiagnCountersArgument_t macLevelDiagnCountersArgument;
 	SJA1105P_port_t physicalPort;
-	static SJA1105P_macLevelErrors_t macLevelErrors[SJA1105P_N_LOGICAL_PORTS];
 
 	if (SJA1105P_getPhysicalPort(port, &physicalPort) == 0U)
 	{
-		ret = SJA1105P_getMacLevelDiagnCounters(&macLevelDiagnCountersArgument, physicalPort.physicalPort, physicalPort.switchId);
-		/* accumulate MAC errors. The hardware register is cleared on read */
-		macLevelErrors[port].nRunt     += (uint32_t) macLevelDiagnCountersArgument.nRunt;
-		macLevelErrors[port].nSoferr   += (uint32_t) macLevelDiagnCountersArgument.nSoferr;
-		macLevelErrors[port].nAlignerr += (uint32_t) macLevelDiagnCountersArgument.nAlignerr;
-		macLevelErrors[port].nMiierr   += (uint32_t) macLevelDiagnCountersArgument.nMiierr;
-		*p_macLevelErrors = macLevelErrors[port];
+		/* the batch holds the transport lock of the switch, which serializes the accumulation */
+		ret = SJA1105P_spiQueueStart(physicalPort.switchId);
+		if (ret == 0U)
+		{
+			ret = SJA1105P_getMacLevelDiagnCounters(&macLevelDiagnCountersArgument, physicalPort.physicalPort, physicalPort.switchId);
+			if (ret == 0U)
+			{
+				accumulateMacErrors(port, &macLevelDiagnCountersArgument);
+				*p_macLevelErrors = g_macLevelErrors[port];
+			}
+			ret += SJA1105P_spiQueueCommit(physicalPort.switchId, NULL, NULL);
+		}
+	}
+
+	return ret;
+}
+
+static void accumulateMacErrors(uint8_t port, const SJA1105P_macLevelDiagnCountersArgument_t *kp_macLevelDiagnCounters)
+{
+	/* accumulate MAC errors. The hardware register is cleared on read, so the caller
+	 * holds the transport lock of the switch from the read up to here */
+	g_macLevelErrors[port].nRunt     += (uint32_t) kp_macLevelDiagnCounters->nRunt;
+	g_macLevelErrors[port].nSoferr   += (uint32_t) kp_macLevelDiagnCounters->nSoferr;
+	g_macLevelErrors[port].nAlignerr += (uint32_t) kp_macLevelDiagnCounters->nAlignerr;
+	g_macLevelErrors[port].nMiierr   += (uint32_t) kp_macLevelDiagnCounters->nMiierr;
+}
+
+/**
+* \brief Retrieve all counters of a port
+*
+* The diagnostic, Ethernet statistic and MAC level counter blocks of the port
+* are read with one burst each, within a single SPI batch, instead of one read
+* per counter. The raw words are split into the counters by the descriptor table
+* gk_counterDescriptors.
+*
+* \param[out] p_portCounters Pointer to the counters of the port
+* \param[in]  port Number of the port where the statistics are requested
+*
+* \return uint8_t Returns 0 upon success, else failed
+*/
+extern uint8_t SJA1105P_getPortCounters(SJA1105P_portCounters_t *p_portCounters, uint8_t port)
+{
+	uint8_t ret = 1;
+	uint8_t queue;
+	uint32_t registerValue[N_PORT_COUNTER_WORDS];
+	SJA1105P_macLevelDiagnCountersArgument_t macLevelDiagnCountersArgument;
+	SJA1105P_hlDiagnCountersOccupancyArgument_t hlDiagnCountersOccupancyArgument;
+	SJA1105P_port_t physicalPort;
+
+	if (SJA1105P_getPhysicalPort(port, &physicalPort) == 0U)
+	{
+		/* the outer batch holds the transport lock of the switch, which serializes the accumulation
+		 * of the MAC level errors. The commit of the inner batch transfers the reads */
+		ret = SJA1105P_spiQueueStart(physicalPort.switchId);
+		if (ret == 0U)
+		{
+			ret  = SJA1105P_spiQueueStart(physicalPort.switchId);
+			ret += SJA1105P_queueGetHlDiagnCounters1(&registerValue[HL_DC_1_OFFSET], physicalPort.physicalPort, physicalPort.switchId);
+			ret += SJA1105P_queueGetHlDiagnCounters2(&registerValue[HL_DC_2_OFFSET], physicalPort.physicalPort, physicalPort.switchId);
+			ret += SJA1105P_queueGetEthStatCounters(&registerValue[ETH_STAT_OFFSET], physicalPort.physicalPort, physicalPort.switchId);
+			ret += SJA1105P_queueGetMacLevelDiagnCounters(&registerValue[MAC_LDC_OFFSET], physicalPort.physicalPort, physicalPort.switchId);
+			ret += SJA1105P_spiQueueCommit(physicalPort.switchId, NULL, NULL);
+
+			if (ret == 0U)
+			{
+				SJA1105P_decodeMacLevelDiagnCounters(registerValue[MAC_LDC_OFFSET], &macLevelDiagnCountersArgument);
+				accumulateMacErrors(port, &macLevelDiagnCountersArgument);
+				p_portCounters->macLevelErrors = g_macLevelErrors[port];
+			}
+			ret += SJA1105P_spiQueueCommit(physicalPort.switchId, NULL, NULL);
+		}
+
+		if (ret == 0U)
+		{
+			decodePortCounters(registerValue, p_portCounters);
+
+			for (queue = 0; queue < SJA1105P_N_EGRESS_QUEUES; queue++)
+			{
+				SJA1105P_decodeHlDiagnCountersOccupancy(registerValue[HL_DCO_OFFSET + queue], &hlDiagnCountersOccupancyArgument);
+				p_portCounters->qOccupancy[queue]         = hlDiagnCountersOccupancyArgument.qOccupancy;
+				p_portCounters->qOccupancyHighWatt[queue] = hlDiagnCountersOccupancyArgument.qOccupancyHighWatt;
+			}
+		}
 	}
 
 	return ret;
 }
 
+static void decodePortCounters(const uint32_t *kp_registerValue, SJA1105P_portCounters_t *p_portCounters)
+{
+	uint8_t i;
+	uint64_t counterValue;
+	const counterDescriptor_t *kp_descriptor;
+
+	/* unidirectional counters are only found at one direction */
+	for (i = 0; i < SJA1105P_N_ETHER_STAT32; i++)
+	{
+		p_portCounters->etherStat32[i][INGRESS] = 0;
+		p_portCounters->etherStat32[i][EGRESS]  = 0;
+	}
+
+	for (i = 0; i < N_COUNTER_DESCRIPTORS; i++)
+	{
+		kp_descriptor = &gk_counterDescriptors[i];
+		counterValue  = (uint64_t) kp_registerValue[kp_descriptor->offset];
+		if (kp_descriptor->width == 2U)
+		{
+			counterValue |= (uint64_t) ((uint64_t) kp_registerValue[kp_descriptor->offset + 1U] << kp_descriptor->ovlpShift);
+			p_portCounters->etherStat64[kp_descriptor->counter][kp_descriptor->direction] = counterValue;
+		}
+		else
+		{
+			p_portCounters->etherStat32[kp_descriptor->counter][kp_descriptor->direction] = (uint32_t) counterValue;
+		}
+	}
+}
+
 /**
 * \brief Retrieve the temperature sensor reading from the switches
 *
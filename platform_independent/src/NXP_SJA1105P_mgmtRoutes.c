@@ -485,6 +485,7 @@ static uint8_t syncMgmtRoutes(void)
 
 				ret += SJA1105P_setL2ArtEntry(&entry, switchId);
 				ret += SJA1105P_setL2AddressLookupTableControl(&control, switchId);
+				ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_L2_ADDRESS_LOOKUP, NULL, switchId);
 				ret += SJA1105P_getL2ArtEntry(&entry, switchId);
 				if (entry.enfport == 0U)
 				{  /* Management route is no longer active */
@@ -46,6 +46,7 @@
 #include "NXP_SJA1105P_sgmii.h"
 #include "NXP_SJA1105P_switchCore.h"
 #include "NXP_SJA1105P_config.h"
+#include "NXP_SJA1105P_spi.h"
 
 /******************************************************************************
 * DEFINES
@@ -347,12 +348,15 @@ extern uint8_t SJA1105P_setSpeed(uint8_t port, uint8_t switchId, SJA1105P_speed_
 	macCfgTableControl.valid = 1;
 	macCfgTableControl.rdwrset = 0;        /* read */
 
+	/* the batch holds the transport lock of the switch, the read-modify-write
+	 * of the entry is not interleaved with the one of SJA1105P_setPvid */
+	if (SJA1105P_spiQueueStart(switchId))
+		return 1;
+
 	ret  = SJA1105P_setMacCfgTableControl(&macCfgTableControl, switchId);
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_MAC_CFG, NULL, switchId);
 	ret += SJA1105P_getMacCfgTableEntry(&macCfgTableEntry, switchId);
 
-	if (ret)
-		return ret;
-
 	switch (speed) {
 	/* Values taken from reference manual, MAC Cfg Table section */
 	case SJA1105P_e_speed_10_MBPS:
@@ -365,15 +369,23 @@ extern uint8_t SJA1105P_setSpeed(uint8_t port, uint8_t switchId, SJA1105P_speed_
 		macCfgTableEntry.speed = 1;
 		break;
 	default:
-		return -1;
+		ret = -1;
+		break;
 	}
 
-	macCfgTableControl.port = port;
-	macCfgTableControl.valid = 1;
-	macCfgTableControl.rdwrset = 1;        /* write */
+	if (!ret) {
+		macCfgTableControl.port = port;
+		macCfgTableControl.valid = 1;
+		macCfgTableControl.rdwrset = 1;        /* write */
+
+		ret += SJA1105P_setMacCfgTableEntry(&macCfgTableEntry, switchId);
+		ret += SJA1105P_setMacCfgTableControl(&macCfgTableControl, switchId);
+		ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_MAC_CFG, NULL, switchId);
+	}
 
-	ret += SJA1105P_setMacCfgTableEntry(&macCfgTableEntry, switchId);
-	ret += SJA1105P_setMacCfgTableControl(&macCfgTableControl, switchId);
+	/* not added to ret, which may be -1 */
+	if (SJA1105P_spiQueueCommit(switchId, NULL, NULL) && !ret)
+		ret = 1;
 
 	return ret;
 }
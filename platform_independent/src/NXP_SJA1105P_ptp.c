@@ -39,6 +39,7 @@
 #include "typedefs.h"
 
 #include "NXP_SJA1105P_switchCore.h"
+#include "NXP_SJA1105P_spi.h"
 #include "NXP_SJA1105P_auxiliaryConfigurationUnit.h"
 #include "NXP_SJA1105P_ptp.h"
 #include "NXP_SJA1105P_config.h"
@@ -49,6 +50,17 @@
 
 #define TIME_TO_FIRST_TOGGLE (uint64_t) (1000*1000*1000/8)  /* Start toggling after 1 s */
  
+/******************************************************************************
+* INTERNAL TYPE DEFINITIONS
+*****************************************************************************/
+
+/* argument of the per switch offset job, see SJA1105P_forEachSwitch */
+typedef struct
+{
+	uint64_t offset;
+	uint8_t  modeChange;  /**< 1: add/subtract mode of Control2 has to be updated first */
+} ptpOffsetJob_t;
+
 /******************************************************************************
 * INTERNAL VARIABLES
 *****************************************************************************/
@@ -56,6 +68,13 @@
 static uint32_t g_clkRatio;
 static SJA1105P_ptpControl2Argument_t g_ptpControl2;
 
+/******************************************************************************
+* INTERNAL FUNCTION DECLARATIONS
+*****************************************************************************/
+
+static uint8_t setClkRatioJob(uint8_t switchId, void *p_context);
+static uint8_t applyOffsetJob(uint8_t switchId, void *p_context);
+
 /******************************************************************************
 * FUNCTIONS
 *****************************************************************************/
@@ -152,16 +171,9 @@ extern uint8_t SJA1105P_setPtpClk(uint64_t clkVal)
 */
 extern uint8_t SJA1105P_setPtpClkRatio(uint32_t clkRatio)
 {
-	uint8_t ret = 0;
-	uint8_t switchId;
 	g_clkRatio = clkRatio;
 
-	 
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-	{
-		ret += SJA1105P_setPtpControl4(clkRatio, switchId);
-	}
-	return ret;
+	return SJA1105P_forEachSwitch(setClkRatioJob, &g_clkRatio);
 }
 
 /**
@@ -188,25 +200,18 @@ extern uint8_t SJA1105P_getPtpClkRatio(uint32_t *p_clkRatio)
 */
 extern uint8_t SJA1105P_addOffsetToPtpClk(uint64_t clkAddVal)
 {
-	uint8_t ret = 0;
-	uint8_t switchId;
+	ptpOffsetJob_t offsetJob;
 
+	offsetJob.offset     = clkAddVal;
+	offsetJob.modeChange = 0;
 	if (g_ptpControl2.ptpclkadd == 0U)
 	{
 		g_ptpControl2.ptpclkadd = 1;
 		g_ptpControl2.ptpclksub = 0;
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-		{
-			ret += SJA1105P_setPtpControl2(&g_ptpControl2, switchId);
-		}
-	}
-	/* Add offset */
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-	{
-		ret += SJA1105P_setPtpControl3(clkAddVal, switchId);
+		offsetJob.modeChange = 1;
 	}
-
-	return ret;
+	/* Add offset on all switches */
+	return SJA1105P_forEachSwitch(applyOffsetJob, &offsetJob);
 }
 
 /**
@@ -220,25 +225,18 @@ extern uint8_t SJA1105P_addOffsetToPtpClk(uint64_t clkAddVal)
 */
 extern uint8_t SJA1105P_subtractOffsetFromPtpClk(uint64_t clkSubVal)
 {
-	uint8_t ret = 0;
-	uint8_t switchId;
+	ptpOffsetJob_t offsetJob;
 
+	offsetJob.offset     = clkSubVal;
+	offsetJob.modeChange = 0;
 	if (g_ptpControl2.ptpclksub == 0U)
 	{
 		g_ptpControl2.ptpclkadd = 0;
 		g_ptpControl2.ptpclksub = 1;
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-		{
-			ret += SJA1105P_setPtpControl2(&g_ptpControl2, switchId);
-		}
-	}
-	/* Add offset */
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-	{
-		ret += SJA1105P_setPtpControl3(clkSubVal, switchId);
+		offsetJob.modeChange = 1;
 	}
-
-	return ret;
+	/* Subtract offset on all switches */
+	return SJA1105P_forEachSwitch(applyOffsetJob, &offsetJob);
 }
 
 /**
@@ -273,8 +271,10 @@ extern uint8_t SJA1105P_syncCascadedClocks(void)
 		{  /* this is a slave which has to be synchronized */
 			ret += SJA1105P_getPtpControl6(&slaveTimestamp, switchId);
 			offset = masterTimestamp - slaveTimestamp;
+			ret += SJA1105P_spiQueueStart(switchId);
 			ret += SJA1105P_setPtpControl2(&g_ptpControl2, switchId);  /* set into add mode */
 			ret += SJA1105P_setPtpControl3(offset, switchId);  /* add offset */
+			ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
 		}
 	}
 
@@ -282,4 +282,43 @@ extern uint8_t SJA1105P_syncCascadedClocks(void)
 	ret += SJA1105P_setPtpControl2(&g_ptpControl2, SJA1105P_g_ptpMasterSwitch);
 
 	return ret;
-}
\ No newline at end of file
+}
+
+/**
+* \brief Write the clock ratio to one switch
+*
+* \param[in]  switchId Switch to be configured
+* \param[in]  p_context Clock ratio
+*
+* \return uint8_t: 0: successful, else: failed
+*/
+static uint8_t setClkRatioJob(uint8_t switchId, void *p_context)
+{
+	return SJA1105P_setPtpControl4(*((const uint32_t *) p_context), switchId);
+}
+
+/**
+* \brief Apply an offset to the PTP clock of one switch
+*
+* Mode change and offset are transferred as one batch.
+*
+* \param[in]  switchId Switch to be configured
+* \param[in]  p_context ::ptpOffsetJob_t describing the offset
+*
+* \return uint8_t: 0: successful, else: failed
+*/
+static uint8_t applyOffsetJob(uint8_t switchId, void *p_context)
+{
+	uint8_t ret;
+	const ptpOffsetJob_t *kp_offsetJob = (const ptpOffsetJob_t *) p_context;
+
+	ret = SJA1105P_spiQueueStart(switchId);
+	if (kp_offsetJob->modeChange == 1U)
+	{
+		ret += SJA1105P_setPtpControl2(&g_ptpControl2, switchId);
+	}
+	ret += SJA1105P_setPtpControl3(kp_offsetJob->offset, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
+	return ret;
+}
@@ -41,6 +41,21 @@
 #include "NXP_SJA1105P_vlan.h"
 #include "NXP_SJA1105P_config.h"
 #include "NXP_SJA1105P_switchCore.h"
+#include "NXP_SJA1105P_spi.h"
+#include "NXP_SJA1105P_addressResolutionTable.h"
+
+/******************************************************************************
+* Defines
+*****************************************************************************/
+
+#define N_VLAN_IDS 4096U
+
+#define N_PIPELINED_READS  16U  /* VLAN lookup table reads transferred within one SPI batch */
+#define N_PIPELINED_WRITES 16U  /* VLAN lookup table writes transferred within one SPI batch */
+
+#define ALL_SWITCHES ((uint8_t) ((1U << SJA1105P_N_SWITCHES) - 1U))
+
+#define N_RETAG_KEY_BUCKETS 16U  /* power of two */
 
 /******************************************************************************
 * INTERNAL TYPE DEFINITIONS
@@ -55,14 +70,76 @@ typedef struct
 	uint8_t vingMirr;   /**< All traffic tagged with VLANID and received on any of the ports having its flag asserted in this field will be forwarded to the mirror port as defined by the MIRR_PORT field of the General Parameters configuration block. */
 } vlanLookupTableReconfigurationEntry_t;
 
+/* configuration of a VLAN in terms of logical ports, one bit per port */
+typedef struct
+{
+	uint16_t enable;    /**< Ports on which traffic of the VLAN is enabled */
+	uint16_t tagged;    /**< Ports to which frames are forwarded tagged */
+	uint16_t untagged;  /**< Ports to which frames are forwarded untagged */
+} vlanConfiguration_t;
+
+/* arguments of the per switch jobs, see SJA1105P_forEachSwitch */
+typedef struct
+{
+	uint16_t firstVlanId;
+	uint16_t lastVlanId;  /**< the entries of the range not yet in the shadow are loaded */
+} vlanLoadJob_t;
+
+/* rule of the retagging table in terms of logical ports, rules with identical VLAN IDs and
+ * egress ports share an entry whose ingress ports are the union of the ingress ports of the rules */
+typedef struct
+{
+	uint16_t ingressVlanId;
+	uint16_t egressVlanId;
+	uint16_t ingressPorts;  /**< Ports on which frames of ingressVlanId are retagged */
+	uint16_t egressPorts;   /**< Ports towards which frames of ingressVlanId are retagged */
+	uint16_t destPorts;     /**< Ports to which all frames of egressVlanId are forwarded if bypassing */
+	uint8_t  bypassing;     /**< 1 if the entry is used for bypassing */
+	uint8_t  doNotLearn;    /**< 1 if learning is disabled for frames of egressVlanId while bypassing */
+	uint8_t  nRules;        /**< Number of retagging rules sharing the entry, 0 if only used for bypassing */
+	uint8_t  nPortRules[SJA1105P_N_LOGICAL_PORTS];  /**< Number of retagging rules per ingress port */
+} retaggingRule_t;
+
+/* VLAN to which untagged and priority tagged frames received by a port are classified */
+typedef struct
+{
+	uint16_t pvid;         /**< VLAN ID in the MAC configuration table entry of the port */
+	uint16_t defaultPvid;  /**< VLAN ID found in the static configuration */
+	uint8_t  valid;        /**< 1 if the VLAN IDs were loaded */
+} portVlan_t;
+
+typedef struct
+{
+	uint16_t firstVlanId;
+	uint16_t lastVlanId;
+	uint16_t failedVlanId[SJA1105P_N_SWITCHES];  /**< VLAN ID of the entry which could not be stored, N_VLAN_IDS if all dirty entries of the switch were stored */
+} vlanFlushJob_t;
+
 /******************************************************************************
 * INTERNAL VARIABLES
 *****************************************************************************/
 
-/* Auxiliary configuration information for acceleration */
-static uint16_t g_retaggingTableVlanId[SJA1105P_N_RETAG_ENTRIES] = {0};  /**< Look-up of stored rules with respect to egress VLAN ID */
-static uint8_t g_retaggingValid[SJA1105P_N_RETAG_ENTRIES] = {0U};
-static uint8_t g_bypassingValid[SJA1105P_N_RETAG_ENTRIES] = {0U};
+/* Retagging rules, indexed by the egress VLAN ID. The indices of the rules are the indices of
+ * the retagging table, see SJA1105P_resetRetagging */
+static retaggingRule_t g_retaggingRule[SJA1105P_N_RETAG_ENTRIES];
+static uint8_t g_retaggingSwitches[SJA1105P_N_RETAG_ENTRIES];  /**< one bit per switch holding a valid entry at this index */
+static uint8_t g_retaggingKeyBucket[N_RETAG_KEY_BUCKETS];     /**< first index of the chain, SJA1105P_N_RETAG_ENTRIES if empty */
+static uint8_t g_retaggingKeyNext[SJA1105P_N_RETAG_ENTRIES];  /**< next index in the same chain, SJA1105P_N_RETAG_ENTRIES at the end */
+static uint8_t g_retaggingFree[SJA1105P_N_RETAG_ENTRIES];     /**< stack of unused indices */
+static uint8_t g_nRetaggingFree = 0;
+static uint8_t g_retaggingInitialized = 0;  /**< 0 until ::SJA1105P_resetRetagging was called */
+
+/* Shadow of the VLAN lookup table. A VLAN ID is read from the switches on first use,
+ * afterwards the configuration is only read from the shadow. */
+static vlanConfiguration_t g_vlanConfiguration[N_VLAN_IDS];
+static vlanLookupTableReconfigurationEntry_t g_vlanEntry[N_VLAN_IDS][SJA1105P_N_SWITCHES];  /**< entries derived from g_vlanConfiguration */
+static uint8_t  g_vlanShadowValid[N_VLAN_IDS] = {0U};    /**< 1 if the shadow of the VLAN ID was loaded or written */
+static uint8_t  g_vlanDirtySwitches[N_VLAN_IDS] = {0U};  /**< one bit per switch whose entry differs from the shadow */
+static uint16_t g_vlanDirtyFirst = N_VLAN_IDS;           /**< lowest VLAN ID with a dirty entry, N_VLAN_IDS if none */
+static uint16_t g_vlanDirtyLast  = 0;                    /**< highest VLAN ID with a dirty entry */
+
+/* Port based VLAN of each port, loaded from the MAC configuration table on demand */
+static portVlan_t g_portVlan[SJA1105P_N_LOGICAL_PORTS];
 
 /******************************************************************************
 * INTERNAL FUNCTION DECLARATIONS
@@ -70,10 +147,31 @@ static uint8_t g_bypassingValid[SJA1105P_N_RETAG_ENTRIES] = {0U};
 
 static uint8_t storeVlanEntry(const SJA1105P_vlanLookupTableEntryArgument_t *kp_vlanEntry, uint8_t switchId);
 static uint8_t loadVlanEntry(uint16_t vlanId, SJA1105P_vlanLookupTableEntryArgument_t *p_vlanEntry, uint8_t switchId);
-
-static uint8_t getRetaggingEntryIndex(uint16_t egressVlanId);
+static uint8_t loadVlanEntryBatch(const uint16_t *kp_vlanId, uint8_t nEntries, uint8_t switchId);
+static uint8_t storeVlanEntryBatch(const uint16_t *kp_vlanId, uint8_t nEntries, uint8_t switchId);
+static uint8_t loadVlanEntriesJob(uint8_t switchId, void *p_context);
+static uint8_t flushVlanEntriesJob(uint8_t switchId, void *p_context);
+static void getVlanShadowEntry(uint16_t vlanId, uint8_t switchId, SJA1105P_vlanLookupTableEntryArgument_t *p_vlanEntry);
+static void setVlanShadowEntry(uint16_t vlanId, uint8_t switchId, const SJA1105P_vlanLookupTableEntryArgument_t *kp_vlanEntry);
+static uint8_t loadVlanShadow(uint16_t firstVlanId, uint16_t lastVlanId);
+static uint8_t updateVlanShadow(uint16_t vlanId, const vlanConfiguration_t *kp_configuration, const vlanLookupTableReconfigurationEntry_t *kp_vlanEntry);
+static uint8_t deriveVlanEntries(const vlanConfiguration_t *kp_configuration, vlanLookupTableReconfigurationEntry_t *p_vlanEntry);
+static uint8_t isVlanEntryEmpty(const vlanLookupTableReconfigurationEntry_t *kp_vlanEntry);
+static uint8_t isVlanEntryEqual(const vlanLookupTableReconfigurationEntry_t *kp_vlanEntry, const vlanLookupTableReconfigurationEntry_t *kp_otherVlanEntry);
+static uint8_t extendVlanSwitches(uint16_t vlanId, uint8_t previousSwitches);
+
+static uint8_t loadPortVlan(uint8_t port);
+static uint8_t writePortVlan(uint8_t port, uint16_t vlanId);
+static uint8_t loadMacCfgEntry(SJA1105P_macCfgTableEntryArgument_t *p_macCfgEntry, uint8_t physicalPort, uint8_t switchId);
+static uint8_t storeMacCfgEntry(const SJA1105P_macCfgTableEntryArgument_t *kp_macCfgEntry, uint8_t physicalPort, uint8_t switchId);
+
+static uint8_t findRetaggingRule(uint16_t ingressVlanId, uint16_t egressVlanId, uint16_t egressPorts);
+static uint8_t findBypassingRule(uint16_t vlanId);
+static uint8_t allocateRetaggingRule(uint16_t egressVlanId, uint8_t bypassing);
+static void releaseRetaggingRule(uint8_t index);
+static uint8_t updateRetaggingRule(uint8_t index, const retaggingRule_t *kp_rule);
+static uint8_t getRetaggingEntry(const retaggingRule_t *kp_rule, uint8_t switchId, SJA1105P_retaggingTableEntryArgument_t *p_retaggingEntry);
 static uint8_t storeRetaggingEntry(const SJA1105P_retaggingTableEntryArgument_t *kp_retaggingEntry, uint8_t index, uint8_t validEntry, uint8_t switchId);
-static uint8_t loadRetaggingEntry(SJA1105P_retaggingTableEntryArgument_t *p_retaggingEntry, uint8_t index, uint8_t *p_validEntry, uint8_t switchId);
 
 /******************************************************************************
 * FUNCTIONS
@@ -82,6 +180,8 @@ static uint8_t loadRetaggingEntry(SJA1105P_retaggingTableEntryArgument_t *p_reta
 /**
 * \brief Configure forwarding rules within a VLAN
 *
+* Only the entries of the switches which change are written.
+*
 * \param[in]  vlan VLAN to be configured
 * \param[in]  p_vlanForwarding Memory location of a list describing the forwarding type of each port.
 * \param[in]  enable Each bit specifies whether VLAN traffic should be enabled for the corresponding port.
@@ -90,32 +190,24 @@ static uint8_t loadRetaggingEntry(SJA1105P_retaggingTableEntryArgument_t *p_reta
 */
 extern uint8_t SJA1105P_writeVlanConfig(uint16_t vlanId, const SJA1105P_vlanForwarding_t *pk_vlanForwarding, uint16_t enable)
 {
-	uint8_t  ret = 0;
-	uint8_t  switchId;
+	uint8_t ret;
 	uint8_t port;
-	uint8_t  enabledPhysicalPorts;
-	uint8_t  firstMemberSwitchId = SJA1105P_N_SWITCHES;
-	uint8_t  lastMemberSwitchId  = 0;
-	uint8_t  firstBroadcastSwitchId = SJA1105P_N_SWITCHES;
-	uint8_t  lastBroadcastSwitchId  = 0;
-	SJA1105P_port_t physicalPort;
-	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry[SJA1105P_N_SWITCHES] = {{0}};
+	vlanConfiguration_t configuration = {0};
+	vlanLookupTableReconfigurationEntry_t vlanLookupTableEntry[SJA1105P_N_SWITCHES];
 
-	/* determine VLAN lookup configuration for logical port and translate to physical lookups */
+	configuration.enable = enable;
 	for (port = 0U; port < SJA1105P_N_LOGICAL_PORTS; port++)
 	{
-		ret += SJA1105P_getPhysicalPort(port, &physicalPort);
 		switch (pk_vlanForwarding[port])
 		{
 			case SJA1105P_e_vlanForwarding_TAGGED:
 			{
-				vlanLookupTableEntry[physicalPort.switchId].tagPort |= (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
-				vlanLookupTableEntry[physicalPort.switchId].vlanBc  |= (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
+				configuration.tagged |= (uint16_t) ((uint16_t) 1 << port);
 				break;
 			}
 			case SJA1105P_e_vlanForwarding_UNTAGGED:
 			{
-				vlanLookupTableEntry[physicalPort.switchId].vlanBc  |= (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
+				configuration.untagged |= (uint16_t) ((uint16_t) 1 << port);
 				break;
 			}
 			default:
@@ -125,62 +217,11 @@ extern uint8_t SJA1105P_writeVlanConfig(uint16_t vlanId, const SJA1105P_vlanForw
 		}
 	}
 
-	/* determine member ports */
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-	{
-		SJA1105P_getPhysicalPortVector(enable, switchId, &enabledPhysicalPorts);
-		vlanLookupTableEntry[switchId].vmembPort = enabledPhysicalPorts;
-	}
-
-	/* determine vlan lookup configuration for the internal ports (cascaded) */
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-	{
-		if (vlanLookupTableEntry[switchId].vmembPort != 0U)
-		{  /* at least one port in this switch is VLAN member */
-			firstMemberSwitchId = (firstMemberSwitchId == SJA1105P_N_SWITCHES) ? (switchId) : (firstMemberSwitchId);
-			lastMemberSwitchId  = (switchId > lastMemberSwitchId) ? (switchId) : (firstMemberSwitchId);
-		}
-		if (vlanLookupTableEntry[switchId].vlanBc != 0U)
-		{  /* at least one port in this switch is VLAN member */
-			firstBroadcastSwitchId = (firstBroadcastSwitchId == SJA1105P_N_SWITCHES) ? (switchId) : (firstBroadcastSwitchId);
-			lastBroadcastSwitchId  = (switchId > lastBroadcastSwitchId) ? (switchId) : (firstBroadcastSwitchId);
-		}
-	}
-
-	/* configure internal ports VLAN forwarding */
-	for (switchId = 0; switchId < (SJA1105P_N_SWITCHES - 1U); switchId++)
-	{
-		if (switchId >= firstMemberSwitchId)
-		{
-			if (switchId < lastMemberSwitchId)
-			{
-				if (switchId < lastBroadcastSwitchId)
-				{
-					/* enable on this switch to forward to the cascaded port */
-					vlanLookupTableEntry[switchId].vlanBc  |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
-					vlanLookupTableEntry[switchId].tagPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
-					/* also enable receiving on the connecting counter part of cascaded port */
-					vlanLookupTableEntry[switchId + 1U].vmembPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
-					vlanLookupTableEntry[switchId + 1U].tagPort   |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
-				}
-				if (switchId >= firstBroadcastSwitchId)
-				{
-					/* enable on this switch to receive from the cascaded port */
-					vlanLookupTableEntry[switchId].vmembPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
-					vlanLookupTableEntry[switchId].tagPort   |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
-					/* also enable forwarding on the connecting counter part of cascaded port */
-					vlanLookupTableEntry[switchId + 1U].vlanBc  |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
-					vlanLookupTableEntry[switchId + 1U].tagPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
-				}
-			}
-		}
-	}
-
-	/* Download the VLAN configuration */
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	ret = deriveVlanEntries(&configuration, vlanLookupTableEntry);
+	if (ret == 0U)
 	{
-		vlanLookupTableEntry[switchId].vlanid = vlanId;
-		ret += storeVlanEntry(&(vlanLookupTableEntry[switchId]), switchId);
+		ret  = updateVlanShadow(vlanId, &configuration, vlanLookupTableEntry);
+		ret += SJA1105P_flushVlanConfig();
 	}
 
 	return ret;
@@ -189,6 +230,8 @@ extern uint8_t SJA1105P_writeVlanConfig(uint16_t vlanId, const SJA1105P_vlanForw
 /**
 * \brief Read configuration of a VLAN.
 *
+* The configuration is read from the shadow, the switches are only accessed on the first use of the VLAN ID.
+*
 * \param[out] vlan VLAN of which the configuration should be read
 * \param[out] p_vlanForwarding Pointer to the memory location of a list describing the forwarding type of each port
 * \param[out] p_enable Pointer to the memory location of a bit vector, where each bit specifies whether VLAN traffic should be enabled
@@ -197,34 +240,150 @@ extern uint8_t SJA1105P_writeVlanConfig(uint16_t vlanId, const SJA1105P_vlanForw
 */
 extern uint8_t SJA1105P_readVlanConfig(uint16_t vlanId, SJA1105P_vlanForwarding_t *p_vlanForwarding, uint16_t *p_enable)
 {
-	uint8_t ret = 0;
+	uint8_t ret;
 	uint8_t port;
-	uint8_t switchId;
-	SJA1105P_port_t physicalPort;
-	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry[SJA1105P_N_SWITCHES] = {{0}};
+	uint16_t portBit;
+	const vlanConfiguration_t *kp_configuration;
 
 	*p_enable = 0;
-	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	ret = loadVlanShadow(vlanId, vlanId);
+	if (ret == 0U)
 	{
-		ret += loadVlanEntry(vlanId, &vlanLookupTableEntry[switchId], switchId);
+		kp_configuration = &(g_vlanConfiguration[vlanId]);
+		for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
+		{
+			portBit = (uint16_t) ((uint16_t) 1 << port);
+			if ((kp_configuration->tagged & portBit) != 0U)
+			{
+				p_vlanForwarding[port] = SJA1105P_e_vlanForwarding_TAGGED;
+			}
+			else
+			{
+				p_vlanForwarding[port] = ((kp_configuration->untagged & portBit) != 0U) ? SJA1105P_e_vlanForwarding_UNTAGGED : SJA1105P_e_vlanForwarding_NOT;
+			}
+		}
+		*p_enable = kp_configuration->enable;
 	}
 
-	for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
+	return ret;
+}
+
+/**
+* \brief Change the configuration of a single port within a VLAN in the shadow
+*
+* The switches are not written before ::SJA1105P_flushVlanConfig is called, which allows
+* to configure many VLANs and ports at once.
+*
+* \param[in]  vlanId VLAN to be configured
+* \param[in]  port Logical port to be configured
+* \param[in]  forwarding Forwarding type of the port
+* \param[in]  enable If set to 1, traffic of the VLAN is enabled for the port
+*
+* \return uint8_t Returns 0 upon success, else failed.
+*/
+extern uint8_t SJA1105P_setVlanPort(uint16_t vlanId, uint8_t port, SJA1105P_vlanForwarding_t forwarding, uint8_t enable)
+{
+	return SJA1105P_setVlanPortRange(vlanId, vlanId, port, forwarding, enable);
+}
+
+/**
+* \brief Change the configuration of a single port within a range of VLANs in the shadow
+*
+* The entries of the range which are not yet in the shadow are read from the switches in
+* pipelined batches. The switches are not written before ::SJA1105P_flushVlanConfig is called.
+*
+* \param[in]  firstVlanId First VLAN to be configured
+* \param[in]  lastVlanId Last VLAN to be configured
+* \param[in]  port Logical port to be configured
+* \param[in]  forwarding Forwarding type of the port
+* \param[in]  enable If set to 1, traffic of the VLANs is enabled for the port
+*
+* \return uint8_t Returns 0 upon success, else failed.
+*/
+extern uint8_t SJA1105P_setVlanPortRange(uint16_t firstVlanId, uint16_t lastVlanId, uint8_t port, SJA1105P_vlanForwarding_t forwarding, uint8_t enable)
+{
+	uint8_t  ret = 1;
+	uint16_t vlanId;
+	uint16_t portBit;
+	vlanConfiguration_t configuration;
+	vlanLookupTableReconfigurationEntry_t vlanLookupTableEntry[SJA1105P_N_SWITCHES];
+
+	if ((port < SJA1105P_N_LOGICAL_PORTS) && (firstVlanId <= lastVlanId) && (loadVlanShadow(firstVlanId, lastVlanId) == 0U))
 	{
-		ret += SJA1105P_getPhysicalPort(port, &physicalPort);
-		if ((vlanLookupTableEntry[physicalPort.switchId].vlanBc & ((uint8_t) ((uint8_t) 1 << physicalPort.physicalPort))) != 0U)
+		ret = 0;
+		portBit = (uint16_t) ((uint16_t) 1 << port);
+		for (vlanId = firstVlanId; (vlanId <= lastVlanId) && (ret == 0U); vlanId++)
 		{
-			p_vlanForwarding[port] = ((vlanLookupTableEntry[physicalPort.switchId].tagPort & ((uint8_t) ((uint8_t) 1 << physicalPort.physicalPort))) != 0U)
-			                          ? SJA1105P_e_vlanForwarding_TAGGED : SJA1105P_e_vlanForwarding_UNTAGGED;
+			configuration = g_vlanConfiguration[vlanId];
+			configuration.enable   &= (uint16_t) ~portBit;
+			configuration.tagged   &= (uint16_t) ~portBit;
+			configuration.untagged &= (uint16_t) ~portBit;
+			configuration.enable   |= (uint16_t) ((uint16_t) enable << port);
+			if (forwarding == SJA1105P_e_vlanForwarding_TAGGED)
+			{
+				configuration.tagged |= portBit;
+			}
+			if (forwarding == SJA1105P_e_vlanForwarding_UNTAGGED)
+			{
+				configuration.untagged |= portBit;
+			}
+
+			ret = deriveVlanEntries(&configuration, vlanLookupTableEntry);
+			if (ret == 0U)
+			{
+				ret = updateVlanShadow(vlanId, &configuration, vlanLookupTableEntry);
+			}
 		}
-		else
+	}
+
+	return ret;
+}
+
+/**
+* \brief Write all entries of the shadow which differ from the switches
+*
+* The switches are written concurrently, each in pipelined batches. Entries which could not
+* be written remain dirty and are written again by the next call.
+*
+* \return uint8_t Returns 0 upon success, else failed.
+*/
+extern uint8_t SJA1105P_flushVlanConfig(void)
+{
+	uint8_t  ret = 0;
+	uint8_t  switchId;
+	uint16_t vlanId;
+	uint16_t dirtyFirst = N_VLAN_IDS;
+	uint16_t dirtyLast  = 0;
+	vlanFlushJob_t flushJob;
+
+	if (g_vlanDirtyFirst < N_VLAN_IDS)
+	{
+		flushJob.firstVlanId = g_vlanDirtyFirst;
+		flushJob.lastVlanId  = g_vlanDirtyLast;
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
 		{
-			p_vlanForwarding[port] = SJA1105P_e_vlanForwarding_NOT;
+			flushJob.failedVlanId[switchId] = g_vlanDirtyFirst;  /* nothing stored unless the job reports otherwise */
 		}
-		if ((vlanLookupTableEntry[physicalPort.switchId].vmembPort & ((uint16_t) ((uint16_t) 1 << physicalPort.physicalPort))) != 0U)
-		{  /* VLAN is enabled on this port */
-			*p_enable |= ((uint16_t) 1) << port;
+		ret = SJA1105P_forEachSwitch(flushVlanEntriesJob, &flushJob);
+
+		/* the entries stored before a failure are clean */
+		for (vlanId = g_vlanDirtyFirst; vlanId <= g_vlanDirtyLast; vlanId++)
+		{
+			for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+			{
+				if (vlanId < flushJob.failedVlanId[switchId])
+				{
+					g_vlanDirtySwitches[vlanId] &= (uint8_t) ~((uint8_t) (((uint8_t) 1) << switchId));
+				}
+			}
+			if (g_vlanDirtySwitches[vlanId] != 0U)
+			{
+				dirtyFirst = (dirtyFirst == N_VLAN_IDS) ? vlanId : dirtyFirst;
+				dirtyLast  = vlanId;
+			}
 		}
+		g_vlanDirtyFirst = dirtyFirst;
+		g_vlanDirtyLast  = dirtyLast;
 	}
 
 	return ret;
@@ -242,15 +401,24 @@ extern uint8_t SJA1105P_readVlanConfig(uint16_t vlanId, SJA1105P_vlanForwarding_
 extern uint8_t SJA1105P_enableVlan(uint16_t vlanId, uint8_t ingressPort, uint8_t enable)
 {
 	uint8_t ret = 1;
+	uint8_t switchId;
 	SJA1105P_port_t physicalIngressPort;
-	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry;
+	vlanConfiguration_t configuration;
+	vlanLookupTableReconfigurationEntry_t vlanLookupTableEntry[SJA1105P_N_SWITCHES];
 
-	if (SJA1105P_getPhysicalPort(ingressPort, &physicalIngressPort) == 0U)
+	if ((SJA1105P_getPhysicalPort(ingressPort, &physicalIngressPort) == 0U) && (loadVlanShadow(vlanId, vlanId) == 0U))
 	{
-		ret  = loadVlanEntry(vlanId, &vlanLookupTableEntry, physicalIngressPort.switchId);
-		vlanLookupTableEntry.vmembPort &= (uint8_t) ~((uint8_t) ((uint16_t) 1 << physicalIngressPort.physicalPort));  /* set corresponding flag low */
-		vlanLookupTableEntry.vmembPort |= (uint8_t) ((uint16_t) enable << physicalIngressPort.physicalPort);
-		ret += storeVlanEntry(&vlanLookupTableEntry, physicalIngressPort.switchId);
+		configuration = g_vlanConfiguration[vlanId];
+		configuration.enable &= (uint16_t) ~((uint16_t) ((uint16_t) 1 << ingressPort));
+		configuration.enable |= (uint16_t) ((uint16_t) enable << ingressPort);
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			vlanLookupTableEntry[switchId] = g_vlanEntry[vlanId][switchId];
+		}
+		vlanLookupTableEntry[physicalIngressPort.switchId].vmembPort &= (uint8_t) ~((uint8_t) ((uint16_t) 1 << physicalIngressPort.physicalPort));  /* set corresponding flag low */
+		vlanLookupTableEntry[physicalIngressPort.switchId].vmembPort |= (uint8_t) ((uint16_t) enable << physicalIngressPort.physicalPort);
+		ret  = updateVlanShadow(vlanId, &configuration, vlanLookupTableEntry);
+		ret += SJA1105P_flushVlanConfig();
 	}
 
 	return ret;
@@ -268,15 +436,20 @@ extern uint8_t SJA1105P_enableVlan(uint16_t vlanId, uint8_t ingressPort, uint8_t
 extern uint8_t SJA1105P_enableVlanIngressMirroring(uint16_t vlanId, uint8_t ingressPort, uint8_t enable)
 {
 	uint8_t ret = 1;
+	uint8_t switchId;
 	SJA1105P_port_t physicalIngressPort;
-	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry;
+	vlanLookupTableReconfigurationEntry_t vlanLookupTableEntry[SJA1105P_N_SWITCHES];
 
-	if (SJA1105P_getPhysicalPort(ingressPort, &physicalIngressPort) == 0U)
+	if ((SJA1105P_getPhysicalPort(ingressPort, &physicalIngressPort) == 0U) && (loadVlanShadow(vlanId, vlanId) == 0U))
 	{
-		ret  = loadVlanEntry(vlanId, &vlanLookupTableEntry, physicalIngressPort.switchId);
-		vlanLookupTableEntry.vingMirr &= (uint8_t) ~((uint8_t) ((uint16_t) 1 << physicalIngressPort.physicalPort));  /* set corresponding flag low */
-		vlanLookupTableEntry.vingMirr |= (uint8_t) ((uint16_t) enable << physicalIngressPort.physicalPort);
-		ret += storeVlanEntry(&vlanLookupTableEntry, physicalIngressPort.switchId);
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			vlanLookupTableEntry[switchId] = g_vlanEntry[vlanId][switchId];
+		}
+		vlanLookupTableEntry[physicalIngressPort.switchId].vingMirr &= (uint8_t) ~((uint8_t) ((uint16_t) 1 << physicalIngressPort.physicalPort));  /* set corresponding flag low */
+		vlanLookupTableEntry[physicalIngressPort.switchId].vingMirr |= (uint8_t) ((uint16_t) enable << physicalIngressPort.physicalPort);
+		ret  = updateVlanShadow(vlanId, &(g_vlanConfiguration[vlanId]), vlanLookupTableEntry);
+		ret += SJA1105P_flushVlanConfig();
 	}
 
 	return ret;
@@ -294,15 +467,93 @@ extern uint8_t SJA1105P_enableVlanIngressMirroring(uint16_t vlanId, uint8_t ingr
 extern uint8_t SJA1105P_enableVlanEgressMirroring(uint16_t vlanId, uint8_t egressPort, uint8_t enable)
 {
 	uint8_t ret = 1;
+	uint8_t switchId;
 	SJA1105P_port_t physicalEgressPort;
-	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry;
+	vlanLookupTableReconfigurationEntry_t vlanLookupTableEntry[SJA1105P_N_SWITCHES];
+
+	if ((SJA1105P_getPhysicalPort(egressPort, &physicalEgressPort) == 0U) && (loadVlanShadow(vlanId, vlanId) == 0U))
+	{
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			vlanLookupTableEntry[switchId] = g_vlanEntry[vlanId][switchId];
+		}
+		vlanLookupTableEntry[physicalEgressPort.switchId].vegrMirr &= (uint8_t) ~((uint8_t) ((uint16_t) 1 << physicalEgressPort.physicalPort));  /* set corresponding flag low */
+		vlanLookupTableEntry[physicalEgressPort.switchId].vegrMirr |= (uint8_t) ((uint16_t) enable << physicalEgressPort.physicalPort);
+		ret  = updateVlanShadow(vlanId, &(g_vlanConfiguration[vlanId]), vlanLookupTableEntry);
+		ret += SJA1105P_flushVlanConfig();
+	}
+
+	return ret;
+}
+
+/**
+* \brief Set the port based VLAN of a port
+*
+* Untagged and priority tagged frames received at the port are classified to this VLAN.
+* Whether they egress tagged or untagged is configured in the VLAN lookup table, see
+* ::SJA1105P_setVlanPort. The MAC configuration table entry of the port is only
+* written if the VLAN ID changes.
+*
+* \param[in]  port Logical port
+* \param[in]  vlanId Port based VLAN ID
+*
+* \return uint8_t Returns 0 upon success, else failed.
+*/
+extern uint8_t SJA1105P_setPvid(uint8_t port, uint16_t vlanId)
+{
+	uint8_t ret = 1;
+
+	if ((port < SJA1105P_N_LOGICAL_PORTS) && (vlanId < N_VLAN_IDS))
+	{
+		ret = loadPortVlan(port);
+		if ((ret == 0U) && (g_portVlan[port].pvid != vlanId))
+		{
+			ret = writePortVlan(port, vlanId);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Get the port based VLAN of a port
+*
+* \param[in]  port Logical port
+* \param[out] p_vlanId Memory location of the port based VLAN ID
+*
+* \return uint8_t Returns 0 upon success, else failed.
+*/
+extern uint8_t SJA1105P_getPvid(uint8_t port, uint16_t *p_vlanId)
+{
+	uint8_t ret = 1;
+
+	if (port < SJA1105P_N_LOGICAL_PORTS)
+	{
+		ret = loadPortVlan(port);
+		*p_vlanId = g_portVlan[port].pvid;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Restore the port based VLAN of the static configuration
+*
+* \param[in]  port Logical port
+*
+* \return uint8_t Returns 0 upon success, else failed.
+*/
+extern uint8_t SJA1105P_resetPvid(uint8_t port)
+{
+	uint8_t ret = 1;
 
-	if (SJA1105P_getPhysicalPort(egressPort, &physicalEgressPort) == 0U)
+	if (port < SJA1105P_N_LOGICAL_PORTS)
 	{
-		ret  = loadVlanEntry(vlanId, &vlanLookupTableEntry, physicalEgressPort.switchId);
-		vlanLookupTableEntry.vegrMirr &= (uint8_t) ~((uint8_t) ((uint16_t) 1 << physicalEgressPort.physicalPort));  /* set corresponding flag low */
-		vlanLookupTableEntry.vegrMirr |= (uint8_t) ((uint16_t) enable << physicalEgressPort.physicalPort);			
-		ret += storeVlanEntry(&vlanLookupTableEntry, physicalEgressPort.switchId);
+		ret = loadPortVlan(port);
+		if ((ret == 0U) && (g_portVlan[port].pvid != g_portVlan[port].defaultPvid))
+		{
+			ret = writePortVlan(port, g_portVlan[port].defaultPvid);
+		}
 	}
 
 	return ret;
@@ -311,6 +562,9 @@ extern uint8_t SJA1105P_enableVlanEgressMirroring(uint16_t vlanId, uint8_t egres
 /**
 * \brief Start retagging frames with the specified configuration.
 *
+* Rules with identical VLAN IDs and egress ports share one entry of the retagging table.
+* Only the switches whose physical port vectors change are written.
+*
 * \param[in]  ingressPorts Ingress ports at which frames matching the ingress VLAN ID will be retagged
 * \param[in]  egressPorts Egress ports at which retagged frames are transmitted
 * \param[in]  ingressVlanId
@@ -321,144 +575,618 @@ extern uint8_t SJA1105P_enableVlanEgressMirroring(uint16_t vlanId, uint8_t egres
 extern uint8_t SJA1105P_startRetagging(uint16_t ingressPorts, uint16_t egressPorts, uint16_t ingressVlanId, uint16_t egressVlanId)
 {
 	uint8_t ret = 1;
-	uint8_t switchId;
-	uint8_t physicalEgressPorts;
-	uint8_t physicalIngressPorts;
-	uint8_t retaggingEntryIndex;
-	uint8_t validEntry;
-	SJA1105P_retaggingTableEntryArgument_t retaggingEntry;
+	uint8_t port;
+	uint8_t index;
+	retaggingRule_t rule;
 
-	retaggingEntryIndex = getRetaggingEntryIndex(egressVlanId);
+	index = findRetaggingRule(ingressVlanId, egressVlanId, egressPorts);
+	if (index == SJA1105P_N_RETAG_ENTRIES)
+	{  /* no identical rule in place */
+		index = allocateRetaggingRule(egressVlanId, 0U);
+	}
 
-	if (retaggingEntryIndex < SJA1105P_N_RETAG_ENTRIES)
+	if (index < SJA1105P_N_RETAG_ENTRIES)
 	{
-		ret = 0;
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		rule = g_retaggingRule[index];
+		rule.ingressVlanId = ingressVlanId;
+		rule.egressPorts   = egressPorts;
+		rule.ingressPorts |= ingressPorts;
+		rule.nRules++;
+		for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
 		{
-			ret += loadRetaggingEntry(&retaggingEntry, retaggingEntryIndex, &validEntry, switchId);
-
-			/* modify parts relevant to the retagging */
-			retaggingEntry.vlanIng = ingressVlanId;
-			retaggingEntry.vlanEgr = egressVlanId;
-			SJA1105P_getPhysicalPortVector(ingressPorts, switchId, &physicalIngressPorts);
-			SJA1105P_getPhysicalPortVector(egressPorts, switchId, &physicalEgressPorts);
-			retaggingEntry.ingPort = physicalIngressPorts;
-			retaggingEntry.egrPort = physicalEgressPorts;
-
-			ret += storeRetaggingEntry(&retaggingEntry, retaggingEntryIndex, 1U, switchId);
-		}
-		if (ret == 0U)
-		{  /* retagging successfully started on all switches */
-			g_retaggingValid[retaggingEntryIndex] = 1;
+			if (((ingressPorts >> port) & 1U) == 1U)
+			{
+				rule.nPortRules[port]++;
+			}
 		}
+		ret = updateRetaggingRule(index, &rule);
 	}
+
 	return ret;
 }
 
 /**
 * \brief Stop retagging frames with the specified configuration.
 *
-* \param[in]  egressVlanId VLAN ID for which retagging should be disabled
+* The entry is only released once all rules sharing it are stopped.
+*
+* \param[in]  ingressPorts Ingress ports of the rule as passed to ::SJA1105P_startRetagging
+* \param[in]  egressPorts Egress ports of the rule
+* \param[in]  ingressVlanId Ingress VLAN ID of the rule
+* \param[in]  egressVlanId Egress VLAN ID of the rule
 *
 * \return uint8_t Returns 0 if successful, else failed.
 */
-extern uint8_t SJA1105P_stopRetagging(uint16_t egressVlanId)
+extern uint8_t SJA1105P_stopRetagging(uint16_t ingressPorts, uint16_t egressPorts, uint16_t ingressVlanId, uint16_t egressVlanId)
 {
 	uint8_t ret = 1;
-	uint8_t switchId;
-	uint8_t retaggingEntryIndex;
-	uint8_t validEntry;
-	SJA1105P_retaggingTableEntryArgument_t retaggingEntry;
+	uint8_t port;
+	uint8_t index;
+	retaggingRule_t rule;
 
-	retaggingEntryIndex = getRetaggingEntryIndex(egressVlanId);
-	if (retaggingEntryIndex < SJA1105P_N_RETAG_ENTRIES)
+	index = findRetaggingRule(ingressVlanId, egressVlanId, egressPorts);
+	if (index < SJA1105P_N_RETAG_ENTRIES)
 	{  /* retagging entry exists */
-		ret = 0;
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		rule = g_retaggingRule[index];
+		rule.nRules--;
+		for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
 		{
-			ret += loadRetaggingEntry(&retaggingEntry, retaggingEntryIndex, &validEntry, switchId);
-
-			retaggingEntry.ingPort = 0;
-			retaggingEntry.egrPort = 0;
-
-			ret += storeRetaggingEntry(&retaggingEntry, retaggingEntryIndex, g_bypassingValid[retaggingEntryIndex], switchId); /* if no bypassing rule is in place, entry can be invalidated */
+			if ((((ingressPorts >> port) & 1U) == 1U) && (rule.nPortRules[port] > 0U))
+			{
+				rule.nPortRules[port]--;
+				if (rule.nPortRules[port] == 0U)
+				{  /* no other rule retags at this port */
+					rule.ingressPorts &= (uint16_t) ~((uint16_t) ((uint16_t) 1 << port));
+				}
+			}
 		}
-		if (ret == 0U)
-		{  /* retagging sucessfully stopped */
-			g_retaggingValid[retaggingEntryIndex] = 0;
+		if (rule.nRules == 0U)
+		{
+			rule.ingressPorts = 0;
+			rule.egressPorts  = 0;
 		}
+		ret = updateRetaggingRule(index, &rule);
 	}
+
 	return ret;
 }
 
 extern uint8_t SJA1105P_enableBypassing(uint16_t vlanId, uint16_t destPorts, uint8_t learningDisabled)
 {
 	uint8_t ret = 1;
-	uint8_t switchId;
-	uint8_t physicalDestPorts;
-	uint8_t retaggingEntryIndex;
-	uint8_t validEntry;
-	SJA1105P_retaggingTableEntryArgument_t retaggingEntry;
+	uint8_t index;
+	retaggingRule_t rule;
 
-	retaggingEntryIndex = getRetaggingEntryIndex(vlanId);
+	index = findBypassingRule(vlanId);
+	if (index == SJA1105P_N_RETAG_ENTRIES)
+	{  /* shares the entry of a retagging rule with the same egress VLAN ID if there is one */
+		index = allocateRetaggingRule(vlanId, 1U);
+	}
 
-	if (retaggingEntryIndex < SJA1105P_N_RETAG_ENTRIES)
+	if (index < SJA1105P_N_RETAG_ENTRIES)
 	{
-		ret = 0;
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-		{
-			ret += loadRetaggingEntry(&retaggingEntry, retaggingEntryIndex, &validEntry, switchId);
-
-			retaggingEntry.vlanEgr      = vlanId;
-			retaggingEntry.doNotLearn   = learningDisabled;
-			retaggingEntry.useDestports = 1;
-			SJA1105P_getPhysicalPortVector(destPorts, switchId, &physicalDestPorts);
-			retaggingEntry.destports = physicalDestPorts;
-
-			ret += storeRetaggingEntry(&retaggingEntry, retaggingEntryIndex, 1, switchId);
-		}
-		if (ret == 0U)
-		{  /* Bypassing successfully started */
-			g_bypassingValid[retaggingEntryIndex] = 1;
-		}
+		rule = g_retaggingRule[index];
+		rule.bypassing  = 1;
+		rule.destPorts  = destPorts;
+		rule.doNotLearn = learningDisabled;
+		ret = updateRetaggingRule(index, &rule);
 	}
+
 	return ret;
 }
 
 extern uint8_t SJA1105P_disableBypassing(uint16_t vlanId)
 {
 	uint8_t ret = 1;
-	uint8_t switchId;
-	uint8_t retaggingEntryIndex;
-	uint8_t validEntry;
-	SJA1105P_retaggingTableEntryArgument_t retaggingEntry;
+	uint8_t index;
+	retaggingRule_t rule;
 
-	retaggingEntryIndex = getRetaggingEntryIndex(vlanId);
-	if (retaggingEntryIndex < SJA1105P_N_RETAG_ENTRIES)
+	index = findBypassingRule(vlanId);
+	if (index < SJA1105P_N_RETAG_ENTRIES)
 	{
-		ret = 0;
-		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
-		{
-			ret += loadRetaggingEntry(&retaggingEntry, retaggingEntryIndex, &validEntry, switchId);
-
-			retaggingEntry.doNotLearn   = 0;
-			retaggingEntry.useDestports = 0;
-
-			ret += storeRetaggingEntry(&retaggingEntry, retaggingEntryIndex, g_retaggingValid[retaggingEntryIndex], switchId);
-		}
-		if (ret == 0U)
-		{  /* bypassing successfully disabled */
-			g_bypassingValid[retaggingEntryIndex] = 0;
-		}
+		rule = g_retaggingRule[index];
+		rule.bypassing  = 0;
+		rule.destPorts  = 0;
+		rule.doNotLearn = 0;
+		ret = updateRetaggingRule(index, &rule);
 	}
+
 	return ret;
 }
 
 /**
-* \brief Store configuration in switch
-*
-* \param[in]  vlanEntry Entry to be stored
-* \param[in]  switchId switch to which the entry will be stored
+* \brief Forget all retagging and bypassing rules
+*
+* Must be called after loading a static configuration, which is assumed to hold no retagging entries.
+*/
+extern void SJA1105P_resetRetagging(void)
+{
+	uint8_t index;
+	uint8_t port;
+
+	for (index = 0; index < N_RETAG_KEY_BUCKETS; index++)
+	{
+		g_retaggingKeyBucket[index] = SJA1105P_N_RETAG_ENTRIES;
+	}
+	for (index = 0; index < SJA1105P_N_RETAG_ENTRIES; index++)
+	{
+		g_retaggingRule[index].ingressVlanId = 0;
+		g_retaggingRule[index].egressVlanId  = 0;
+		g_retaggingRule[index].ingressPorts  = 0;
+		g_retaggingRule[index].egressPorts   = 0;
+		g_retaggingRule[index].destPorts     = 0;
+		g_retaggingRule[index].bypassing     = 0;
+		g_retaggingRule[index].doNotLearn    = 0;
+		g_retaggingRule[index].nRules        = 0;
+		for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
+		{
+			g_retaggingRule[index].nPortRules[port] = 0;
+		}
+		g_retaggingSwitches[index] = 0;
+		g_retaggingKeyNext[index]  = SJA1105P_N_RETAG_ENTRIES;
+		g_retaggingFree[index] = (uint8_t) (SJA1105P_N_RETAG_ENTRIES - 1U - index);  /* lowest index on top */
+	}
+	g_nRetaggingFree = SJA1105P_N_RETAG_ENTRIES;
+	g_retaggingInitialized = 1;
+}
+
+/**
+* \brief Get the switches in which a VLAN may be configured
+*
+* Frames of the VLAN are neither received nor forwarded by a switch holding an empty
+* entry for it. VLAN IDs not yet used by this module are assumed to be configured.
+*
+* \param[in]  vlanId VLAN ID
+*
+* \return uint8_t One bit per switch, cleared if the switch is known to hold an empty entry
+*/
+extern uint8_t SJA1105P_getVlanSwitches(uint16_t vlanId)
+{
+	uint8_t switches = ALL_SWITCHES;
+	uint8_t switchId;
+
+	if ((vlanId < N_VLAN_IDS) && (g_vlanShadowValid[vlanId] == 1U))
+	{  /* entries not yet written are not known to be empty */
+		switches = g_vlanDirtySwitches[vlanId];
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			if (isVlanEntryEmpty(&(g_vlanEntry[vlanId][switchId])) == 0U)
+			{
+				switches |= (uint8_t) (((uint8_t) 1) << switchId);
+			}
+		}
+	}
+
+	return switches;
+}
+
+/**
+* \brief Invalidate the shadow of the VLAN lookup table
+*
+* Must be called if the VLAN lookup table was modified without using this module,
+* e.g. after loading a static configuration. Entries not yet flushed are discarded.
+* The port based VLANs are loaded again as well, the VLAN IDs found then are
+* restored by ::SJA1105P_resetPvid.
+*/
+extern void SJA1105P_resetVlanShadow(void)
+{
+	uint16_t vlanId;
+	uint8_t  port;
+
+	for (vlanId = 0; vlanId < N_VLAN_IDS; vlanId++)
+	{
+		g_vlanShadowValid[vlanId]   = 0;
+		g_vlanDirtySwitches[vlanId] = 0;
+	}
+	g_vlanDirtyFirst = N_VLAN_IDS;
+	g_vlanDirtyLast  = 0;
+
+	for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
+	{
+		g_portVlan[port].valid = 0;
+	}
+}
+
+/**
+* \brief Load the entries of one switch which are not yet in the shadow
+*
+* \param[in]  switchId switch from which the entries will be loaded
+* \param[in]  p_context ::vlanLoadJob_t, the entries are stored in the shadow at the position of the switch
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t loadVlanEntriesJob(uint8_t switchId, void *p_context)
+{
+	uint8_t  ret = 0;
+	uint8_t  nEntries = 0;
+	uint16_t vlanId;
+	uint16_t batchVlanId[N_PIPELINED_READS];
+	const vlanLoadJob_t *kp_loadJob = (const vlanLoadJob_t *) p_context;
+
+	for (vlanId = kp_loadJob->firstVlanId; (vlanId <= kp_loadJob->lastVlanId) && (ret == 0U); vlanId++)
+	{
+		if (g_vlanShadowValid[vlanId] == 0U)
+		{
+			batchVlanId[nEntries] = vlanId;
+			nEntries++;
+		}
+		if ((nEntries == N_PIPELINED_READS) || ((vlanId == kp_loadJob->lastVlanId) && (nEntries > 0U)))
+		{
+			ret = loadVlanEntryBatch(batchVlanId, nEntries, switchId);
+			nEntries = 0;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Store the dirty entries of one switch in ascending order of the VLAN ID
+*
+* Stops at the first batch which could not be stored.
+*
+* \param[in]  switchId switch to which the entries will be stored
+* \param[in,out] p_context ::vlanFlushJob_t, the failed VLAN ID is stored at the position of the switch
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t flushVlanEntriesJob(uint8_t switchId, void *p_context)
+{
+	uint8_t  ret = 0;
+	uint8_t  nEntries = 0;
+	uint16_t vlanId;
+	uint16_t batchVlanId[N_PIPELINED_WRITES];
+	vlanFlushJob_t *p_flushJob = (vlanFlushJob_t *) p_context;
+
+	p_flushJob->failedVlanId[switchId] = N_VLAN_IDS;
+	for (vlanId = p_flushJob->firstVlanId; (vlanId <= p_flushJob->lastVlanId) && (ret == 0U); vlanId++)
+	{
+		if (((g_vlanDirtySwitches[vlanId] >> switchId) & 1U) == 1U)
+		{
+			batchVlanId[nEntries] = vlanId;
+			nEntries++;
+		}
+		if ((nEntries == N_PIPELINED_WRITES) || ((vlanId == p_flushJob->lastVlanId) && (nEntries > 0U)))
+		{
+			ret = storeVlanEntryBatch(batchVlanId, nEntries, switchId);
+			if (ret != 0U)
+			{  /* the entries of the batch and the remaining ones are kept dirty */
+				p_flushJob->failedVlanId[switchId] = batchVlanId[0];
+			}
+			nEntries = 0;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Get an entry of the shadow in the format of the switch
+*
+* \param[in]  vlanId VLAN ID of the entry
+* \param[in]  switchId switch of the entry
+* \param[out] p_vlanEntry Memory location of the entry
+*/
+static void getVlanShadowEntry(uint16_t vlanId, uint8_t switchId, SJA1105P_vlanLookupTableEntryArgument_t *p_vlanEntry)
+{
+	const vlanLookupTableReconfigurationEntry_t *kp_shadowEntry = &(g_vlanEntry[vlanId][switchId]);
+
+	p_vlanEntry->vlanid    = vlanId;
+	p_vlanEntry->tagPort   = kp_shadowEntry->tagPort;
+	p_vlanEntry->vlanBc    = kp_shadowEntry->vlanBc;
+	p_vlanEntry->vmembPort = kp_shadowEntry->vmembPort;
+	p_vlanEntry->vegrMirr  = kp_shadowEntry->vegrMirr;
+	p_vlanEntry->vingMirr  = kp_shadowEntry->vingMirr;
+}
+
+/**
+* \brief Set an entry of the shadow from an entry read from the switch
+*
+* \param[in]  vlanId VLAN ID of the entry
+* \param[in]  switchId switch of the entry
+* \param[in]  kp_vlanEntry Entry read from the switch
+*/
+static void setVlanShadowEntry(uint16_t vlanId, uint8_t switchId, const SJA1105P_vlanLookupTableEntryArgument_t *kp_vlanEntry)
+{
+	vlanLookupTableReconfigurationEntry_t *p_shadowEntry = &(g_vlanEntry[vlanId][switchId]);
+
+	p_shadowEntry->tagPort   = kp_vlanEntry->tagPort;
+	p_shadowEntry->vlanBc    = kp_vlanEntry->vlanBc;
+	p_shadowEntry->vmembPort = kp_vlanEntry->vmembPort;
+	p_shadowEntry->vegrMirr  = kp_vlanEntry->vegrMirr;
+	p_shadowEntry->vingMirr  = kp_vlanEntry->vingMirr;
+}
+
+/**
+* \brief Load the shadow of a range of VLAN IDs from the switches, unless already done
+*
+* \param[in]  firstVlanId First VLAN ID of the range
+* \param[in]  lastVlanId Last VLAN ID of the range
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t loadVlanShadow(uint16_t firstVlanId, uint16_t lastVlanId)
+{
+	uint8_t  ret = 1;
+	uint8_t  port;
+	uint8_t  physicalPortBit;
+	uint16_t vlanId;
+	const vlanLookupTableReconfigurationEntry_t *kp_shadowEntry;
+	SJA1105P_port_t physicalPort;
+	vlanConfiguration_t configuration;
+	vlanLoadJob_t loadJob;
+
+	if ((firstVlanId <= lastVlanId) && (lastVlanId < N_VLAN_IDS))
+	{
+		loadJob.firstVlanId = N_VLAN_IDS;
+		loadJob.lastVlanId  = 0;
+		for (vlanId = firstVlanId; vlanId <= lastVlanId; vlanId++)
+		{
+			if (g_vlanShadowValid[vlanId] == 0U)
+			{
+				loadJob.firstVlanId = (loadJob.firstVlanId == N_VLAN_IDS) ? vlanId : loadJob.firstVlanId;
+				loadJob.lastVlanId  = vlanId;
+			}
+		}
+
+		ret = 0;
+		if (loadJob.firstVlanId < N_VLAN_IDS)
+		{
+			ret = SJA1105P_forEachSwitch(loadVlanEntriesJob, &loadJob);
+		}
+
+		/* translate the physical lookups to the configuration of the logical ports */
+		for (vlanId = loadJob.firstVlanId; (vlanId <= loadJob.lastVlanId) && (ret == 0U); vlanId++)
+		{
+			if (g_vlanShadowValid[vlanId] == 0U)
+			{
+				configuration.enable   = 0;
+				configuration.tagged   = 0;
+				configuration.untagged = 0;
+				for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
+				{
+					ret += SJA1105P_getPhysicalPort(port, &physicalPort);
+					physicalPortBit = (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
+					kp_shadowEntry = &(g_vlanEntry[vlanId][physicalPort.switchId]);
+					if ((kp_shadowEntry->vlanBc & physicalPortBit) != 0U)
+					{
+						if ((kp_shadowEntry->tagPort & physicalPortBit) != 0U)
+						{
+							configuration.tagged |= (uint16_t) ((uint16_t) 1 << port);
+						}
+						else
+						{
+							configuration.untagged |= (uint16_t) ((uint16_t) 1 << port);
+						}
+					}
+					if ((kp_shadowEntry->vmembPort & physicalPortBit) != 0U)
+					{  /* VLAN is enabled on this port */
+						configuration.enable |= (uint16_t) ((uint16_t) 1 << port);
+					}
+				}
+				g_vlanConfiguration[vlanId] = configuration;
+				g_vlanShadowValid[vlanId]   = (ret == 0U) ? 1U : 0U;
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Update the shadow of a VLAN ID and mark the entries which changed as dirty
+*
+* The static address resolution entries of the VLAN are copied to the switches it was
+* extended to, such that they are in place once the entries are flushed.
+*
+* \param[in]  vlanId VLAN ID
+* \param[in]  kp_configuration Configuration of the logical ports
+* \param[in]  kp_vlanEntry One entry per switch
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t updateVlanShadow(uint16_t vlanId, const vlanConfiguration_t *kp_configuration, const vlanLookupTableReconfigurationEntry_t *kp_vlanEntry)
+{
+	uint8_t ret = 1;
+	uint8_t switchId;
+	uint8_t previousSwitches;
+
+	if (vlanId < N_VLAN_IDS)
+	{
+		previousSwitches = SJA1105P_getVlanSwitches(vlanId);
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			if ((g_vlanShadowValid[vlanId] == 0U) || (isVlanEntryEqual(&(g_vlanEntry[vlanId][switchId]), &(kp_vlanEntry[switchId])) == 0U))
+			{
+				g_vlanEntry[vlanId][switchId] = kp_vlanEntry[switchId];
+				g_vlanDirtySwitches[vlanId] |= (uint8_t) (((uint8_t) 1) << switchId);
+			}
+		}
+		g_vlanConfiguration[vlanId] = *kp_configuration;
+		g_vlanShadowValid[vlanId]   = 1;
+
+		if (g_vlanDirtySwitches[vlanId] != 0U)
+		{
+			g_vlanDirtyFirst = (vlanId < g_vlanDirtyFirst) ? vlanId : g_vlanDirtyFirst;
+			g_vlanDirtyLast  = (vlanId > g_vlanDirtyLast)  ? vlanId : g_vlanDirtyLast;
+		}
+		ret = extendVlanSwitches(vlanId, previousSwitches);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Translate the configuration of the logical ports into one entry per switch
+*
+* \param[in]  kp_configuration Configuration of the logical ports
+* \param[out] p_vlanEntry Memory location of one entry per switch
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t deriveVlanEntries(const vlanConfiguration_t *kp_configuration, vlanLookupTableReconfigurationEntry_t *p_vlanEntry)
+{
+	uint8_t  ret = 0;
+	uint8_t  switchId;
+	uint8_t  port;
+	uint8_t  enabledPhysicalPorts;
+	uint8_t  firstMemberSwitchId = SJA1105P_N_SWITCHES;
+	uint8_t  lastMemberSwitchId  = 0;
+	uint8_t  firstBroadcastSwitchId = SJA1105P_N_SWITCHES;
+	uint8_t  lastBroadcastSwitchId  = 0;
+	uint16_t portBit;
+	SJA1105P_port_t physicalPort;
+
+	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	{
+		p_vlanEntry[switchId].tagPort   = 0;
+		p_vlanEntry[switchId].vlanBc    = 0;
+		p_vlanEntry[switchId].vmembPort = 0;
+		p_vlanEntry[switchId].vegrMirr  = 0;
+		p_vlanEntry[switchId].vingMirr  = 0;
+	}
+
+	/* determine VLAN lookup configuration for logical port and translate to physical lookups */
+	for (port = 0U; port < SJA1105P_N_LOGICAL_PORTS; port++)
+	{
+		ret += SJA1105P_getPhysicalPort(port, &physicalPort);
+		portBit = (uint16_t) ((uint16_t) 1 << port);
+		if ((kp_configuration->tagged & portBit) != 0U)
+		{
+			p_vlanEntry[physicalPort.switchId].tagPort |= (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
+			p_vlanEntry[physicalPort.switchId].vlanBc  |= (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
+		}
+		else if ((kp_configuration->untagged & portBit) != 0U)
+		{
+			p_vlanEntry[physicalPort.switchId].vlanBc  |= (uint8_t) ((uint8_t) 1 << physicalPort.physicalPort);
+		}
+		else
+		{
+			/* port is not forwarded to */
+		}
+	}
+
+	/* determine member ports */
+	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	{
+		SJA1105P_getPhysicalPortVector(kp_configuration->enable, switchId, &enabledPhysicalPorts);
+		p_vlanEntry[switchId].vmembPort = enabledPhysicalPorts;
+	}
+
+	/* determine vlan lookup configuration for the internal ports (cascaded) */
+	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	{
+		if (p_vlanEntry[switchId].vmembPort != 0U)
+		{  /* at least one port in this switch is VLAN member */
+			firstMemberSwitchId = (firstMemberSwitchId == SJA1105P_N_SWITCHES) ? (switchId) : (firstMemberSwitchId);
+			lastMemberSwitchId  = (switchId > lastMemberSwitchId) ? (switchId) : (firstMemberSwitchId);
+		}
+		if (p_vlanEntry[switchId].vlanBc != 0U)
+		{  /* at least one port in this switch is VLAN member */
+			firstBroadcastSwitchId = (firstBroadcastSwitchId == SJA1105P_N_SWITCHES) ? (switchId) : (firstBroadcastSwitchId);
+			lastBroadcastSwitchId  = (switchId > lastBroadcastSwitchId) ? (switchId) : (firstBroadcastSwitchId);
+		}
+	}
+
+	/* configure internal ports VLAN forwarding */
+	for (switchId = 0; switchId < (SJA1105P_N_SWITCHES - 1U); switchId++)
+	{
+		if (switchId >= firstMemberSwitchId)
+		{
+			if (switchId < lastMemberSwitchId)
+			{
+				if (switchId < lastBroadcastSwitchId)
+				{
+					/* enable on this switch to forward to the cascaded port */
+					p_vlanEntry[switchId].vlanBc  |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
+					p_vlanEntry[switchId].tagPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
+					/* also enable receiving on the connecting counter part of cascaded port */
+					p_vlanEntry[switchId + 1U].vmembPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
+					p_vlanEntry[switchId + 1U].tagPort   |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
+				}
+				if (switchId >= firstBroadcastSwitchId)
+				{
+					/* enable on this switch to receive from the cascaded port */
+					p_vlanEntry[switchId].vmembPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
+					p_vlanEntry[switchId].tagPort   |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.cascPort[switchId]);
+					/* also enable forwarding on the connecting counter part of cascaded port */
+					p_vlanEntry[switchId + 1U].vlanBc  |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
+					p_vlanEntry[switchId + 1U].tagPort |= (uint8_t) ((uint8_t) 1 << SJA1105P_g_generalParameters.hostPort[switchId + 1U]);
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Check whether an entry neither receives, forwards nor mirrors any port
+*
+* \param[in]  kp_vlanEntry Entry to be checked
+*
+* \return uint8_t 1 if the entry is empty, else 0
+*/
+static uint8_t isVlanEntryEmpty(const vlanLookupTableReconfigurationEntry_t *kp_vlanEntry)
+{
+	uint8_t empty = 0;
+
+	if ((kp_vlanEntry->tagPort == 0U) && (kp_vlanEntry->vlanBc == 0U) && (kp_vlanEntry->vmembPort == 0U) &&
+	    (kp_vlanEntry->vegrMirr == 0U) && (kp_vlanEntry->vingMirr == 0U))
+	{
+		empty = 1;
+	}
+
+	return empty;
+}
+
+/**
+* \brief Check whether two entries are identical
+*
+* \param[in]  kp_vlanEntry Entry to be compared
+* \param[in]  kp_otherVlanEntry Entry to be compared with
+*
+* \return uint8_t 1 if the entries are identical, else 0
+*/
+static uint8_t isVlanEntryEqual(const vlanLookupTableReconfigurationEntry_t *kp_vlanEntry, const vlanLookupTableReconfigurationEntry_t *kp_otherVlanEntry)
+{
+	uint8_t equal = 0;
+
+	if ((kp_vlanEntry->tagPort == kp_otherVlanEntry->tagPort) && (kp_vlanEntry->vlanBc == kp_otherVlanEntry->vlanBc) &&
+	    (kp_vlanEntry->vmembPort == kp_otherVlanEntry->vmembPort) && (kp_vlanEntry->vegrMirr == kp_otherVlanEntry->vegrMirr) &&
+	    (kp_vlanEntry->vingMirr == kp_otherVlanEntry->vingMirr))
+	{
+		equal = 1;
+	}
+
+	return equal;
+}
+
+/**
+* \brief Copy the static address resolution entries of a VLAN to the switches it was extended to
+*
+* \param[in]  vlanId VLAN ID
+* \param[in]  previousSwitches Result of ::SJA1105P_getVlanSwitches before the VLAN was modified
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t extendVlanSwitches(uint16_t vlanId, uint8_t previousSwitches)
+{
+	uint8_t ret = 0;
+
+	if ((SJA1105P_getVlanSwitches(vlanId) & (uint8_t) ~previousSwitches) != 0U)
+	{  /* the entries were not written to the added switches */
+		ret = SJA1105P_synchArlVlanSwitches(vlanId);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Store configuration in switch
+*
+* \param[in]  vlanEntry Entry to be stored
+* \param[in]  switchId switch to which the entry will be stored
 *
 * \return uint8_t 0 upon success, else failed
 */
@@ -471,8 +1199,12 @@ static uint8_t storeVlanEntry(const SJA1105P_vlanLookupTableEntryArgument_t *kp_
 	vlanLookupTableControl.valident = 1;
 	vlanLookupTableControl.rdwrset  = 1;  /* write access */
 
-	ret  = SJA1105P_setVlanLookupTableEntry(kp_vlanEntry, switchId);
+	/* entry and control are transferred together with the first completion poll */
+	ret  = SJA1105P_spiQueueStart(switchId);
+	ret += SJA1105P_setVlanLookupTableEntry(kp_vlanEntry, switchId);
 	ret += SJA1105P_setVlanLookupTableControl(&vlanLookupTableControl, switchId);
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_VLAN_LOOKUP, NULL, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
 
 	return ret;
 }
@@ -495,97 +1227,525 @@ static uint8_t loadVlanEntry(uint16_t vlanId, SJA1105P_vlanLookupTableEntryArgum
 
 	p_vlanEntry->vlanid = vlanId;
 
-	ret  = SJA1105P_setVlanLookupTableEntry(p_vlanEntry, switchId);
-	ret += SJA1105P_setVlanLookupTableControl(&vlanLookupTableControl, switchId);
-	ret += SJA1105P_getVlanLookupTableEntry(p_vlanEntry, switchId);
+	/* the outer batch holds the transport lock of the switch until the entry was read back */
+	ret = SJA1105P_spiQueueStart(switchId);
+	if (ret == 0U)
+	{
+		ret  = SJA1105P_spiQueueStart(switchId);
+		ret += SJA1105P_setVlanLookupTableEntry(p_vlanEntry, switchId);
+		ret += SJA1105P_setVlanLookupTableControl(&vlanLookupTableControl, switchId);
+		ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_VLAN_LOOKUP, NULL, switchId);
+		ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+		if (ret == 0U)
+		{  /* the entry is only valid once the read command completed */
+			ret = SJA1105P_getVlanLookupTableEntry(p_vlanEntry, switchId);
+		}
+		if ((ret == 0U) && (p_vlanEntry->vlanid != vlanId))
+		{
+			ret = 1;
+		}
+		ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+	}
 
 	return ret;
 }
 
 /**
-* \brief Find the index matching the VLAN ID.
+* \brief Load several entries into the shadow within one SPI batch
 *
-* If no matching entry exists, the lowest unused index is used instead.
+* For each entry, the VLAN ID and the read command are written, followed by a read of the control
+* register and of the entry. If the control register shows that a command did not complete in
+* time, or the entry read back carries another VLAN ID, the following commands may have been issued
+* while it was still running. This entry and all following ones are read again with ::loadVlanEntry.
 *
-* \param[in]  egressVlanId VLAN ID for which the entry is searched
+* \param[in]  kp_vlanId VLAN IDs of the entries to be loaded
+* \param[in]  nEntries Number of entries to be loaded, at most N_PIPELINED_READS
+* \param[in]  switchId switch from which the entries will be loaded
 *
-* \return uint8_t Return the index of the retagging entry. Returns invalid index if no resources are available.
+* \return uint8_t 0 upon success, else failed
 */
-static uint8_t getRetaggingEntryIndex(uint16_t egressVlanId)
+static uint8_t loadVlanEntryBatch(const uint16_t *kp_vlanId, uint8_t nEntries, uint8_t switchId)
 {
-	uint8_t retaggingEntryIndex = SJA1105P_N_RETAG_ENTRIES;
-	uint8_t i;
-	for (i = 0; i < SJA1105P_N_RETAG_ENTRIES; i++)
-	{  /* find available retagging resources */
-		if (((g_retaggingValid[i] == 1U) || (g_bypassingValid[i] == 1U)) && (g_retaggingTableVlanId[i] == egressVlanId))
-		{  /* there is already a rule in place. It will be overwritten with the new settings */
-			retaggingEntryIndex = i;
-			break;
+	uint8_t  ret;
+	uint8_t  i;
+	uint8_t  inTime = 1;
+	uint32_t controlRegister[N_PIPELINED_READS];
+	uint32_t entryRegister[N_PIPELINED_READS][SJA1105P_VLAN_LOOKUP_TABLE_ENTRY_WORDS];
+
+	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry = {0};
+	SJA1105P_vlanLookupTableControlArgument_t vlanLookupTableControl;
+
+	vlanLookupTableControl.valid    = 1;
+	vlanLookupTableControl.valident = 1;
+	vlanLookupTableControl.rdwrset  = 0;  /* read access */
+
+	ret = SJA1105P_spiQueueStart(switchId);
+	for (i = 0; i < nEntries; i++)
+	{
+		vlanLookupTableEntry.vlanid = kp_vlanId[i];
+		ret += SJA1105P_setVlanLookupTableEntry(&vlanLookupTableEntry, switchId);
+		ret += SJA1105P_setVlanLookupTableControl(&vlanLookupTableControl, switchId);
+		ret += SJA1105P_queueGetVlanLookupTableControl(&(controlRegister[i]), switchId);
+		ret += SJA1105P_queueGetVlanLookupTableEntry(entryRegister[i], switchId);
+	}
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
+	for (i = 0; (i < nEntries) && (ret == 0U); i++)
+	{
+		if (inTime == 1U)
+		{
+			SJA1105P_decodeVlanLookupTableControl(controlRegister[i], &vlanLookupTableControl);
+			SJA1105P_decodeVlanLookupTableEntry(entryRegister[i], &vlanLookupTableEntry);
+			if ((vlanLookupTableControl.valid == 1U) || (vlanLookupTableEntry.vlanid != kp_vlanId[i]))
+			{  /* not complete when the entry was read and the next command was issued */
+				inTime = 0;
+			}
 		}
-		else
+
+		if (inTime == 0U)
+		{
+			ret = loadVlanEntry(kp_vlanId[i], &vlanLookupTableEntry, switchId);
+		}
+
+		if (ret == 0U)
 		{
-			if ((g_retaggingValid[i] == 0U) && (g_bypassingValid[i] == 0U) && (retaggingEntryIndex == SJA1105P_N_RETAG_ENTRIES))
-			{  /* no matching rule found yet. This is the first available entry. */
-				g_retaggingTableVlanId[i] = egressVlanId;
-				retaggingEntryIndex = i;
+			setVlanShadowEntry(kp_vlanId[i], switchId, &vlanLookupTableEntry);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Store several entries of the shadow within one SPI batch
+*
+* For each entry, the entry and the write command are written, followed by a read of the control
+* register. If the control register shows that a command did not complete in time, the entry
+* registers were overwritten by the next entry while it was running and the following commands
+* may have been ignored. This entry and all following ones are stored again with ::storeVlanEntry.
+*
+* \param[in]  kp_vlanId VLAN IDs of the entries to be stored
+* \param[in]  nEntries Number of entries to be stored, at most N_PIPELINED_WRITES
+* \param[in]  switchId switch to which the entries will be stored
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t storeVlanEntryBatch(const uint16_t *kp_vlanId, uint8_t nEntries, uint8_t switchId)
+{
+	uint8_t  ret;
+	uint8_t  i;
+	uint8_t  inTime = 1;
+	uint32_t controlRegister[N_PIPELINED_WRITES];
+
+	SJA1105P_vlanLookupTableEntryArgument_t vlanLookupTableEntry;
+	SJA1105P_vlanLookupTableControlArgument_t vlanLookupTableControl;
+
+	vlanLookupTableControl.valid    = 1;
+	vlanLookupTableControl.valident = 1;
+	vlanLookupTableControl.rdwrset  = 1;  /* write access */
+
+	ret = SJA1105P_spiQueueStart(switchId);
+	for (i = 0; i < nEntries; i++)
+	{
+		getVlanShadowEntry(kp_vlanId[i], switchId, &vlanLookupTableEntry);
+		ret += SJA1105P_setVlanLookupTableEntry(&vlanLookupTableEntry, switchId);
+		ret += SJA1105P_setVlanLookupTableControl(&vlanLookupTableControl, switchId);
+		ret += SJA1105P_queueGetVlanLookupTableControl(&(controlRegister[i]), switchId);
+	}
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
+	for (i = 0; (i < nEntries) && (ret == 0U); i++)
+	{
+		if (inTime == 1U)
+		{
+			SJA1105P_decodeVlanLookupTableControl(controlRegister[i], &vlanLookupTableControl);
+			if (vlanLookupTableControl.valid == 1U)
+			{  /* still busy when the next command was issued */
+				inTime = 0;
 			}
 		}
+
+		if (inTime == 0U)
+		{
+			getVlanShadowEntry(kp_vlanId[i], switchId, &vlanLookupTableEntry);
+			ret = storeVlanEntry(&vlanLookupTableEntry, switchId);
+		}
 	}
-	return retaggingEntryIndex;
+
+	return ret;
 }
 
-static uint8_t storeRetaggingEntry(const SJA1105P_retaggingTableEntryArgument_t *kp_retaggingEntry, uint8_t index, uint8_t validEntry, uint8_t switchId)
+/**
+* \brief Load the port based VLAN of a port if not yet known
+*
+* \param[in]  port Logical port
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t loadPortVlan(uint8_t port)
+{
+	uint8_t ret = 0;
+	SJA1105P_port_t physicalPort;
+	SJA1105P_macCfgTableEntryArgument_t macCfgEntry;
+
+	if (g_portVlan[port].valid == 0U)
+	{
+		ret  = SJA1105P_getPhysicalPort(port, &physicalPort);
+		ret += loadMacCfgEntry(&macCfgEntry, physicalPort.physicalPort, physicalPort.switchId);
+		if (ret == 0U)
+		{
+			g_portVlan[port].pvid        = macCfgEntry.vlanid;
+			g_portVlan[port].defaultPvid = macCfgEntry.vlanid;
+			g_portVlan[port].valid       = 1;
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Write the port based VLAN to the MAC configuration table entry of a port
+*
+* The other parameters of the entry are read back first, since e.g. the speed
+* is changed at run time. The transport lock of the switch is held from the read
+* to the write of the entry, as in ::SJA1105P_setSpeed.
+*
+* \param[in]  port Logical port
+* \param[in]  vlanId Port based VLAN ID
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t writePortVlan(uint8_t port, uint16_t vlanId)
 {
 	uint8_t ret;
-	SJA1105P_retaggingTableControlArgument_t retaggingControl;
-	uint8_t errors = 0;
+	SJA1105P_port_t physicalPort;
+	SJA1105P_macCfgTableEntryArgument_t macCfgEntry;
 
-	retaggingControl.valid    = 1;
-	retaggingControl.valident = validEntry;
-	retaggingControl.rdwrset  = 1;  /* write */
-	retaggingControl.index    = index;
+	ret = SJA1105P_getPhysicalPort(port, &physicalPort);
+	if (ret == 0U)
+	{
+		ret = SJA1105P_spiQueueStart(physicalPort.switchId);
+		if (ret == 0U)
+		{
+			ret = loadMacCfgEntry(&macCfgEntry, physicalPort.physicalPort, physicalPort.switchId);
+			if (ret == 0U)
+			{
+				macCfgEntry.vlanid = vlanId;
+				ret = storeMacCfgEntry(&macCfgEntry, physicalPort.physicalPort, physicalPort.switchId);
+			}
+			ret += SJA1105P_spiQueueCommit(physicalPort.switchId, NULL, NULL);
+		}
+	}
 
-	ret =  SJA1105P_setRetaggingTableEntry(kp_retaggingEntry, switchId);
-	ret += SJA1105P_setRetaggingTableControl(&retaggingControl, switchId);
-	ret += SJA1105P_getRetaggingTableControl(&errors, switchId);
-	if (errors != 0U)
+	if (ret == 0U)
 	{
-		ret++;
+		g_portVlan[port].pvid = vlanId;
 	}
+	else
+	{  /* the content of the entry is unknown */
+		g_portVlan[port].valid = 0;
+	}
+
+	return ret;
+}
+
+/**
+* \brief Load the MAC configuration table entry of a port
+*
+* \param[out] p_macCfgEntry Memory location where the entry will be loaded
+* \param[in]  physicalPort Port of the entry
+* \param[in]  switchId switch from which the entry will be loaded
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t loadMacCfgEntry(SJA1105P_macCfgTableEntryArgument_t *p_macCfgEntry, uint8_t physicalPort, uint8_t switchId)
+{
+	uint8_t ret;
+	SJA1105P_macCfgTableControlArgument_t macCfgTableControl;
+
+	macCfgTableControl.valid   = 1;
+	macCfgTableControl.rdwrset = 0;  /* read access */
+	macCfgTableControl.port    = physicalPort;
 
-	if (validEntry == 0U)
+	/* the outer batch holds the transport lock of the switch until the entry was read back */
+	ret = SJA1105P_spiQueueStart(switchId);
+	if (ret == 0U)
 	{
-		g_retaggingTableVlanId[index] = 0;  /* reset the vlan id stored in lookup */
+		ret  = SJA1105P_spiQueueStart(switchId);
+		ret += SJA1105P_setMacCfgTableControl(&macCfgTableControl, switchId);
+		ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_MAC_CFG, NULL, switchId);
+		ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+		if (ret == 0U)
+		{  /* the entry is only valid once the read command completed */
+			ret = SJA1105P_getMacCfgTableEntry(p_macCfgEntry, switchId);
+		}
+		ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
 	}
 
 	return ret;
 }
 
-static uint8_t loadRetaggingEntry(SJA1105P_retaggingTableEntryArgument_t *p_retaggingEntry, uint8_t index, uint8_t *p_validEntry, uint8_t switchId)
+/**
+* \brief Store the MAC configuration table entry of a port
+*
+* \param[in]  kp_macCfgEntry Entry to be stored
+* \param[in]  physicalPort Port of the entry
+* \param[in]  switchId switch to which the entry will be stored
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t storeMacCfgEntry(const SJA1105P_macCfgTableEntryArgument_t *kp_macCfgEntry, uint8_t physicalPort, uint8_t switchId)
 {
 	uint8_t ret;
-	SJA1105P_retaggingTableControlArgument_t retaggingControl = {0};
-	uint8_t errors = 0;
+	SJA1105P_macCfgTableControlArgument_t macCfgTableControl;
 
-	retaggingControl.valid    = 1;
-	retaggingControl.rdwrset  = 0;  /* read */
-	retaggingControl.index    = index;
+	macCfgTableControl.valid   = 1;
+	macCfgTableControl.rdwrset = 1;  /* write access */
+	macCfgTableControl.port    = physicalPort;
+
+	/* entry and control are transferred together with the first completion poll */
+	ret  = SJA1105P_spiQueueStart(switchId);
+	ret += SJA1105P_setMacCfgTableEntry(kp_macCfgEntry, switchId);
+	ret += SJA1105P_setMacCfgTableControl(&macCfgTableControl, switchId);
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_MAC_CFG, NULL, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
+	return ret;
+}
+
+/**
+* \brief Find the index of a retagging rule
+*
+* \param[in]  ingressVlanId Ingress VLAN ID of the rule
+* \param[in]  egressVlanId Egress VLAN ID of the rule
+* \param[in]  egressPorts Egress ports of the rule
+*
+* \return uint8_t Index of the rule, SJA1105P_N_RETAG_ENTRIES if there is none
+*/
+static uint8_t findRetaggingRule(uint16_t ingressVlanId, uint16_t egressVlanId, uint16_t egressPorts)
+{
+	uint8_t index;
 
-	ret  = SJA1105P_setRetaggingTableControl(&retaggingControl, switchId);
-	ret += SJA1105P_getRetaggingTableControl(&errors, switchId);
-	if (errors != 0U)
+	if (g_retaggingInitialized == 0U)
 	{
-		ret++;
+		SJA1105P_resetRetagging();
 	}
-	else
+	index = g_retaggingKeyBucket[egressVlanId & (N_RETAG_KEY_BUCKETS - 1U)];
+
+	while (index < SJA1105P_N_RETAG_ENTRIES)
 	{
+		if ((g_retaggingRule[index].nRules > 0U) && (g_retaggingRule[index].egressVlanId == egressVlanId) &&
+		    (g_retaggingRule[index].ingressVlanId == ingressVlanId) && (g_retaggingRule[index].egressPorts == egressPorts))
+		{
+			break;
+		}
+		index = g_retaggingKeyNext[index];
+	}
+
+	return index;
+}
+
+/**
+* \brief Find the index of the bypassing rule of a VLAN ID
+*
+* \param[in]  vlanId VLAN ID of the rule
+*
+* \return uint8_t Index of the rule, SJA1105P_N_RETAG_ENTRIES if there is none
+*/
+static uint8_t findBypassingRule(uint16_t vlanId)
+{
+	uint8_t index;
+
+	if (g_retaggingInitialized == 0U)
+	{
+		SJA1105P_resetRetagging();
+	}
+	index = g_retaggingKeyBucket[vlanId & (N_RETAG_KEY_BUCKETS - 1U)];
+
+	while (index < SJA1105P_N_RETAG_ENTRIES)
+	{
+		if ((g_retaggingRule[index].bypassing == 1U) && (g_retaggingRule[index].egressVlanId == vlanId))
+		{
+			break;
+		}
+		index = g_retaggingKeyNext[index];
+	}
+
+	return index;
+}
+
+/**
+* \brief Get an index for a new rule
+*
+* A retagging rule shares the entry of a bypassing rule with the same egress VLAN ID and
+* vice versa, as long as that entry is not used for both purposes already.
+*
+* \param[in]  egressVlanId Egress VLAN ID of the new rule
+* \param[in]  bypassing 1 for a bypassing rule, 0 for a retagging rule
+*
+* \return uint8_t Index of the rule, SJA1105P_N_RETAG_ENTRIES if no resources are available
+*/
+static uint8_t allocateRetaggingRule(uint16_t egressVlanId, uint8_t bypassing)
+{
+	uint8_t bucket = (uint8_t) (egressVlanId & (N_RETAG_KEY_BUCKETS - 1U));
+	uint8_t index  = g_retaggingKeyBucket[bucket];
+
+	while (index < SJA1105P_N_RETAG_ENTRIES)
+	{
+		if ((g_retaggingRule[index].egressVlanId == egressVlanId) &&
+		    (((bypassing == 1U) && (g_retaggingRule[index].bypassing == 0U)) || ((bypassing == 0U) && (g_retaggingRule[index].nRules == 0U))))
+		{  /* the entry is not used for this purpose yet */
+			break;
+		}
+		index = g_retaggingKeyNext[index];
+	}
+
+	if ((index == SJA1105P_N_RETAG_ENTRIES) && (g_nRetaggingFree > 0U))
+	{
+		g_nRetaggingFree--;
+		index = g_retaggingFree[g_nRetaggingFree];
+		g_retaggingRule[index].egressVlanId = egressVlanId;
+		g_retaggingKeyNext[index]    = g_retaggingKeyBucket[bucket];
+		g_retaggingKeyBucket[bucket] = index;
+	}
+
+	return index;
+}
+
+/**
+* \brief Release the index of a rule which neither retags nor bypasses
+*
+* \param[in]  index Index of the rule
+*/
+static void releaseRetaggingRule(uint8_t index)
+{
+	uint8_t *p_link = &(g_retaggingKeyBucket[g_retaggingRule[index].egressVlanId & (N_RETAG_KEY_BUCKETS - 1U)]);
+
+	while (*p_link < SJA1105P_N_RETAG_ENTRIES)
+	{
+		if (*p_link == index)
+		{
+			*p_link = g_retaggingKeyNext[index];
+			break;
+		}
+		p_link = &(g_retaggingKeyNext[*p_link]);
+	}
+	g_retaggingKeyNext[index] = SJA1105P_N_RETAG_ENTRIES;
+	g_retaggingRule[index].egressVlanId  = 0;
+	g_retaggingRule[index].ingressVlanId = 0;
+	g_retaggingFree[g_nRetaggingFree] = index;
+	g_nRetaggingFree++;
+}
+
+/**
+* \brief Apply a modified rule to the switches
+*
+* Only the switches whose entry changes are written. If a switch could not be written, the
+* previous rule is restored as far as possible.
+*
+* \param[in]  index Index of the rule
+* \param[in]  kp_rule Modified rule
+*
+* \return uint8_t 0 upon success, else failed
+*/
+static uint8_t updateRetaggingRule(uint8_t index, const retaggingRule_t *kp_rule)
+{
+	uint8_t ret = 0;
+	uint8_t i;
+	uint8_t switchId;
+	uint8_t switchBit;
+	uint8_t validEntry;
+	uint8_t previousValidEntry;
+	retaggingRule_t rule[2];
+	SJA1105P_retaggingTableEntryArgument_t retaggingEntry;
+	SJA1105P_retaggingTableEntryArgument_t previousRetaggingEntry;
+
+	rule[0] = g_retaggingRule[index];  /* restored upon failure */
+	rule[1] = *kp_rule;
+	for (i = 2U; i > 0U; i--)
+	{
+		g_retaggingRule[index] = rule[i - 1U];
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			switchBit = (uint8_t) (((uint8_t) 1) << switchId);
+			validEntry = getRetaggingEntry(&(rule[i - 1U]), switchId, &retaggingEntry);
+			previousValidEntry = getRetaggingEntry(&(rule[2U - i]), switchId, &previousRetaggingEntry);
+			if ((validEntry != (((g_retaggingSwitches[index] & switchBit) != 0U) ? 1U : 0U)) ||
+			    ((validEntry == 1U) && ((i == 1U) || (previousValidEntry == 0U) ||
+			     (retaggingEntry.ingPort != previousRetaggingEntry.ingPort) || (retaggingEntry.egrPort != previousRetaggingEntry.egrPort) ||
+			     (retaggingEntry.destports != previousRetaggingEntry.destports) || (retaggingEntry.useDestports != previousRetaggingEntry.useDestports) ||
+			     (retaggingEntry.doNotLearn != previousRetaggingEntry.doNotLearn) || (retaggingEntry.vlanIng != previousRetaggingEntry.vlanIng))))
+			{
+				if (storeRetaggingEntry(&retaggingEntry, index, validEntry, switchId) == 0U)
+				{
+					g_retaggingSwitches[index] = (validEntry == 1U) ? (uint8_t) (g_retaggingSwitches[index] | switchBit) : (uint8_t) (g_retaggingSwitches[index] & (uint8_t) ~switchBit);
+				}
+				else
+				{  /* the content of the entry is unknown */
+					g_retaggingSwitches[index] |= switchBit;
+					ret = 1;
+				}
+			}
+		}
 		if (ret == 0U)
 		{
-			ret = SJA1105P_getRetaggingTableEntry(p_retaggingEntry, switchId);
-			*p_validEntry = retaggingControl.valident;
+			break;
 		}
 	}
 
+	if ((g_retaggingRule[index].nRules == 0U) && (g_retaggingRule[index].bypassing == 0U) && (g_retaggingSwitches[index] == 0U))
+	{
+		releaseRetaggingRule(index);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Translate a rule into the entry of a switch
+*
+* \param[in]  kp_rule Rule
+* \param[in]  switchId switch of the entry
+* \param[out] p_retaggingEntry Memory location of the entry
+*
+* \return uint8_t 1 if the switch needs the entry, 0 if the entry has no effect in the switch
+*/
+static uint8_t getRetaggingEntry(const retaggingRule_t *kp_rule, uint8_t switchId, SJA1105P_retaggingTableEntryArgument_t *p_retaggingEntry)
+{
+	uint8_t validEntry = 0;
+
+	p_retaggingEntry->vlanIng      = kp_rule->ingressVlanId;
+	p_retaggingEntry->vlanEgr      = kp_rule->egressVlanId;
+	p_retaggingEntry->useDestports = kp_rule->bypassing;
+	p_retaggingEntry->doNotLearn   = kp_rule->doNotLearn;
+	SJA1105P_getPhysicalPortVector(kp_rule->ingressPorts, switchId, &(p_retaggingEntry->ingPort));
+	SJA1105P_getPhysicalPortVector(kp_rule->egressPorts, switchId, &(p_retaggingEntry->egrPort));
+	SJA1105P_getPhysicalPortVector(kp_rule->destPorts, switchId, &(p_retaggingEntry->destports));
+
+	if ((kp_rule->bypassing == 1U) || (p_retaggingEntry->ingPort != 0U) || (p_retaggingEntry->egrPort != 0U))
+	{  /* bypassing also applies to switches without destination ports, frames of the VLAN are dropped */
+		validEntry = 1;
+	}
+
+	return validEntry;
+}
+
+static uint8_t storeRetaggingEntry(const SJA1105P_retaggingTableEntryArgument_t *kp_retaggingEntry, uint8_t index, uint8_t validEntry, uint8_t switchId)
+{
+	uint8_t ret;
+	SJA1105P_retaggingTableControlArgument_t retaggingControl;
+
+	retaggingControl.valid    = 1;
+	retaggingControl.valident = validEntry;
+	retaggingControl.rdwrset  = 1;  /* write */
+	retaggingControl.index    = index;
+
+	ret  = SJA1105P_spiQueueStart(switchId);
+	ret += SJA1105P_setRetaggingTableEntry(kp_retaggingEntry, switchId);
+	ret += SJA1105P_setRetaggingTableControl(&retaggingControl, switchId);
+	ret += SJA1105P_waitReconfiguration(SJA1105P_e_reconfiguration_RETAGGING, NULL, switchId);
+	ret += SJA1105P_spiQueueCommit(switchId, NULL, NULL);
+
 	return ret;
 }
 
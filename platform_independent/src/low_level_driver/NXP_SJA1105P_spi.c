@@ -41,6 +41,28 @@
 #include "typedefs.h"
 
 #include "NXP_SJA1105P_spi.h"
+#include "NXP_SJA1105P_config.h"
+
+/******************************************************************************
+* DEFINES
+*****************************************************************************/
+
+#define N_CACHEABLE_RANGES 8U
+#define N_CACHED_REGISTERS 55U  /**< Sum of the words of all cacheable ranges */
+
+#define R_CTRL_ADDR      (0x100440U)  /**< Address of the resetCtrl register, a reset restores the register defaults */
+#define CONFIG_BASE_ADDR (0x20000U)   /**< Start of the static configuration area, a config load restores the register defaults */
+#define CONFIG_END_ADDR  (0x30000U)
+
+/******************************************************************************
+* TYPE DEFINITIONS
+*****************************************************************************/
+
+typedef struct
+{
+	uint32_t startAddress;
+	uint8_t  nWords;
+} cacheableRange_t;
 
 /******************************************************************************
 * EXPORTED VARIABLES
@@ -49,15 +71,443 @@
 SJA1105P_spiRead32_cb_t SJA1105P_gpf_spiRead32 = NULL;
 SJA1105P_spiWrite32_cb_t SJA1105P_gpf_spiWrite32 = NULL;
 
+/******************************************************************************
+* INTERNAL VARIABLES
+*****************************************************************************/
+
+static SJA1105P_spiQueueStart_cb_t  gpf_spiQueueStart  = NULL;
+static SJA1105P_spiQueueRead32_cb_t gpf_spiQueueRead32 = NULL;
+static SJA1105P_spiQueueCommit_cb_t gpf_spiQueueCommit = NULL;
+static SJA1105P_forEachSwitch_cb_t  gpf_forEachSwitch  = NULL;
+static SJA1105P_waitUs_cb_t         gpf_waitUs         = NULL;
+static SJA1105P_getTimeNs_cb_t      gpf_getTimeNs      = NULL;
+
+#if SJA1105P_REGISTER_CACHE == 1U
+/* registers which are only modified by the driver, the hardware never changes their content */
+static const cacheableRange_t gk_cacheableRanges[N_CACHEABLE_RANGES] =
+{
+	{0x100008U,  1U},  /* pll_control PLL0 */
+	{0x10000aU,  1U},  /* pll_control PLL1 */
+	{0x10000bU,  5U},  /* idiv_c_control_register, one per port */
+	{0x100013U, 30U},  /* miix_clock_control_register, 6 per port */
+	{0x100800U, 10U},  /* cfg_pad_miix, TX and RX per port */
+	{0x100810U,  5U},  /* cfg_pad_miix_id, one per port */
+	{0x100840U,  1U},  /* cfg_pad_misc */
+	{0x100880U,  2U}   /* cfg_pad_spi, cfg_pad_jtag */
+};
+
+static SJA1105P_spiRead32_cb_t  gpf_platformSpiRead32  = NULL;
+static SJA1105P_spiWrite32_cb_t gpf_platformSpiWrite32 = NULL;
+
+static uint32_t g_registerCache[SJA1105P_N_SWITCHES][N_CACHED_REGISTERS];
+static uint8_t  g_registerCacheValid[SJA1105P_N_SWITCHES][N_CACHED_REGISTERS];
+#endif
+
+/******************************************************************************
+* INTERNAL FUNCTION DECLARATIONS
+*****************************************************************************/
+
+#if SJA1105P_REGISTER_CACHE == 1U
+static uint8_t getCacheIndex(uint32_t registerAddress, uint8_t *p_cacheIndex);
+static uint8_t isRangeCached(uint32_t registerAddress, uint8_t wordCount);
+static void updateCache(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, const uint32_t *kp_registerValue, uint8_t valid);
+static uint8_t cachedSpiRead32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+static uint8_t cachedSpiWrite32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+#endif
+
 /******************************************************************************
 * FUNCTIONS
 *****************************************************************************/
 
 extern void SJA1105P_registerSpiRead32CB(SJA1105P_spiRead32_cb_t pf_spiRead32)
 {
+#if SJA1105P_REGISTER_CACHE == 1U
+	uint8_t switchId;
+
+	for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+	{  /* content is unknown to a newly registered platform */
+		SJA1105P_invalidateRegisterCache(switchId);
+	}
+	gpf_platformSpiRead32  = pf_spiRead32;
+	SJA1105P_gpf_spiRead32 = (pf_spiRead32 == NULL) ? NULL : cachedSpiRead32;
+#else
 	SJA1105P_gpf_spiRead32 = pf_spiRead32;
+#endif
 }
 extern void SJA1105P_registerSpiWrite32CB(SJA1105P_spiWrite32_cb_t pf_spiWrite32)
 {
+#if SJA1105P_REGISTER_CACHE == 1U
+	gpf_platformSpiWrite32  = pf_spiWrite32;
+	SJA1105P_gpf_spiWrite32 = (pf_spiWrite32 == NULL) ? NULL : cachedSpiWrite32;
+#else
 	SJA1105P_gpf_spiWrite32 = pf_spiWrite32;
+#endif
+}
+
+/**
+* \brief Drop all shadowed register values of a switch
+*
+* Must be called whenever the switch registers are modified outside of the
+* registered SPI callbacks, e.g. when the static configuration is uploaded directly.
+* Resets and configuration loads issued through the callbacks are detected automatically.
+*
+* \param[in]  deviceSelect Switch of which the shadow is dropped
+*/
+extern void SJA1105P_invalidateRegisterCache(uint8_t deviceSelect)
+{
+#if SJA1105P_REGISTER_CACHE == 1U
+	uint8_t cacheIndex;
+
+	if (deviceSelect < SJA1105P_N_SWITCHES)
+	{
+		for (cacheIndex = 0; cacheIndex < N_CACHED_REGISTERS; cacheIndex++)
+		{
+			g_registerCacheValid[deviceSelect][cacheIndex] = 0;
+		}
+	}
+#else
+	(void) deviceSelect;
+#endif
+}
+extern void SJA1105P_registerSpiQueueStartCB(SJA1105P_spiQueueStart_cb_t pf_spiQueueStart)
+{
+	gpf_spiQueueStart = pf_spiQueueStart;
+}
+extern void SJA1105P_registerSpiQueueRead32CB(SJA1105P_spiQueueRead32_cb_t pf_spiQueueRead32)
+{
+	gpf_spiQueueRead32 = pf_spiQueueRead32;
+}
+extern void SJA1105P_registerSpiQueueCommitCB(SJA1105P_spiQueueCommit_cb_t pf_spiQueueCommit)
+{
+	gpf_spiQueueCommit = pf_spiQueueCommit;
+}
+extern void SJA1105P_registerForEachSwitchCB(SJA1105P_forEachSwitch_cb_t pf_forEachSwitch)
+{
+	gpf_forEachSwitch = pf_forEachSwitch;
+}
+extern void SJA1105P_registerWaitUsCB(SJA1105P_waitUs_cb_t pf_waitUs)
+{
+	gpf_waitUs = pf_waitUs;
+}
+extern void SJA1105P_registerGetTimeNsCB(SJA1105P_getTimeNs_cb_t pf_getTimeNs)
+{
+	gpf_getTimeNs = pf_getTimeNs;
+}
+
+/**
+* \brief Open a batch of queued SPI operations towards a switch
+*
+* Until ::SJA1105P_spiQueueCommit is called, write operations issued through
+* ::SJA1105P_gpf_spiWrite32 for this switch are queued by the platform instead
+* of being transferred one by one. A read issued through ::SJA1105P_gpf_spiRead32
+* transfers the queued operations together with the read and returns the result
+* immediately, the batch remains open.
+* If the platform does not provide a queue, all operations are performed immediately.
+*
+* \param[in]  deviceSelect Switch on which the batch is opened
+*
+* \return uint8_t: 0: successful, else: failed
+*/
+extern uint8_t SJA1105P_spiQueueStart(uint8_t deviceSelect)
+{
+	uint8_t ret = 0;
+
+	if (gpf_spiQueueStart != NULL)
+	{
+		ret = gpf_spiQueueStart(deviceSelect);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Queue a read operation within the open batch
+*
+* The location pointed to by p_registerValue is only valid once the batch was committed.
+* If the platform does not provide a queue, the read is performed immediately.
+*
+* \param[in]  deviceSelect Switch from which is read
+* \param[in]  wordCount Number of consecutive words to be read
+* \param[in]  registerAddress Address of the first word
+* \param[out] p_registerValue Memory location where the words will be stored
+*
+* \return uint8_t: 0: successful, else: failed
+*/
+extern uint8_t SJA1105P_spiQueueRead32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint8_t ret;
+
+	if (gpf_spiQueueRead32 != NULL)
+	{
+		ret = gpf_spiQueueRead32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	}
+	else
+	{
+		ret = SJA1105P_gpf_spiRead32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	}
+
+	return ret;
+}
+
+/**
+* \brief Transfer all queued operations and close the batch
+*
+* \param[in]  deviceSelect Switch on which the batch is committed
+* \param[in]  pf_complete Function notified when the transfer completed. If NULL, the call blocks until the transfer completed.
+* \param[in]  p_context Argument passed to pf_complete
+*
+* \return uint8_t: 0: successful, else: failed
+*/
+extern uint8_t SJA1105P_spiQueueCommit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context)
+{
+	uint8_t ret = 0;
+
+	if (gpf_spiQueueCommit != NULL)
+	{
+		ret = gpf_spiQueueCommit(deviceSelect, pf_complete, p_context);
+	}
+	else if (pf_complete != NULL)
+	{  /* all operations were already performed */
+		pf_complete(deviceSelect, 0U, p_context);
+	}
+	else
+	{
+		/* nothing to be done */
+	}
+
+	return ret;
+}
+
+/**
+* \brief Execute a job for all switches
+*
+* The job is called once for each switch. It must only access the switch
+* it is called for, since the platform may execute the jobs concurrently,
+* each from a different thread. If no platform function is registered,
+* the jobs are executed one after the other in ascending switch order.
+* The call returns once all jobs have finished.
+*
+* \param[in]  pf_job Job to be executed
+* \param[in]  p_context Argument passed to each job
+*
+* \return uint8_t: 0: all jobs successful, else: failed
+*/
+extern uint8_t SJA1105P_forEachSwitch(SJA1105P_switchJob_cb_t pf_job, void *p_context)
+{
+	uint8_t ret = 0;
+	uint8_t switchId;
+
+	if (gpf_forEachSwitch != NULL)
+	{
+		ret = gpf_forEachSwitch(pf_job, p_context);
+	}
+	else
+	{
+		for (switchId = 0; switchId < SJA1105P_N_SWITCHES; switchId++)
+		{
+			ret += pf_job(switchId, p_context);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Wait before polling a register again
+*
+* If the platform does not provide a wait function, the call returns immediately
+* and the caller keeps polling.
+*
+* \param[in]  waitUs Minimum time to wait in microseconds
+*/
+extern void SJA1105P_waitUs(uint32_t waitUs)
+{
+	if (gpf_waitUs != NULL)
+	{
+		gpf_waitUs(waitUs);
+	}
+}
+
+/**
+* \brief Read the monotonic time of the platform
+*
+* \return uint64_t: time in nanoseconds, 0 if the platform does not provide a time
+*/
+extern uint64_t SJA1105P_getTimeNs(void)
+{
+	uint64_t timeNs = 0;
+
+	if (gpf_getTimeNs != NULL)
+	{
+		timeNs = gpf_getTimeNs();
+	}
+
+	return timeNs;
+}
+
+#if SJA1105P_REGISTER_CACHE == 1U
+/**
+* \brief Find the shadow location of a register
+*
+* \param[in]  registerAddress Address of the register
+* \param[out] p_cacheIndex Index of the register within the shadow
+*
+* \return uint8_t: 1: register is cacheable, 0: register is not cached
+*/
+static uint8_t getCacheIndex(uint32_t registerAddress, uint8_t *p_cacheIndex)
+{
+	uint8_t range;
+	uint8_t cacheIndex = 0;
+	uint8_t cacheable  = 0;
+
+	for (range = 0; range < N_CACHEABLE_RANGES; range++)
+	{
+		if ((registerAddress >= gk_cacheableRanges[range].startAddress) &&
+		    (registerAddress < (gk_cacheableRanges[range].startAddress + gk_cacheableRanges[range].nWords)))
+		{
+			*p_cacheIndex = cacheIndex + (uint8_t) (registerAddress - gk_cacheableRanges[range].startAddress);
+			cacheable = 1;
+			break;
+		}
+		cacheIndex += gk_cacheableRanges[range].nWords;
+	}
+
+	return cacheable;
+}
+
+/**
+* \brief Check if an access covers at least one shadowed register
+*
+* \param[in]  registerAddress Address of the first word
+* \param[in]  wordCount Number of consecutive words
+*
+* \return uint8_t: 1: a shadowed register is covered, 0: no shadowed register is covered
+*/
+static uint8_t isRangeCached(uint32_t registerAddress, uint8_t wordCount)
+{
+	uint8_t range;
+	uint8_t cached = 0;
+
+	for (range = 0; range < N_CACHEABLE_RANGES; range++)
+	{
+		if ((registerAddress < (gk_cacheableRanges[range].startAddress + gk_cacheableRanges[range].nWords)) &&
+		    ((registerAddress + wordCount) > gk_cacheableRanges[range].startAddress))
+		{
+			cached = 1;
+			break;
+		}
+	}
+
+	return cached;
+}
+
+/**
+* \brief Update the shadow of the registers covered by an access
+*
+* Must be called with the transport lock of the switch held.
+*
+* \param[in]  deviceSelect Switch of which the shadow is updated
+* \param[in]  wordCount Number of consecutive words
+* \param[in]  registerAddress Address of the first word
+* \param[in]  kp_registerValue Register content
+* \param[in]  valid 1: content is known to be in the switch, 0: content is unknown and the shadow is dropped
+*/
+static void updateCache(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, const uint32_t *kp_registerValue, uint8_t valid)
+{
+	uint8_t word;
+	uint8_t cacheIndex;
+
+	for (word = 0; word < wordCount; word++)
+	{
+		if (getCacheIndex(registerAddress + word, &cacheIndex) == 1U)
+		{
+			g_registerCache[deviceSelect][cacheIndex]      = kp_registerValue[word];
+			g_registerCacheValid[deviceSelect][cacheIndex] = valid;
+		}
+	}
+}
+
+/**
+* \brief Read through the register shadow
+*
+* Single word reads of valid shadowed registers are served without SPI access.
+* All other reads are forwarded to the platform. Reads of shadowed registers refresh
+* the shadow within a batch, so that the transport lock of the switch is held.
+*/
+static uint8_t cachedSpiRead32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint8_t ret;
+	uint8_t cacheIndex;
+
+	if ((wordCount == 1U) && (getCacheIndex(registerAddress, &cacheIndex) == 1U) && (g_registerCacheValid[deviceSelect][cacheIndex] == 1U))
+	{  /* cache hit */
+		*p_registerValue = g_registerCache[deviceSelect][cacheIndex];
+		ret = 0;
+	}
+	else if (isRangeCached(registerAddress, wordCount) == 0U)
+	{
+		ret = gpf_platformSpiRead32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	}
+	else
+	{
+		ret = SJA1105P_spiQueueStart(deviceSelect);
+		if (ret == 0U)
+		{
+			ret = gpf_platformSpiRead32(deviceSelect, wordCount, registerAddress, p_registerValue);
+			if (ret == 0U)
+			{
+				updateCache(deviceSelect, wordCount, registerAddress, p_registerValue, 1U);
+			}
+			ret += SJA1105P_spiQueueCommit(deviceSelect, NULL, NULL);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Write through the register shadow
+*
+* All writes are forwarded to the platform. Writes of shadowed registers are transferred
+* right away, also within an open batch, and update the shadow only once the transfer
+* succeeded. On failure, the register content is unknown and the affected words are dropped.
+* Resets and configuration loads drop the whole shadow of the switch.
+*/
+static uint8_t cachedSpiWrite32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint8_t ret;
+	uint8_t isReset;
+
+	isReset = ((registerAddress == R_CTRL_ADDR) || ((registerAddress >= CONFIG_BASE_ADDR) && (registerAddress < CONFIG_END_ADDR))) ? 1U : 0U;
+
+	if ((isReset == 0U) && (isRangeCached(registerAddress, wordCount) == 0U))
+	{  /* the write may remain queued in an open batch */
+		ret = gpf_platformSpiWrite32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	}
+	else
+	{  /* the outer batch holds the transport lock of the switch, the commit of the inner batch transfers the write */
+		ret = SJA1105P_spiQueueStart(deviceSelect);
+		if (ret == 0U)
+		{
+			ret = SJA1105P_spiQueueStart(deviceSelect);
+			if (ret == 0U)
+			{
+				ret  = gpf_platformSpiWrite32(deviceSelect, wordCount, registerAddress, p_registerValue);
+				ret += SJA1105P_spiQueueCommit(deviceSelect, NULL, NULL);
+			}
+
+			if (isReset == 1U)
+			{  /* all registers return to their defaults */
+				SJA1105P_invalidateRegisterCache(deviceSelect);
+			}
+			else
+			{
+				updateCache(deviceSelect, wordCount, registerAddress, p_registerValue, (ret == 0U) ? 1U : 0U);
+			}
+			ret += SJA1105P_spiQueueCommit(deviceSelect, NULL, NULL);
+		}
+	}
+
+	return ret;
 }
+#endif
@@ -42,6 +42,7 @@
 
 #include "NXP_SJA1105P_switchCore.h"
 #include "NXP_SJA1105P_spi.h"
+#include "NXP_SJA1105P_config.h"
 
 /******************************************************************************
 * DEFINES
@@ -184,6 +185,7 @@
 /* register category mac_level_diagn_counters */
 #define MAC_LDC_PORT_INC (0x2)
 #define MAC_LDC_ADDR     (0x200)  /**< Address of the macLevelDiagnCounters register */
+#define MAC_LDC_WORD_COUNT (1)    /**< Number of data words read by ::SJA1105P_queueGetMacLevelDiagnCounters */
 
 /* register category mac_level_diagn_flags */
 #define MAC_LDF_PORT_INC (0x2)
@@ -204,6 +206,7 @@
 #define HL_DC_1_6_ADDR       (0x40c)  /**< Address of the hlDiagnCounters16 register */
 #define HL_DC_1_7_ADDR       (0x40e)  /**< Address of the hlDiagnCounters17 register */
 #define HL_DC_1_8_ADDR       (0x40f)  /**< Address of the hlDiagnCounters18 register */
+#define HL_DC_1_WORD_COUNT   (16)     /**< Number of data words of the hl_diagn_counters_1 block of a port */
 
 /* register category hl_diagn_counters_2 */
 #define HL_DC_2_PORT_INC (0x10)
@@ -211,6 +214,7 @@
 #define HL_DC_2_1_ADDR   (0x601)  /**< Address of the hlDiagnCounters21 register */
 #define HL_DC_2_2_ADDR   (0x602)  /**< Address of the hlDiagnCounters22 register */
 #define HL_DC_2_3_ADDR   (0x603)  /**< Address of the hlDiagnCounters23 register */
+#define HL_DC_2_WORD_COUNT (12)   /**< Number of data words of the hl_diagn_counters_2 block of a port, including the hl_diagn_counters_occupancy of the 8 queues */
 
 /* register category hl_diagn_counters_occupancy */
 #define HL_DCO_PORT_INC (0x10)
@@ -244,6 +248,7 @@
 #define ETH_STAT_C_20_ADDR  (0x1414)  /**< Address of the ethStatCounters20 register */
 #define ETH_STAT_C_21_ADDR  (0x1415)  /**< Address of the ethStatCounters21 register */
 #define ETH_STAT_C_22_ADDR  (0x1416)  /**< Address of the ethStatCounters22 register */
+#define ETH_STAT_C_WORD_COUNT (23)    /**< Number of data words of the eth_stat_counters block of a port */
 
 /* register category l2_forwarding_parameters */
 #define L2_FP_WORD_COUNT (3)       /**< Number of data words contained in the l2ForwardingParameters register */
@@ -756,10 +761,6 @@
 #define MAC_LDF_SPCERRS_MASK     (0x00000002U)  /**< Bit mask for the SPCERRS field */
 
 /* register category hl_diagn_counters_1 */
-#define HL_DC_1_0_N_TXBYTE_SHIFT_OVLP (32)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_TXBYTE field */
-#define HL_DC_1_1_N_TXFRM_SHIFT_OVLP  (32)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_TXFRM field */
-#define HL_DC_1_2_N_RXBYTE_SHIFT_OVLP (32)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_RXBYTE field */
-#define HL_DC_1_3_N_RXFRM_SHIFT_OVLP  (32)  /**< Shift value for the to compensate for the alignment of the 2. part of the overlapping N_RXFRM field */
 
 /* register category hl_diagn_counters_occupancy */
 #define HL_DCO_Q_OCCUPANCY_HIGH_WATT_SHIFT (16)  /**< Shift value for the Q_OCCUPANCY_HIGH_WATT field */
@@ -804,6 +805,47 @@
 #define AVB_PC_RDWRSET_SHIFT (29)           /**< Shift value for the RDWRSET field */
 #define AVB_PC_RDWRSET_MASK  (0x20000000U)  /**< Bit mask for the RDWRSET field */
 
+/* completion of dynamic reconfiguration commands */
+#define RECONFIGURATION_VALID_MASK    (0x80000000U)  /**< The VALID flag of all control registers is cleared by the switch once the command completed */
+#define RECONFIGURATION_N_SPIN_POLLS  (4U)    /**< Number of polls issued back to back, most commands complete within the first one */
+#define RECONFIGURATION_MIN_WAIT_US   (2U)    /**< First wait between two polls after spinning */
+#define RECONFIGURATION_MAX_WAIT_US   (256U)  /**< The wait between two polls doubles up to this value */
+#define RECONFIGURATION_MAX_POLLS     (1000U) /**< Bound of the number of polls, also applies if the platform provides no time */
+
+/******************************************************************************
+* INTERNAL VARIABLES
+*****************************************************************************/
+
+/* indexed by ::SJA1105P_reconfiguration_t */
+static const uint32_t gk_reconfigurationAddr[SJA1105P_N_RECONFIGURATIONS] =
+{
+	(uint32_t) L2_ALTC_ADDR,
+	(uint32_t) L2_FTC_ADDR,
+	(uint32_t) VLAN_LTC_ADDR,
+	(uint32_t) CBSC_ADDR,
+	(uint32_t) RTC_ADDR,
+	(uint32_t) GPC_ADDR,
+	(uint32_t) MAC_CFG_TC_ADDR,
+	(uint32_t) L2_LPC_ADDR,
+	(uint32_t) AVB_PC_ADDR
+};
+
+/* indexed by ::SJA1105P_reconfiguration_t, 0 if the control register has no ERRORS flag */
+static const uint32_t gk_reconfigurationErrorsMask[SJA1105P_N_RECONFIGURATIONS] =
+{
+	L2_ALTC_ERRORS_MASK,
+	L2_FTC_ERRORS_MASK,
+	0U,
+	CBSC_ERRORS_MASK,
+	RTC_ERRORS_MASK,
+	GPC_ERRORS_MASK,
+	MAC_CFG_TC_ERRORS_MASK,
+	0U,
+	AVB_PC_ERRORS_MASK
+};
+
+static SJA1105P_reconfigurationStats_t g_reconfigurationStats[SJA1105P_N_SWITCHES][SJA1105P_N_RECONFIGURATIONS];
+
 /******************************************************************************
 * FUNCTIONS
 *****************************************************************************/
@@ -1744,87 +1786,112 @@ uint8_t SJA1105P_setL2ArtLockedEntry(const SJA1105P_l2ArtLockedEntryArgument_t *
 uint8_t SJA1105P_getL2ArtLockedEntry(SJA1105P_l2ArtLockedEntryArgument_t *p_l2ArtLockedEntry, uint8_t deviceSelect)
 {
 	uint8_t ret;
-	uint32_t cResult;
 
 	uint32_t registerValue[L2_ART_LE_WORD_COUNT] = {0};
+
+	ret = SJA1105P_gpf_spiRead32(deviceSelect, L2_ART_LE_WORD_COUNT, (uint32_t) L2_ART_LE_ADDR, registerValue);  /* read data via SPI from register at address -0x1*/
+	SJA1105P_decodeL2ArtLockedEntry(registerValue, p_l2ArtLockedEntry);
+
+	return ret;
+}
+
+/**
+* \brief This function is used to queue a read of the l2_art_locked_entry within the open SPI batch
+*
+* \param[out] p_registerValue Location of SJA1105P_L2_ART_LOCKED_ENTRY_WORDS raw words, valid once the batch was committed.
+* They are converted by ::SJA1105P_decodeL2ArtLockedEntry
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetL2ArtLockedEntry(uint32_t *p_registerValue, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, L2_ART_LE_WORD_COUNT, (uint32_t) L2_ART_LE_ADDR, p_registerValue);
+}
+
+/**
+* \brief This function is used to split raw words of the l2_art_locked_entry into its fields
+*
+* \param[in]  kp_registerValue SJA1105P_L2_ART_LOCKED_ENTRY_WORDS raw words of the register
+* \param[out] p_l2ArtLockedEntry Location of the struct containing all readable fields of the register
+*/
+void SJA1105P_decodeL2ArtLockedEntry(const uint32_t *kp_registerValue, SJA1105P_l2ArtLockedEntryArgument_t *p_l2ArtLockedEntry)
+{
+	uint32_t cResult;
+
 	uint64_t macaddrTmp;
 	uint64_t maskTmp;
 
 	/* split received register values into bit groups */
-	ret = SJA1105P_gpf_spiRead32(deviceSelect, L2_ART_LE_WORD_COUNT, (uint32_t) L2_ART_LE_ADDR, registerValue);  /* read data via SPI from register at address -0x1*/
-	cResult   = (uint32_t) registerValue[WORD0];
+	cResult   = (uint32_t) kp_registerValue[WORD0];
 	cResult  &= (uint32_t) (L2_ART_LE_INDEX_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_INDEX_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->index = (uint16_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD0];
+	cResult   = (uint32_t) kp_registerValue[WORD0];
 	cResult  &= (uint32_t) (L2_ART_LE_ENFPORT_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_ENFPORT_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->enfport = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD0];
+	cResult   = (uint32_t) kp_registerValue[WORD0];
 	cResult  &= (uint32_t) (L2_ART_LE_DESTPORTS_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_DESTPORTS_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->destports = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD0];
+	cResult   = (uint32_t) kp_registerValue[WORD0];
 	cResult >>= (uint32_t) (L2_ART_LE_MACADDR_SHIFT_0);  /* shift to right aligned position */
 	macaddrTmp  = (uint64_t) ((uint16_t) cResult);
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	macaddrTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) L2_ART_LE_MACADDR_SHIFT_OVLP_1);
 
-	cResult   = (uint32_t) registerValue[WORD2];
+	cResult   = (uint32_t) kp_registerValue[WORD2];
 	cResult  &= (uint32_t) (L2_ART_LE_MACADDR_MASK_2);   /* mask desired bits */
 	macaddrTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) L2_ART_LE_MACADDR_SHIFT_OVLP_2);
 	p_l2ArtLockedEntry->macaddr = (uint64_t) macaddrTmp;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD2];
+	cResult   = (uint32_t) kp_registerValue[WORD2];
 	cResult  &= (uint32_t) (L2_ART_LE_VLANID_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_VLANID_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->vlanid = (uint16_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD2];
+	cResult   = (uint32_t) kp_registerValue[WORD2];
 	cResult  &= (uint32_t) (L2_ART_LE_INNER_OUTER_VLAN_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_INNER_OUTER_VLAN_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->innerOuterVlan = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD2];
+	cResult   = (uint32_t) kp_registerValue[WORD2];
 	cResult >>= (uint32_t) (L2_ART_LE_MASK_SHIFT_0);  /* shift to right aligned position */
 	maskTmp  = (uint64_t) ((uint16_t) cResult);
 
-	cResult   = (uint32_t) registerValue[WORD3];
+	cResult   = (uint32_t) kp_registerValue[WORD3];
 	maskTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) L2_ART_LE_MASK_SHIFT_OVLP_1);
 
-	cResult   = (uint32_t) registerValue[WORD4];
+	cResult   = (uint32_t) kp_registerValue[WORD4];
 	maskTmp |= (uint64_t) ((uint64_t) ((uint16_t) cResult) << (uint8_t) L2_ART_LE_MASK_SHIFT_OVLP_2);
 	p_l2ArtLockedEntry->mask = (uint64_t) maskTmp;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD4];
+	cResult   = (uint32_t) kp_registerValue[WORD4];
 	cResult  &= (uint32_t) (L2_ART_LE_RETAG_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_RETAG_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->retag = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD4];
+	cResult   = (uint32_t) kp_registerValue[WORD4];
 	cResult  &= (uint32_t) (L2_ART_LE_MIRROR_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_MIRROR_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->mirror = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD4];
+	cResult   = (uint32_t) kp_registerValue[WORD4];
 	cResult  &= (uint32_t) (L2_ART_LE_TAKE_TS_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_TAKE_TS_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->takeTs = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD4];
+	cResult   = (uint32_t) kp_registerValue[WORD4];
 	cResult  &= (uint32_t) (L2_ART_LE_MIRRORED_VLAN_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ART_LE_MIRRORED_VLAN_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->mirroredVlan = (uint16_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD4];
+	cResult   = (uint32_t) kp_registerValue[WORD4];
 	cResult >>= (uint32_t) (L2_ART_LE_TS_REG_SHIFT);  /* shift to right aligned position */
 	p_l2ArtLockedEntry->tsReg = (uint8_t) cResult;  /* deliver result */
-
-	return ret;
 }
 
 /**
@@ -1890,12 +1957,38 @@ uint8_t SJA1105P_setL2AddressLookupTableControl(const SJA1105P_l2AddressLookupTa
 uint8_t SJA1105P_getL2AddressLookupTableControl(SJA1105P_l2AddressLookupTableControlGetArgument_t *p_l2AddressLookupTableControl, uint8_t deviceSelect)
 {
 	uint8_t ret;
-	uint32_t cResult;
 
 	uint32_t registerValue = 0;
 
-	/* split received register values into bit groups */
 	ret = SJA1105P_gpf_spiRead32(deviceSelect, 1U, (uint32_t) L2_ALTC_ADDR, &registerValue);  /* read data via SPI from register at address -0x1*/
+	SJA1105P_decodeL2AddressLookupTableControl(registerValue, p_l2AddressLookupTableControl);
+
+	return ret;
+}
+
+/**
+* \brief This function is used to queue a read of the l2_address_lookup_table_control within the open SPI batch
+*
+* \param[out] p_registerValue Location of the raw register word, valid once the batch was committed.
+* It is converted by ::SJA1105P_decodeL2AddressLookupTableControl
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetL2AddressLookupTableControl(uint32_t *p_registerValue, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, 1U, (uint32_t) L2_ALTC_ADDR, p_registerValue);
+}
+
+/**
+* \brief This function is used to split the raw word of the l2_address_lookup_table_control into its fields
+*
+* \param[in]  registerValue Raw word of the register
+* \param[out] p_l2AddressLookupTableControl Location of the struct containing all readable fields of the register
+*/
+void SJA1105P_decodeL2AddressLookupTableControl(uint32_t registerValue, SJA1105P_l2AddressLookupTableControlGetArgument_t *p_l2AddressLookupTableControl)
+{
+	uint32_t cResult;
+
+	/* split received register values into bit groups */
 	cResult   = (uint32_t) registerValue;
 	cResult >>= (uint32_t) (L2_ALTC_VALID_SHIFT);  /* shift to right aligned position */
 	p_l2AddressLookupTableControl->valid = (uint8_t) cResult;  /* deliver result */
@@ -1924,8 +2017,6 @@ uint8_t SJA1105P_getL2AddressLookupTableControl(SJA1105P_l2AddressLookupTableCon
 	cResult  &= (uint32_t) (L2_ALTC_HOST_CMD_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (L2_ALTC_HOST_CMD_SHIFT);  /* shift to right aligned position */
 	p_l2AddressLookupTableControl->hostCmd = SJA1105P_convertToHostCmd(cResult);  /* deliver result */
-
-	return ret;
 }
 
 /**
@@ -2215,47 +2306,72 @@ uint8_t SJA1105P_setVlanLookupTableEntry(const SJA1105P_vlanLookupTableEntryArgu
 uint8_t SJA1105P_getVlanLookupTableEntry(SJA1105P_vlanLookupTableEntryArgument_t *p_vlanLookupTableEntry, uint8_t deviceSelect)
 {
 	uint8_t ret;
-	uint32_t cResult;
 
 	uint32_t registerValue[VLAN_LTE_WORD_COUNT] = {0};
+
+	ret = SJA1105P_gpf_spiRead32(deviceSelect, VLAN_LTE_WORD_COUNT, (uint32_t) VLAN_LTE_ADDR, registerValue);  /* read data via SPI from register at address -0x1*/
+	SJA1105P_decodeVlanLookupTableEntry(registerValue, p_vlanLookupTableEntry);
+
+	return ret;
+}
+
+/**
+* \brief This function is used to queue a read of the vlan_lookup_table_entry within the open SPI batch
+*
+* \param[out] p_registerValue Location of SJA1105P_VLAN_LOOKUP_TABLE_ENTRY_WORDS raw words, valid once the batch was committed.
+* They are converted by ::SJA1105P_decodeVlanLookupTableEntry
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetVlanLookupTableEntry(uint32_t *p_registerValue, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, VLAN_LTE_WORD_COUNT, (uint32_t) VLAN_LTE_ADDR, p_registerValue);
+}
+
+/**
+* \brief This function is used to split raw words of the vlan_lookup_table_entry into its fields
+*
+* \param[in]  kp_registerValue SJA1105P_VLAN_LOOKUP_TABLE_ENTRY_WORDS raw words of the register
+* \param[out] p_vlanLookupTableEntry Location of the struct containing all readable fields of the register
+*/
+void SJA1105P_decodeVlanLookupTableEntry(const uint32_t *kp_registerValue, SJA1105P_vlanLookupTableEntryArgument_t *p_vlanLookupTableEntry)
+{
+	uint32_t cResult;
+
 	uint16_t vlanidTmp;
 
 	/* split received register values into bit groups */
-	ret = SJA1105P_gpf_spiRead32(deviceSelect, VLAN_LTE_WORD_COUNT, (uint32_t) VLAN_LTE_ADDR, registerValue);  /* read data via SPI from register at address -0x1*/
-	cResult   = (uint32_t) registerValue[WORD0];
+	cResult   = (uint32_t) kp_registerValue[WORD0];
 	cResult >>= (uint32_t) (VLAN_LTE_VLANID_SHIFT_0);  /* shift to right aligned position */
 	vlanidTmp  = (uint16_t) ((uint8_t) cResult);
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	cResult  &= (uint32_t) (VLAN_LTE_VLANID_MASK_1);   /* mask desired bits */
 	vlanidTmp |= (uint16_t) ((uint16_t) cResult << (uint8_t) VLAN_LTE_VLANID_SHIFT_OVLP);
 	p_vlanLookupTableEntry->vlanid = (uint16_t) vlanidTmp;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	cResult  &= (uint32_t) (VLAN_LTE_TAG_PORT_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (VLAN_LTE_TAG_PORT_SHIFT);  /* shift to right aligned position */
 	p_vlanLookupTableEntry->tagPort = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	cResult  &= (uint32_t) (VLAN_LTE_VLAN_BC_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (VLAN_LTE_VLAN_BC_SHIFT);  /* shift to right aligned position */
 	p_vlanLookupTableEntry->vlanBc = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	cResult  &= (uint32_t) (VLAN_LTE_VMEMB_PORT_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (VLAN_LTE_VMEMB_PORT_SHIFT);  /* shift to right aligned position */
 	p_vlanLookupTableEntry->vmembPort = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	cResult  &= (uint32_t) (VLAN_LTE_VEGR_MIRR_MASK);   /* mask desired bits */
 	cResult >>= (uint32_t) (VLAN_LTE_VEGR_MIRR_SHIFT);  /* shift to right aligned position */
 	p_vlanLookupTableEntry->vegrMirr = (uint8_t) cResult;  /* deliver result */
 
-	cResult   = (uint32_t) registerValue[WORD1];
+	cResult   = (uint32_t) kp_registerValue[WORD1];
 	cResult >>= (uint32_t) (VLAN_LTE_VING_MIRR_SHIFT);  /* shift to right aligned position */
 	p_vlanLookupTableEntry->vingMirr = (uint8_t) cResult;  /* deliver result */
-
-	return ret;
 }
 
 /**
@@ -2322,6 +2438,44 @@ uint8_t SJA1105P_getVlanLookupTableControl(uint8_t *p_valident, uint8_t deviceSe
 	return ret;
 }
 
+/**
+* \brief This function is used to queue a read of the vlan_lookup_table_control within the open SPI batch
+*
+* \param[out] p_registerValue Location of the raw register word, valid once the batch was committed.
+* It is converted by ::SJA1105P_decodeVlanLookupTableControl
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetVlanLookupTableControl(uint32_t *p_registerValue, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, 1U, (uint32_t) VLAN_LTC_ADDR, p_registerValue);
+}
+
+/**
+* \brief This function is used to split the raw word of the vlan_lookup_table_control into its fields
+*
+* \param[in]  registerValue Raw word of the register
+* \param[out] p_vlanLookupTableControl Location of the struct containing the fields of the register
+*/
+void SJA1105P_decodeVlanLookupTableControl(uint32_t registerValue, SJA1105P_vlanLookupTableControlArgument_t *p_vlanLookupTableControl)
+{
+	uint32_t cResult;
+
+	/* split received register values into bit groups */
+	cResult   = (uint32_t) registerValue;
+	cResult >>= (uint32_t) (VLAN_LTC_VALID_SHIFT);  /* shift to right aligned position */
+	p_vlanLookupTableControl->valid = (uint8_t) cResult;  /* deliver result */
+
+	cResult   = (uint32_t) registerValue;
+	cResult  &= (uint32_t) (VLAN_LTC_RDWRSET_MASK);   /* mask desired bits */
+	cResult >>= (uint32_t) (VLAN_LTC_RDWRSET_SHIFT);  /* shift to right aligned position */
+	p_vlanLookupTableControl->rdwrset = (uint8_t) cResult;  /* deliver result */
+
+	cResult   = (uint32_t) registerValue;
+	cResult  &= (uint32_t) (VLAN_LTC_VALIDENT_MASK);   /* mask desired bits */
+	cResult >>= (uint32_t) (VLAN_LTC_VALIDENT_SHIFT);  /* shift to right aligned position */
+	p_vlanLookupTableControl->valident = (uint8_t) cResult;  /* deliver result */
+}
+
 /**
 * \brief This function is used to SET data of the credit_based_shaping_entry
 *
@@ -4046,12 +4200,39 @@ uint8_t SJA1105P_getL2MemoryPartitionStatus(SJA1105P_l2MemoryPartitionStatusArgu
 uint8_t SJA1105P_getMacLevelDiagnCounters(SJA1105P_macLevelDiagnCountersArgument_t *p_macLevelDiagnCounters, uint8_t port, uint8_t deviceSelect)
 {
 	uint8_t ret;
-	uint32_t cResult;
 
 	uint32_t registerValue = 0;
 
-	/* split received register values into bit groups */
 	ret = SJA1105P_gpf_spiRead32(deviceSelect, 1U, (uint32_t) ((uint32_t) MAC_LDC_ADDR + ((uint32_t) MAC_LDC_PORT_INC * port)), &registerValue);  /* read data via SPI from register at address -0x1*/
+	SJA1105P_decodeMacLevelDiagnCounters(registerValue, p_macLevelDiagnCounters);
+
+	return ret;
+}
+
+/**
+* \brief This function is used to queue a read of the mac_level_diagn_counters within the open SPI batch
+*
+* \param[out] p_registerValue Location of the raw register word, valid once the batch was committed.
+* It is converted by ::SJA1105P_decodeMacLevelDiagnCounters
+* \param[in]  port Ethernet port number {0:4}
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetMacLevelDiagnCounters(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, MAC_LDC_WORD_COUNT, (uint32_t) ((uint32_t) MAC_LDC_ADDR + ((uint32_t) MAC_LDC_PORT_INC * port)), p_registerValue);
+}
+
+/**
+* \brief This function is used to split the raw word of the mac_level_diagn_counters into its fields
+*
+* \param[in]  registerValue Raw word of the register
+* \param[out] p_macLevelDiagnCounters Location of the struct containing the fields of the register
+*/
+void SJA1105P_decodeMacLevelDiagnCounters(uint32_t registerValue, SJA1105P_macLevelDiagnCountersArgument_t *p_macLevelDiagnCounters)
+{
+	uint32_t cResult;
+
+	/* split received register values into bit groups */
 	cResult   = (uint32_t) registerValue;
 	cResult >>= (uint32_t) (MAC_LDC_N_RUNT_SHIFT);  /* shift to right aligned position */
 	p_macLevelDiagnCounters->nRunt = (uint8_t) cResult;  /* deliver result */
@@ -4066,8 +4247,6 @@ uint8_t SJA1105P_getMacLevelDiagnCounters(SJA1105P_macLevelDiagnCountersArgument
 
 	cResult   = (uint32_t) registerValue;
 	p_macLevelDiagnCounters->nMiierr = (uint8_t) cResult;  /* deliver result */
-
-	return ret;
 }
 
 /**
@@ -4141,7 +4320,7 @@ uint8_t SJA1105P_getHlDiagnCounters10(uint64_t *p_nTxbyte, uint8_t port, uint8_t
 	nTxbyteTmp  = (uint64_t) cResult;
 
 	cResult   = (uint32_t) registerValue[WORD1];
-	nTxbyteTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) HL_DC_1_0_N_TXBYTE_SHIFT_OVLP);
+	nTxbyteTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) SJA1105P_HL_DC_1_0_N_TXBYTE_SHIFT_OVLP);
 	*p_nTxbyte = (uint64_t) nTxbyteTmp;  /* deliver result */
 
 	return ret;
@@ -4168,7 +4347,7 @@ uint8_t SJA1105P_getHlDiagnCounters11(uint64_t *p_nTxfrm, uint8_t port, uint8_t
 	nTxfrmTmp  = (uint64_t) cResult;
 
 	cResult   = (uint32_t) registerValue[WORD1];
-	nTxfrmTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) HL_DC_1_1_N_TXFRM_SHIFT_OVLP);
+	nTxfrmTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) SJA1105P_HL_DC_1_1_N_TXFRM_SHIFT_OVLP);
 	*p_nTxfrm = (uint64_t) nTxfrmTmp;  /* deliver result */
 
 	return ret;
@@ -4195,7 +4374,7 @@ uint8_t SJA1105P_getHlDiagnCounters12(uint64_t *p_nRxbyte, uint8_t port, uint8_t
 	nRxbyteTmp  = (uint64_t) cResult;
 
 	cResult   = (uint32_t) registerValue[WORD1];
-	nRxbyteTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) HL_DC_1_2_N_RXBYTE_SHIFT_OVLP);
+	nRxbyteTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) SJA1105P_HL_DC_1_2_N_RXBYTE_SHIFT_OVLP);
 	*p_nRxbyte = (uint64_t) nRxbyteTmp;  /* deliver result */
 
 	return ret;
@@ -4222,7 +4401,7 @@ uint8_t SJA1105P_getHlDiagnCounters13(uint64_t *p_nRxfrm, uint8_t port, uint8_t
 	nRxfrmTmp  = (uint64_t) cResult;
 
 	cResult   = (uint32_t) registerValue[WORD1];
-	nRxfrmTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) HL_DC_1_3_N_RXFRM_SHIFT_OVLP);
+	nRxfrmTmp |= (uint64_t) ((uint64_t) cResult << (uint8_t) SJA1105P_HL_DC_1_3_N_RXFRM_SHIFT_OVLP);
 	*p_nRxfrm = (uint64_t) nRxfrmTmp;  /* deliver result */
 
 	return ret;
@@ -4338,6 +4517,18 @@ uint8_t SJA1105P_getHlDiagnCounters18(uint32_t *p_nN664err, uint8_t port, uint8_
 	return ret;
 }
 
+/**
+* \brief This function is used to queue a read of all hl_diagn_counters_1 of a port within the open SPI batch
+*
+* \param[out] p_registerValue Location of SJA1105P_HL_DIAGN_COUNTERS_1_WORDS raw words, starting with hl_diagn_counters_1_0, valid once the batch was committed.
+* \param[in]  port Ethernet port number {0:4}
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetHlDiagnCounters1(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, HL_DC_1_WORD_COUNT, (uint32_t) ((uint32_t) HL_DC_1_0_ADDR + ((uint32_t) HL_DC_1_PORT_INC * port)), p_registerValue);
+}
+
 /**
 * \brief This function is used to GET data of the hl_diagn_counters_2_0
 *
@@ -4438,20 +4629,45 @@ uint8_t SJA1105P_getHlDiagnCounters23(uint32_t *p_qfull, uint8_t port, uint8_t d
 uint8_t SJA1105P_getHlDiagnCountersOccupancy(SJA1105P_hlDiagnCountersOccupancyArgument_t *p_hlDiagnCountersOccupancy, uint8_t port, uint8_t queue, uint8_t deviceSelect)
 {
 	uint8_t ret;
-	uint32_t cResult;
 
 	uint32_t registerValue = 0;
 
-	/* split received register values into bit groups */
 	ret = SJA1105P_gpf_spiRead32(deviceSelect, 1U, (uint32_t) ((uint32_t) HL_DCO_ADDR + ((uint32_t) HL_DCO_PORT_INC * port) + ((uint32_t) queue)), &registerValue);  /* read data via SPI from register at address -0x1*/
+	SJA1105P_decodeHlDiagnCountersOccupancy(registerValue, p_hlDiagnCountersOccupancy);
+
+	return ret;
+}
+
+/**
+* \brief This function is used to queue a read of all hl_diagn_counters_2 and hl_diagn_counters_occupancy of a port within the open SPI batch
+*
+* \param[out] p_registerValue Location of SJA1105P_HL_DIAGN_COUNTERS_2_WORDS raw words, starting with hl_diagn_counters_2_0, valid once the batch was committed.
+* The occupancy of queue q is found at word 4 + q and converted by ::SJA1105P_decodeHlDiagnCountersOccupancy
+* \param[in]  port Ethernet port number {0:4}
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetHlDiagnCounters2(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, HL_DC_2_WORD_COUNT, (uint32_t) ((uint32_t) HL_DC_2_0_ADDR + ((uint32_t) HL_DC_2_PORT_INC * port)), p_registerValue);
+}
+
+/**
+* \brief This function is used to split the raw word of the hl_diagn_counters_occupancy of a queue into its fields
+*
+* \param[in]  registerValue Raw word of the register
+* \param[out] p_hlDiagnCountersOccupancy Location of the struct containing the fields of the register
+*/
+void SJA1105P_decodeHlDiagnCountersOccupancy(uint32_t registerValue, SJA1105P_hlDiagnCountersOccupancyArgument_t *p_hlDiagnCountersOccupancy)
+{
+	uint32_t cResult;
+
+	/* split received register values into bit groups */
 	cResult   = (uint32_t) registerValue;
 	cResult >>= (uint32_t) (HL_DCO_Q_OCCUPANCY_HIGH_WATT_SHIFT);  /* shift to right aligned position */
 	p_hlDiagnCountersOccupancy->qOccupancyHighWatt = (uint8_t) cResult;  /* deliver result */
 
 	cResult   = (uint32_t) registerValue;
 	p_hlDiagnCountersOccupancy->qOccupancy = (uint8_t) cResult;  /* deliver result */
-
-	return ret;
 }
 
 /**
@@ -4982,6 +5198,18 @@ uint8_t SJA1105P_getEthStatCounters22(uint32_t *p_ingAddrNotLearnedDrop, uint8_t
 	return ret;
 }
 
+/**
+* \brief This function is used to queue a read of all eth_stat_counters of a port within the open SPI batch
+*
+* \param[out] p_registerValue Location of SJA1105P_ETH_STAT_COUNTERS_WORDS raw words, starting with eth_stat_counters_00, valid once the batch was committed.
+* \param[in]  port Ethernet port number {0:4}
+* \return uint8_t
+*/
+uint8_t SJA1105P_queueGetEthStatCounters(uint32_t *p_registerValue, uint8_t port, uint8_t deviceSelect)
+{
+	return SJA1105P_spiQueueRead32(deviceSelect, ETH_STAT_C_WORD_COUNT, (uint32_t) ((uint32_t) ETH_STAT_C_00_ADDR + ((uint32_t) ETH_STAT_C_PORT_INC * port)), p_registerValue);
+}
+
 /**
 * \brief This function is used to GET data of the l2_forwarding_parameters
 *
@@ -5242,3 +5470,155 @@ SJA1105P_hostCmd_t SJA1105P_convertToHostCmd(uint32_t stdintValue)
 	}
 	return ret;
 }
+
+/**
+* \brief Wait for the completion of a dynamic reconfiguration command
+*
+* The control register is polled until the switch clears its VALID flag.
+* The first polls are issued back to back. Afterwards, the platform wait
+* function is called between two polls with an exponentially growing
+* duration. The command is reported as failed if it is still pending after
+* ::SJA1105P_RECONFIGURATION_TIMEOUT_US or ::RECONFIGURATION_MAX_POLLS polls.
+* If a batch of the SPI queue is open, the first poll transfers it.
+*
+* The ERRORS flag only fails the call if p_registerValue is NULL. Callers that read
+* back the control register decode the flag themselves, e.g. a SEARCH miss of the
+* L2 address lookup table is not an error.
+*
+* \param[in]  reconfiguration Control register of the command
+* \param[out] p_registerValue Last value read from the control register, decoded by the caller. May be NULL.
+* \param[in]  deviceSelect Switch the command was issued to
+*
+* \return uint8_t: {0: command completed, else: SPI failure, timeout or ERRORS flag set and p_registerValue is NULL}
+*/
+extern uint8_t SJA1105P_waitReconfiguration(SJA1105P_reconfiguration_t reconfiguration, uint32_t *p_registerValue, uint8_t deviceSelect)
+{
+	uint8_t  ret;
+	uint8_t  pending;
+	uint32_t registerValue = 0;
+	uint32_t nPolls = 0;
+	uint32_t waitUs = RECONFIGURATION_MIN_WAIT_US;
+	uint64_t startNs;
+	uint64_t latencyNs = 0;
+	SJA1105P_reconfigurationStats_t *p_stats;
+
+	startNs = SJA1105P_getTimeNs();
+	do
+	{
+		if (nPolls >= RECONFIGURATION_N_SPIN_POLLS)
+		{  /* the command takes longer than usual, do not occupy the SPI bus */
+			SJA1105P_waitUs(waitUs);
+			if (waitUs < RECONFIGURATION_MAX_WAIT_US)
+			{
+				waitUs <<= 1U;
+			}
+		}
+		ret = SJA1105P_gpf_spiRead32(deviceSelect, 1U, gk_reconfigurationAddr[reconfiguration], &registerValue);
+		nPolls++;
+		latencyNs = SJA1105P_getTimeNs() - startNs;
+		pending = ((registerValue & RECONFIGURATION_VALID_MASK) != 0U) ? 1U : 0U;
+	}
+	while ((ret == 0U) && (pending == 1U) && (nPolls < RECONFIGURATION_MAX_POLLS) && (latencyNs < ((uint64_t) SJA1105P_RECONFIGURATION_TIMEOUT_US * 1000U)));
+
+	/* the batch holds the transport lock of the switch while the statistics are updated */
+	if ((deviceSelect < SJA1105P_N_SWITCHES) && (SJA1105P_spiQueueStart(deviceSelect) == 0U))
+	{
+		p_stats = &(g_reconfigurationStats[deviceSelect][reconfiguration]);
+		p_stats->nCommands++;
+		p_stats->totalPolls += nPolls;
+		p_stats->totalLatencyNs += latencyNs;
+		if (nPolls > p_stats->maxPolls)
+		{
+			p_stats->maxPolls = nPolls;
+		}
+		if (latencyNs > p_stats->maxLatencyNs)
+		{
+			p_stats->maxLatencyNs = latencyNs;
+		}
+		if ((ret == 0U) && (pending == 1U))
+		{
+			p_stats->nTimeouts++;
+		}
+		else if ((ret == 0U) && ((registerValue & gk_reconfigurationErrorsMask[reconfiguration]) != 0U))
+		{
+			p_stats->nErrors++;
+		}
+		else
+		{
+			/* completed or SPI failure */
+		}
+		(void) SJA1105P_spiQueueCommit(deviceSelect, NULL, NULL);  /* nothing queued since the last poll */
+	}
+
+	if (pending == 1U)
+	{
+		ret = 1;
+	}
+	if (p_registerValue != NULL)
+	{
+		*p_registerValue = registerValue;
+	}
+	else if ((registerValue & gk_reconfigurationErrorsMask[reconfiguration]) != 0U)
+	{
+		ret = 1;
+	}
+	else
+	{
+		/* no error */
+	}
+
+	return ret;
+}
+
+/**
+* \brief Get the completion statistics of a dynamic reconfiguration control register
+*
+* \param[in]  reconfiguration Control register
+* \param[out] p_stats Memory location the statistics are copied to
+* \param[in]  deviceSelect Switch
+*
+* \return uint8_t: {0: successful, else: invalid switch}
+*/
+extern uint8_t SJA1105P_getReconfigurationStats(SJA1105P_reconfiguration_t reconfiguration, SJA1105P_reconfigurationStats_t *p_stats, uint8_t deviceSelect)
+{
+	uint8_t ret = 1;
+
+	if ((deviceSelect < SJA1105P_N_SWITCHES) && ((uint8_t) reconfiguration < SJA1105P_N_RECONFIGURATIONS))
+	{  /* copied under the transport lock of the switch, see SJA1105P_waitReconfiguration() */
+		ret = SJA1105P_spiQueueStart(deviceSelect);
+		if (ret == 0U)
+		{
+			*p_stats = g_reconfigurationStats[deviceSelect][reconfiguration];
+			ret = SJA1105P_spiQueueCommit(deviceSelect, NULL, NULL);
+		}
+	}
+
+	return ret;
+}
+
+/**
+* \brief Clear the completion statistics of all control registers of a switch
+*
+* \param[in]  deviceSelect Switch
+*/
+extern void SJA1105P_resetReconfigurationStats(uint8_t deviceSelect)
+{
+	uint8_t reconfiguration;
+	SJA1105P_reconfigurationStats_t *p_stats;
+
+	if ((deviceSelect < SJA1105P_N_SWITCHES) && (SJA1105P_spiQueueStart(deviceSelect) == 0U))
+	{  /* cleared under the transport lock of the switch, see SJA1105P_waitReconfiguration() */
+		for (reconfiguration = 0; reconfiguration < SJA1105P_N_RECONFIGURATIONS; reconfiguration++)
+		{
+			p_stats = &(g_reconfigurationStats[deviceSelect][reconfiguration]);
+			p_stats->nCommands      = 0;
+			p_stats->nTimeouts      = 0;
+			p_stats->nErrors        = 0;
+			p_stats->maxPolls       = 0;
+			p_stats->totalPolls     = 0;
+			p_stats->totalLatencyNs = 0;
+			p_stats->maxLatencyNs   = 0;
+		}
+		(void) SJA1105P_spiQueueCommit(deviceSelect, NULL, NULL);
+	}
+}
@@ -30,32 +30,27 @@
 #ifndef _SJA1105P_SPI_LINUX_H
 #define _SJA1105P_SPI_LINUX_H
 
-/*
- * The configuration must be loaded into SJA1105P starting from 0x20000
- * The configuration must be split in 64 words block transfers
- */
-#define SJA1105P_CONFIG_START_ADDRESS 0x20000UL
-#define SJA1105P_CONFIG_WORDS_PER_BLOCK 64
-
-#define CMD_RWOP_SHIFT 31
-#define CMD_RD_OP 0
-#define CMD_WR_OP 1
-#define CMD_REG_ADDR_SHIFT 4
-#define CMD_REG_ADDR_WIDTH 21
-#define CMD_REG_RD_CNT_SHIFT 25
-#define CMD_REG_RD_CNT_WIDTH 6
-
-#define WIDTH2MASK(_w_) ((1 << (_w_)) - 1)
-
-#define CMD_ENCODE_RWOP(_write_)   ((_write_)<< CMD_RWOP_SHIFT)
-#define CMD_ENCODE_ADDR(_addr_)    (((_addr_) & WIDTH2MASK(CMD_REG_ADDR_WIDTH)) << CMD_REG_ADDR_SHIFT)
-#define CMD_ENCODE_WRD_CNT(_cnt_)  (((_cnt_) & WIDTH2MASK(CMD_REG_RD_CNT_WIDTH)) << CMD_REG_RD_CNT_SHIFT)
+#include "sja1105p_spi_frame.h"
 
+/* timing report of a static configuration upload */
+struct sja1105p_cfg_upload_stats {
+	int nb_words;             /**< number of configuration words uploaded */
+	int nb_blocks;            /**< number of SPI frames used */
+	s64 prepare_us;           /**< time spent framing the image */
+	s64 transfer_us;          /**< time spent on the bus */
+};
 
 void register_spi_callback(struct spi_device *spi, int device_select, int active_switches);
 void unregister_spi_callback(int active_switches);
 
+int sja1105p_spi_read(struct spi_device *spi, u32 reg_addr, u32 *data, int nb_words);
 u32 sja1105p_read_reg32(struct spi_device *spi, u32 reg_addr);
 int sja1105p_cfg_block_write(struct spi_device *spi, u32 reg_addr, u32 *data, int nb_words);
+struct seq_file;
+
+void sja1105p_spi_stats_show(struct seq_file *s, int device_select);
+void sja1105p_spi_stats_reset(int device_select);
+
+int sja1105p_cfg_upload(struct spi_device *spi, u32 reg_addr, const u32 *data, int nb_words, int block_words, struct sja1105p_cfg_upload_stats *stats);
 
 #endif /* _SJA1105P_SPI_LINUX_H */
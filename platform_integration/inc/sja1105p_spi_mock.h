@@ -0,0 +1,65 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file sja1105p_spi_mock.h
+*
+* \author NXP Semiconductors
+*
+* \brief In-memory SPI backend of the HAL, used to run the HAL without switch hardware
+*
+*****************************************************************************/
+#ifndef _SJA1105P_SPI_MOCK_H
+#define _SJA1105P_SPI_MOCK_H
+
+#include <stdint.h>
+
+/* number of 32 bit words addressable by a command frame */
+#define SJA1105P_MOCK_ADDR_SPACE (1UL << 21)
+
+/*
+ * Called on every register access of the mock, once per word.
+ * For writes, the hook runs after the word was stored and may modify the
+ * register memory (e.g. to model a table lookup). For reads, it runs before
+ * the word is returned.
+ */
+typedef void (*sja1105p_mock_hook_t)(uint8_t deviceSelect, int write, uint32_t reg_addr, uint32_t *p_regs, void *p_context);
+
+/* SPI cost of the HAL, counted per switch */
+struct sja1105p_mock_stats {
+	uint64_t rd_transactions;  /**< read callbacks invoked by the HAL */
+	uint64_t rd_frames;        /**< read command frames, split by SPI_RD_BLOCKS */
+	uint64_t rd_words;
+	uint64_t wr_transactions;  /**< write callbacks invoked by the HAL */
+	uint64_t wr_frames;        /**< write command frames, split by SPI_CFG_BLOCKS */
+	uint64_t wr_words;
+	uint64_t batches;          /**< committed batches */
+};
+
+void sja1105p_mock_register(void);
+void sja1105p_mock_unregister(void);
+void sja1105p_mock_reset(void);
+
+uint32_t *sja1105p_mock_registers(uint8_t deviceSelect);
+void sja1105p_mock_set_hook(sja1105p_mock_hook_t pf_hook, void *p_context);
+
+void sja1105p_mock_get_stats(uint8_t deviceSelect, struct sja1105p_mock_stats *p_stats);
+void sja1105p_mock_reset_stats(void);
+
+#endif /* _SJA1105P_SPI_MOCK_H */
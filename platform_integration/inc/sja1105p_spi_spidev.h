@@ -0,0 +1,39 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file sja1105p_spi_spidev.h
+*
+* \author NXP Semiconductors
+*
+* \brief Userspace SPI backend of the HAL using the Linux spidev interface
+*
+*****************************************************************************/
+#ifndef _SJA1105P_SPI_SPIDEV_H
+#define _SJA1105P_SPI_SPIDEV_H
+
+#include <stdint.h>
+
+int sja1105p_spidev_open(uint8_t deviceSelect, const char *path, uint32_t speed_hz);
+void sja1105p_spidev_close(uint8_t deviceSelect);
+
+void sja1105p_spidev_register(void);
+void sja1105p_spidev_unregister(void);
+
+#endif /* _SJA1105P_SPI_SPIDEV_H */
@@ -0,0 +1,42 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file sja1105p_switch_model.h
+*
+* \author NXP Semiconductors
+*
+* \brief Software model of the SJA1105P/Q/R/S register file on top of the mock SPI backend
+*
+*****************************************************************************/
+#ifndef _SJA1105P_SWITCH_MODEL_H
+#define _SJA1105P_SWITCH_MODEL_H
+
+#include <stdint.h>
+
+#include "NXP_SJA1105P_auxiliaryConfigurationUnit.h"
+#include "sja1105p_spi_mock.h"
+
+void sja1105p_model_attach(SJA1105P_partNr_t partNr);
+void sja1105p_model_detach(void);
+void sja1105p_model_reset(void);
+
+uint64_t sja1105p_model_get_ptp_clk(uint8_t deviceSelect);
+
+#endif /* _SJA1105P_SWITCH_MODEL_H */
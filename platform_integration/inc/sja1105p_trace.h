@@ -0,0 +1,85 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file sja1105p_trace.h
+*
+* \author NXP Semiconductors
+*
+* \brief Tracepoints of the SPI transport, available below events/sja1105p
+*
+*****************************************************************************/
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM sja1105p
+
+#if !defined(_SJA1105P_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _SJA1105P_TRACE_H
+
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(sja1105p_spi_access,
+
+	TP_PROTO(int device, u32 reg_addr, int nb_words, s64 duration_ns),
+
+	TP_ARGS(device, reg_addr, nb_words, duration_ns),
+
+	TP_STRUCT__entry(
+		__field(int, device)
+		__field(u32, reg_addr)
+		__field(int, nb_words)
+		__field(s64, duration_ns)
+	),
+
+	TP_fast_assign(
+		__entry->device = device;
+		__entry->reg_addr = reg_addr;
+		__entry->nb_words = nb_words;
+		__entry->duration_ns = duration_ns;
+	),
+
+	TP_printk("device=%d addr=0x%06x words=%d duration=%lld ns",
+		__entry->device, __entry->reg_addr, __entry->nb_words, __entry->duration_ns)
+);
+
+/* HAL read callback, may span several frames */
+DEFINE_EVENT(sja1105p_spi_access, sja1105p_spi_read32,
+	TP_PROTO(int device, u32 reg_addr, int nb_words, s64 duration_ns),
+	TP_ARGS(device, reg_addr, nb_words, duration_ns)
+);
+
+/* HAL write callback, may span several frames or only queue them within a batch */
+DEFINE_EVENT(sja1105p_spi_access, sja1105p_spi_write32,
+	TP_PROTO(int device, u32 reg_addr, int nb_words, s64 duration_ns),
+	TP_ARGS(device, reg_addr, nb_words, duration_ns)
+);
+
+/* single write frame */
+DEFINE_EVENT(sja1105p_spi_access, sja1105p_cfg_block_write,
+	TP_PROTO(int device, u32 reg_addr, int nb_words, s64 duration_ns),
+	TP_ARGS(device, reg_addr, nb_words, duration_ns)
+);
+
+#endif /* _SJA1105P_TRACE_H */
+
+/* the header is found through the include path of the platform integration */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE sja1105p_trace
+#include <trace/define_trace.h>
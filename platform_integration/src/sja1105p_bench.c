@@ -0,0 +1,350 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file  sja1105p_bench.c
+*
+* \author NXP Semiconductors
+*
+* \brief Host side benchmark of the HAL against the switch model
+*
+* Reports the SPI cost (transactions, frames, words, batches summed over all
+* switches) and the host run time of HAL calls. The SPI cost does not depend
+* on the host and can be compared between revisions of the HAL.
+*
+*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "NXP_SJA1105P_config.h"
+#include "NXP_SJA1105P_addressResolutionTable.h"
+#include "NXP_SJA1105P_arlCompaction.h"
+#include "NXP_SJA1105P_vlan.h"
+#include "NXP_SJA1105P_ptp.h"
+#include "NXP_SJA1105P_diagnostics.h"
+#include "sja1105p_switch_model.h"
+
+#define BENCH_ARL_ENTRIES 64
+#define BENCH_ARL_BATCH_ENTRIES 1000
+#define BENCH_LEARNED_BUDGET 256
+#define BENCH_COMPACTION_ENTRIES 4096
+
+struct bench_result {
+	struct sja1105p_mock_stats spi;
+	uint64_t duration_ns;
+	uint8_t ret;
+};
+
+/* number of calls that failed, reported as exit status */
+static unsigned g_bench_failures;
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void bench_total_stats(struct sja1105p_mock_stats *p_total)
+{
+	struct sja1105p_mock_stats stats;
+	int i;
+
+	memset(p_total, 0, sizeof(*p_total));
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+		sja1105p_mock_get_stats(i, &stats);
+		p_total->rd_transactions += stats.rd_transactions;
+		p_total->rd_frames += stats.rd_frames;
+		p_total->rd_words += stats.rd_words;
+		p_total->wr_transactions += stats.wr_transactions;
+		p_total->wr_frames += stats.wr_frames;
+		p_total->wr_words += stats.wr_words;
+		p_total->batches += stats.batches;
+	}
+}
+
+static void bench_start(struct bench_result *p_result)
+{
+	sja1105p_mock_reset_stats();
+	p_result->ret = 0;
+	p_result->duration_ns = bench_now_ns();
+}
+
+static void bench_stop(struct bench_result *p_result, const char *name, unsigned calls)
+{
+	struct sja1105p_mock_stats *s = &p_result->spi;
+
+	p_result->duration_ns = bench_now_ns() - p_result->duration_ns;
+	bench_total_stats(s);
+	if (p_result->ret)
+		g_bench_failures++;
+
+	if (calls == 0)
+		calls = 1;
+	printf("%-28s %4s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %7.1f %9.1f\n",
+	       name, p_result->ret ? "FAIL" : "ok",
+	       (double) s->rd_transactions / calls, (double) s->rd_frames / calls, (double) s->rd_words / calls,
+	       (double) s->wr_transactions / calls, (double) s->wr_frames / calls, (double) s->wr_words / calls,
+	       (double) s->batches / calls, (double) p_result->duration_ns / calls / 1000.0);
+}
+
+int main(void)
+{
+	SJA1105P_addressResolutionTableEntry_t entry;
+	static SJA1105P_arlTableSnapshot_t snapshot;
+	static SJA1105P_arlCompactionEntry_t compaction[BENCH_COMPACTION_ENTRIES];
+	SJA1105P_arlCompactionStats_t compactionStats;
+	SJA1105P_vlanForwarding_t vlanForwarding[SJA1105P_N_LOGICAL_PORTS];
+	SJA1105P_portCounters_t portCounters;
+	SJA1105P_macLevelErrors_t macLevelErrors;
+	struct bench_result r;
+	uint64_t counter64;
+	uint32_t counter32;
+	uint64_t clk;
+	uint16_t enable;
+	uint16_t pvid;
+	unsigned i, j;
+
+	sja1105p_model_attach(SJA1105P_e_partNr_SJA1105Q);
+
+	printf("%d switches, cost per call summed over all switches\n", SJA1105P_N_SWITCHES);
+	printf("%-28s %4s %8s %8s %8s %8s %8s %8s %7s %9s\n", "call", "",
+	       "rd_xfer", "rd_frm", "rd_wrd", "wr_xfer", "wr_frm", "wr_wrd", "batch", "host_us");
+
+	bench_start(&r);
+	r.ret = SJA1105P_synchSwitchConfiguration();
+	SJA1105P_initAutoPortMapping();
+	bench_stop(&r, "synchSwitchConfiguration", 1);
+
+	bench_start(&r);
+	r.ret = SJA1105P_initPtp();
+	bench_stop(&r, "initPtp", 1);
+
+	bench_start(&r);
+	for (i = 0; i < 100; i++)
+		r.ret |= SJA1105P_getPtpClk(&clk);
+	bench_stop(&r, "getPtpClk", 100);
+
+	bench_start(&r);
+	for (i = 0; i < 100; i++)
+		r.ret |= SJA1105P_addOffsetToPtpClk(125);
+	bench_stop(&r, "addOffsetToPtpClk", 100);
+
+	memset(&entry, 0, sizeof(entry));
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.dstMacAddress = 0x001122330000ULL + i;
+		entry.vlanId = 0;
+		entry.ports = 1;
+		r.ret |= SJA1105P_addArlTableEntry(&entry);
+	}
+	bench_stop(&r, "addArlTableEntry", BENCH_ARL_ENTRIES);
+
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.index = i;
+		r.ret |= SJA1105P_readArlTableEntryByIndex(&entry);
+		if (entry.dstMacAddress != 0x001122330000ULL + i)
+			r.ret = 1;
+	}
+	bench_stop(&r, "readArlTableEntryByIndex", BENCH_ARL_ENTRIES);
+
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.dstMacAddress = 0x001122330000ULL + i;
+		entry.vlanId = 0;
+		r.ret |= SJA1105P_readArlTableEntryByAddress(&entry);
+		if (entry.index != i)
+			r.ret = 1;
+	}
+	bench_stop(&r, "readArlTableEntryByAddress", BENCH_ARL_ENTRIES);
+
+	bench_start(&r);
+	r.ret = SJA1105P_snapshotArlTable(&snapshot);
+	if (snapshot.nEntries != BENCH_ARL_ENTRIES)
+		r.ret = 1;
+	bench_stop(&r, "snapshotArlTable", 1);
+
+	/* one scan of the learned FDB sync with the default budget, static entries are skipped */
+	bench_start(&r);
+	r.ret = SJA1105P_readLearnedArlTableEntries(0, BENCH_LEARNED_BUDGET, snapshot.entries, 1);
+	for (i = 0; i < BENCH_LEARNED_BUDGET; i++)
+		if (snapshot.entries[i].enabled)
+			r.ret = 1;
+	bench_stop(&r, "readLearnedArlTableEntries", 1);
+
+	/* multicast join of a second port of the master switch, the other switches are not written */
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.dstMacAddress = 0x001122330000ULL + i;
+		entry.vlanId = 0;
+		entry.ports = 3;
+		r.ret |= SJA1105P_updateArlTableEntryPorts(&entry, 1);
+		if (entry.index != i)
+			r.ret = 1;
+	}
+	bench_stop(&r, "updateArlTableEntryPorts", BENCH_ARL_ENTRIES);
+
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.index = i;
+		r.ret |= SJA1105P_removeArlTableEntryByIndex(&entry);
+	}
+	bench_stop(&r, "removeArlTableEntryByIndex", BENCH_ARL_ENTRIES);
+
+	bench_start(&r);
+	r.ret = SJA1105P_beginArlBatch();
+	for (i = 0; i < BENCH_ARL_BATCH_ENTRIES; i++) {
+		entry.dstMacAddress = 0x001122330000ULL + i;
+		entry.vlanId = i % 16;
+		entry.ports = (uint16_t) (1U << (i % SJA1105P_N_LOGICAL_PORTS));
+		r.ret |= SJA1105P_addArlBatchEntry(&entry);
+	}
+	r.ret |= SJA1105P_commitArlBatch();
+	bench_stop(&r, "commitArlBatch (1000 adds)", 1);
+
+	bench_start(&r);
+	r.ret = SJA1105P_beginArlBatch();
+	for (i = 0; i < BENCH_ARL_BATCH_ENTRIES; i++) {
+		entry.dstMacAddress = 0x001122330000ULL + i;
+		entry.vlanId = i % 16;
+		r.ret |= SJA1105P_removeArlBatchEntry(&entry);
+	}
+	r.ret |= SJA1105P_commitArlBatch();
+	bench_stop(&r, "commitArlBatch (1000 rms)", 1);
+
+	/* four blocks of 1024 addresses, one per port */
+	for (i = 0; i < BENCH_COMPACTION_ENTRIES; i++) {
+		compaction[i].dstMacAddress = 0x001122330000ULL + i;
+		compaction[i].vlanId = 0;
+		compaction[i].ports = (uint16_t) (1U << (i / 1024U));
+	}
+	bench_start(&r);
+	r.ret = SJA1105P_compactArlTable(compaction, BENCH_COMPACTION_ENTRIES);
+	SJA1105P_getArlCompactionStats(&compactionStats);
+	if (compactionStats.nEntries != 4 || compactionStats.nSlotsSaved != BENCH_COMPACTION_ENTRIES - 4)
+		r.ret = 1;
+	bench_stop(&r, "compactArlTable (4096 addrs)", 1);
+
+	/* the block of the address is split into 10 entries */
+	bench_start(&r);
+	r.ret = SJA1105P_removeCompactedArlAddress(0x001122330123ULL, 0);
+	SJA1105P_getArlCompactionStats(&compactionStats);
+	if (compactionStats.nEntries != 13)
+		r.ret = 1;
+	bench_stop(&r, "removeCompactedArlAddress", 1);
+
+	SJA1105P_compactArlTable(compaction, 0);  /* remove the set again */
+
+	/* VLANs local to the master switch, only port 0 is member */
+	memset(vlanForwarding, 0, sizeof(vlanForwarding));
+	for (i = 1; i < SJA1105P_N_LOGICAL_PORTS; i++)
+		vlanForwarding[i] = SJA1105P_e_vlanForwarding_NOT;
+	bench_start(&r);
+	for (i = 1; i <= 100; i++)
+		r.ret |= SJA1105P_writeVlanConfig(i, vlanForwarding, 1);
+	bench_stop(&r, "writeVlanConfig", 100);
+
+	/* the shadow is unchanged, no entry is written again */
+	bench_start(&r);
+	for (i = 1; i <= 100; i++)
+		r.ret |= SJA1105P_writeVlanConfig(i, vlanForwarding, 1);
+	bench_stop(&r, "writeVlanConfig (again)", 100);
+
+	bench_start(&r);
+	for (i = 1; i <= 100; i++) {
+		r.ret |= SJA1105P_readVlanConfig(i, vlanForwarding, &enable);
+		if (enable != 1)
+			r.ret = 1;
+	}
+	bench_stop(&r, "readVlanConfig", 100);
+
+	/* only the entries of the master switch change, all are written by a single flush */
+	bench_start(&r);
+	for (i = 1; i <= 100; i++)
+		r.ret |= SJA1105P_setVlanPort(i, 0, SJA1105P_e_vlanForwarding_UNTAGGED, 1);
+	r.ret |= SJA1105P_flushVlanConfig();
+	bench_stop(&r, "setVlanPort + flush", 100);
+
+	/* entries not yet in the shadow are read and written in pipelined batches */
+	bench_start(&r);
+	r.ret |= SJA1105P_setVlanPortRange(101, 1100, 0, SJA1105P_e_vlanForwarding_TAGGED, 1);
+	r.ret |= SJA1105P_flushVlanConfig();
+	bench_stop(&r, "setVlanPortRange + flush", 1000);
+
+	/* the MAC configuration entry is read and written once per port, an unchanged PVID costs nothing */
+	bench_start(&r);
+	for (i = 0; i < SJA1105P_N_LOGICAL_PORTS; i++)
+		r.ret |= SJA1105P_setPvid(i, 100);
+	for (i = 0; i < SJA1105P_N_LOGICAL_PORTS; i++)
+		r.ret |= SJA1105P_setPvid(i, 100);
+	bench_stop(&r, "setPvid (twice)", SJA1105P_N_LOGICAL_PORTS);
+
+	bench_start(&r);
+	for (i = 0; i < SJA1105P_N_LOGICAL_PORTS; i++) {
+		r.ret |= SJA1105P_getPvid(i, &pvid);
+		if (pvid != 100)
+			r.ret = 1;
+		r.ret |= SJA1105P_resetPvid(i);
+	}
+	bench_stop(&r, "getPvid + resetPvid", SJA1105P_N_LOGICAL_PORTS);
+
+	/* all counters of a port, one read per counter against one burst per counter block */
+	bench_start(&r);
+	for (i = 0; i < SJA1105P_N_LOGICAL_PORTS; i++) {
+		for (j = 0; j < SJA1105P_N_ETHER_STAT64; j++)
+			r.ret |= SJA1105P_get64bitEtherStatCounter(j, &counter64, i, SJA1105P_e_etherStatDirection_BOTH);
+		for (j = 0; j < SJA1105P_N_ETHER_STAT32; j++)
+			r.ret |= SJA1105P_get32bitEtherStatCounter(j, &counter32, i, SJA1105P_e_etherStatDirection_BOTH);
+		r.ret |= SJA1105P_getMacErrors(&macLevelErrors, i);
+	}
+	bench_stop(&r, "get*EtherStatCounter (all)", SJA1105P_N_LOGICAL_PORTS);
+
+	bench_start(&r);
+	for (i = 0; i < SJA1105P_N_LOGICAL_PORTS; i++)
+		r.ret |= SJA1105P_getPortCounters(&portCounters, i);
+	bench_stop(&r, "getPortCounters", SJA1105P_N_LOGICAL_PORTS);
+
+	/* VLAN 1 is only configured in the master switch, the cascaded switches are not written */
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.dstMacAddress = 0x001122330000ULL + i;
+		entry.vlanId = 1;
+		entry.ports = 1;
+		r.ret |= SJA1105P_addArlTableEntry(&entry);
+	}
+	bench_stop(&r, "addArlTableEntry (VLAN 1)", BENCH_ARL_ENTRIES);
+
+	bench_start(&r);
+	for (i = 0; i < BENCH_ARL_ENTRIES; i++) {
+		entry.index = i;
+		r.ret |= SJA1105P_removeArlTableEntryByIndex(&entry);
+	}
+	bench_stop(&r, "removeArlTableEntry (VLAN 1)", BENCH_ARL_ENTRIES);
+
+	sja1105p_model_detach();
+
+	if (g_bench_failures)
+		printf("%u calls failed\n", g_bench_failures);
+
+	return g_bench_failures ? 1 : 0;
+}
@@ -29,19 +29,130 @@
 *****************************************************************************/
 #include <linux/spi/spi.h>
 #include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/completion.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/workqueue.h>
+#include <linux/atomic.h>
+#include <linux/log2.h>
+#include <linux/seq_file.h>
+#include <linux/wait.h>
 
 #include "NXP_SJA1105P_spi.h"
 #include "sja1105p_spi_linux.h"
 #include "NXP_SJA1105P_config.h"
 
+#define CREATE_TRACE_POINTS
+#include "sja1105p_trace.h"
+
+#if (SPI_RD_BLOCKS < 1) || (SPI_RD_BLOCKS > SJA1105P_CONFIG_WORDS_PER_BLOCK)
+#error "SPI_RD_BLOCKS must be in the range 1..SJA1105P_CONFIG_WORDS_PER_BLOCK"
+#endif
+
+/* maximum number of command frames collected in one spi_message */
+#define SJA1105P_SPI_QUEUE_DEPTH 16
+
+/* number of log2 latency buckets, the last one collects everything above */
+#define SJA1105P_SPI_HIST_BUCKETS 16
+
+/* number of configuration upload messages kept in flight */
+#define SJA1105P_CFG_UPLOAD_SLOTS 2
+
+/* one in-flight message of a configuration upload */
+struct sja1105p_cfg_upload_slot {
+	struct spi_message m;
+	struct spi_transfer t;
+	struct completion done;
+	bool busy;
+};
+
+/* one command frame of a queued batch */
+struct sja1105p_spi_xfer {
+	struct spi_transfer t;
+	u32 *dst;                 /**< destination of a queued read, NULL for writes */
+	int nb_words;             /**< number of data words of the frame */
+	u32 buf[];                /**< tx frame, followed by the rx frame for reads */
+};
+
+/* batch of command frames transferred as one spi_message */
+struct sja1105p_spi_batch {
+	struct spi_message m;
+	struct sja1105p_spi_xfer *xfers[SJA1105P_SPI_QUEUE_DEPTH];
+	int n_xfers;
+	ktime_t t_submit;         /**< start of the transfer, for the statistics */
+	int nesting;              /**< number of nested SJA1105P_spiQueueStart calls */
+	uint8_t device_select;
+	SJA1105P_spiComplete_cb_t complete;
+	void *context;
+};
+
+/*
+ * transport lock of one device, recursive for the owning task so that a
+ * batch opened by SJA1105P_spiQueueStart can span several HAL calls.
+ * A batch committed asynchronously still owns the device until its completion
+ * has delivered the results, the lock is only granted once it is done.
+ */
+struct sja1105p_spi_lock {
+	struct mutex lock;
+	struct task_struct *owner;
+	int depth;
+	atomic_t in_flight;           /**< number of asynchronous batches not yet completed */
+	wait_queue_head_t idle;       /**< woken up when in_flight drops to 0 */
+};
+
+/* one switch of a SJA1105P_forEachSwitch fan-out */
+struct sja1105p_switch_job {
+	struct work_struct work;
+	SJA1105P_switchJob_cb_t pf_job;
+	void *context;
+	uint8_t switch_id;
+	uint8_t ret;
+};
+
+/* transfer statistics of one direction of a device */
+struct sja1105p_spi_stats {
+	atomic64_t transactions;  /**< number of command frames */
+	atomic64_t words;         /**< number of data words */
+	atomic64_t bytes;         /**< number of bytes on the bus, including command words */
+	atomic64_t latency_hist[SJA1105P_SPI_HIST_BUCKETS];  /**< bucket n > 0: latency in [2^(n-1), 2^n) us */
+};
+
 /* is initialized during SJA1105P probing */
 static struct spi_device *g_spi_h[SJA1105P_N_SWITCHES];
 
+/* always-on statistics, indexed by device and direction (0: read, 1: write) */
+static struct sja1105p_spi_stats g_spi_stats[SJA1105P_N_SWITCHES][2];
+
+/* accesses to different devices are independent and may run concurrently */
+static struct sja1105p_spi_lock g_spi_lock[SJA1105P_N_SWITCHES];
+
+/* workers executing per switch jobs, NULL if jobs run sequentially */
+static struct workqueue_struct *g_switch_wq;
+
+/* batch currently open on each device, NULL if none */
+static struct sja1105p_spi_batch *g_spi_batch[SJA1105P_N_SWITCHES];
+
 extern int verbosity;
+extern int parallel_switches;
 
 /* prototypes */
 uint8_t sja1105p_spi_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
 uint8_t sja1105p_spi_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_spi_queue_start(uint8_t deviceSelect);
+uint8_t sja1105p_spi_queue_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_spi_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context);
+uint8_t sja1105p_for_each_switch(SJA1105P_switchJob_cb_t pf_job, void *p_context);
+static void sja1105p_wait_us(uint32_t waitUs);
+static uint64_t sja1105p_get_time_ns(void);
+static uint8_t __sja1105p_spi_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+static uint8_t __sja1105p_spi_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+static uint8_t __sja1105p_spi_queue_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+static uint8_t __sja1105p_spi_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context);
+static int sja1105p_spi_batch_flush(struct spi_device *spi, struct sja1105p_spi_batch *batch);
+static uint8_t sja1105p_spi_queue_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
 
 /* helper function, the word order needs to be switched for some platforms */
 u32 preprocess_words(u32 cmd)
@@ -56,6 +167,128 @@ u32 preprocess_words(u32 cmd)
 	return cmd;
 }
 
+/****************************** Transfer statistics ***************************/
+
+/* the direct register accessors only know the spi device */
+static int sja1105p_spi_device_select(struct spi_device *spi)
+{
+	int i;
+
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+		if (g_spi_h[i] == spi)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * sja1105p_spi_account - record a completed transfer in the statistics of a device
+ * @device_select: The switch ID, ignored if negative
+ * @write: direction of the transfer
+ * @nb_frames: Number of command frames
+ * @nb_words: Number of data words of all frames
+ * @t_start: Start of the transfer
+ *
+ * @return: duration of the transfer in ns
+ */
+static s64 sja1105p_spi_account(int device_select, bool write, int nb_frames, int nb_words, ktime_t t_start)
+{
+	struct sja1105p_spi_stats *stats;
+	s64 duration_ns = ktime_to_ns(ktime_sub(ktime_get(), t_start));
+	s64 duration_us = duration_ns / NSEC_PER_USEC;
+	int bucket;
+
+	if (device_select < 0 || device_select >= SJA1105P_N_SWITCHES)
+		return duration_ns;
+
+	stats = &g_spi_stats[device_select][write ? 1 : 0];
+	bucket = (duration_us > 0) ? min_t(int, ilog2(duration_us) + 1, SJA1105P_SPI_HIST_BUCKETS - 1) : 0;
+
+	atomic64_add(nb_frames, &stats->transactions);
+	atomic64_add(nb_words, &stats->words);
+	atomic64_add((nb_frames + nb_words) << 2, &stats->bytes);
+	atomic64_inc(&stats->latency_hist[bucket]);
+
+	return duration_ns;
+}
+
+/**
+ * sja1105p_spi_stats_show - print the transfer statistics of a device
+ * @s: The seq_file to print to
+ * @device_select: The switch ID
+ */
+void sja1105p_spi_stats_show(struct seq_file *s, int device_select)
+{
+	struct sja1105p_spi_stats *stats;
+	int dir, i;
+
+	for (dir = 0; dir < 2; dir++) {
+		stats = &g_spi_stats[device_select][dir];
+
+		seq_printf(s, "\n%s\n", dir ? "Writes" : "Reads");
+		seq_printf(s, "transactions     = %lld\n", (long long)atomic64_read(&stats->transactions));
+		seq_printf(s, "words            = %lld\n", (long long)atomic64_read(&stats->words));
+		seq_printf(s, "bytes            = %lld\n", (long long)atomic64_read(&stats->bytes));
+		seq_printf(s, "latency [us]     count\n");
+		for (i = 0; i < SJA1105P_SPI_HIST_BUCKETS; i++) {
+			if (i == 0)
+				seq_printf(s, "%7d - %-7d %lld\n", 0, 1, (long long)atomic64_read(&stats->latency_hist[i]));
+			else if (i < SJA1105P_SPI_HIST_BUCKETS - 1)
+				seq_printf(s, "%7d - %-7d %lld\n", 1 << (i - 1), 1 << i, (long long)atomic64_read(&stats->latency_hist[i]));
+			else
+				seq_printf(s, "%7d - %-7s %lld\n", 1 << (i - 1), "", (long long)atomic64_read(&stats->latency_hist[i]));
+		}
+	}
+}
+
+/**
+ * sja1105p_spi_stats_reset - clear the transfer statistics of a device
+ * @device_select: The switch ID
+ */
+void sja1105p_spi_stats_reset(int device_select)
+{
+	struct sja1105p_spi_stats *stats;
+	int dir, i;
+
+	for (dir = 0; dir < 2; dir++) {
+		stats = &g_spi_stats[device_select][dir];
+		atomic64_set(&stats->transactions, 0);
+		atomic64_set(&stats->words, 0);
+		atomic64_set(&stats->bytes, 0);
+		for (i = 0; i < SJA1105P_SPI_HIST_BUCKETS; i++)
+			atomic64_set(&stats->latency_hist[i], 0);
+	}
+}
+
+/*************************** Per device transport lock ***********************/
+
+static void sja1105p_spi_lock(uint8_t deviceSelect)
+{
+	struct sja1105p_spi_lock *l = &g_spi_lock[deviceSelect];
+
+	if (READ_ONCE(l->owner) == current) {
+		l->depth++;
+	} else {
+		mutex_lock(&l->lock);
+		WRITE_ONCE(l->owner, current);
+		l->depth = 1;
+	}
+
+	/* the completion does not take the lock, waiting for it while holding the lock is safe */
+	wait_event(l->idle, atomic_read(&l->in_flight) == 0);
+}
+
+static void sja1105p_spi_unlock(uint8_t deviceSelect)
+{
+	struct sja1105p_spi_lock *l = &g_spi_lock[deviceSelect];
+
+	if (--l->depth == 0) {
+		WRITE_ONCE(l->owner, NULL);
+		mutex_unlock(&l->lock);
+	}
+}
+
 /************************** HAL Callback registration *************************/
 void unregister_spi_callback(int active_switches)
 {
@@ -63,11 +296,28 @@ void unregister_spi_callback(int active_switches)
 	if (active_switches == 0) {
 		SJA1105P_registerSpiRead32CB(NULL);
 		SJA1105P_registerSpiWrite32CB(NULL);
+		SJA1105P_registerSpiQueueStartCB(NULL);
+		SJA1105P_registerSpiQueueRead32CB(NULL);
+		SJA1105P_registerSpiQueueCommitCB(NULL);
+		SJA1105P_registerForEachSwitchCB(NULL);
+		SJA1105P_registerWaitUsCB(NULL);
+		SJA1105P_registerGetTimeNsCB(NULL);
+
+		if (g_switch_wq) {
+			destroy_workqueue(g_switch_wq);
+			g_switch_wq = NULL;
+		}
 	}
 }
 
 void register_spi_callback(struct spi_device *spi, int device_select, int active_switches)
 {
+	mutex_init(&g_spi_lock[device_select].lock);
+	g_spi_lock[device_select].owner = NULL;
+	g_spi_lock[device_select].depth = 0;
+	atomic_set(&g_spi_lock[device_select].in_flight, 0);
+	init_waitqueue_head(&g_spi_lock[device_select].idle);
+
 	/* spi context stored to be used by contextless HAL callbacks */
 	g_spi_h[device_select] = spi;
 
@@ -75,68 +325,209 @@ void register_spi_callback(struct spi_device *spi, int device_select, int active
 	if (active_switches == 0) {
 		SJA1105P_registerSpiRead32CB(sja1105p_spi_read32);
 		SJA1105P_registerSpiWrite32CB(sja1105p_spi_write32);
+		SJA1105P_registerSpiQueueStartCB(sja1105p_spi_queue_start);
+		SJA1105P_registerSpiQueueRead32CB(sja1105p_spi_queue_read32);
+		SJA1105P_registerSpiQueueCommitCB(sja1105p_spi_queue_commit);
+		SJA1105P_registerWaitUsCB(sja1105p_wait_us);
+		SJA1105P_registerGetTimeNsCB(sja1105p_get_time_ns);
+
+		if (parallel_switches && SJA1105P_N_SWITCHES > 1) {
+			g_switch_wq = alloc_workqueue("sja1105p_switch", WQ_UNBOUND, SJA1105P_N_SWITCHES);
+			if (g_switch_wq)
+				SJA1105P_registerForEachSwitchCB(sja1105p_for_each_switch);
+			else
+				dev_err(&spi->dev, "Could not allocate switch workers, per switch jobs run sequentially\n");
+		}
+	}
+}
+
+/************************** Reconfiguration polling ***************************/
+
+/**
+ * sja1105p_wait_us - this function is used by the HAL between two polls of a control register
+ *
+ * Short waits are busy, since the timer slack of a sleep would exceed them.
+ * The HAL is only called from process context, longer waits give the CPU
+ * and the SPI bus to other users.
+ */
+static void sja1105p_wait_us(uint32_t waitUs)
+{
+	if (waitUs < 10)
+		udelay(waitUs);
+	else
+		usleep_range(waitUs, 2 * waitUs);
+}
+
+static uint64_t sja1105p_get_time_ns(void)
+{
+	return ktime_get_ns();
+}
+
+/*************************** Per switch fan-out *******************************/
+
+static void sja1105p_switch_job_work(struct work_struct *work)
+{
+	struct sja1105p_switch_job *job = container_of(work, struct sja1105p_switch_job, work);
+
+	job->ret = job->pf_job(job->switch_id, job->context);
+}
+
+/**
+ * sja1105p_for_each_switch - this function is used by the HAL to run a job on all switches concurrently
+ *
+ * Switch 0 is handled in the calling context, all other switches on the
+ * switch workers. Must not be called while a batch is open on any switch,
+ * since the workers would wait for the transport lock held by the caller.
+ */
+uint8_t sja1105p_for_each_switch(SJA1105P_switchJob_cb_t pf_job, void *p_context)
+{
+	struct sja1105p_switch_job jobs[SJA1105P_N_SWITCHES];
+	uint8_t ret;
+	int i;
+
+	for (i = 1; i < SJA1105P_N_SWITCHES; i++) {
+		INIT_WORK_ONSTACK(&jobs[i].work, sja1105p_switch_job_work);
+		jobs[i].pf_job = pf_job;
+		jobs[i].context = p_context;
+		jobs[i].switch_id = i;
+		jobs[i].ret = 0;
+		queue_work(g_switch_wq, &jobs[i].work);
+	}
+
+	ret = pf_job(0, p_context);
+
+	for (i = 1; i < SJA1105P_N_SWITCHES; i++) {
+		flush_work(&jobs[i].work);
+		destroy_work_on_stack(&jobs[i].work);
+		ret += jobs[i].ret;
 	}
+
+	return ret;
 }
 
 /*************************** Platform dependent read **************************/
 
 /**
- * sja1105p_read_reg32  - read 32bit register from slave
- * @dev: The chip state (device)
+ * sja1105p_spi_read  - read N consecutive 32bit registers from slave in a single transfer
+ * @spi: The spi device
  * @reg_addr: The register address to start from
+ * @data: The buffer receiving the values read
+ * @nb_words: Number of words to read, at most SJA1105P_CONFIG_WORDS_PER_BLOCK
  *
- * @return: value read
+ * @return: 0 on success, else negative error code
  */
-u32 sja1105p_read_reg32(struct spi_device *spi, u32 reg_addr)
+int sja1105p_spi_read(struct spi_device *spi, u32 reg_addr, u32 *data, int nb_words)
 {
-	u32 cmd[2];
-	u32 resp[2];
+	u32 *cmd;
+	u32 *resp;
 	struct spi_message m;
 	struct spi_transfer t;
-
+	ktime_t t_start;
 	int rc;
+	int i;
 
-	cmd[0] = cpu_to_le32 (CMD_ENCODE_RWOP(CMD_RD_OP) | CMD_ENCODE_ADDR(reg_addr) | CMD_ENCODE_WRD_CNT(1));
-	cmd[1] = 0;
+	/* kmalloc memory is DMA-safe, unlike stack buffers */
+	cmd = kmalloc_array(2 * (nb_words + 1), sizeof(u32), GFP_KERNEL);
+	if (!cmd)
+		return -ENOMEM;
+	resp = cmd + (nb_words + 1);
 
-	cmd[0] =  preprocess_words(cmd[0]);
+	/* a word count of 64 is encoded as 0 in the 6 bit RD_CNT field */
+	cmd[0] = cpu_to_le32 (CMD_ENCODE_RWOP(CMD_RD_OP) | CMD_ENCODE_ADDR(reg_addr) | CMD_ENCODE_WRD_CNT(nb_words));
+	cmd[0] = preprocess_words(cmd[0]);
+	memset(&cmd[1], 0, nb_words << 2);
 
 	spi_message_init(&m);
 	memset(&t, 0, sizeof(t));
 	t.tx_buf = cmd;
 	t.rx_buf = resp;
-	t.len = 8;
+	t.len = ((nb_words + 1) << 2);
 	t.bits_per_word = SPI_BITS_PER_WORD_MSG;
 
-	if (verbosity > 3) dev_info(&spi->dev, "reading 4bytes @%08x tlen %d t.bits_per_word %d\n", reg_addr, t.len, t.bits_per_word);
+	if (verbosity > 3) dev_info(&spi->dev, "reading %d words @%08x tlen %d t.bits_per_word %d\n", nb_words, reg_addr, t.len, t.bits_per_word);
 
 	spi_message_add_tail(&t, &m);
+	t_start = ktime_get();
 	rc = spi_sync(spi, &m);
-	if (rc) dev_info(&spi->dev, "spi_sync rc %d\n", rc);
+	sja1105p_spi_account(sja1105p_spi_device_select(spi), false, 1, nb_words, t_start);
+	if (rc) {
+		dev_err(&spi->dev, "spi_sync rc %d\n", rc);
+	} else {
+		/* first word received is clocked out during the command phase */
+		for (i = 0; i < nb_words; i++)
+			data[i] = le32_to_cpu(preprocess_words(resp[i+1]));
+	}
+
+	kfree(cmd);
+
+	return rc;
+}
+
+/**
+ * sja1105p_read_reg32  - read 32bit register from slave
+ * @dev: The chip state (device)
+ * @reg_addr: The register address to start from
+ *
+ * @return: value read
+ */
+u32 sja1105p_read_reg32(struct spi_device *spi, u32 reg_addr)
+{
+	u32 val = 0;
 
-	resp[1] = preprocess_words(resp[1]);
+	sja1105p_spi_read(spi, reg_addr, &val, 1);
 
-	return le32_to_cpu(resp[1]);
+	return val;
 }
 
 /**
- *sja1105p_spi_write32 - this function is used by the HAL to read data from SJA1105
+ *sja1105p_spi_read32 - this function is used by the HAL to read data from SJA1105
  */
 uint8_t sja1105p_spi_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint8_t ret;
+	ktime_t t_start;
+
+	sja1105p_spi_lock(deviceSelect);
+	t_start = ktime_get();
+	ret = __sja1105p_spi_read32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	trace_sja1105p_spi_read32(deviceSelect, registerAddress, wordCount, ktime_to_ns(ktime_sub(ktime_get(), t_start)));
+	sja1105p_spi_unlock(deviceSelect);
+
+	return ret;
+}
+
+/* called with the transport lock of the device held */
+static uint8_t __sja1105p_spi_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
 {
 	struct spi_device *spi = g_spi_h[deviceSelect];
-	int i = 0;
+	int block_size_words;
+	int i;
 
 	if (verbosity > 5) dev_info(&spi->dev, "%s: device %d wordCount=%d, registerAddress=%08x\n", __func__, deviceSelect, wordCount, registerAddress);
 
-	while (i < wordCount) {
-		*p_registerValue = sja1105p_read_reg32(spi, registerAddress);
-		if (verbosity > 5) dev_info(&spi->dev, "%s: wordCount %d i %d registerAddress=%08x registerValue=%08x\n", __func__, wordCount, i, registerAddress, *p_registerValue);
-		p_registerValue++;
-		registerAddress++;
-		i++;
+	if (g_spi_batch[deviceSelect]) {
+		/* transfer the queued frames together with this read, the batch stays open */
+		if (__sja1105p_spi_queue_read32(deviceSelect, wordCount, registerAddress, p_registerValue))
+			return 1;
+		return (sja1105p_spi_batch_flush(spi, g_spi_batch[deviceSelect]) == 0) ? 0 : 1;
 	}
 
+	/* split the access into as few bursts as the platform allows */
+	while (wordCount > 0) {
+		block_size_words = min_t(int, wordCount, SPI_RD_BLOCKS);
+
+		if (sja1105p_spi_read(spi, registerAddress, p_registerValue, block_size_words))
+			return 1;
+
+		if (verbosity > 5) {
+			for (i = 0; i < block_size_words; i++)
+				dev_info(&spi->dev, "%s: registerAddress=%08x registerValue=%08x\n", __func__, registerAddress+i, p_registerValue[i]);
+		}
+
+		p_registerValue += block_size_words;
+		registerAddress += block_size_words;
+		wordCount -= block_size_words;
+	}
 
 	return 0;
 }
@@ -181,13 +572,22 @@ int sja1105p_spi_write(struct spi_device *spi, u32 *cmd, u8 nb_words)
  * @data: The pointer to buffer of 32bits words
  * @nb_words: number of 32bits words to write
  *
- * @return: value read
+ * @return: 0 on success, else negative error code
  */
 int sja1105p_cfg_block_write(struct spi_device *spi, u32 reg_addr, u32 *data, int nb_words)
 {
-	u32 cmd[SJA1105P_CONFIG_WORDS_PER_BLOCK+1];
+	u32 *cmd;
+	int device_select;
+	ktime_t t_start;
+	s64 duration_ns;
+	int rc;
 	int i = 0;
 
+	/* kmalloc memory is DMA-safe, unlike stack buffers */
+	cmd = kmalloc_array(nb_words + 1, sizeof(u32), GFP_KERNEL);
+	if (!cmd)
+		return -ENOMEM;
+
 	cmd[0] = cpu_to_le32 (CMD_ENCODE_RWOP(CMD_WR_OP) | CMD_ENCODE_ADDR(reg_addr));
 	cmd[0] = preprocess_words(cmd[0]);
 
@@ -198,7 +598,15 @@ int sja1105p_cfg_block_write(struct spi_device *spi, u32 reg_addr, u32 *data, in
 		i++;
 	}
 
-	return sja1105p_spi_write(spi, cmd, nb_words + 1);
+	t_start = ktime_get();
+	rc = sja1105p_spi_write(spi, cmd, nb_words + 1);
+	device_select = sja1105p_spi_device_select(spi);
+	duration_ns = sja1105p_spi_account(device_select, true, 1, nb_words, t_start);
+	trace_sja1105p_cfg_block_write(device_select, reg_addr, nb_words, duration_ns);
+
+	kfree(cmd);
+
+	return rc;
 }
 
 /**
@@ -206,18 +614,509 @@ int sja1105p_cfg_block_write(struct spi_device *spi, u32 reg_addr, u32 *data, in
  */
 uint8_t sja1105p_spi_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
 {
-	struct spi_device *spi = g_spi_h[deviceSelect];
+	uint8_t ret;
+	ktime_t t_start;
 
+	sja1105p_spi_lock(deviceSelect);
+	t_start = ktime_get();
+	ret = __sja1105p_spi_write32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	trace_sja1105p_spi_write32(deviceSelect, registerAddress, wordCount, ktime_to_ns(ktime_sub(ktime_get(), t_start)));
+	sja1105p_spi_unlock(deviceSelect);
+
+	return ret;
+}
+
+/* called with the transport lock of the device held */
+static uint8_t __sja1105p_spi_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	struct spi_device *spi = g_spi_h[deviceSelect];
+	int rc = 0;
 #if SPI_CFG_BLOCKS == 1
 	int i;
+#endif
+
+	if (g_spi_batch[deviceSelect])
+		return sja1105p_spi_queue_write32(deviceSelect, wordCount, registerAddress, p_registerValue);
 
-	for (i = 0; i < wordCount; i++)
-		sja1105p_cfg_block_write(spi, registerAddress+i, p_registerValue+i, 1);
+#if SPI_CFG_BLOCKS == 1
+	for (i = 0; (i < wordCount) && !rc; i++)
+		rc = sja1105p_cfg_block_write(spi, registerAddress+i, p_registerValue+i, 1);
 #else
-	sja1105p_cfg_block_write(spi, registerAddress, p_registerValue, wordCount);
+	rc = sja1105p_cfg_block_write(spi, registerAddress, p_registerValue, wordCount);
 #endif
 
 	if (verbosity > 5) dev_info(&spi->dev, "%s: device %d wordCount=%d, registerAddress=%08x registerValue=%08x\n", __func__, deviceSelect, wordCount, registerAddress, *p_registerValue);
 
+	return (rc == 0) ? 0 : 1;
+}
+
+
+/*********************** Static configuration upload ***********************/
+
+static void sja1105p_cfg_upload_complete(void *context)
+{
+	struct sja1105p_cfg_upload_slot *slot = context;
+
+	complete(&slot->done);
+}
+
+/**
+ * sja1105p_cfg_upload - upload a static configuration image
+ * @spi: The spi device
+ * @reg_addr: The register address of the first word
+ * @data: The configuration image
+ * @nb_words: Number of words of the image
+ * @block_words: Number of data words per frame, at most SJA1105P_CONFIG_WORDS_PER_BLOCK
+ * @stats: Timing report, may be NULL
+ *
+ * The whole image is framed once into a single DMA-safe buffer, so the word
+ * order is fixed up front instead of per block. The frames are then sent with
+ * two messages in flight: while the controller clocks out one frame, the
+ * completion of the previous one is handled and the next one is queued.
+ *
+ * @return: 0 on success, else negative error code
+ */
+int sja1105p_cfg_upload(struct spi_device *spi, u32 reg_addr, const u32 *data, int nb_words, int block_words, struct sja1105p_cfg_upload_stats *stats)
+{
+	struct sja1105p_cfg_upload_slot slots[SJA1105P_CFG_UPLOAD_SLOTS];
+	struct sja1105p_cfg_upload_slot *slot;
+	int frame_words = block_words + 1;
+	int nb_blocks;
+	int block;
+	int words;
+	int rc = 0;
+	int i;
+	u32 *frames;
+	u32 *frame;
+	ktime_t t_start, t_framed;
+
+	if (nb_words <= 0 || block_words < 1 || block_words > SJA1105P_CONFIG_WORDS_PER_BLOCK)
+		return -EINVAL;
+
+	nb_blocks = DIV_ROUND_UP(nb_words, block_words);
+
+	t_start = ktime_get();
+
+	/* kmalloc memory is DMA-safe, unlike stack buffers */
+	frames = kmalloc_array(nb_blocks, frame_words * sizeof(u32), GFP_KERNEL);
+	if (!frames)
+		return -ENOMEM;
+
+	for (block = 0; block < nb_blocks; block++) {
+		frame = frames + (block * frame_words);
+		words = min(block_words, nb_words - (block * block_words));
+
+		frame[0] = cpu_to_le32 (CMD_ENCODE_RWOP(CMD_WR_OP) | CMD_ENCODE_ADDR(reg_addr + (block * block_words)));
+		frame[0] = preprocess_words(frame[0]);
+		for (i = 0; i < words; i++)
+			frame[i+1] = preprocess_words(data[(block * block_words) + i]);
+	}
+
+	t_framed = ktime_get();
+
+	for (i = 0; i < SJA1105P_CFG_UPLOAD_SLOTS; i++) {
+		init_completion(&slots[i].done);
+		slots[i].busy = false;
+	}
+
+	for (block = 0; block < nb_blocks; block++) {
+		slot = &slots[block % SJA1105P_CFG_UPLOAD_SLOTS];
+
+		/* reuse the slot of the frame sent two blocks ago */
+		if (slot->busy) {
+			wait_for_completion(&slot->done);
+			slot->busy = false;
+			if (slot->m.status) {
+				rc = slot->m.status;
+				break;
+			}
+		}
+
+		words = min(block_words, nb_words - (block * block_words));
+
+		spi_message_init(&slot->m);
+		memset(&slot->t, 0, sizeof(slot->t));
+		slot->t.tx_buf = frames + (block * frame_words);
+		slot->t.rx_buf = NULL;
+		slot->t.len = ((words + 1) << 2);
+		slot->t.bits_per_word = SPI_BITS_PER_WORD_MSG;
+		spi_message_add_tail(&slot->t, &slot->m);
+		slot->m.complete = sja1105p_cfg_upload_complete;
+		slot->m.context = slot;
+		reinit_completion(&slot->done);
+
+		if (verbosity > 2) dev_info(&spi->dev, "Loading block %d @%08x, %d words\n", block, reg_addr + (block * block_words), words);
+
+		rc = spi_async(spi, &slot->m);
+		if (rc)
+			break;
+		slot->busy = true;
+	}
+
+	/* wait for the frames still in flight, also on error since they use the frame buffer */
+	for (i = 0; i < SJA1105P_CFG_UPLOAD_SLOTS; i++) {
+		if (slots[i].busy) {
+			wait_for_completion(&slots[i].done);
+			if (!rc && slots[i].m.status)
+				rc = slots[i].m.status;
+		}
+	}
+
+	kfree(frames);
+
+	sja1105p_spi_account(sja1105p_spi_device_select(spi), true, nb_blocks, nb_words, t_framed);
+
+	if (rc) dev_err(&spi->dev, "spi_async rc %d\n", rc);
+
+	if (stats) {
+		stats->nb_words = nb_words;
+		stats->nb_blocks = nb_blocks;
+		stats->prepare_us = ktime_us_delta(t_framed, t_start);
+		stats->transfer_us = ktime_us_delta(ktime_get(), t_framed);
+	}
+
+	return rc;
+}
+
+
+/*************************** Platform dependent queue *************************/
+
+/**
+ * sja1105p_spi_xfer_alloc - allocate and encode one command frame of a batch
+ * @write: true for a write frame, false for a read frame
+ * @reg_addr: The register address to start from
+ * @data: The words to write, unused for reads
+ * @nb_words: Number of data words of the frame
+ *
+ * @return: the frame, NULL if allocation failed
+ */
+static struct sja1105p_spi_xfer *sja1105p_spi_xfer_alloc(bool write, u32 reg_addr, u32 *data, int nb_words)
+{
+	struct sja1105p_spi_xfer *xfer;
+	int frame_words = nb_words + 1;
+	int i;
+
+	/* kmalloc memory is DMA-safe, unlike stack buffers */
+	xfer = kzalloc(sizeof(*xfer) + ((write ? 1 : 2) * frame_words * sizeof(u32)), GFP_KERNEL);
+	if (!xfer)
+		return NULL;
+
+	if (write) {
+		xfer->buf[0] = cpu_to_le32 (CMD_ENCODE_RWOP(CMD_WR_OP) | CMD_ENCODE_ADDR(reg_addr));
+		for (i = 0; i < nb_words; i++)
+			xfer->buf[i+1] = preprocess_words(data[i]);
+	} else {
+		xfer->buf[0] = cpu_to_le32 (CMD_ENCODE_RWOP(CMD_RD_OP) | CMD_ENCODE_ADDR(reg_addr) | CMD_ENCODE_WRD_CNT(nb_words));
+		xfer->t.rx_buf = &xfer->buf[frame_words];
+	}
+	xfer->buf[0] = preprocess_words(xfer->buf[0]);
+
+	xfer->t.tx_buf = xfer->buf;
+	xfer->t.len = (frame_words << 2);
+	xfer->t.bits_per_word = SPI_BITS_PER_WORD_MSG;
+	/* the switch delimits command frames by chip select */
+	xfer->t.cs_change = 1;
+	xfer->nb_words = nb_words;
+
+	return xfer;
+}
+
+/**
+ * sja1105p_spi_batch_finish - deliver the results of a transferred batch and release its frames
+ * @batch: The batch
+ * @status: status of the spi_message
+ */
+static void sja1105p_spi_batch_finish(struct sja1105p_spi_batch *batch, int status)
+{
+	struct sja1105p_spi_xfer *xfer;
+	int nb_frames[2] = {0, 0};
+	int nb_words[2] = {0, 0};
+	u32 *resp;
+	int i, j;
+
+	for (i = 0; i < batch->n_xfers; i++) {
+		xfer = batch->xfers[i];
+		if (xfer->dst && !status) {
+			resp = (u32 *)xfer->t.rx_buf;
+			for (j = 0; j < xfer->nb_words; j++)
+				xfer->dst[j] = le32_to_cpu(preprocess_words(resp[j+1]));
+		}
+		nb_frames[xfer->dst ? 0 : 1]++;
+		nb_words[xfer->dst ? 0 : 1] += xfer->nb_words;
+		kfree(xfer);
+	}
+	batch->n_xfers = 0;
+
+	/* the latency of a mixed message is accounted to the reads it was waited for */
+	if (nb_frames[0] > 0) {
+		sja1105p_spi_account(batch->device_select, false, nb_frames[0], nb_words[0], batch->t_submit);
+		if (nb_frames[1] > 0) {
+			atomic64_add(nb_frames[1], &g_spi_stats[batch->device_select][1].transactions);
+			atomic64_add(nb_words[1], &g_spi_stats[batch->device_select][1].words);
+			atomic64_add((nb_frames[1] + nb_words[1]) << 2, &g_spi_stats[batch->device_select][1].bytes);
+		}
+	} else if (nb_frames[1] > 0) {
+		sja1105p_spi_account(batch->device_select, true, nb_frames[1], nb_words[1], batch->t_submit);
+	}
+}
+
+/**
+ * sja1105p_spi_batch_complete - spi_async completion of a committed batch
+ * @context: The batch
+ */
+static void sja1105p_spi_batch_complete(void *context)
+{
+	struct sja1105p_spi_batch *batch = context;
+	struct sja1105p_spi_lock *l = &g_spi_lock[batch->device_select];
+	int status = batch->m.status;
+
+	if (status) dev_err(&batch->m.spi->dev, "spi_async status %d\n", status);
+
+	sja1105p_spi_batch_finish(batch, status);
+	batch->complete(batch->device_select, (status == 0) ? 0 : 1, batch->context);
+	kfree(batch);
+
+	/* the results are delivered, the device may be accessed again */
+	if (atomic_dec_and_test(&l->in_flight))
+		wake_up(&l->idle);
+}
+
+/**
+ * sja1105p_spi_batch_submit - transfer all queued frames of a batch as one spi_message
+ * @spi: The spi device
+ * @batch: The batch
+ * @async: if true, return immediately and notify batch->complete when done,
+ *         the batch is released in completion context
+ *
+ * @return: 0 on success, else spi error code
+ */
+static int sja1105p_spi_batch_submit(struct spi_device *spi, struct sja1105p_spi_batch *batch, bool async)
+{
+	int rc;
+	int i;
+
+	spi_message_init(&batch->m);
+	for (i = 0; i < batch->n_xfers; i++) {
+		/* keep chip select deasserted after the last frame */
+		batch->xfers[i]->t.cs_change = (i < batch->n_xfers - 1);
+		spi_message_add_tail(&batch->xfers[i]->t, &batch->m);
+	}
+
+	if (verbosity > 5) dev_info(&spi->dev, "%s: %d frames, async %d\n", __func__, batch->n_xfers, async);
+
+	batch->t_submit = ktime_get();
+
+	if (async) {
+		batch->m.complete = sja1105p_spi_batch_complete;
+		batch->m.context = batch;
+		/* taken before the submission, the completion may run before spi_async returns */
+		atomic_inc(&g_spi_lock[batch->device_select].in_flight);
+		rc = spi_async(spi, &batch->m);
+		if (rc) {
+			dev_err(&spi->dev, "spi_async rc %d\n", rc);
+			sja1105p_spi_batch_finish(batch, rc);
+			atomic_dec(&g_spi_lock[batch->device_select].in_flight);
+		}
+		return rc;
+	}
+
+	rc = spi_sync(spi, &batch->m);
+	if (rc) dev_err(&spi->dev, "spi_sync rc %d\n", rc);
+
+	sja1105p_spi_batch_finish(batch, rc);
+
+	return rc;
+}
+
+/**
+ * sja1105p_spi_batch_flush - synchronously transfer all queued frames, the batch stays open
+ * @spi: The spi device
+ * @batch: The batch
+ *
+ * @return: 0 on success, else spi error code
+ */
+static int sja1105p_spi_batch_flush(struct spi_device *spi, struct sja1105p_spi_batch *batch)
+{
+	if (batch->n_xfers == 0)
+		return 0;
+
+	return sja1105p_spi_batch_submit(spi, batch, false);
+}
+
+/**
+ * sja1105p_spi_batch_add - append a frame to the open batch of a device
+ * @deviceSelect: The switch ID
+ * @xfer: The frame, released together with the batch
+ *
+ * @return: 0 on success, else failed
+ */
+static int sja1105p_spi_batch_add(uint8_t deviceSelect, struct sja1105p_spi_xfer *xfer)
+{
+	struct sja1105p_spi_batch *batch = g_spi_batch[deviceSelect];
+	int rc = 0;
+
+	if (!xfer)
+		return -ENOMEM;
+
+	/* a full batch is transferred right away, ordering is preserved */
+	if (batch->n_xfers == SJA1105P_SPI_QUEUE_DEPTH)
+		rc = sja1105p_spi_batch_flush(g_spi_h[deviceSelect], batch);
+
+	batch->xfers[batch->n_xfers++] = xfer;
+
+	return rc;
+}
+
+/**
+ * sja1105p_spi_queue_write32 - queue a write to the open batch of a device
+ */
+static uint8_t sja1105p_spi_queue_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	int block_size_words;
+	int rc = 0;
+
+	while (wordCount > 0) {
+		block_size_words = min_t(int, wordCount, SPI_CFG_BLOCKS);
+		rc |= sja1105p_spi_batch_add(deviceSelect, sja1105p_spi_xfer_alloc(true, registerAddress, p_registerValue, block_size_words));
+
+		p_registerValue += block_size_words;
+		registerAddress += block_size_words;
+		wordCount -= block_size_words;
+	}
+
+	return (rc == 0) ? 0 : 1;
+}
+
+/**
+ * sja1105p_spi_queue_read32 - this function is used by the HAL to queue a read to the open batch of a device
+ */
+uint8_t sja1105p_spi_queue_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint8_t ret;
+
+	sja1105p_spi_lock(deviceSelect);
+	ret = __sja1105p_spi_queue_read32(deviceSelect, wordCount, registerAddress, p_registerValue);
+	sja1105p_spi_unlock(deviceSelect);
+
+	return ret;
+}
+
+/* called with the transport lock of the device held */
+static uint8_t __sja1105p_spi_queue_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	struct sja1105p_spi_xfer *xfer;
+	int block_size_words;
+	int rc = 0;
+
+	/* without an open batch, the read is performed immediately */
+	if (!g_spi_batch[deviceSelect])
+		return __sja1105p_spi_read32(deviceSelect, wordCount, registerAddress, p_registerValue);
+
+	while (wordCount > 0) {
+		block_size_words = min_t(int, wordCount, SPI_RD_BLOCKS);
+		xfer = sja1105p_spi_xfer_alloc(false, registerAddress, NULL, block_size_words);
+		if (xfer)
+			xfer->dst = p_registerValue;
+		rc |= sja1105p_spi_batch_add(deviceSelect, xfer);
+
+		p_registerValue += block_size_words;
+		registerAddress += block_size_words;
+		wordCount -= block_size_words;
+	}
+
+	return (rc == 0) ? 0 : 1;
+}
+
+/**
+ * sja1105p_spi_queue_start - this function is used by the HAL to open a batch on a device
+ *
+ * The transport lock of the device is held until the matching commit,
+ * other tasks cannot access the device while the batch is open.
+ */
+uint8_t sja1105p_spi_queue_start(uint8_t deviceSelect)
+{
+	struct sja1105p_spi_batch *batch;
+
+	sja1105p_spi_lock(deviceSelect);
+
+	batch = g_spi_batch[deviceSelect];
+	if (batch) {
+		batch->nesting++;
+		return 0;
+	}
+
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch) {
+		sja1105p_spi_unlock(deviceSelect);
+		return 1;
+	}
+
+	batch->device_select = deviceSelect;
+	batch->nesting = 1;
+	g_spi_batch[deviceSelect] = batch;
+
 	return 0;
 }
+
+/**
+ * sja1105p_spi_queue_commit - this function is used by the HAL to transfer and close the batch of a device
+ *
+ * With pf_complete, the outermost commit returns once the batch is submitted.
+ * Further accesses to the device wait until the completion has delivered the
+ * results of the batch, also when they start after the lock was released.
+ */
+uint8_t sja1105p_spi_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context)
+{
+	uint8_t ret;
+
+	/* only the task which opened the batch holds the lock and may commit it */
+	if (READ_ONCE(g_spi_lock[deviceSelect].owner) != current)
+		return 1;
+
+	ret = __sja1105p_spi_queue_commit(deviceSelect, pf_complete, p_context);
+
+	/* release the lock taken by the matching sja1105p_spi_queue_start */
+	sja1105p_spi_unlock(deviceSelect);
+
+	return ret;
+}
+
+/* called with the transport lock of the device held */
+static uint8_t __sja1105p_spi_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context)
+{
+	struct spi_device *spi = g_spi_h[deviceSelect];
+	struct sja1105p_spi_batch *batch = g_spi_batch[deviceSelect];
+	int rc;
+
+	if (!batch)
+		return 1;
+
+	if (--batch->nesting > 0) {
+		/* nested commit: transfer what was queued so far, the outer batch stays open */
+		rc = sja1105p_spi_batch_flush(spi, batch);
+		if (pf_complete)
+			pf_complete(deviceSelect, (rc == 0) ? 0 : 1, p_context);
+		return (rc == 0) ? 0 : 1;
+	}
+
+	g_spi_batch[deviceSelect] = NULL;
+
+	if (pf_complete && batch->n_xfers > 0) {
+		/* the batch is released by the completion handler */
+		batch->complete = pf_complete;
+		batch->context = p_context;
+		rc = sja1105p_spi_batch_submit(spi, batch, true);
+		if (rc) {
+			kfree(batch);
+			pf_complete(deviceSelect, 1, p_context);
+		}
+		return (rc == 0) ? 0 : 1;
+	}
+
+	rc = sja1105p_spi_batch_flush(spi, batch);
+	kfree(batch);
+	if (pf_complete)
+		pf_complete(deviceSelect, (rc == 0) ? 0 : 1, p_context);
+
+	return (rc == 0) ? 0 : 1;
+}
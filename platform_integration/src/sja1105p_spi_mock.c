@@ -0,0 +1,288 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file  sja1105p_spi_mock.c
+*
+* \author NXP Semiconductors
+*
+* \brief In-memory SPI backend of the HAL
+*
+* Every switch is modelled as a plain array of registers. Dynamic
+* reconfiguration commands complete as soon as they are written, i.e. the
+* VALID flag of the control register is cleared. The static configuration
+* upload, PHY/CGU settings and counters are not modelled. An access hook can be
+* installed to add behaviour on top of the register memory.
+*
+*****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "NXP_SJA1105P_spi.h"
+#include "NXP_SJA1105P_config.h"
+#include "sja1105p_spi_mock.h"
+
+#define SJA1105P_MOCK_VALID_FLAG (1UL << 31)
+
+/* control registers of the dynamic reconfiguration interface, VALID is bit 31 */
+static const uint32_t gk_mockControlRegs[] = {
+	0x18,    /* ptpControl2 */
+	0x29,    /* l2AddressLookupTableControl */
+	0x2c,    /* l2ForwardingTableControl */
+	0x30,    /* vlanLookupTableControl */
+	0x37,    /* creditBasedShapingControl */
+	0x3a,    /* retaggingTableControl */
+	0x46,    /* generalParametersControl */
+	0x53,    /* macCfgTableControl */
+	0x58,    /* l2LookupParametersControl */
+	0x8007,  /* avbParametersControl */
+};
+
+static uint32_t *g_mockRegs[SJA1105P_N_SWITCHES];
+static pthread_mutex_t g_mockLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static int g_mockNesting[SJA1105P_N_SWITCHES];
+
+static struct sja1105p_mock_stats g_mockStats[SJA1105P_N_SWITCHES];
+
+static sja1105p_mock_hook_t g_mockHook;
+static void *g_mockHookContext;
+
+uint8_t sja1105p_mock_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_mock_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_mock_queue_start(uint8_t deviceSelect);
+uint8_t sja1105p_mock_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context);
+static uint64_t sja1105p_mock_get_time_ns(void);
+
+static int sja1105p_mock_is_control(uint32_t reg_addr)
+{
+	unsigned i;
+
+	for (i = 0; i < sizeof(gk_mockControlRegs) / sizeof(gk_mockControlRegs[0]); i++)
+		if (gk_mockControlRegs[i] == reg_addr)
+			return 1;
+
+	return 0;
+}
+
+/* register memory is only allocated on first access to keep unused switches cheap */
+static uint32_t *sja1105p_mock_regs(uint8_t deviceSelect)
+{
+	if (deviceSelect >= SJA1105P_N_SWITCHES)
+		return NULL;
+
+	if (!g_mockRegs[deviceSelect])
+		g_mockRegs[deviceSelect] = calloc(SJA1105P_MOCK_ADDR_SPACE, sizeof(uint32_t));
+
+	return g_mockRegs[deviceSelect];
+}
+
+static uint64_t sja1105p_mock_get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************** Mock handling *************************************/
+
+void sja1105p_mock_register(void)
+{
+	SJA1105P_registerSpiRead32CB(sja1105p_mock_read32);
+	SJA1105P_registerSpiWrite32CB(sja1105p_mock_write32);
+	SJA1105P_registerSpiQueueStartCB(sja1105p_mock_queue_start);
+	/* a queued read completes right away, just as a plain read */
+	SJA1105P_registerSpiQueueRead32CB(sja1105p_mock_read32);
+	SJA1105P_registerSpiQueueCommitCB(sja1105p_mock_queue_commit);
+	/* commands complete on the write, no wait callback is needed */
+	SJA1105P_registerGetTimeNsCB(sja1105p_mock_get_time_ns);
+}
+
+void sja1105p_mock_unregister(void)
+{
+	int i;
+
+	SJA1105P_registerSpiRead32CB(NULL);
+	SJA1105P_registerSpiWrite32CB(NULL);
+	SJA1105P_registerSpiQueueStartCB(NULL);
+	SJA1105P_registerSpiQueueRead32CB(NULL);
+	SJA1105P_registerSpiQueueCommitCB(NULL);
+	SJA1105P_registerGetTimeNsCB(NULL);
+
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+		free(g_mockRegs[i]);
+		g_mockRegs[i] = NULL;
+	}
+}
+
+/**
+ * sja1105p_mock_reset - clear the register memory of all switches
+ */
+void sja1105p_mock_reset(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_mockLock);
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++)
+		if (g_mockRegs[i])
+			memset(g_mockRegs[i], 0, SJA1105P_MOCK_ADDR_SPACE * sizeof(uint32_t));
+	pthread_mutex_unlock(&g_mockLock);
+}
+
+/**
+ * sja1105p_mock_get_stats - SPI cost accumulated since the last reset
+ * @deviceSelect: The switch ID
+ * @p_stats: Destination of the counters
+ *
+ * Taking the difference of two calls around a HAL function gives its cost.
+ */
+void sja1105p_mock_get_stats(uint8_t deviceSelect, struct sja1105p_mock_stats *p_stats)
+{
+	pthread_mutex_lock(&g_mockLock);
+	if (deviceSelect < SJA1105P_N_SWITCHES)
+		*p_stats = g_mockStats[deviceSelect];
+	else
+		memset(p_stats, 0, sizeof(*p_stats));
+	pthread_mutex_unlock(&g_mockLock);
+}
+
+void sja1105p_mock_reset_stats(void)
+{
+	pthread_mutex_lock(&g_mockLock);
+	memset(g_mockStats, 0, sizeof(g_mockStats));
+	pthread_mutex_unlock(&g_mockLock);
+}
+
+/**
+ * sja1105p_mock_registers - direct access to the register memory of a switch
+ * @deviceSelect: The switch ID
+ *
+ * @return: SJA1105P_MOCK_ADDR_SPACE words, NULL on failure
+ */
+uint32_t *sja1105p_mock_registers(uint8_t deviceSelect)
+{
+	uint32_t *regs;
+
+	pthread_mutex_lock(&g_mockLock);
+	regs = sja1105p_mock_regs(deviceSelect);
+	pthread_mutex_unlock(&g_mockLock);
+
+	return regs;
+}
+
+void sja1105p_mock_set_hook(sja1105p_mock_hook_t pf_hook, void *p_context)
+{
+	pthread_mutex_lock(&g_mockLock);
+	g_mockHook = pf_hook;
+	g_mockHookContext = p_context;
+	pthread_mutex_unlock(&g_mockLock);
+}
+
+/************************** HAL callbacks *************************************/
+
+uint8_t sja1105p_mock_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint32_t *regs;
+	uint32_t addr;
+	int i;
+
+	pthread_mutex_lock(&g_mockLock);
+	regs = sja1105p_mock_regs(deviceSelect);
+	if (!regs) {
+		pthread_mutex_unlock(&g_mockLock);
+		return 1;
+	}
+
+	g_mockStats[deviceSelect].rd_transactions++;
+	g_mockStats[deviceSelect].rd_frames += (wordCount + SPI_RD_BLOCKS - 1) / SPI_RD_BLOCKS;
+	g_mockStats[deviceSelect].rd_words += wordCount;
+
+	for (i = 0; i < wordCount; i++) {
+		addr = (registerAddress + i) & (SJA1105P_MOCK_ADDR_SPACE - 1);
+		if (g_mockHook)
+			g_mockHook(deviceSelect, 0, addr, regs, g_mockHookContext);
+		p_registerValue[i] = regs[addr];
+	}
+	pthread_mutex_unlock(&g_mockLock);
+
+	return 0;
+}
+
+uint8_t sja1105p_mock_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	uint32_t *regs;
+	uint32_t addr;
+	int i;
+
+	pthread_mutex_lock(&g_mockLock);
+	regs = sja1105p_mock_regs(deviceSelect);
+	if (!regs) {
+		pthread_mutex_unlock(&g_mockLock);
+		return 1;
+	}
+
+	g_mockStats[deviceSelect].wr_transactions++;
+	g_mockStats[deviceSelect].wr_frames += (wordCount + SPI_CFG_BLOCKS - 1) / SPI_CFG_BLOCKS;
+	g_mockStats[deviceSelect].wr_words += wordCount;
+
+	for (i = 0; i < wordCount; i++) {
+		addr = (registerAddress + i) & (SJA1105P_MOCK_ADDR_SPACE - 1);
+		regs[addr] = p_registerValue[i];
+		if (g_mockHook)
+			g_mockHook(deviceSelect, 1, addr, regs, g_mockHookContext);
+		/* the command was executed, the switch clears VALID */
+		if (sja1105p_mock_is_control(addr))
+			regs[addr] &= ~SJA1105P_MOCK_VALID_FLAG;
+	}
+	pthread_mutex_unlock(&g_mockLock);
+
+	return 0;
+}
+
+uint8_t sja1105p_mock_queue_start(uint8_t deviceSelect)
+{
+	if (deviceSelect >= SJA1105P_N_SWITCHES)
+		return 1;
+
+	/* held until the matching commit, as by the hardware backends */
+	pthread_mutex_lock(&g_mockLock);
+	g_mockNesting[deviceSelect]++;
+
+	return 0;
+}
+
+uint8_t sja1105p_mock_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context)
+{
+	if ((deviceSelect >= SJA1105P_N_SWITCHES) || (g_mockNesting[deviceSelect] == 0))
+		return 1;
+
+	/* a nested commit transfers nothing here, only the outermost one is a batch */
+	if (--g_mockNesting[deviceSelect] == 0)
+		g_mockStats[deviceSelect].batches++;
+
+	if (pf_complete)
+		pf_complete(deviceSelect, 0, p_context);
+
+	pthread_mutex_unlock(&g_mockLock);
+
+	return 0;
+}
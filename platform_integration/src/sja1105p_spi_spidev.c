@@ -0,0 +1,458 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file  sja1105p_spi_spidev.c
+*
+* \author NXP Semiconductors
+*
+* \brief Userspace SPI read and write functions over /dev/spidevX.Y
+*
+* Command frames are collected and transferred with a single SPI_IOC_MESSAGE
+* ioctl, each frame delimited by chip select. Frames are only collected as long
+* as they fit into the spidev buffer (bufsiz module parameter of spidev).
+*
+*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <endian.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+#include "NXP_SJA1105P_spi.h"
+#include "NXP_SJA1105P_config.h"
+#include "sja1105p_spi_frame.h"
+#include "sja1105p_spi_spidev.h"
+
+#if (SPI_RD_BLOCKS < 1) || (SPI_RD_BLOCKS > SJA1105P_CONFIG_WORDS_PER_BLOCK)
+#error "SPI_RD_BLOCKS must be in the range 1..SJA1105P_CONFIG_WORDS_PER_BLOCK"
+#endif
+
+/* maximum number of command frames transferred by one ioctl */
+#define SJA1105P_SPIDEV_MAX_XFERS 64
+
+/* default of the spidev bufsiz module parameter */
+#define SJA1105P_SPIDEV_DEFAULT_BUFSIZ 4096
+#define SJA1105P_SPIDEV_BUFSIZ_PARAM "/sys/module/spidev/parameters/bufsiz"
+
+/* largest command frame in bytes */
+#define SJA1105P_SPIDEV_MAX_FRAME ((SJA1105P_CONFIG_WORDS_PER_BLOCK + 1) << 2)
+
+/* one collected device */
+struct sja1105p_spidev {
+	int fd;
+	uint32_t speed_hz;
+	pthread_mutex_t lock;      /**< recursive, held from queue start to the matching commit */
+	int nesting;               /**< number of open batches, 0 if frames are transferred right away */
+
+	struct spi_ioc_transfer t[SJA1105P_SPIDEV_MAX_XFERS];
+	uint32_t *dst[SJA1105P_SPIDEV_MAX_XFERS];  /**< destination of a read frame, NULL for writes */
+	int n_xfers;
+
+	uint8_t *tx;               /**< frame memory, bufsiz bytes */
+	uint8_t *rx;               /**< response memory, bufsiz bytes */
+	size_t bufsiz;
+	size_t n_bytes;            /**< bytes used by the collected frames */
+};
+
+static struct sja1105p_spidev g_spidev[SJA1105P_N_SWITCHES] = {
+	[0 ... SJA1105P_N_SWITCHES - 1] = { .fd = -1 }
+};
+
+uint8_t sja1105p_spidev_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_spidev_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_spidev_queue_start(uint8_t deviceSelect);
+uint8_t sja1105p_spidev_queue_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue);
+uint8_t sja1105p_spidev_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context);
+static void sja1105p_spidev_wait_us(uint32_t waitUs);
+static uint64_t sja1105p_spidev_get_time_ns(void);
+
+/* helper function, the word order needs to be switched for some platforms */
+static uint32_t preprocess_words(uint32_t cmd)
+{
+#if SPI_SWITCH_WORDS == 1
+	uint32_t upper, lower;
+	upper = (cmd & 0x0000FFFF) << 16;
+	lower = (cmd & 0xFFFF0000) >> 16;
+	cmd = upper | lower;
+#endif
+
+	return cmd;
+}
+
+/* the spidev buffer limits the total length of all transfers of one ioctl */
+static size_t sja1105p_spidev_bufsiz(void)
+{
+	FILE *f;
+	unsigned long bufsiz = SJA1105P_SPIDEV_DEFAULT_BUFSIZ;
+
+	f = fopen(SJA1105P_SPIDEV_BUFSIZ_PARAM, "r");
+	if (f) {
+		if (fscanf(f, "%lu", &bufsiz) != 1)
+			bufsiz = SJA1105P_SPIDEV_DEFAULT_BUFSIZ;
+		fclose(f);
+	}
+
+	return (bufsiz < SJA1105P_SPIDEV_MAX_FRAME) ? SJA1105P_SPIDEV_MAX_FRAME : bufsiz;
+}
+
+/************************** Device handling ***********************************/
+
+/**
+ * sja1105p_spidev_open - attach a switch to a spidev node
+ * @deviceSelect: The switch ID
+ * @path: The spidev node, e.g. /dev/spidev0.0
+ * @speed_hz: SPI clock, 0 selects SPI_FREQUENCY
+ *
+ * @return: 0 on success, else negative errno
+ */
+int sja1105p_spidev_open(uint8_t deviceSelect, const char *path, uint32_t speed_hz)
+{
+	struct sja1105p_spidev *dev;
+	pthread_mutexattr_t attr;
+	uint8_t mode = SPI_MODE_1;
+	uint8_t bits = SPI_BITS_PER_WORD;
+
+	if (deviceSelect >= SJA1105P_N_SWITCHES)
+		return -EINVAL;
+
+	dev = &g_spidev[deviceSelect];
+	if (dev->fd >= 0)
+		return -EBUSY;
+
+	dev->speed_hz = (speed_hz != 0) ? speed_hz : SPI_FREQUENCY;
+
+	dev->fd = open(path, O_RDWR);
+	if (dev->fd < 0)
+		return -errno;
+
+	if (ioctl(dev->fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+	    ioctl(dev->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+	    ioctl(dev->fd, SPI_IOC_WR_MAX_SPEED_HZ, &dev->speed_hz) < 0)
+		goto err_close;
+
+	dev->bufsiz = sja1105p_spidev_bufsiz();
+	dev->tx = calloc(1, dev->bufsiz);
+	dev->rx = calloc(1, dev->bufsiz);
+	if (!dev->tx || !dev->rx) {
+		errno = ENOMEM;
+		goto err_free;
+	}
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&dev->lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	dev->nesting = 0;
+	dev->n_xfers = 0;
+	dev->n_bytes = 0;
+
+	return 0;
+
+err_free:
+	free(dev->tx);
+	free(dev->rx);
+	dev->tx = NULL;
+	dev->rx = NULL;
+err_close:
+	close(dev->fd);
+	dev->fd = -1;
+	return -errno;
+}
+
+/**
+ * sja1105p_spidev_close - detach a switch from its spidev node
+ * @deviceSelect: The switch ID
+ */
+void sja1105p_spidev_close(uint8_t deviceSelect)
+{
+	struct sja1105p_spidev *dev;
+
+	if (deviceSelect >= SJA1105P_N_SWITCHES)
+		return;
+
+	dev = &g_spidev[deviceSelect];
+	if (dev->fd < 0)
+		return;
+
+	close(dev->fd);
+	dev->fd = -1;
+	pthread_mutex_destroy(&dev->lock);
+	free(dev->tx);
+	free(dev->rx);
+	dev->tx = NULL;
+	dev->rx = NULL;
+}
+
+/************************** HAL Callback registration *************************/
+
+void sja1105p_spidev_register(void)
+{
+	SJA1105P_registerSpiRead32CB(sja1105p_spidev_read32);
+	SJA1105P_registerSpiWrite32CB(sja1105p_spidev_write32);
+	SJA1105P_registerSpiQueueStartCB(sja1105p_spidev_queue_start);
+	SJA1105P_registerSpiQueueRead32CB(sja1105p_spidev_queue_read32);
+	SJA1105P_registerSpiQueueCommitCB(sja1105p_spidev_queue_commit);
+	SJA1105P_registerWaitUsCB(sja1105p_spidev_wait_us);
+	SJA1105P_registerGetTimeNsCB(sja1105p_spidev_get_time_ns);
+}
+
+void sja1105p_spidev_unregister(void)
+{
+	SJA1105P_registerSpiRead32CB(NULL);
+	SJA1105P_registerSpiWrite32CB(NULL);
+	SJA1105P_registerSpiQueueStartCB(NULL);
+	SJA1105P_registerSpiQueueRead32CB(NULL);
+	SJA1105P_registerSpiQueueCommitCB(NULL);
+	SJA1105P_registerWaitUsCB(NULL);
+	SJA1105P_registerGetTimeNsCB(NULL);
+}
+
+/************************** Reconfiguration polling ***************************/
+
+static void sja1105p_spidev_wait_us(uint32_t waitUs)
+{
+	struct timespec ts = { .tv_sec = waitUs / 1000000, .tv_nsec = (long) (waitUs % 1000000) * 1000 };
+
+	nanosleep(&ts, NULL);
+}
+
+static uint64_t sja1105p_spidev_get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/************************** Frame collection **********************************/
+
+/**
+ * sja1105p_spidev_flush - transfer all collected frames with a single ioctl
+ * @dev: The device, locked
+ *
+ * @return: 0 on success, else 1
+ */
+static uint8_t sja1105p_spidev_flush(struct sja1105p_spidev *dev)
+{
+	uint32_t *resp;
+	int nb_words;
+	int rc;
+	int i, j;
+
+	if (dev->n_xfers == 0)
+		return 0;
+
+	/* keep chip select deasserted after the last frame */
+	dev->t[dev->n_xfers - 1].cs_change = 0;
+
+	rc = ioctl(dev->fd, SPI_IOC_MESSAGE(dev->n_xfers), dev->t);
+	if (rc < 0)
+		fprintf(stderr, "sja1105p: SPI_IOC_MESSAGE(%d) failed: %s\n", dev->n_xfers, strerror(errno));
+
+	for (i = 0; (i < dev->n_xfers) && (rc >= 0); i++) {
+		if (!dev->dst[i])
+			continue;
+		/* first word received is clocked out during the command phase */
+		resp = (uint32_t *)(uintptr_t)dev->t[i].rx_buf;
+		nb_words = (dev->t[i].len >> 2) - 1;
+		for (j = 0; j < nb_words; j++)
+			dev->dst[i][j] = le32toh(preprocess_words(resp[j+1]));
+	}
+
+	dev->n_xfers = 0;
+	dev->n_bytes = 0;
+
+	return (rc < 0) ? 1 : 0;
+}
+
+/**
+ * sja1105p_spidev_add - append one command frame, flushing first if it does not fit
+ * @dev: The device, locked
+ * @write: true for a write frame
+ * @reg_addr: The register address to start from
+ * @data: The words to write, unused for reads
+ * @dst: The destination of a read, unused for writes
+ * @nb_words: Number of data words of the frame
+ *
+ * @return: 0 on success, else 1
+ */
+static uint8_t sja1105p_spidev_add(struct sja1105p_spidev *dev, int write, uint32_t reg_addr, const uint32_t *data, uint32_t *dst, int nb_words)
+{
+	struct spi_ioc_transfer t;
+	uint32_t *frame;
+	uint8_t ret = 0;
+	int i;
+
+	memset(&t, 0, sizeof(t));
+	t.len = (nb_words + 1) << 2;
+
+	if ((dev->n_xfers == SJA1105P_SPIDEV_MAX_XFERS) || (dev->n_bytes + t.len > dev->bufsiz))
+		ret = sja1105p_spidev_flush(dev);
+
+	frame = (uint32_t *)(dev->tx + dev->n_bytes);
+	if (write) {
+		frame[0] = htole32(CMD_ENCODE_RWOP(CMD_WR_OP) | CMD_ENCODE_ADDR(reg_addr));
+		for (i = 0; i < nb_words; i++)
+			frame[i+1] = preprocess_words(data[i]);
+	} else {
+		frame[0] = htole32(CMD_ENCODE_RWOP(CMD_RD_OP) | CMD_ENCODE_ADDR(reg_addr) | CMD_ENCODE_WRD_CNT(nb_words));
+		memset(&frame[1], 0, nb_words << 2);
+		t.rx_buf = (uintptr_t)(dev->rx + dev->n_bytes);
+	}
+	frame[0] = preprocess_words(frame[0]);
+
+	t.tx_buf = (uintptr_t)frame;
+	t.speed_hz = dev->speed_hz;
+	t.bits_per_word = SPI_BITS_PER_WORD_MSG;
+	/* the switch delimits command frames by chip select */
+	t.cs_change = 1;
+
+	dev->t[dev->n_xfers] = t;
+	dev->dst[dev->n_xfers] = write ? NULL : dst;
+	dev->n_xfers++;
+	dev->n_bytes += t.len;
+
+	return ret;
+}
+
+/* split an access into frames of at most block_words words */
+static uint8_t sja1105p_spidev_add_split(struct sja1105p_spidev *dev, int write, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue, int block_words)
+{
+	uint8_t ret = 0;
+	int block_size_words;
+
+	while (wordCount > 0) {
+		block_size_words = (wordCount < block_words) ? wordCount : block_words;
+		ret |= sja1105p_spidev_add(dev, write, registerAddress, p_registerValue, p_registerValue, block_size_words);
+
+		p_registerValue += block_size_words;
+		registerAddress += block_size_words;
+		wordCount -= block_size_words;
+	}
+
+	return ret;
+}
+
+/************************** HAL callbacks *************************************/
+
+/**
+ * sja1105p_spidev_read32 - this function is used by the HAL to read data from SJA1105
+ *
+ * Frames collected in an open batch are transferred together with the read.
+ */
+uint8_t sja1105p_spidev_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	struct sja1105p_spidev *dev = &g_spidev[deviceSelect];
+	uint8_t ret;
+
+	pthread_mutex_lock(&dev->lock);
+	ret  = sja1105p_spidev_add_split(dev, 0, wordCount, registerAddress, p_registerValue, SPI_RD_BLOCKS);
+	ret |= sja1105p_spidev_flush(dev);
+	pthread_mutex_unlock(&dev->lock);
+
+	return ret;
+}
+
+/**
+ * sja1105p_spidev_write32 - this function is used by the HAL to write data to SJA1105
+ */
+uint8_t sja1105p_spidev_write32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	struct sja1105p_spidev *dev = &g_spidev[deviceSelect];
+	uint8_t ret;
+
+	pthread_mutex_lock(&dev->lock);
+	ret = sja1105p_spidev_add_split(dev, 1, wordCount, registerAddress, p_registerValue, SPI_CFG_BLOCKS);
+	if (dev->nesting == 0)
+		ret |= sja1105p_spidev_flush(dev);
+	pthread_mutex_unlock(&dev->lock);
+
+	return ret;
+}
+
+/**
+ * sja1105p_spidev_queue_read32 - this function is used by the HAL to queue a read to the open batch of a device
+ */
+uint8_t sja1105p_spidev_queue_read32(uint8_t deviceSelect, uint8_t wordCount, uint32_t registerAddress, uint32_t *p_registerValue)
+{
+	struct sja1105p_spidev *dev = &g_spidev[deviceSelect];
+	uint8_t ret;
+
+	pthread_mutex_lock(&dev->lock);
+	ret = sja1105p_spidev_add_split(dev, 0, wordCount, registerAddress, p_registerValue, SPI_RD_BLOCKS);
+	if (dev->nesting == 0)
+		ret |= sja1105p_spidev_flush(dev);
+	pthread_mutex_unlock(&dev->lock);
+
+	return ret;
+}
+
+/**
+ * sja1105p_spidev_queue_start - this function is used by the HAL to open a batch on a device
+ *
+ * The device lock is held until the matching commit.
+ */
+uint8_t sja1105p_spidev_queue_start(uint8_t deviceSelect)
+{
+	struct sja1105p_spidev *dev = &g_spidev[deviceSelect];
+
+	pthread_mutex_lock(&dev->lock);
+	dev->nesting++;
+
+	return 0;
+}
+
+/**
+ * sja1105p_spidev_queue_commit - this function is used by the HAL to transfer and close the batch of a device
+ *
+ * The transfer is always synchronous, pf_complete is called before returning.
+ */
+uint8_t sja1105p_spidev_queue_commit(uint8_t deviceSelect, SJA1105P_spiComplete_cb_t pf_complete, void *p_context)
+{
+	struct sja1105p_spidev *dev = &g_spidev[deviceSelect];
+	uint8_t ret;
+
+	/* nesting is owned by the lock holder, as in sja1105p_spidev_queue_start */
+	pthread_mutex_lock(&dev->lock);
+	if (dev->nesting == 0) {
+		pthread_mutex_unlock(&dev->lock);
+		return 1;
+	}
+
+	ret = sja1105p_spidev_flush(dev);
+	dev->nesting--;
+
+	if (pf_complete)
+		pf_complete(deviceSelect, ret, p_context);
+
+	/* release the lock taken above and the one taken by the matching sja1105p_spidev_queue_start */
+	pthread_mutex_unlock(&dev->lock);
+	pthread_mutex_unlock(&dev->lock);
+
+	return ret;
+}
@@ -0,0 +1,524 @@
+/*
+* AVB switch driver module for SJA1105
+* Copyright (C) 2017 NXP Semiconductors
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+/**
+*
+* \file  sja1105p_switch_model.c
+*
+* \author NXP Semiconductors
+*
+* \brief Software model of the SJA1105P/Q/R/S register file
+*
+* The model is installed as access hook of the mock SPI backend and adds the
+* behaviour of the switch on top of its plain register memory:
+*   - device ID and product ID registers
+*   - the configuration area, written as a stream starting at 0x20000. The
+*     configuration is accepted if its first word matches the device ID,
+*     CRCs are not checked and the tables are not parsed.
+*   - the L2 address lookup TCAM (READ, WRITE, SEARCH, INVALIDATE of static
+*     entries and management routes)
+*   - the dynamic reconfiguration interfaces of the L2 forwarding, VLAN
+*     lookup, credit based shaping, retagging, general parameters, MAC
+*     configuration, L2 lookup parameters and AVB parameters tables
+*   - the PTP clock, running at the host clock scaled by PTPCLKRATE, with
+*     add/subtract mode, reset and the shadow register of cascaded sync
+* Counters and all remaining registers are plain memory, they can be preset
+* through sja1105p_mock_registers().
+*
+*****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "NXP_SJA1105P_spi.h"
+#include "NXP_SJA1105P_config.h"
+#include "sja1105p_switch_model.h"
+
+#define MODEL_VALID (1UL << 31)
+
+/* device identification */
+#define MODEL_D_ID_ADDR    0x0
+#define MODEL_PROD_ID_ADDR 0x100bc3
+#define MODEL_PROD_ID_PART_NR_SHIFT 4
+#define MODEL_DEVICE_ID_PR 0xAF00030EU
+#define MODEL_DEVICE_ID_QS 0xAE00030EU
+
+/* configuration area and configuration flags */
+#define MODEL_CONFIG_START 0x20000UL
+#define MODEL_CONFIG_END   0x30000UL
+#define MODEL_CF_ADDR      0x1
+#define MODEL_CF_CONFIGS   (1UL << 31)
+#define MODEL_CF_IDS       (1UL << 29)
+
+/* L2 address lookup table */
+#define MODEL_ART_ADDR       0x24
+#define MODEL_ART_WORDS      5
+#define MODEL_ART_INDEX_MASK 0x0000FFC0U
+#define MODEL_ART_INDEX_SHIFT 6
+#define MODEL_ALTC_ADDR      0x29
+#define MODEL_ALTC_RDWRSET   (1UL << 30)
+#define MODEL_ALTC_ERRORS    (1UL << 29)
+#define MODEL_ALTC_LOCKEDS   (1UL << 28)
+#define MODEL_ALTC_VALIDENT  (1UL << 27)
+#define MODEL_ALTC_MGMTROUTE (1UL << 26)
+#define MODEL_ALTC_HOST_CMD_SHIFT 23
+#define MODEL_ALTC_HOST_CMD_MASK  0x7U
+#define MODEL_N_ARL_ENTRIES  1024
+#define MODEL_N_MGMT_ROUTES  SJA1105P_N_MGMT_ROUTES
+
+#define MODEL_HOST_CMD_SEARCH 1U
+#define MODEL_HOST_CMD_READ   2U
+#define MODEL_HOST_CMD_WRITE  3U
+
+/* PTP */
+#define MODEL_PTP_C_2_ADDR 0x18
+#define MODEL_PTP_C_3_ADDR 0x19  /* PTPCLKVAL, 2 words */
+#define MODEL_PTP_C_4_ADDR 0x1b  /* PTPCLKRATE */
+#define MODEL_PTP_C_5_ADDR 0x1c  /* PTPTSCLK, 2 words */
+#define MODEL_PTP_C_6_ADDR 0x1f  /* PTPTSSHADOW, 2 words */
+#define MODEL_PTP_SYNC_CASCADED (1UL << 26)
+#define MODEL_PTP_RESPTP        (1UL << 3)
+#define MODEL_PTP_CLKSUB        (1UL << 1)
+#define MODEL_PTP_CLKADD        (1UL << 0)
+#define MODEL_PTP_RATIO_ONE     0x80000000U
+#define MODEL_PTP_TICK_NS       8
+
+/* table behind a dynamic reconfiguration interface */
+struct model_table_desc {
+	uint32_t ctrl_addr;
+	uint32_t entry_addr;
+	uint8_t  entry_words;
+	uint16_t n_entries;
+	uint32_t index_mask;  /**< index field of the control register, 0 if single entry or VLAN table */
+	uint32_t rdwrset;
+	uint32_t valident;    /**< 0 if the table has no valid flag per entry */
+	uint32_t errors;      /**< 0 if the control register has no error flag */
+};
+
+enum model_table_id {
+	MODEL_L2_FWD,
+	MODEL_VLAN,
+	MODEL_CBS,
+	MODEL_RETAG,
+	MODEL_GENERAL,
+	MODEL_MAC_CFG,
+	MODEL_L2_LOOKUP,
+	MODEL_AVB,
+	MODEL_N_TABLES
+};
+
+static const struct model_table_desc gk_tables[MODEL_N_TABLES] = {
+	[MODEL_L2_FWD]    = { 0x2c,   0x2a,   2,  32,                      0x1f, 1UL << 29, 0,         1UL << 30 },
+	[MODEL_VLAN]      = { 0x30,   0x2d,   2,  SJA1105P_N_VLAN_ENTRIES, 0,    1UL << 30, 1UL << 27, 0 },
+	[MODEL_CBS]       = { 0x37,   0x32,   5,  16,                      0x0f, 1UL << 30, 0,         1UL << 29 },
+	[MODEL_RETAG]     = { 0x3a,   0x38,   2,  SJA1105P_N_RETAG_ENTRIES, 0x3f, 1UL << 28, 1UL << 29, 1UL << 30 },
+	[MODEL_GENERAL]   = { 0x46,   0x3b,   11, 1,                       0,    1UL << 28, 0,         1UL << 30 },
+	[MODEL_MAC_CFG]   = { 0x53,   0x4b,   8,  SJA1105P_N_PORTS,        0x1f, 1UL << 29, 0,         1UL << 30 },
+	[MODEL_L2_LOOKUP] = { 0x58,   0x54,   4,  1,                       0,    1UL << 30, 0,         0 },
+	[MODEL_AVB]       = { 0x8007, 0x8003, 4,  1,                       0,    1UL << 29, 0,         1UL << 30 },
+};
+
+struct model_table {
+	uint32_t *data;
+	uint8_t  *valid;
+};
+
+struct model_switch {
+	uint32_t device_id;
+	uint32_t cfg_first_word;
+	uint32_t cfg_words;
+
+	uint32_t art[MODEL_N_ARL_ENTRIES][MODEL_ART_WORDS];
+	uint8_t  art_valid[MODEL_N_ARL_ENTRIES];
+	uint8_t  art_locked[MODEL_N_ARL_ENTRIES];
+	uint32_t mgmt[MODEL_N_MGMT_ROUTES][MODEL_ART_WORDS];
+	uint8_t  mgmt_valid[MODEL_N_MGMT_ROUTES];
+
+	struct model_table tables[MODEL_N_TABLES];
+
+	uint64_t ptp_clk;      /**< corrected clock in 8 ns ticks, PTPCLKVAL */
+	uint64_t ptp_ts_clk;   /**< uncorrected clock in 8 ns ticks, PTPTSCLK */
+	uint64_t ptp_host_ns;  /**< host time of the last update of both clocks */
+	uint32_t ptp_ratio;
+};
+
+static struct model_switch *g_model[SJA1105P_N_SWITCHES];
+static SJA1105P_partNr_t g_modelPartNr;
+
+static void model_hook(uint8_t deviceSelect, int write, uint32_t reg_addr, uint32_t *p_regs, void *p_context);
+
+static uint64_t model_host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void model_write64(uint32_t *p_regs, uint32_t reg_addr, uint64_t value)
+{
+	p_regs[reg_addr]     = (uint32_t) value;
+	p_regs[reg_addr + 1] = (uint32_t) (value >> 32);
+}
+
+static uint64_t model_read64(const uint32_t *p_regs, uint32_t reg_addr)
+{
+	return (uint64_t) p_regs[reg_addr] | ((uint64_t) p_regs[reg_addr + 1] << 32);
+}
+
+static void model_init_switch(struct model_switch *sw, uint32_t *p_regs)
+{
+	int t;
+
+	for (t = 0; t < MODEL_N_TABLES; t++) {
+		memset(sw->tables[t].data, 0, gk_tables[t].n_entries * gk_tables[t].entry_words * sizeof(uint32_t));
+		memset(sw->tables[t].valid, 0, gk_tables[t].n_entries);
+	}
+	memset(sw->art_valid, 0, sizeof(sw->art_valid));
+	memset(sw->art_locked, 0, sizeof(sw->art_locked));
+	memset(sw->mgmt_valid, 0, sizeof(sw->mgmt_valid));
+
+	sw->device_id = ((g_modelPartNr == SJA1105P_e_partNr_SJA1105P) || (g_modelPartNr == SJA1105P_e_partNr_SJA1105R)) ?
+			MODEL_DEVICE_ID_PR : MODEL_DEVICE_ID_QS;
+	sw->cfg_first_word = 0;
+	sw->cfg_words = 0;
+
+	sw->ptp_clk = 0;
+	sw->ptp_ts_clk = 0;
+	sw->ptp_host_ns = model_host_ns();
+	sw->ptp_ratio = MODEL_PTP_RATIO_ONE;
+
+	p_regs[MODEL_D_ID_ADDR] = sw->device_id;
+	p_regs[MODEL_PROD_ID_ADDR] = (uint32_t) g_modelPartNr << MODEL_PROD_ID_PART_NR_SHIFT;
+}
+
+/************************** Model handling ************************************/
+
+/**
+ * sja1105p_model_attach - run the HAL against the switch model
+ * @partNr: The part to be modelled for all switches
+ *
+ * Registers the mock SPI backend with the model as its access hook.
+ */
+void sja1105p_model_attach(SJA1105P_partNr_t partNr)
+{
+	struct model_switch *sw;
+	int i, t;
+
+	g_modelPartNr = partNr;
+
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+		sw = calloc(1, sizeof(*sw));
+		for (t = 0; sw && (t < MODEL_N_TABLES); t++) {
+			sw->tables[t].data = calloc(gk_tables[t].n_entries * gk_tables[t].entry_words, sizeof(uint32_t));
+			sw->tables[t].valid = calloc(gk_tables[t].n_entries, 1);
+		}
+		g_model[i] = sw;
+	}
+
+	sja1105p_mock_register();
+	sja1105p_mock_set_hook(model_hook, NULL);
+	sja1105p_model_reset();
+}
+
+void sja1105p_model_detach(void)
+{
+	int i, t;
+
+	sja1105p_mock_set_hook(NULL, NULL);
+	sja1105p_mock_unregister();
+
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+		if (!g_model[i])
+			continue;
+		for (t = 0; t < MODEL_N_TABLES; t++) {
+			free(g_model[i]->tables[t].data);
+			free(g_model[i]->tables[t].valid);
+		}
+		free(g_model[i]);
+		g_model[i] = NULL;
+	}
+}
+
+/**
+ * sja1105p_model_reset - bring all modelled switches into their reset state
+ *
+ * Also clears the SPI statistics of the mock.
+ */
+void sja1105p_model_reset(void)
+{
+	uint32_t *regs;
+	int i;
+
+	sja1105p_mock_reset();
+	sja1105p_mock_reset_stats();
+
+	for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+		regs = sja1105p_mock_registers(i);
+		if (g_model[i] && regs)
+			model_init_switch(g_model[i], regs);
+	}
+}
+
+/************************** PTP clock *****************************************/
+
+/* advance both clocks to the current host time */
+static void model_ptp_update(struct model_switch *sw)
+{
+	uint64_t now = model_host_ns();
+	uint64_t ticks = (now - sw->ptp_host_ns) / MODEL_PTP_TICK_NS;
+
+	/* ratio is a fixed point number with 31 fractional bits, split to avoid overflow */
+	sw->ptp_clk += ((ticks >> 31) * sw->ptp_ratio) + (((ticks & 0x7FFFFFFFULL) * sw->ptp_ratio) >> 31);
+	sw->ptp_ts_clk += ticks;
+	/* keep the remainder of the division */
+	sw->ptp_host_ns = now - ((now - sw->ptp_host_ns) % MODEL_PTP_TICK_NS);
+}
+
+uint64_t sja1105p_model_get_ptp_clk(uint8_t deviceSelect)
+{
+	if ((deviceSelect >= SJA1105P_N_SWITCHES) || !g_model[deviceSelect])
+		return 0;
+
+	model_ptp_update(g_model[deviceSelect]);
+	return g_model[deviceSelect]->ptp_clk;
+}
+
+static void model_ptp_control(struct model_switch *sw, uint32_t *p_regs)
+{
+	uint32_t *regs;
+	int i;
+
+	if (p_regs[MODEL_PTP_C_2_ADDR] & MODEL_PTP_RESPTP) {
+		sw->ptp_clk = 0;
+		sw->ptp_ts_clk = 0;
+		sw->ptp_host_ns = model_host_ns();
+	}
+
+	/* the sync impulse on the PTP pin latches the clocks of all cascaded switches */
+	if (p_regs[MODEL_PTP_C_2_ADDR] & MODEL_PTP_SYNC_CASCADED) {
+		for (i = 0; i < SJA1105P_N_SWITCHES; i++) {
+			regs = sja1105p_mock_registers(i);
+			if (!g_model[i] || !regs)
+				continue;
+			model_ptp_update(g_model[i]);
+			model_write64(regs, MODEL_PTP_C_6_ADDR, g_model[i]->ptp_clk);
+		}
+	}
+}
+
+static void model_ptp_set_clk(struct model_switch *sw, uint32_t *p_regs)
+{
+	uint64_t value = model_read64(p_regs, MODEL_PTP_C_3_ADDR);
+
+	model_ptp_update(sw);
+	if (p_regs[MODEL_PTP_C_2_ADDR] & MODEL_PTP_CLKADD)
+		sw->ptp_clk += value;
+	else if (p_regs[MODEL_PTP_C_2_ADDR] & MODEL_PTP_CLKSUB)
+		sw->ptp_clk -= value;
+	else
+		sw->ptp_clk = value;
+}
+
+/************************** L2 address lookup TCAM ****************************/
+
+/* compare the search key of the entry registers against a stored entry, honouring its mask */
+static int model_art_match(const uint32_t *kp_key, const uint32_t *kp_entry)
+{
+	uint64_t key, stored, mask;
+
+	/* MACADDR, VLANID and INNER_OUTER_VLAN form a contiguous 61 bit field from bit 22 of word 0 */
+	key    = ((uint64_t) kp_key[0] >> 22) | ((uint64_t) kp_key[1] << 10) | ((uint64_t) (kp_key[2] & 0x7FFFFU) << 42);
+	stored = ((uint64_t) kp_entry[0] >> 22) | ((uint64_t) kp_entry[1] << 10) | ((uint64_t) (kp_entry[2] & 0x7FFFFU) << 42);
+	mask   = ((uint64_t) kp_entry[2] >> 19) | ((uint64_t) kp_entry[3] << 13) | ((uint64_t) (kp_entry[4] & 0xFFFFU) << 45);
+
+	return (((key ^ stored) & mask) == 0U) ? 1 : 0;
+}
+
+static void model_art_command(struct model_switch *sw, uint32_t *p_regs)
+{
+	uint32_t ctrl = p_regs[MODEL_ALTC_ADDR];
+	uint32_t cmd = (ctrl >> MODEL_ALTC_HOST_CMD_SHIFT) & MODEL_ALTC_HOST_CMD_MASK;
+	uint32_t *entry = &p_regs[MODEL_ART_ADDR];
+	uint32_t index = (entry[0] & MODEL_ART_INDEX_MASK) >> MODEL_ART_INDEX_SHIFT;
+	uint32_t status = ctrl & ~(MODEL_ALTC_ERRORS | MODEL_ALTC_VALIDENT | MODEL_ALTC_LOCKEDS);
+	uint32_t (*table)[MODEL_ART_WORDS] = sw->art;
+	uint8_t *valid = sw->art_valid;
+	uint32_t n_entries = MODEL_N_ARL_ENTRIES;
+	uint32_t i;
+
+	if (ctrl & MODEL_ALTC_MGMTROUTE) {
+		table = sw->mgmt;
+		valid = sw->mgmt_valid;
+		n_entries = MODEL_N_MGMT_ROUTES;
+	}
+
+	if ((cmd != MODEL_HOST_CMD_SEARCH) && (index >= n_entries)) {
+		p_regs[MODEL_ALTC_ADDR] = status | MODEL_ALTC_ERRORS;
+		return;
+	}
+
+	switch (cmd) {
+	case MODEL_HOST_CMD_WRITE:
+		memcpy(table[index], entry, sizeof(table[index]));
+		valid[index] = (ctrl & MODEL_ALTC_VALIDENT) ? 1 : 0;
+		if (!(ctrl & MODEL_ALTC_MGMTROUTE))
+			sw->art_locked[index] = (ctrl & MODEL_ALTC_LOCKEDS) ? 1 : 0;
+		break;
+	case MODEL_HOST_CMD_READ:
+		if (valid[index])
+			memcpy(entry, table[index], sizeof(table[index]));
+		break;
+	case MODEL_HOST_CMD_SEARCH:
+		for (i = 0; i < n_entries; i++) {
+			if (valid[i] && model_art_match(entry, table[i])) {
+				memcpy(entry, table[i], sizeof(table[i]));
+				/* the index of the hit is reported in the entry */
+				entry[0] = (entry[0] & ~MODEL_ART_INDEX_MASK) | (i << MODEL_ART_INDEX_SHIFT);
+				break;
+			}
+		}
+		index = i;
+		break;
+	default:
+		/* host invalidate entry */
+		valid[index] = 0;
+		break;
+	}
+
+	if ((index < n_entries) && valid[index]) {
+		status |= MODEL_ALTC_VALIDENT;
+		if (!(ctrl & MODEL_ALTC_MGMTROUTE) && sw->art_locked[index])
+			status |= MODEL_ALTC_LOCKEDS;
+	}
+	p_regs[MODEL_ALTC_ADDR] = status;
+}
+
+/************************** Reconfiguration tables ****************************/
+
+static void model_table_command(const struct model_table_desc *kp_desc, struct model_table *p_table, uint32_t *p_regs)
+{
+	uint32_t ctrl = p_regs[kp_desc->ctrl_addr];
+	uint32_t *entry = &p_regs[kp_desc->entry_addr];
+	uint32_t *stored;
+	uint32_t index;
+
+	if (kp_desc == &gk_tables[MODEL_VLAN])
+		/* the VLAN ID in the entry is the index */
+		index = (entry[0] >> 27) | ((entry[1] & 0x7FU) << 5);
+	else
+		index = ctrl & kp_desc->index_mask;
+
+	ctrl &= ~(kp_desc->errors | kp_desc->valident);
+	if (index >= kp_desc->n_entries) {
+		p_regs[kp_desc->ctrl_addr] = ctrl | kp_desc->errors;
+		return;
+	}
+
+	stored = &p_table->data[index * kp_desc->entry_words];
+	if (p_regs[kp_desc->ctrl_addr] & kp_desc->rdwrset) {
+		memcpy(stored, entry, kp_desc->entry_words * sizeof(uint32_t));
+		p_table->valid[index] = (kp_desc->valident == 0U) || (p_regs[kp_desc->ctrl_addr] & kp_desc->valident);
+	} else if ((kp_desc->valident == 0U) || p_table->valid[index]) {
+		memcpy(entry, stored, kp_desc->entry_words * sizeof(uint32_t));
+	}
+
+	if (p_table->valid[index])
+		ctrl |= kp_desc->valident;
+	p_regs[kp_desc->ctrl_addr] = ctrl;
+}
+
+/************************** Access hook ***************************************/
+
+static void model_hook(uint8_t deviceSelect, int write, uint32_t reg_addr, uint32_t *p_regs, void *p_context)
+{
+	struct model_switch *sw = g_model[deviceSelect];
+	int t;
+
+	(void) p_context;
+
+	if (!sw)
+		return;
+
+	if (!write) {
+		switch (reg_addr) {
+		case MODEL_CF_ADDR:
+			p_regs[MODEL_CF_ADDR] = 0;
+			if (sw->cfg_words > 0) {
+				if (sw->cfg_first_word == sw->device_id)
+					p_regs[MODEL_CF_ADDR] |= MODEL_CF_CONFIGS;
+				else
+					p_regs[MODEL_CF_ADDR] |= MODEL_CF_IDS;
+			}
+			break;
+		case MODEL_PTP_C_3_ADDR:
+			model_ptp_update(sw);
+			model_write64(p_regs, MODEL_PTP_C_3_ADDR, sw->ptp_clk);
+			break;
+		case MODEL_PTP_C_5_ADDR:
+			model_ptp_update(sw);
+			model_write64(p_regs, MODEL_PTP_C_5_ADDR, sw->ptp_ts_clk);
+			break;
+		default:
+			break;
+		}
+		return;
+	}
+
+	/* the configuration area is a stream, each upload starts at its first address */
+	if ((reg_addr >= MODEL_CONFIG_START) && (reg_addr < MODEL_CONFIG_END)) {
+		if (reg_addr == MODEL_CONFIG_START) {
+			sw->cfg_first_word = p_regs[reg_addr];
+			sw->cfg_words = 0;
+		}
+		sw->cfg_words++;
+		return;
+	}
+
+	switch (reg_addr) {
+	case MODEL_D_ID_ADDR:
+		/* read only */
+		p_regs[reg_addr] = sw->device_id;
+		return;
+	case MODEL_ALTC_ADDR:
+		if (p_regs[reg_addr] & MODEL_VALID)
+			model_art_command(sw, p_regs);
+		return;
+	case MODEL_PTP_C_2_ADDR:
+		if (p_regs[reg_addr] & MODEL_VALID)
+			model_ptp_control(sw, p_regs);
+		return;
+	case MODEL_PTP_C_3_ADDR + 1:
+		/* PTPCLKVAL takes effect with its upper word */
+		model_ptp_set_clk(sw, p_regs);
+		return;
+	case MODEL_PTP_C_4_ADDR:
+		model_ptp_update(sw);
+		sw->ptp_ratio = p_regs[reg_addr];
+		return;
+	default:
+		break;
+	}
+
+	for (t = 0; t < MODEL_N_TABLES; t++) {
+		if ((gk_tables[t].ctrl_addr == reg_addr) && (p_regs[reg_addr] & MODEL_VALID)) {
+			model_table_command(&gk_tables[t], &sw->tables[t], p_regs);
+			break;
+		}
+	}
+}
@@ -55,6 +55,7 @@
 #include "sja1105p_cfg_file.h"
 #include "sja1105p_general_status.h"
 #include "sja1105p_debugfs.h"
+#include "sja1105p_stats.h"
 #ifndef DISABLE_SWITCHDEV
 #include "sja1105p_switchdev.h"
 #endif
@@ -66,6 +67,13 @@
  */
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 
+#define SJA1105P_SPI_MAX_HZ 25000000  /* upper limit of the SPI clock in the datasheet */
+#define SJA1105P_DEVICE_ID_ADDR 0x0
+#define SJA1105P_CFG_PAD_MIIX_ID_ADDR 0x100810  /* pad configuration of port 0, followed by the other ports, used as scratch registers */
+#define SJA1105P_CFG_PAD_MIIX_ID_MASK 0x7f7f    /* writable bits: RXC/TXC delay, bypass and power down */
+#define SJA1105P_CFG_PAD_MIIX_ID_WORDS SJA1105P_PORT_NB
+#define SJA1105P_SPI_CALIB_ROUNDS 32
+
 /*
  * Static variables
  *
@@ -74,6 +82,10 @@ static int max_hz = SPI_FREQUENCY; /* 25 MHz is the default but might have to be
 module_param(max_hz, int, S_IRUGO);
 MODULE_PARM_DESC(max_hz, "SPI bus speed may be limited for the remote SJA1105P application board, 25MHz is the maximum");
 
+static int spi_calibrate = 1;
+module_param(spi_calibrate, int, S_IRUGO);
+MODULE_PARM_DESC(spi_calibrate, "Step the SPI clock up from max_hz at probe and settle one step below the fastest stable rate (25MHz at most)");
+
 #ifndef DISABLE_HOST_NETDEV
 static char *ifname =  "eth0";
 module_param(ifname, charp, S_IRUGO);
@@ -84,10 +96,30 @@ int verbosity =  0;
 module_param(verbosity, int, S_IRUGO);
 MODULE_PARM_DESC(verbosity, "Trace level'");
 
+int parallel_switches = 0;
+module_param(parallel_switches, int, S_IRUGO);
+MODULE_PARM_DESC(parallel_switches, "Execute per switch operations of the HAL concurrently on worker threads");
+
+static int cfg_block_words = SPI_CFG_BLOCKS; /* frame size supported by the SPI controller of the board */
+module_param(cfg_block_words, int, S_IRUGO);
+MODULE_PARM_DESC(cfg_block_words, "Number of words per SPI frame of the configuration upload (1 to 64), default NR_CFG_BLOCKS of the board");
+
+int stats_interval_ms = 1000;
+module_param(stats_interval_ms, int, S_IRUGO);
+MODULE_PARM_DESC(stats_interval_ms, "Interval between two reads of the port counters in ms (at least 100)");
+
 #ifndef DISABLE_SWITCHDEV
 static int enable_switchdev = 1;
 module_param(enable_switchdev, int, S_IRUGO);
 MODULE_PARM_DESC(enable_switchdev, "Enable the switchdev driver");
+
+int fdb_learn_interval_ms = 100;
+module_param(fdb_learn_interval_ms, int, S_IRUGO);
+MODULE_PARM_DESC(fdb_learn_interval_ms, "Interval between two scans for learned FDB entries in ms, 0 disables the sync to the bridge");
+
+int fdb_learn_budget = 256;
+module_param(fdb_learn_budget, int, S_IRUGO);
+MODULE_PARM_DESC(fdb_learn_budget, "Number of ARL table indices read per scan for learned FDB entries (16 to 1024)");
 #endif
 
 
@@ -124,6 +156,16 @@ const char * fw_name_suffix[SJA1105P_NB_REV] = {
 
 struct _SJA_CONF sja_cfg;
 
+/* SPI clock rates tried by the calibration above max_hz, in ascending order */
+static const u32 spi_calib_rates[] = {
+	5000000, 10000000, 12500000, 15000000, 17500000, 20000000, 22500000, SJA1105P_SPI_MAX_HZ
+};
+
+/* scratch patterns written to the pad configuration register, within SJA1105P_CFG_PAD_MIIX_ID_MASK */
+static const u32 spi_calib_patterns[] = {
+	0x5a5a, 0x2525, 0x7f7f, 0x0000
+};
+
 
 
 static int sja1105p_check_device_id(struct spi_device *spi, unsigned int device_select, bool dump_id)
@@ -159,6 +201,117 @@ static int sja1105p_wait_for_reset(struct spi_device *spi, int revision, int dev
 	return -EIO;
 }
 
+/*
+ * Read back the device id and scratch patterns at the current SPI clock rate.
+ * The patterns are written to the pad configuration of all ports with one burst
+ * and read back with one burst, bursts are the first to fail at a high clock.
+ * The HAL is bypassed so that the register cache does not hide bus errors.
+ */
+static void sja1105p_spi_calib_check(struct spi_device *spi, u32 devid, struct sja1105p_spi_calib_step *step)
+{
+	u32 val;
+	u32 pattern[SJA1105P_CFG_PAD_MIIX_ID_WORDS];
+	u32 readback[SJA1105P_CFG_PAD_MIIX_ID_WORDS];
+	int i, j;
+
+	for (i = 0; i < SJA1105P_SPI_CALIB_ROUNDS; i++) {
+		step->nb_words++;
+		if (sja1105p_spi_read(spi, SJA1105P_DEVICE_ID_ADDR, &val, 1) || val != devid)
+			step->nb_errors++;
+
+		for (j = 0; j < SJA1105P_CFG_PAD_MIIX_ID_WORDS; j++)
+			pattern[j] = spi_calib_patterns[(i + j) % ARRAY_SIZE(spi_calib_patterns)];
+
+		step->nb_words += SJA1105P_CFG_PAD_MIIX_ID_WORDS;
+		if (sja1105p_cfg_block_write(spi, SJA1105P_CFG_PAD_MIIX_ID_ADDR, pattern, SJA1105P_CFG_PAD_MIIX_ID_WORDS)
+		    || sja1105p_spi_read(spi, SJA1105P_CFG_PAD_MIIX_ID_ADDR, readback, SJA1105P_CFG_PAD_MIIX_ID_WORDS)) {
+			step->nb_errors += SJA1105P_CFG_PAD_MIIX_ID_WORDS;
+			continue;
+		}
+		for (j = 0; j < SJA1105P_CFG_PAD_MIIX_ID_WORDS; j++) {
+			if ((readback[j] & SJA1105P_CFG_PAD_MIIX_ID_MASK) != pattern[j])
+				step->nb_errors++;
+		}
+	}
+}
+
+/*
+ * Step the SPI clock up from max_hz until a rate shows errors or the datasheet
+ * limit is reached. The switch is operated one step below the fastest clean rate
+ * to keep some margin, but never below max_hz.
+ * Must be called before the cold reset, which discards the scratch writes.
+ */
+static void sja1105p_spi_calibrate(struct sja1105p_context_data *sw_ctx)
+{
+	struct spi_device *spi = sw_ctx->spi_dev;
+	u32 devid = device_id_list[sw_ctx->sja1105p_chip_revision];
+	struct sja1105p_spi_calib_step *step;
+	u32 pad_orig[SJA1105P_CFG_PAD_MIIX_ID_WORDS];
+	u32 rate = max_hz;
+	u32 best = max_hz;
+	u32 prev = max_hz;
+	bool unstable = false;
+	unsigned int i = 0;
+
+	sw_ctx->spi_hz = max_hz;
+	if (!spi_calibrate)
+		return;
+
+	if (sja1105p_spi_read(spi, SJA1105P_CFG_PAD_MIIX_ID_ADDR, pad_orig, SJA1105P_CFG_PAD_MIIX_ID_WORDS)) {
+		dev_err(&spi->dev, "SPI calibration skipped, scratch registers not readable\n");
+		return;
+	}
+
+	while (sw_ctx->nb_spi_calib_steps < SJA1105P_SPI_CALIB_MAX_STEPS) {
+		step = &sw_ctx->spi_calib[sw_ctx->nb_spi_calib_steps];
+
+		spi->max_speed_hz = rate;
+		if (spi_setup(spi) < 0)
+			break;
+		/* the controller may round the rate down */
+		if (sw_ctx->nb_spi_calib_steps > 0 && spi->max_speed_hz <= best)
+			break;
+
+		step->hz = spi->max_speed_hz;
+		sja1105p_spi_calib_check(spi, devid, step);
+		sw_ctx->nb_spi_calib_steps++;
+		if (verbosity > 1) dev_info(&spi->dev, "SPI calibration: %u Hz, %u errors in %u words\n", step->hz, step->nb_errors, step->nb_words);
+
+		if (step->nb_errors) {
+			unstable = true;
+			break;
+		}
+		prev = best;
+		best = step->hz;
+
+		while (i < ARRAY_SIZE(spi_calib_rates) && spi_calib_rates[i] <= rate)
+			i++;
+		if (i == ARRAY_SIZE(spi_calib_rates))
+			break;
+		rate = spi_calib_rates[i];
+	}
+
+	/* margin: the fastest clean rate is not used */
+	if (best > max_hz)
+		best = prev;
+	else if (unstable)
+		dev_warn(&spi->dev, "SPI calibration: errors at max_hz=%d, consider lowering it\n", max_hz);
+
+	spi->max_speed_hz = best;
+	if (spi_setup(spi) < 0) {
+		spi->max_speed_hz = max_hz;
+		spi_setup(spi);
+	}
+	sw_ctx->spi_hz = spi->max_speed_hz;
+	sja1105p_cfg_block_write(spi, SJA1105P_CFG_PAD_MIIX_ID_ADDR, pad_orig, SJA1105P_CFG_PAD_MIIX_ID_WORDS);
+
+	if (sw_ctx->nb_spi_calib_steps) {
+		step = &sw_ctx->spi_calib[sw_ctx->nb_spi_calib_steps-1];
+		dev_info(&spi->dev, "SPI clock calibrated to %u Hz (%d rates tried, %u errors in %u words at %u Hz)\n",
+			 sw_ctx->spi_hz, sw_ctx->nb_spi_calib_steps, step->nb_errors, step->nb_words, step->hz);
+	}
+}
+
 static bool sja1105p_check_device_status(struct spi_device *spi)
 {
 	struct sja1105p_context_data *sw_ctx = spi_get_drvdata(spi);
@@ -314,12 +467,11 @@ static int sja1105p_configuration_load(const struct firmware *config_file, struc
 	struct sja1105p_context_data *data = spi_get_drvdata(spi);
 	int nb_words;
 	u32 * cfg_data;
-	int remaining_words;
-	u32 dev_addr;
 	u32 val;
 	bool swap_required;
 	int i;
 	SJA1105P_portStatusMiixArgument_t portStatusMiix;
+	struct sja1105p_cfg_upload_stats upload_stats;
 
 	/* read back ports configuration */
 	for (i=0; i<SJA1105P_PORT_NB; i++) {
@@ -379,26 +531,15 @@ static int sja1105p_configuration_load(const struct firmware *config_file, struc
 
 	if (verbosity > 1) dev_info(&spi->dev, "swap_required %d nb_words %d dev_addr %08x\n", swap_required, nb_words, (u32)SJA1105P_CONFIG_START_ADDRESS);
 
-	remaining_words = nb_words;
-	dev_addr = SJA1105P_CONFIG_START_ADDRESS;
-
-	i = 0;
-	while (remaining_words > 0) {
-		//TODO: should use SJA1105P_CONFIG_WORDS_PER_BLOCK many words per transfer
-		int block_size_words = MIN(SPI_CFG_BLOCKS, remaining_words);
-
-		if (verbosity > 2) dev_info(&spi->dev, "block_size_words %d remaining_words %d\n", block_size_words, remaining_words);
+	/* the upload bypasses the HAL, drop its shadowed register values */
+	SJA1105P_invalidateRegisterCache(data->device_select);
 
-		if (sja1105p_cfg_block_write(spi, dev_addr, cfg_data, block_size_words) < 0)
-			goto err_cfg;
-
-		if (verbosity > 1) dev_info(&spi->dev, "Loaded block %d @%08x\n", i, dev_addr);
+	if (sja1105p_cfg_upload(spi, SJA1105P_CONFIG_START_ADDRESS, cfg_data, nb_words, clamp(cfg_block_words, 1, SJA1105P_CONFIG_WORDS_PER_BLOCK), &upload_stats) < 0)
+		goto err_cfg;
 
-		dev_addr += block_size_words;
-		cfg_data += block_size_words;
-		remaining_words -= block_size_words;
-		i++;
-	}
+	if (verbosity > 0) dev_info(&spi->dev, "Configuration upload: %d words in %d frames, prepare %lld us, transfer %lld us (%lld kB/s)\n",
+		upload_stats.nb_words, upload_stats.nb_blocks, upload_stats.prepare_us, upload_stats.transfer_us,
+		upload_stats.transfer_us ? div64_s64((s64)upload_stats.nb_words * 4 * 1000, upload_stats.transfer_us) : 0);
 
 	if (!sja1105p_post_cfg_load_check(spi, data))  {
 		dev_err(&spi->dev, "SJA1105P configuration failed\n");
@@ -568,6 +709,9 @@ int sja1105p_probe_final(struct sja1105p_context_data *switch_ctx)
 		return err;
 	}
 
+	/* counters are read in the background, readers get the last snapshot */
+	sja1105p_stats_start();
+
 	read_lock(&rwlock);
 	dev_info(&switch_ctx->spi_dev->dev, "%d switch%s initialized successfully!\n", switches_active, (switches_active > 1)?"es":"");
 	read_unlock(&rwlock);
@@ -658,6 +802,8 @@ static int sja1105p_probe(struct spi_device *spi)
 		return -ENODEV;
 	}
 
+	sja1105p_spi_calibrate(switch_ctx);
+
 	SJA1105P_setResetCtrl(SJA1105P_RESET_CTRL_COLDRESET, switch_ctx->device_select);
 	err = sja1105p_wait_for_reset(spi, switch_ctx->sja1105p_chip_revision, switch_ctx->device_select);
 	if (err != 0)
@@ -713,6 +859,9 @@ static int sja1105p_probe(struct spi_device *spi)
 
 static int sja1105p_remove(struct spi_device *spi)
 {
+	/* the collectors access all switches */
+	sja1105p_stats_stop();
+
 	/* Keep track of the total number of switches that were probed */
 	write_lock(&rwlock);
 	switches_active--;
@@ -48,6 +48,15 @@ struct sja1105p_platform_data {
 	struct port_desc ports[SJA1105P_PORT_NB];
 };
 
+/* maximum number of SPI clock rates tried during the probe-time calibration */
+#define SJA1105P_SPI_CALIB_MAX_STEPS 9
+
+struct sja1105p_spi_calib_step {
+	u32 hz;                        /**< SPI clock rate applied by spi_setup */
+	u32 nb_words;                  /**< number of words compared against their expected value */
+	u32 nb_errors;                 /**< number of mismatching words, all words of a failed transfer count */
+};
+
 struct sja1105p_context_data {
 	struct spi_device	*spi_dev;        /**< passsed at spi probing*/
 	struct device_node	*of_node;        /**< Open Firmware node describing device */
@@ -59,6 +68,10 @@ struct sja1105p_context_data {
 	struct sja1105p_platform_data *pdata;
 
 	struct list_head cfg_block_list;        /**< Block list resulting from call to configuration file parsing function */
+
+	u32 spi_hz;                             /**< SPI clock rate the switch is operated at */
+	int nb_spi_calib_steps;                 /**< number of rates tried by the calibration, 0 if it did not run */
+	struct sja1105p_spi_calib_step spi_calib[SJA1105P_SPI_CALIB_MAX_STEPS];
 };
 
 
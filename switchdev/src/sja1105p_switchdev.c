@@ -16,12 +16,21 @@
 
 #include <linux/module.h>
 #include <linux/etherdevice.h>
+#include <linux/ethtool.h>
 #include <linux/if_bridge.h>
+#include <linux/if_vlan.h>
 #include <linux/rtnetlink.h>
 #include <net/switchdev.h>
 #include <net/netlink.h>
+#include <net/pkt_cls.h>
+#include <net/tc_act/tc_vlan.h>
 #include <linux/of_mdio.h>
 #include <linux/fec.h>
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/hashtable.h>
+#include <linux/slab.h>
 
 #include "NXP_SJA1105P_addressResolutionTable.h"
 #include "NXP_SJA1105P_diagnostics.h"
@@ -30,13 +39,19 @@
 #include "NXP_SJA1105P_portConfig.h"
 
 #include "sja1105p_switchdev.h"
+#include "sja1105p_stats.h"
 
 #define PRODUCT_NAME "SJA1105P"
 #define PNAME_LEN 22U
-#define ARL_TABLE_SIZE 1024U
+#define FDB_SNAPSHOT_MAX_AGE HZ /* learned entries change without the driver noticing */
 #define DTS_NAME_LEN 8U
+#define FDB_LEARN_MIN_BUDGET 16 /* indices read within one SPI batch */
+#define MDB_HASH_BITS 6U
+#define MDB_KEY(mac, vid) ((mac) ^ ((u64)(vid) << 48))
 
 extern int verbosity;
+extern int fdb_learn_interval_ms;
+extern int fdb_learn_budget;
 static struct sja1105p_context_data **sja1105p_context_arr;
 typedef enum {UP, DOWN} linkstatus_t;
 
@@ -48,11 +63,68 @@ struct nxp_port_data_struct {
 	unsigned char *base_mac;
 	struct net_device *netdev;
 	int link_state;
+	struct work_struct link_work;                  /* applies link_state to the netdev flags */
 	int speed;
+	u16 pvid;                                      /* PVID set by the bridge, 0 if none */
+	struct list_head tc_vlan_rules;                /* nxp_tc_vlan_rule, protected by rtnl */
+};
+
+/* VLAN translation offloaded from a tc flower filter of the port */
+struct nxp_tc_vlan_rule {
+	struct list_head list;
+	unsigned long cookie;
+	u16 vid;
+	u16 new_vid;
+};
+
+/* ARL table shared by the fdb dumps of all ports */
+struct nxp_fdb_snapshot_struct {
+	struct mutex lock;
+	SJA1105P_arlTableSnapshot_t *table;
+	bool valid;
+	unsigned long taken;                           /* jiffies */
+	unsigned int serial;                           /* incremented with every new snapshot */
+	u16 port_count[SJA1105P_N_LOGICAL_PORTS];      /* number of entries per port */
+
+	/* resume point of a dump interrupted by a full skb */
+	unsigned int cursor_serial;
+	int cursor_port;
+	int cursor_start_idx;                          /* idx when the port was entered */
+	int cursor_idx;
+	u16 cursor_pos;                                /* first entry not sent */
+};
+
+/* learned entry found at an index of a switch by the last scan */
+struct nxp_fdb_learned_entry {
+	u64 mac;
+	u16 vid;
+	s8 port;                                       /* logical port, -1 if none */
+};
+
+/* entries learned by the switches, reported to the bridge */
+struct nxp_fdb_learned_struct {
+	struct delayed_work work;
+	struct nxp_fdb_learned_entry *known;           /* SJA1105P_N_SWITCHES x SJA1105P_N_ARL_ENTRIES */
+	SJA1105P_addressResolutionTableEntry_t *scan;  /* fdb_learn_budget entries */
+	int budget;
+	int switch_id;                                 /* next index to be scanned */
+	u16 index;
+};
+
+/* multicast group offloaded to the ARL table, protected by rtnl */
+struct nxp_mdb_group {
+	struct hlist_node node;
+	u64 mac;
+	u16 vid;
+	u16 ports;                                     /* ports configured in the ARL table */
+	u16 refcount[SJA1105P_N_LOGICAL_PORTS];        /* memberships per port */
 };
 
 struct nxp_private_data_struct {
 	struct nxp_port_data_struct **ports;
+	struct nxp_fdb_snapshot_struct fdb;
+	struct nxp_fdb_learned_struct learned;
+	DECLARE_HASHTABLE(mdb, MDB_HASH_BITS);         /* nxp_mdb_group by MDB_KEY */
 };
 
 
@@ -82,16 +154,17 @@ static int nxp_port_fdb_add(struct ndmsg *ndm, struct nlattr *tb[],
 	 * retrieve it to add current port to the port mask
 	 */
 	memcpy (&entry.dstMacAddress, addr, sizeof (entry.dstMacAddress));
+	entry.vlanId = vid;
 	err = SJA1105P_readArlTableEntryByAddress(&entry);
 	if (err)
 		netdev_alert(netdev, "No existing entry found, creating new one\n");
 
 	/* build table entry,
 	 * the index and enabled fields are filled
-	 * by the SJA1105P_addArlTableEntry function
+	 * by the SJA1105P_addArlTableEntry function,
+	 * an existing entry of the same address is updated in place
 	 */
 	entry.ports |= (1 << nxp_port->port_num);
-	entry.vlanId = vid;
 
 	/* add to sw using function from the sja1105p driver module */
 	err = SJA1105P_addArlTableEntry(&entry);
@@ -122,6 +195,7 @@ static int nxp_port_fdb_del(struct ndmsg *ndm, struct nlattr *tb[],
 		nxp_port->port_num, *(addr+0), *(addr+1), *(addr+2), *(addr+3), *(addr+4), *(addr+5), vid, netdev->name);
 
 	memcpy (&entry.dstMacAddress, addr, sizeof (entry.dstMacAddress));
+	entry.vlanId = vid;
 	err = SJA1105P_readArlTableEntryByAddress(&entry);
 	if (err)
 		goto sja1105p_entry_not_found;
@@ -144,11 +218,9 @@ static int nxp_port_fdb_del(struct ndmsg *ndm, struct nlattr *tb[],
 		if (verbosity > 1)
 			netdev_alert(netdev, "deactivated last port, also remove table entry\n");
 
-		/* build table entry,
-		 * entry to be removed is identified by MAC and vid,
+		/* entry to be removed is identified by MAC and vid,
 		 * the index is retrived by SJA1105P_removeArlTableEntryByAddress
 		 */
-		entry.vlanId = vid;
 
 		/* del from sw using function from the sja1105p driver module */
 		err = SJA1105P_removeArlTableEntryByAddress(&entry);
@@ -225,6 +297,43 @@ nla_put_failure:
 	return -EMSGSIZE;
 }
 
+/* Take a new snapshot of the ARL table if the driver modified the table
+ * or the snapshot is too old to show the learned entries
+ */
+static int nxp_fdb_snapshot_refresh(struct nxp_fdb_snapshot_struct *fdb)
+{
+	SJA1105P_addressResolutionTableEntry_t *entry;
+	int i, port;
+
+	if (!fdb->table) {
+		fdb->table = vmalloc(sizeof(*fdb->table));
+		if (!fdb->table)
+			return -ENOMEM;
+	}
+
+	if (fdb->valid && fdb->table->generation == SJA1105P_getArlTableGeneration() &&
+	    time_before(jiffies, fdb->taken + FDB_SNAPSHOT_MAX_AGE))
+		return 0;
+
+	fdb->valid = false;
+	if (SJA1105P_snapshotArlTable(fdb->table))
+		return -EIO;
+
+	memset(fdb->port_count, 0, sizeof(fdb->port_count));
+	for (i = 0; i < fdb->table->nEntries; i++) {
+		entry = &fdb->table->entries[i];
+		for (port = 0; port < SJA1105P_N_LOGICAL_PORTS; port++)
+			if (entry->ports & BIT(port))
+				fdb->port_count[port]++;
+	}
+
+	fdb->valid = true;
+	fdb->taken = jiffies;
+	fdb->serial++;
+
+	return 0;
+}
+
 /* Used to add FDB entries to dump requests. Implementers should add entries
  * to skb and update idx with the number of entries
  */
@@ -234,77 +343,679 @@ static int nxp_port_fdb_dump(struct sk_buff *skb,
 			     struct net_device *filter_dev,
 			     int *idx)
 {
-	int vid;
-	char *mac_addr;
-
-	int index, err;
+	struct nxp_fdb_snapshot_struct *fdb = &nxp_private_data.fdb;
+	SJA1105P_addressResolutionTableEntry_t *entry;
 	struct nxp_port_data_struct *nxp_port;
+	u8 mac_addr[ETH_ALEN] __aligned(2);
+	int start_idx = *idx;
+	int port, err;
+	u16 pos = 0;
 
 	nxp_port = netdev_priv(netdev);
+	port = nxp_port->port_num;
 
 	if (verbosity > 1)
 		netdev_alert(netdev, "nxp_port_fdb_dump was called (%d)! idx [%d], arg is [%ld]%s\n",
-		nxp_port->port_num, *idx, cb->args[0], ((*idx < cb->args[0])?" (skipping)":""));
+		port, *idx, cb->args[0], ((*idx < cb->args[0])?" (skipping)":""));
 
-	for (index = 0; index < ARL_TABLE_SIZE; index++) {
-		SJA1105P_addressResolutionTableEntry_t entry;
-		entry.index = index;
+	mutex_lock(&fdb->lock);
 
-		/* get table entry at position index from arl table */
-		err = SJA1105P_readArlTableEntryByIndex(&entry);
-		if (err)
-			goto sja1105p_read_error;
+	err = nxp_fdb_snapshot_refresh(fdb);
+	if (err)
+		goto sja1105p_read_error;
 
-		/* skip without incrementing idx if entry is not valid (empty)
-		 * or belongs to a different port
-		 */
-		if (!entry.enabled || !(entry.ports & BIT(nxp_port->port_num))) {
+	/* On the first pass, cb->args[0] is always 0, idx is
+	 * incremented with every valid table entry.
+	 * On a continuation, cb->args[0] now holds the total number
+	 * of entries for all devices sent so far,
+	 * idx must still be incremented per valid table entry.
+	 * Ports that were sent completely are skipped at once,
+	 * the interrupted port resumes at the cursor.
+	 */
+	if (*idx + fdb->port_count[port] <= cb->args[0]) {
+		*idx += fdb->port_count[port];
+		goto unlock;
+	}
+	if (fdb->cursor_serial == fdb->serial && fdb->cursor_port == port &&
+	    fdb->cursor_start_idx == start_idx && fdb->cursor_idx <= cb->args[0]) {
+		pos = fdb->cursor_pos;
+		*idx = fdb->cursor_idx;
+	}
+
+	for (; pos < fdb->table->nEntries; pos++) {
+		entry = &fdb->table->entries[pos];
+
+		/* skip without incrementing idx if entry belongs to a different port */
+		if (!(entry->ports & BIT(port)))
 			continue;
-		}
 
-		/* On the first pass, cb->args[0] is always 0, idx is
-		 * incremented with every valid table entry.
-		 * Skip the netlink send on second pass,
-		 * cb->args[0] now holds the total number
-		 * of entries for all devices,
-		 * idx must still be incremented per valid table entry.
-		 */
 		if (*idx < cb->args[0]) {
 			*idx += 1;
 			continue;
 		}
 
-		mac_addr = kzalloc(17*sizeof(char), GFP_KERNEL);
-		if (!mac_addr)
-			return -ENOMEM;
-
-		vid = entry.vlanId;
-		ether_addr_copy(mac_addr, (char*)&entry.dstMacAddress);
+		ether_addr_copy(mac_addr, (u8 *)&entry->dstMacAddress);
 
 		if (verbosity > 1)
 			netdev_alert(netdev, "discovered [%02x:%02x:%02x:%02x:%02x:%02x] in vlan [%x] on device [%s]\n",
-			*(mac_addr+0), *(mac_addr+1), *(mac_addr+2), *(mac_addr+3), *(mac_addr+4), *(mac_addr+5), vid, netdev->name);
+			*(mac_addr+0), *(mac_addr+1), *(mac_addr+2), *(mac_addr+3), *(mac_addr+4), *(mac_addr+5), entry->vlanId, netdev->name);
 
 		/* send data via netlink message */
-		err = nxp_send_netlink_msg(nxp_port, skb, cb, vid, mac_addr);
-		kfree(mac_addr);
-		if (err)
+		err = nxp_send_netlink_msg(nxp_port, skb, cb, entry->vlanId, mac_addr);
+		if (err) {
+			fdb->cursor_serial = fdb->serial;
+			fdb->cursor_port = port;
+			fdb->cursor_start_idx = start_idx;
+			fdb->cursor_idx = *idx;
+			fdb->cursor_pos = pos;
 			goto send_error;
+		}
 
 		*idx += 1;
 	}
 
+unlock:
+	mutex_unlock(&fdb->lock);
 	return 0;
 
 sja1105p_read_error:
+	mutex_unlock(&fdb->lock);
 	netdev_err(netdev, "Could not read table entry from sja1105p!\n");
 	return err;
 
 send_error:
+	mutex_unlock(&fdb->lock);
 	netdev_err(netdev, "nla put faillure, could not send netlink msg\n");
 	return err;
 }
 
+/*************************learned fdb sync**************************************/
+
+static void nxp_fdb_learned_notify(unsigned long type,
+				   const struct nxp_fdb_learned_entry *learned)
+{
+	struct switchdev_notifier_fdb_info info;
+	struct net_device *netdev;
+	u8 mac_addr[ETH_ALEN] __aligned(2);
+
+	netdev = nxp_private_data.ports[learned->port]->netdev;
+	ether_addr_copy(mac_addr, (u8 *)&learned->mac);
+
+	if (verbosity > 1)
+		netdev_alert(netdev, "%s learned [%02x:%02x:%02x:%02x:%02x:%02x] in vlan [%x]\n",
+		(type == SWITCHDEV_FDB_ADD_TO_BRIDGE)?"add":"del",
+		*(mac_addr+0), *(mac_addr+1), *(mac_addr+2), *(mac_addr+3), *(mac_addr+4), *(mac_addr+5), learned->vid);
+
+	memset(&info, 0, sizeof(info));
+	info.addr = mac_addr;
+	info.vid = learned->vid;
+	call_switchdev_notifiers(type, netdev, &info.info);
+}
+
+/* Compare the indices read by a burst against the previous scan,
+ * only changes are reported to the bridge
+ */
+static void nxp_fdb_learned_diff(struct nxp_fdb_learned_struct *learned,
+				 int switch_id, u16 first_index, int nb_indices)
+{
+	SJA1105P_addressResolutionTableEntry_t *entry;
+	struct nxp_fdb_learned_entry *known, found;
+	int i;
+
+	for (i = 0; i < nb_indices; i++) {
+		entry = &learned->scan[i];
+		known = &learned->known[switch_id * SJA1105P_N_ARL_ENTRIES + first_index + i];
+
+		found.mac = entry->dstMacAddress;
+		found.vid = entry->vlanId;
+		found.port = -1;
+		/* learned entries point to a single port, addresses behind the host port are not reported */
+		if (entry->enabled && !nxp_private_data.ports[__ffs(entry->ports)]->is_host)
+			found.port = __ffs(entry->ports);
+
+		if (known->port == found.port && known->mac == found.mac && known->vid == found.vid)
+			continue;
+
+		if (known->port >= 0)
+			nxp_fdb_learned_notify(SWITCHDEV_FDB_DEL_TO_BRIDGE, known);
+		if (found.port >= 0)
+			nxp_fdb_learned_notify(SWITCHDEV_FDB_ADD_TO_BRIDGE, &found);
+		*known = found;
+	}
+}
+
+/* Read the next fdb_learn_budget indices, a complete pass over
+ * all switches spans several scans
+ */
+static void nxp_fdb_learned_work(struct work_struct *work)
+{
+	struct nxp_fdb_learned_struct *learned =
+		container_of(to_delayed_work(work), struct nxp_fdb_learned_struct, work);
+	int budget, nb_indices;
+
+	rtnl_lock();
+	for (budget = learned->budget; budget > 0; budget -= nb_indices) {
+		nb_indices = min_t(int, budget, SJA1105P_N_ARL_ENTRIES - learned->index);
+
+		if (SJA1105P_readLearnedArlTableEntries(learned->index, nb_indices,
+							learned->scan, learned->switch_id)) {
+			pr_err("Could not read learned entries from sja1105p %d!\n", learned->switch_id);
+			break;
+		}
+		nxp_fdb_learned_diff(learned, learned->switch_id, learned->index, nb_indices);
+
+		learned->index += nb_indices;
+		if (learned->index == SJA1105P_N_ARL_ENTRIES) {
+			learned->index = 0;
+			learned->switch_id = (learned->switch_id + 1) % SJA1105P_N_SWITCHES;
+		}
+	}
+	rtnl_unlock();
+
+	schedule_delayed_work(&learned->work, msecs_to_jiffies(fdb_learn_interval_ms));
+}
+
+static int nxp_fdb_learned_start(struct nxp_fdb_learned_struct *learned)
+{
+	int i;
+
+	if (fdb_learn_interval_ms <= 0)
+		return 0;
+
+	learned->budget = clamp(fdb_learn_budget, FDB_LEARN_MIN_BUDGET, (int)SJA1105P_N_ARL_ENTRIES);
+	learned->known = vmalloc(sizeof(*learned->known) * SJA1105P_N_SWITCHES * SJA1105P_N_ARL_ENTRIES);
+	learned->scan = vmalloc(sizeof(*learned->scan) * learned->budget);
+	if (!learned->known || !learned->scan) {
+		vfree(learned->known);
+		vfree(learned->scan);
+		learned->known = NULL;
+		learned->scan = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < SJA1105P_N_SWITCHES * SJA1105P_N_ARL_ENTRIES; i++)
+		learned->known[i].port = -1;
+	learned->switch_id = 0;
+	learned->index = 0;
+
+	INIT_DELAYED_WORK(&learned->work, nxp_fdb_learned_work);
+	schedule_delayed_work(&learned->work, msecs_to_jiffies(fdb_learn_interval_ms));
+
+	return 0;
+}
+
+static void nxp_fdb_learned_stop(struct nxp_fdb_learned_struct *learned)
+{
+	if (!learned->known)
+		return;
+
+	cancel_delayed_work_sync(&learned->work);
+	vfree(learned->known);
+	vfree(learned->scan);
+	learned->known = NULL;
+	learned->scan = NULL;
+}
+
+/*****************************mdb offload**************************************/
+
+static struct nxp_mdb_group *nxp_mdb_find(u64 mac, u16 vid)
+{
+	struct nxp_mdb_group *group;
+
+	hash_for_each_possible(nxp_private_data.mdb, group, node, MDB_KEY(mac, vid))
+		if (group->mac == mac && group->vid == vid)
+			return group;
+
+	return NULL;
+}
+
+/* Configure the ports of a group in the ARL table, the switches of the
+ * cascade whose port vector did not change are not accessed. A group only
+ * creates its entry, an existing static entry of the same address (e.g. a
+ * FDB entry) is not taken over.
+ */
+static int nxp_mdb_write(struct nxp_mdb_group *group, u16 ports)
+{
+	int err;
+	SJA1105P_addressResolutionTableEntry_t entry;
+
+	memset(&entry, 0, sizeof(SJA1105P_addressResolutionTableEntry_t));
+	entry.dstMacAddress = group->mac;
+	entry.vlanId = group->vid;
+
+	if (!group->ports && ports && !SJA1105P_readArlTableEntryByAddress(&entry))
+		return -EEXIST;
+
+	memset(&entry, 0, sizeof(SJA1105P_addressResolutionTableEntry_t));
+	entry.dstMacAddress = group->mac;
+	entry.vlanId = group->vid;
+	entry.ports = ports;
+
+	if (ports)
+		err = SJA1105P_updateArlTableEntryPorts(&entry, group->ports);
+	else
+		err = SJA1105P_removeArlTableEntryByAddress(&entry);
+	if (err)
+		return -EIO;
+
+	group->ports = ports;
+	return 0;
+}
+
+static int nxp_port_mdb_add(struct net_device *netdev,
+			    const struct switchdev_obj_port_mdb *mdb,
+			    struct switchdev_trans *trans)
+{
+	int err;
+	u64 mac = 0;
+	struct nxp_mdb_group *group;
+	struct nxp_port_data_struct *nxp_port;
+
+	/* memberships are counted once, in the commit phase */
+	if (switchdev_trans_ph_prepare(trans))
+		return 0;
+
+	nxp_port = netdev_priv(netdev);
+	memcpy(&mac, mdb->addr, ETH_ALEN);
+
+	if (verbosity > 1)
+		netdev_alert(netdev, "nxp_port_mdb_add was called [%d]! Join [%02x:%02x:%02x:%02x:%02x:%02x] in vlan [%x]\n",
+		nxp_port->port_num, *(mdb->addr+0), *(mdb->addr+1), *(mdb->addr+2), *(mdb->addr+3), *(mdb->addr+4), *(mdb->addr+5), mdb->vid);
+
+	group = nxp_mdb_find(mac, mdb->vid);
+	if (!group) {
+		group = kzalloc(sizeof(*group), GFP_KERNEL);
+		if (!group)
+			return -ENOMEM;
+		group->mac = mac;
+		group->vid = mdb->vid;
+		hash_add(nxp_private_data.mdb, &group->node, MDB_KEY(mac, mdb->vid));
+	}
+
+	/* the entry is only rewritten if the port joins the group */
+	if (group->refcount[nxp_port->port_num]++)
+		return 0;
+
+	err = nxp_mdb_write(group, group->ports | BIT(nxp_port->port_num));
+	if (err) {
+		if (err == -EEXIST)
+			netdev_err(netdev, "Multicast group conflicts with an existing entry of the arl table of sja1105p!");
+		else
+			netdev_err(netdev, "Could not add multicast group to arl table of sja1105p!");
+		group->refcount[nxp_port->port_num]--;
+		if (!group->ports) {
+			hash_del(&group->node);
+			kfree(group);
+		}
+	}
+
+	return err;
+}
+
+static int nxp_port_mdb_del(struct net_device *netdev,
+			    const struct switchdev_obj_port_mdb *mdb)
+{
+	int err;
+	u64 mac = 0;
+	struct nxp_mdb_group *group;
+	struct nxp_port_data_struct *nxp_port;
+
+	nxp_port = netdev_priv(netdev);
+	memcpy(&mac, mdb->addr, ETH_ALEN);
+
+	if (verbosity > 1)
+		netdev_alert(netdev, "nxp_port_mdb_del was called [%d]! Leave [%02x:%02x:%02x:%02x:%02x:%02x] in vlan [%x]\n",
+		nxp_port->port_num, *(mdb->addr+0), *(mdb->addr+1), *(mdb->addr+2), *(mdb->addr+3), *(mdb->addr+4), *(mdb->addr+5), mdb->vid);
+
+	group = nxp_mdb_find(mac, mdb->vid);
+	if (!group || !group->refcount[nxp_port->port_num])
+		return -ENOENT;
+
+	/* the entry is only rewritten if the port leaves the group */
+	if (--group->refcount[nxp_port->port_num])
+		return 0;
+
+	err = nxp_mdb_write(group, group->ports & ~BIT(nxp_port->port_num));
+	if (err) {
+		netdev_err(netdev, "Could not remove multicast group from arl table of sja1105p!");
+		group->refcount[nxp_port->port_num]++;
+		return err;
+	}
+
+	if (!group->ports) {
+		hash_del(&group->node);
+		kfree(group);
+	}
+
+	return 0;
+}
+
+static void nxp_mdb_flush(void)
+{
+	struct nxp_mdb_group *group;
+	struct hlist_node *tmp;
+	int bkt;
+
+	hash_for_each_safe(nxp_private_data.mdb, bkt, tmp, group, node) {
+		hash_del(&group->node);
+		kfree(group);
+	}
+}
+
+/*****************************vlan offload*************************************/
+
+/* Configure the port in all VLANs of the range within the shadow of the VLAN
+ * lookup table, then write the changed entries to the switches in one pass
+ */
+static int nxp_vlan_write(struct nxp_port_data_struct *nxp_port,
+			  u16 vid_begin, u16 vid_end,
+			  SJA1105P_vlanForwarding_t fwd, uint8_t enable)
+{
+	int err;
+
+	err = SJA1105P_setVlanPortRange(vid_begin, vid_end, nxp_port->port_num,
+					fwd, enable);
+
+	/* entries changed before a failure are written as well */
+	err += SJA1105P_flushVlanConfig();
+
+	return err ? -EIO : 0;
+}
+
+/* Untagged frames received by the port are classified to the PVID of the
+ * bridge, without one the PVID of the static configuration applies again
+ */
+static int nxp_pvid_write(struct nxp_port_data_struct *nxp_port, u16 pvid)
+{
+	int err;
+
+	if (pvid)
+		err = SJA1105P_setPvid(nxp_port->port_num, pvid);
+	else
+		err = SJA1105P_resetPvid(nxp_port->port_num);
+	if (err)
+		return -EIO;
+
+	nxp_port->pvid = pvid;
+
+	return 0;
+}
+
+static bool nxp_pvid_in_range(struct nxp_port_data_struct *nxp_port,
+			      u16 vid_begin, u16 vid_end)
+{
+	return nxp_port->pvid && nxp_port->pvid >= vid_begin &&
+	       nxp_port->pvid <= vid_end;
+}
+
+static int nxp_port_vlan_add(struct net_device *netdev,
+			     const struct switchdev_obj_port_vlan *vlan,
+			     struct switchdev_trans *trans)
+{
+	int err;
+	struct nxp_port_data_struct *nxp_port;
+	SJA1105P_vlanForwarding_t fwd;
+
+	if (vlan->vid_begin > vlan->vid_end || vlan->vid_end >= VLAN_N_VID)
+		return -EINVAL;
+
+	/* the range is written at once, in the commit phase */
+	if (switchdev_trans_ph_prepare(trans))
+		return 0;
+
+	nxp_port = netdev_priv(netdev);
+
+	if (verbosity > 1)
+		netdev_alert(netdev, "nxp_port_vlan_add was called [%d]! Add vlans [%d-%d], flags [%x]\n",
+		nxp_port->port_num, vlan->vid_begin, vlan->vid_end, vlan->flags);
+
+	if (vlan->flags & BRIDGE_VLAN_INFO_UNTAGGED)
+		fwd = SJA1105P_e_vlanForwarding_UNTAGGED;
+	else
+		fwd = SJA1105P_e_vlanForwarding_TAGGED;
+
+	err = nxp_vlan_write(nxp_port, vlan->vid_begin, vlan->vid_end, fwd, 1);
+	if (err) {
+		netdev_err(netdev, "Could not write vlan cfg to sja1105p!\n");
+		return err;
+	}
+
+	/* the bridge only accepts the PVID flag for a single VLAN, adding
+	 * the current PVID again without the flag clears it
+	 */
+	if (vlan->flags & BRIDGE_VLAN_INFO_PVID)
+		err = nxp_pvid_write(nxp_port, vlan->vid_end);
+	else if (nxp_pvid_in_range(nxp_port, vlan->vid_begin, vlan->vid_end))
+		err = nxp_pvid_write(nxp_port, 0);
+	if (err)
+		netdev_err(netdev, "Could not write pvid to sja1105p!\n");
+
+	return err;
+}
+
+static int nxp_port_vlan_del(struct net_device *netdev,
+			     const struct switchdev_obj_port_vlan *vlan)
+{
+	int err;
+	struct nxp_port_data_struct *nxp_port;
+
+	if (vlan->vid_begin > vlan->vid_end || vlan->vid_end >= VLAN_N_VID)
+		return -EINVAL;
+
+	nxp_port = netdev_priv(netdev);
+
+	if (verbosity > 1)
+		netdev_alert(netdev, "nxp_port_vlan_del was called [%d]! Del vlans [%d-%d]\n",
+		nxp_port->port_num, vlan->vid_begin, vlan->vid_end);
+
+	err = nxp_vlan_write(nxp_port, vlan->vid_begin, vlan->vid_end,
+			     SJA1105P_e_vlanForwarding_NOT, 0);
+	if (err) {
+		netdev_err(netdev, "Could not write vlan cfg to sja1105p!\n");
+		return err;
+	}
+
+	if (nxp_pvid_in_range(nxp_port, vlan->vid_begin, vlan->vid_end)) {
+		err = nxp_pvid_write(nxp_port, 0);
+		if (err)
+			netdev_err(netdev, "Could not write pvid to sja1105p!\n");
+	}
+
+	return err;
+}
+
+/*****************************tc offload***************************************/
+
+/* Frames of the VLAN received by the port are retagged towards all ports,
+ * so rules of different ports translating the same VLAN share one entry of
+ * the retagging table
+ */
+static u16 nxp_tc_vlan_egress_ports(void)
+{
+	return (u16)((1U << SJA1105P_N_LOGICAL_PORTS) - 1U);
+}
+
+static struct nxp_tc_vlan_rule *nxp_tc_vlan_find(struct nxp_port_data_struct *nxp_port,
+						 unsigned long cookie)
+{
+	struct nxp_tc_vlan_rule *rule;
+
+	list_for_each_entry(rule, &nxp_port->tc_vlan_rules, list)
+		if (rule->cookie == cookie)
+			return rule;
+
+	return NULL;
+}
+
+/* Only filters matching a VLAN ID exactly, with a single vlan modify action
+ * keeping the priority, map to the retagging table
+ */
+static int nxp_tc_vlan_parse(struct tc_cls_flower_offload *f,
+			     u16 *vid, u16 *new_vid)
+{
+	struct flow_dissector_key_vlan *key, *mask;
+	const struct tc_action *a;
+	int i, n_actions = 0;
+
+	if (f->dissector->used_keys &
+	    ~(BIT(FLOW_DISSECTOR_KEY_CONTROL) |
+	      BIT(FLOW_DISSECTOR_KEY_BASIC) |
+	      BIT(FLOW_DISSECTOR_KEY_VLAN))) {
+		NL_SET_ERR_MSG_MOD(f->common.extack, "Only VLAN keys are supported");
+		return -EOPNOTSUPP;
+	}
+
+	if (!dissector_uses_key(f->dissector, FLOW_DISSECTOR_KEY_VLAN)) {
+		NL_SET_ERR_MSG_MOD(f->common.extack, "A VLAN ID must be matched");
+		return -EOPNOTSUPP;
+	}
+
+	key = skb_flow_dissector_target(f->dissector, FLOW_DISSECTOR_KEY_VLAN,
+					f->key);
+	mask = skb_flow_dissector_target(f->dissector, FLOW_DISSECTOR_KEY_VLAN,
+					 f->mask);
+	if (mask->vlan_id != VLAN_VID_MASK || mask->vlan_priority) {
+		NL_SET_ERR_MSG_MOD(f->common.extack, "Only an exact VLAN ID can be matched");
+		return -EOPNOTSUPP;
+	}
+	*vid = key->vlan_id;
+
+	tcf_exts_for_each_action(i, a, f->exts) {
+		if (!is_tcf_vlan(a) || tcf_vlan_action(a) != TCA_VLAN_ACT_MODIFY ||
+		    tcf_vlan_push_prio(a)) {
+			NL_SET_ERR_MSG_MOD(f->common.extack, "Only vlan modify of the VLAN ID is supported");
+			return -EOPNOTSUPP;
+		}
+		*new_vid = tcf_vlan_push_vid(a);
+		n_actions++;
+	}
+
+	if (n_actions != 1) {
+		NL_SET_ERR_MSG_MOD(f->common.extack, "Exactly one vlan modify action is required");
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+static int nxp_tc_vlan_replace(struct nxp_port_data_struct *nxp_port,
+			       struct tc_cls_flower_offload *f)
+{
+	struct nxp_tc_vlan_rule *rule;
+	u16 vid, new_vid;
+	int err;
+
+	if (nxp_tc_vlan_find(nxp_port, f->cookie))
+		return -EEXIST;
+
+	err = nxp_tc_vlan_parse(f, &vid, &new_vid);
+	if (err)
+		return err;
+
+	rule = kzalloc(sizeof(*rule), GFP_KERNEL);
+	if (!rule)
+		return -ENOMEM;
+
+	if (SJA1105P_startRetagging(BIT(nxp_port->port_num),
+				    nxp_tc_vlan_egress_ports(), vid, new_vid)) {
+		NL_SET_ERR_MSG_MOD(f->common.extack, "Retagging table full or not writable");
+		kfree(rule);
+		return -ENOSPC;
+	}
+
+	if (verbosity > 1)
+		netdev_info(nxp_port->netdev, "retagging vlan [%d] to [%d]\n",
+			    vid, new_vid);
+
+	rule->cookie = f->cookie;
+	rule->vid = vid;
+	rule->new_vid = new_vid;
+	list_add_tail(&rule->list, &nxp_port->tc_vlan_rules);
+
+	return 0;
+}
+
+static int nxp_tc_vlan_destroy(struct nxp_port_data_struct *nxp_port,
+			       unsigned long cookie)
+{
+	struct nxp_tc_vlan_rule *rule;
+	int err = 0;
+
+	rule = nxp_tc_vlan_find(nxp_port, cookie);
+	if (!rule)
+		return -ENOENT;
+
+	if (SJA1105P_stopRetagging(BIT(nxp_port->port_num),
+				   nxp_tc_vlan_egress_ports(),
+				   rule->vid, rule->new_vid)) {
+		netdev_err(nxp_port->netdev, "Could not stop retagging vlan [%d]!\n",
+			   rule->vid);
+		err = -EIO;
+	}
+
+	/* the filter is gone regardless */
+	list_del(&rule->list);
+	kfree(rule);
+
+	return err;
+}
+
+static int nxp_tc_block_cb(enum tc_setup_type type, void *type_data,
+			   void *cb_priv)
+{
+	struct nxp_port_data_struct *nxp_port = cb_priv;
+	struct tc_cls_flower_offload *f = type_data;
+
+	if (type != TC_SETUP_CLSFLOWER)
+		return -EOPNOTSUPP;
+
+	if (!tc_cls_can_offload_and_chain0(nxp_port->netdev, &f->common))
+		return -EOPNOTSUPP;
+
+	switch (f->command) {
+	case TC_CLSFLOWER_REPLACE:
+		return nxp_tc_vlan_replace(nxp_port, f);
+	case TC_CLSFLOWER_DESTROY:
+		return nxp_tc_vlan_destroy(nxp_port, f->cookie);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int nxp_port_setup_tc(struct net_device *netdev,
+			     enum tc_setup_type type, void *type_data)
+{
+	struct nxp_port_data_struct *nxp_port = netdev_priv(netdev);
+	struct tc_block_offload *f = type_data;
+
+	if (type != TC_SETUP_BLOCK)
+		return -EOPNOTSUPP;
+
+	/* retagging applies to frames received by the port */
+	if (f->binder_type != TCF_BLOCK_BINDER_TYPE_CLSACT_INGRESS)
+		return -EOPNOTSUPP;
+
+	switch (f->command) {
+	case TC_BLOCK_BIND:
+		return tcf_block_cb_register(f->block, nxp_tc_block_cb, nxp_port,
+					     nxp_port, f->extack);
+	case TC_BLOCK_UNBIND:
+		tcf_block_cb_unregister(f->block, nxp_tc_block_cb, nxp_port);
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/* Remove the rules left over when the port goes away */
+static void nxp_tc_vlan_flush(struct nxp_port_data_struct *nxp_port)
+{
+	struct nxp_tc_vlan_rule *rule, *tmp;
+
+	list_for_each_entry_safe(rule, tmp, &nxp_port->tc_vlan_rules, list)
+		nxp_tc_vlan_destroy(nxp_port, rule->cookie);
+}
+
 static int nxp_port_get_phys_port_name(struct net_device *netdev,
 				       char *buf, size_t len)
 {
@@ -330,7 +1041,9 @@ static netdev_tx_t sja1105x_ndo_start_xmit(struct sk_buff *skb,
 
 static void set_port_linkstatus(struct net_device *netdev, linkstatus_t s)
 {
-	int needlock, flags;
+	int flags;
+
+	ASSERT_RTNL();
 
 	flags = dev_get_flags(netdev);
 	if (s == UP)
@@ -338,205 +1051,220 @@ static void set_port_linkstatus(struct net_device *netdev, linkstatus_t s)
 	else
 		flags &= ~IFF_UP;
 
-	/* dev_change_flags requires rtnl mutex to be locked when called.
-	 * register_netdev calls nxp_get_stats with rtnl locked already,
-	 * syscalls however (for example by ifconfig)
-	 * do not lock rtnl before calling nxp_get_stats.
-	 * Thus we must check if the mutex is locked,
-	 * and only lock it if it is not (which defeats its purpose)
-	 */
-	needlock =  !rtnl_is_locked();
-	if (needlock)
-		rtnl_lock();
-
 	netdev->operstate = (s == UP) ? IF_OPER_UP : IF_OPER_DOWN;
 	dev_change_flags(netdev, flags);
-
-	if (needlock)
-		rtnl_unlock();
 }
 
-void nxp_get_stats(struct net_device *netdev,
-			struct rtnl_link_stats64 *storage)
+/* indicate the linkstate of the port, show host port as always up.
+ * Scheduled by the phy callback, dev_change_flags requires rtnl
+ */
+static void nxp_port_link_work(struct work_struct *work)
 {
-	int err;
-	uint64_t tx_bytes, tx_packets, rx_bytes, rx_packets;
-	uint32_t rx_crc_errors, rx_length_errors, polerr, vlanerr, n664err;
-	uint32_t not_reach, egr_disabled, part_drop, qfull;
-	uint32_t addr_not_learned_drop, empty_route_drop, illegal_double_drop;
-	uint32_t double_tagged_drop, single_outer_drop, single_inner_drop, untagged_drop;
-	SJA1105P_macLevelErrors_t p_macLevelErrors;
-	struct nxp_port_data_struct *nxp_port = netdev_priv(netdev);
+	struct nxp_port_data_struct *nxp_port =
+		container_of(work, struct nxp_port_data_struct, link_work);
+	struct net_device *netdev = nxp_port->netdev;
 
-	/* indicate the linkstate of the port, show host port as always up */
+	rtnl_lock();
 	if (nxp_port->link_state || nxp_port->is_host) {
 		if (verbosity > 0)
 			netdev_alert(netdev, "Change link status of [%s] to: up\n", netdev->name);
 
-		netdev->flags |= IFF_UP;
-
-		/* if flag change is not visible via dev_get_flags,
-		 * use dev_change_flags to commit the change
-		 */
 		if (!(dev_get_flags(netdev) & IFF_UP))
 			set_port_linkstatus(netdev, UP);
 	} else {
 		if (verbosity > 0)
 			netdev_alert(netdev, "Change link status of [%s] to: down\n", netdev->name);
 
-		netdev->flags &= ~IFF_UP;
-
 		if (dev_get_flags(netdev) & IFF_UP)
 			set_port_linkstatus(netdev, DOWN);
 	}
+	rtnl_unlock();
+}
 
-	/* get stats from switch using the sja1105p drv functions */
-	err = SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_OCTETS,
-					       &tx_bytes,
-					       nxp_port->port_num,
-					       SJA1105P_e_etherStatDirection_EGRESS);
-
-	err += SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_PKTS,
-						&tx_packets,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_EGRESS);
-
-	err += SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_OCTETS,
-						&rx_bytes,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_INGRESS);
-
-	err += SJA1105P_get64bitEtherStatCounter(SJA1105P_e_etherStat64_N_PKTS,
-						&rx_packets,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_INGRESS);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_CRCERR,
-						&rx_crc_errors,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_SIZEERR,
-						&rx_length_errors,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_NOT_REACH,
-						&not_reach,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_EGR_DISABLED,
-						&egr_disabled,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_PART_DROP,
-						&part_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_QFULL,
-						&qfull,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_POLERR,
-						&polerr,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_VLANERR,
-						&vlanerr,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_N664ERR,
-						&n664err,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_ADDR_NOT_LEARNED_DROP,
-						&addr_not_learned_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_EMPTY_ROUTE_DROP,
-						&empty_route_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_ILLEGAL_DOUBLE_DROP,
-						&illegal_double_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_DOUBLE_TAGGED_DROP,
-						&double_tagged_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_SINGLE_OUTER_DROP,
-						&single_outer_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_SINGLE_INNER_DROP,
-						&single_inner_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_get32bitEtherStatCounter(SJA1105P_e_etherStat32_N_UNTAGGED_DROP,
-						&untagged_drop,
-						nxp_port->port_num,
-						SJA1105P_e_etherStatDirection_BOTH);
-
-	err += SJA1105P_getMacErrors(&p_macLevelErrors, nxp_port->port_num);
+/* Called from any context, also under rcu by /proc/net/dev.
+ * The counters are read from the snapshot of the stats collector
+ */
+void nxp_get_stats(struct net_device *netdev,
+			struct rtnl_link_stats64 *storage)
+{
+	int err;
+	const u64 *cnt;
+	struct sja1105p_port_stats stats;
+	struct nxp_port_data_struct *nxp_port = netdev_priv(netdev);
 
-	if (err)
-		goto sja1105p_read_error;
+	err = sja1105p_stats_get(nxp_port->port_num, &stats);
+	if (err) {
+		/* nothing collected yet */
+		if (verbosity > 3)
+			netdev_alert(netdev, "No stats of sja1105p port [%d] yet (err=%d)\n",
+				     nxp_port->port_num, err);
+		return;
+	}
+	cnt = stats.counter;
 
 	/* fill out the provided struct */
-	storage->tx_bytes = tx_bytes;
-	storage->tx_packets = tx_packets;
-	storage->rx_bytes = rx_bytes;
-	storage->rx_packets = rx_packets;
+	storage->tx_bytes = stats.tx_bytes;
+	storage->tx_packets = stats.tx_packets;
+	storage->rx_bytes = stats.rx_bytes;
+	storage->rx_packets = stats.rx_packets;
 
-	storage->rx_crc_errors = rx_crc_errors;
-	storage->rx_length_errors = rx_length_errors;
-	storage->rx_frame_errors = p_macLevelErrors.nAlignerr;
+	storage->rx_crc_errors = cnt[SJA1105P_e_etherStat32_N_CRCERR];
+	storage->rx_length_errors = cnt[SJA1105P_e_etherStat32_N_SIZEERR];
+	storage->rx_frame_errors = stats.mac_errors.nAlignerr;
 
-	storage->tx_errors = not_reach + egr_disabled;
-	storage->rx_errors = rx_crc_errors + rx_length_errors + part_drop + p_macLevelErrors.nSoferr + p_macLevelErrors.nMiierr + p_macLevelErrors.nAlignerr;
+	storage->tx_errors = cnt[SJA1105P_e_etherStat32_N_NOT_REACH] + cnt[SJA1105P_e_etherStat32_N_EGR_DISABLED];
+	storage->rx_errors = cnt[SJA1105P_e_etherStat32_N_CRCERR] + cnt[SJA1105P_e_etherStat32_N_SIZEERR] + cnt[SJA1105P_e_etherStat32_N_PART_DROP];
+	storage->rx_errors += stats.mac_errors.nSoferr + stats.mac_errors.nMiierr + stats.mac_errors.nAlignerr;
 
-	storage->tx_dropped = qfull;
-	storage->rx_dropped = part_drop + polerr + vlanerr + n664err;
-	storage->rx_dropped += addr_not_learned_drop + empty_route_drop + illegal_double_drop + double_tagged_drop + single_outer_drop + single_inner_drop + untagged_drop;
+	storage->tx_dropped = cnt[SJA1105P_e_etherStat32_N_QFULL];
+	storage->rx_dropped = cnt[SJA1105P_e_etherStat32_N_PART_DROP] + cnt[SJA1105P_e_etherStat32_N_POLERR] + cnt[SJA1105P_e_etherStat32_N_VLANERR] + cnt[SJA1105P_e_etherStat32_N_N664ERR];
+	storage->rx_dropped += cnt[SJA1105P_e_etherStat32_N_ADDR_NOT_LEARNED_DROP] + cnt[SJA1105P_e_etherStat32_N_EMPTY_ROUTE_DROP] + cnt[SJA1105P_e_etherStat32_N_ILLEGAL_DOUBLE_DROP];
+	storage->rx_dropped += cnt[SJA1105P_e_etherStat32_N_DOUBLE_TAGGED_DROP] + cnt[SJA1105P_e_etherStat32_N_SINGLE_OUTER_DROP] + cnt[SJA1105P_e_etherStat32_N_SINGLE_INNER_DROP] + cnt[SJA1105P_e_etherStat32_N_UNTAGGED_DROP];
 
 	if (verbosity > 3) {
 		netdev_alert(netdev, "nxp_get_stats was called for [%d]: rxb [%llu], txb [%llu],"
-		"rxp [%llu], txp [%llu], rx_crc_errors[%u], rx_length_errors[%u],"
-		"not_reach[%u], egr_disabled[%u], part_drop[%u], qfull[%u],"
-		"polerr[%u], vlanerr[%u], n664err[%u]\n",
-		nxp_port->port_num, tx_bytes, tx_packets, rx_bytes, rx_packets,
-		rx_crc_errors, rx_length_errors, not_reach, egr_disabled, part_drop,
-		qfull, polerr, vlanerr, n664err);
+		"rxp [%llu], txp [%llu], rx_crc_errors[%llu], rx_length_errors[%llu],"
+		"not_reach[%llu], egr_disabled[%llu], part_drop[%llu], qfull[%llu],"
+		"polerr[%llu], vlanerr[%llu], n664err[%llu]\n",
+		nxp_port->port_num, stats.rx_bytes, stats.tx_bytes, stats.rx_packets, stats.tx_packets,
+		cnt[SJA1105P_e_etherStat32_N_CRCERR], cnt[SJA1105P_e_etherStat32_N_SIZEERR],
+		cnt[SJA1105P_e_etherStat32_N_NOT_REACH], cnt[SJA1105P_e_etherStat32_N_EGR_DISABLED],
+		cnt[SJA1105P_e_etherStat32_N_PART_DROP], cnt[SJA1105P_e_etherStat32_N_QFULL],
+		cnt[SJA1105P_e_etherStat32_N_POLERR], cnt[SJA1105P_e_etherStat32_N_VLANERR],
+		cnt[SJA1105P_e_etherStat32_N_N664ERR]);
 	}
+}
 
-	return;
+/* ethtool -S, served from the snapshot of the stats collector like nxp_get_stats */
+#define NXP_DIR_COUNTER(c) (SJA1105P_e_etherStat32_##c - SJA1105P_STATS_N_COUNTERS)
 
-sja1105p_read_error:
-	netdev_err(netdev, "Could not read stats from sja1105p!\n");
+static const char nxp_traffic_names[][ETH_GSTRING_LEN] = {
+	"rx_bytes", "rx_packets", "tx_bytes", "tx_packets",
+};
+
+static const char nxp_mac_error_names[][ETH_GSTRING_LEN] = {
+	"mac_runt", "mac_soferr", "mac_alignerr", "mac_miierr",
+};
+
+static const char nxp_counter_names[SJA1105P_STATS_N_COUNTERS][ETH_GSTRING_LEN] = {
+	[SJA1105P_e_etherStat32_N_NOT_REACH]		= "not_reach",
+	[SJA1105P_e_etherStat32_N_EGR_DISABLED]		= "egr_disabled",
+	[SJA1105P_e_etherStat32_N_PART_DROP]		= "part_drop",
+	[SJA1105P_e_etherStat32_N_QFULL]		= "qfull",
+	[SJA1105P_e_etherStat32_N_POLERR]		= "polerr",
+	[SJA1105P_e_etherStat32_N_CRCERR]		= "crcerr",
+	[SJA1105P_e_etherStat32_N_SIZEERR]		= "sizeerr",
+	[SJA1105P_e_etherStat32_N_VLANERR]		= "vlanerr",
+	[SJA1105P_e_etherStat32_N_N664ERR]		= "n664err",
+	[SJA1105P_e_etherStat32_N_ADDR_NOT_LEARNED_DROP] = "addr_not_learned_drop",
+	[SJA1105P_e_etherStat32_N_EMPTY_ROUTE_DROP]	= "empty_route_drop",
+	[SJA1105P_e_etherStat32_N_ILLEGAL_DOUBLE_DROP]	= "illegal_double_drop",
+	[SJA1105P_e_etherStat32_N_DOUBLE_TAGGED_DROP]	= "double_tagged_drop",
+	[SJA1105P_e_etherStat32_N_SINGLE_OUTER_DROP]	= "single_outer_drop",
+	[SJA1105P_e_etherStat32_N_SINGLE_INNER_DROP]	= "single_inner_drop",
+	[SJA1105P_e_etherStat32_N_UNTAGGED_DROP]	= "untagged_drop",
+};
+
+/* prefixed with rx_ and tx_ */
+static const char nxp_dir_counter_names[SJA1105P_STATS_N_DIR_COUNTERS][ETH_GSTRING_LEN - 3] = {
+	[NXP_DIR_COUNTER(N_PKTS_1024_TO_1518_OCTETS)]	= "pkts_1024_to_1518_octets",
+	[NXP_DIR_COUNTER(N_PKTS_512_TO_1023_OCTETS)]	= "pkts_512_to_1023_octets",
+	[NXP_DIR_COUNTER(N_PKTS_256_TO_511_OCTETS)]	= "pkts_256_to_511_octets",
+	[NXP_DIR_COUNTER(N_PKTS_128_TO_255_OCTETS)]	= "pkts_128_to_255_octets",
+	[NXP_DIR_COUNTER(N_PKTS_65_TO_127_OCTETS)]	= "pkts_65_to_127_octets",
+	[NXP_DIR_COUNTER(N_PKTS_64_OCTETS)]		= "pkts_64_octets",
+	[NXP_DIR_COUNTER(N_MULTICAST_PKTS)]		= "multicast_pkts",
+	[NXP_DIR_COUNTER(N_BROADCAST_PKTS)]		= "broadcast_pkts",
+};
+
+#define NXP_ETHTOOL_N_STATS (ARRAY_SIZE(nxp_traffic_names) + SJA1105P_STATS_N_COUNTERS + \
+			     2 * SJA1105P_STATS_N_DIR_COUNTERS + ARRAY_SIZE(nxp_mac_error_names) + \
+			     2 * SJA1105P_N_EGRESS_QUEUES)
+
+static int nxp_port_get_sset_count(struct net_device *netdev, int sset)
+{
+	if (sset != ETH_SS_STATS)
+		return -EOPNOTSUPP;
+
+	return NXP_ETHTOOL_N_STATS;
+}
+
+static void nxp_port_get_strings(struct net_device *netdev, u32 stringset,
+				 u8 *data)
+{
+	int i;
+
+	if (stringset != ETH_SS_STATS)
+		return;
+
+	/* same order as nxp_port_get_ethtool_stats */
+	memcpy(data, nxp_traffic_names, sizeof(nxp_traffic_names));
+	data += sizeof(nxp_traffic_names);
+	memcpy(data, nxp_counter_names, sizeof(nxp_counter_names));
+	data += sizeof(nxp_counter_names);
+	for (i = 0; i < SJA1105P_STATS_N_DIR_COUNTERS; i++) {
+		snprintf(data, ETH_GSTRING_LEN, "rx_%s", nxp_dir_counter_names[i]);
+		data += ETH_GSTRING_LEN;
+	}
+	for (i = 0; i < SJA1105P_STATS_N_DIR_COUNTERS; i++) {
+		snprintf(data, ETH_GSTRING_LEN, "tx_%s", nxp_dir_counter_names[i]);
+		data += ETH_GSTRING_LEN;
+	}
+
+	memcpy(data, nxp_mac_error_names, sizeof(nxp_mac_error_names));
+	data += sizeof(nxp_mac_error_names);
+
+	for (i = 0; i < SJA1105P_N_EGRESS_QUEUES; i++) {
+		snprintf(data, ETH_GSTRING_LEN, "q%d_occupancy", i);
+		data += ETH_GSTRING_LEN;
+		snprintf(data, ETH_GSTRING_LEN, "q%d_occupancy_high_watt", i);
+		data += ETH_GSTRING_LEN;
+	}
+}
+
+/* no SPI access, the counters of the port were read by one bulk read of the collector */
+static void nxp_port_get_ethtool_stats(struct net_device *netdev,
+				       struct ethtool_stats *estats, u64 *data)
+{
+	struct nxp_port_data_struct *nxp_port = netdev_priv(netdev);
+	struct sja1105p_port_stats stats;
+	int i;
+
+	if (sja1105p_stats_get(nxp_port->port_num, &stats)) {
+		/* nothing collected yet */
+		memset(data, 0, NXP_ETHTOOL_N_STATS * sizeof(*data));
+		return;
+	}
+
+	*data++ = stats.rx_bytes;
+	*data++ = stats.rx_packets;
+	*data++ = stats.tx_bytes;
+	*data++ = stats.tx_packets;
+
+	for (i = 0; i < SJA1105P_STATS_N_COUNTERS; i++)
+		*data++ = stats.counter[i];
+	for (i = 0; i < SJA1105P_STATS_N_DIR_COUNTERS; i++)
+		*data++ = stats.rx_counter[i];
+	for (i = 0; i < SJA1105P_STATS_N_DIR_COUNTERS; i++)
+		*data++ = stats.tx_counter[i];
+
+	*data++ = stats.mac_errors.nRunt;
+	*data++ = stats.mac_errors.nSoferr;
+	*data++ = stats.mac_errors.nAlignerr;
+	*data++ = stats.mac_errors.nMiierr;
+
+	for (i = 0; i < SJA1105P_N_EGRESS_QUEUES; i++) {
+		*data++ = stats.q_occupancy[i];
+		*data++ = stats.q_occupancy_high_watt[i];
+	}
 }
 
 /* this function is called when a VLAN id is registered */
 static int nxp_port_vlan_rx_add_vid(struct net_device *netdev,
 				    __be16 proto, u16 vid)
 {
-	int err, i;
-	uint16_t ports_enable;
+	int err;
 	struct nxp_port_data_struct *nxp_port;
-	SJA1105P_vlanForwarding_t vlanFwd[SJA1105P_N_LOGICAL_PORTS];
 
 	nxp_port = netdev_priv(netdev);
 
@@ -544,27 +1272,14 @@ static int nxp_port_vlan_rx_add_vid(struct net_device *netdev,
 		netdev_alert(netdev, "nxp_port_vlan_rx_add_vid was called for [%d], vid is [%d], proto is [%d]\n",
 		nxp_port->port_num, vid, proto);
 
-	/* retrieve current configuration from switch */
-	err = SJA1105P_readVlanConfig(vid, vlanFwd, &ports_enable);
-
-	if (err == 1) {
-		/* configuration for the specified vid was not yet present,
-		 * so create an initial configuration
-		 */
-		ports_enable = 0;
-		for (i=0; i<SJA1105P_N_LOGICAL_PORTS; i++) {
-			vlanFwd[i] = SJA1105P_e_vlanForwarding_NOT;
-		}
-	}
-
-	/* change forwarding status of current port */
-	vlanFwd[nxp_port->port_num] = SJA1105P_e_vlanForwarding_TAGGED;
-
-	/* enable output from the current port */
-	ports_enable |= (1 << nxp_port->port_num);
+	/* forward tagged to and enable output from the current port,
+	 * the other ports keep the configuration held in the shadow
+	 */
+	err = SJA1105P_setVlanPort(vid, nxp_port->port_num,
+				   SJA1105P_e_vlanForwarding_TAGGED, 1);
 
-	/* write modified cfg to switch */
-	err = SJA1105P_writeVlanConfig(vid, vlanFwd, ports_enable);
+	/* write the changed entries to the switches */
+	err += SJA1105P_flushVlanConfig();
 	if (err)
 		goto sja1105p_write_error;
 
@@ -580,9 +1295,7 @@ static int nxp_port_vlan_rx_kill_vid(struct net_device *netdev,
 				     __be16 proto, u16 vid)
 {
 	int err;
-	uint16_t ports_enable;
 	struct nxp_port_data_struct *nxp_port;
-	SJA1105P_vlanForwarding_t vlanFwd[SJA1105P_N_LOGICAL_PORTS];
 
 	nxp_port = netdev_priv(netdev);
 
@@ -590,19 +1303,13 @@ static int nxp_port_vlan_rx_kill_vid(struct net_device *netdev,
 		netdev_alert(netdev, "nxp_port_vlan_rx_kill_vid was called for [%d], vid is [%d], proto is [%d]\n",
 		nxp_port->port_num, vid, proto);
 
-	/* retrieve current configuration from switch */
-	err = SJA1105P_readVlanConfig(vid, vlanFwd, &ports_enable);
+	/* stop forwarding to and disable output from the current port */
+	err = SJA1105P_setVlanPort(vid, nxp_port->port_num,
+				   SJA1105P_e_vlanForwarding_NOT, 0);
 
-	/* only modify cfg if a cfg for the specified vid exists already */
+	/* only write the switches if a cfg for the specified vid exists */
 	if (err == 0) {
-		/* change forwarding status of current port */
-		vlanFwd[nxp_port->port_num] = SJA1105P_e_vlanForwarding_NOT;
-
-		/* disable output from the current port */
-		ports_enable &= ~(1 << nxp_port->port_num);
-
-		/* write modified cfg to switch */
-		err = SJA1105P_writeVlanConfig(vid, vlanFwd, ports_enable);
+		err = SJA1105P_flushVlanConfig();
 		if (err)
 			goto sja1105p_write_error;
 	}
@@ -702,15 +1409,27 @@ static int nxp_port_obj_add(struct net_device *netdev,
 				const struct switchdev_obj *obj,
 				struct switchdev_trans *trans)
 {
-	/* Not implemented */
-	return -EOPNOTSUPP;
+	switch (obj->id) {
+	case SWITCHDEV_OBJ_ID_PORT_MDB:
+		return nxp_port_mdb_add(netdev, SWITCHDEV_OBJ_PORT_MDB(obj), trans);
+	case SWITCHDEV_OBJ_ID_PORT_VLAN:
+		return nxp_port_vlan_add(netdev, SWITCHDEV_OBJ_PORT_VLAN(obj), trans);
+	default:
+		return -EOPNOTSUPP;
+	}
 }
 
 static int nxp_port_obj_del(struct net_device *netdev,
 				const struct switchdev_obj *obj)
 {
-	/* Not implemented */
-	return -EOPNOTSUPP;
+	switch (obj->id) {
+	case SWITCHDEV_OBJ_ID_PORT_MDB:
+		return nxp_port_mdb_del(netdev, SWITCHDEV_OBJ_PORT_MDB(obj));
+	case SWITCHDEV_OBJ_ID_PORT_VLAN:
+		return nxp_port_vlan_del(netdev, SWITCHDEV_OBJ_PORT_VLAN(obj));
+	default:
+		return -EOPNOTSUPP;
+	}
 }
 
 /* Called when ports are toggled to reset delay lines */
@@ -795,8 +1514,12 @@ static void nxp_adjust_link(struct net_device *netdev)
 				}
 				nxp_toggle_port(nxp_port->port_num);
 			}
+			if (!nxp_port->link_state)
+				schedule_work(&nxp_port->link_work);
 			nxp_port->link_state = 1;
 		} else {
+			if (nxp_port->link_state)
+				schedule_work(&nxp_port->link_work);
 			nxp_port->link_state = 0;
 		}
 	}
@@ -812,6 +1535,14 @@ static const struct net_device_ops nxp_port_netdev_ops = {
 	.ndo_vlan_rx_add_vid		= nxp_port_vlan_rx_add_vid,
 	.ndo_vlan_rx_kill_vid		= nxp_port_vlan_rx_kill_vid,
 	.ndo_get_phys_port_name		= nxp_port_get_phys_port_name,
+	.ndo_setup_tc			= nxp_port_setup_tc,
+};
+
+/********************************ethtool_ops***********************************/
+static const struct ethtool_ops nxp_port_ethtool_ops = {
+	.get_sset_count			= nxp_port_get_sset_count,
+	.get_strings			= nxp_port_get_strings,
+	.get_ethtool_stats		= nxp_port_get_ethtool_stats,
 };
 
 /**********************************sw_ops**************************************/
@@ -1009,6 +1740,8 @@ int register_ports(struct nxp_private_data_struct *pr_data)
 		nxp_port->port_num = port;
 		nxp_port->ppid = physicalPortInfo.switchId;
 		nxp_port->is_host = is_hostport(&spidev->dev, port);
+		INIT_LIST_HEAD(&nxp_port->tc_vlan_rules);
+		INIT_WORK(&nxp_port->link_work, nxp_port_link_work);
 
 		/* give dev a meaningful name */
 		port_name = kzalloc(sizeof(char) * PNAME_LEN, GFP_KERNEL);
@@ -1023,6 +1756,7 @@ int register_ports(struct nxp_private_data_struct *pr_data)
 
 		/* populate netdev */
 		netdev->netdev_ops = &nxp_port_netdev_ops;
+		netdev->ethtool_ops = &nxp_port_ethtool_ops;
 		SWITCHDEV_SET_OPS(netdev, &nxp_port_swdev_ops);
 
 
@@ -1032,10 +1766,13 @@ int register_ports(struct nxp_private_data_struct *pr_data)
 		 * 	  to move between nw namespaces
 		 * 	- HW switch offload: feature flag for all switch asic
 		 * 	  offloads. Switch drivers set this flag on switch ports
+		 * 	- tc offload: VLAN translation by flower filters
 		*/
 		//TODO taken from rocker: recheck, possibly expand
 		netdev->features |= NETIF_F_NETNS_LOCAL |
-				    NETIF_F_VLAN_FEATURES;
+				    NETIF_F_VLAN_FEATURES |
+				    NETIF_F_HW_TC;
+		netdev->hw_features |= NETIF_F_HW_TC;
 
 		//TODO set priv_flags
 
@@ -1054,6 +1791,9 @@ int register_ports(struct nxp_private_data_struct *pr_data)
 
 		if (verbosity > 0)
 			netdev_info(netdev, "registered netdevice: [%s]\n", netdev->name);
+
+		/* initial flags, the phy callback reports changes of the link */
+		schedule_work(&nxp_port->link_work);
 	}
 
 	return 0;
@@ -1098,9 +1838,16 @@ void unregister_ports(struct nxp_private_data_struct *pr_data)
 			put_device(&phydev->mdio.dev);
 		}
 
+		/* no more link changes after the phy was disconnected */
+		cancel_work_sync(&pr_data->ports[i]->link_work);
+
 		if (verbosity > 0)
 			netdev_alert(netdev, "unregistering: [%s]\n", netdev->name);
 		unregister_netdev(netdev);
+
+		rtnl_lock();
+		nxp_tc_vlan_flush(pr_data->ports[i]);
+		rtnl_unlock();
 	}
 }
 
@@ -1127,16 +1874,35 @@ static void unregister_fec(void)
 /* module init function */
 int nxp_swdev_init(struct sja1105p_context_data **ctx_nodes)
 {
+	int err;
+
 	sja1105p_context_arr = ctx_nodes;
+	mutex_init(&nxp_private_data.fdb.lock);
+	hash_init(nxp_private_data.mdb);
+
 	
 	register_fec();
-	
-	return register_ports(&nxp_private_data);
+
+	err = register_ports(&nxp_private_data);
+	if (err)
+		return err;
+
+	/* the bridge does not see the learned entries otherwise */
+	if (nxp_fdb_learned_start(&nxp_private_data.learned))
+		pr_err("Could not allocate memory, learned fdb entries are not reported to the bridge\n");
+
+	return 0;
 }
 
 /* module exit function */
 void nxp_swdev_exit(void)
 {
 	unregister_fec();
+	nxp_fdb_learned_stop(&nxp_private_data.learned);
 	unregister_ports(&nxp_private_data);
+	nxp_mdb_flush();
+
+	vfree(nxp_private_data.fdb.table);
+	nxp_private_data.fdb.table = NULL;
+	nxp_private_data.fdb.valid = false;
 }